@@ -398,12 +398,14 @@
 #include <string>
 #include <vector>
 #include <errno.h>
+#include <pthread.h>
 
 
 #include "AnalogIn.h"
 #include "AnalogOut.h"
 #include "HeaterCtrl.h"
 #include "SolenoidCtrl.h"
+#include "SolenoidSchedule.h"
 #include "RTD.h"
 #include "PreampStream.h"
 #include "PreampConfig.h"
@@ -425,6 +427,8 @@
 #include "SerialModeCtrl.h"
 #include "IMBComm.h"
 #include "FpdG2control.h"
+#include "HALTrace.h"
+#include "TelemetryPoller.h"
 #include "hardwareHelpers.h"
 
 #include "tableapi.hpp"
@@ -440,8 +444,13 @@ int g_nConfigure = 0;
 
 bool g_b370XAIOBoards = false;
 
+// HAL trace file (-t), NULL - no trace
+char *g_pszTraceFile = NULL;
+
 
 void TestTempStability();
+void TestConcurrency(int nMaxThreads);
+void TestTelemetryPoller(int nPeriodMs);
 
 //local prototypes
 
@@ -1092,6 +1101,7 @@ enum
   HTR_FUNC_GET_COMP_BASE_TEMP,
   HTR_FUNC_GET_COMP_TEMP_SLOPE,
   HTR_BOARD_INFO,
+  HTR_FUNC_GET_STREAM,
   HTR_FUNC_EXIT
 };
 
@@ -1126,7 +1136,7 @@ void TestHeaterCtrl()
 
   for (int nHtrs = 0; nHtrs < nNumHtrChannels; nHtrs++)
   {
-    nRetVal = obHtr[nHtrs].OpenHal(szHtrDevNames[nHtrs]);
+    nRetVal = obHtr[nHtrs].OpenHal(szHtrDevNames[nHtrs], TRUE);
     if (nRetVal < 0)
     {
       DEBUG("Error %d opening Htr Channel: %d\n", nRetVal, nHtrs);
@@ -1173,6 +1183,7 @@ void TestHeaterCtrl()
     printf("  %d. Get Compensation Base Temperature.\n", HTR_FUNC_GET_COMP_BASE_TEMP);
     printf("  %d. Get Compensation Temperature Slope.\n", HTR_FUNC_GET_COMP_TEMP_SLOPE);
     printf("  %d. Get board information.\n", HTR_BOARD_INFO);
+    printf("  %d. Get temperature and PWM pushed by the board continuously.\n", HTR_FUNC_GET_STREAM);
     printf("  %d. Exit application.\n", HTR_FUNC_EXIT);
 
     fflush(stdin);
@@ -1373,6 +1384,33 @@ void TestHeaterCtrl()
     }
     break;
 
+    case HTR_FUNC_GET_STREAM:
+    {
+      DevStreamValueStruct stValue;
+      DevStreamStatsStruct stStats;
+
+      if ((nRetVal = obHtr[unCh].SetStreamPeriod(1000)) < 0)
+      {
+        printf("CHeaterCtrl[%d].SetStreamPeriod() failed.: %d\n", unCh + 1, nRetVal);
+        break;
+      }
+      do
+      {
+        nRetVal = obHtr[unCh].ReadStreamData(&stValue, 2000);
+        if (nRetVal < 0)
+          printf("CHeaterCtrl[%d].ReadStreamData() failed.: %d\n", unCh + 1, nRetVal);
+        else if (STREAM_VAL_TEMP_MDEGC == stValue.eValue)
+          printf("%d, temperature %f\n", unCh + 1, stValue.nValue/1000.0f);
+        else if (STREAM_VAL_PWM_MPCT == stValue.eValue)
+          printf("%d, PWM percent %f\n", unCh + 1, stValue.nValue/1000.0f);
+      } while (g_nExitApp != 1);
+      g_nExitApp = 0;
+      obHtr[unCh].SetStreamPeriod(0);
+      if (obHtr[unCh].GetStreamStats(&stStats) == 0)
+        printf("Values received: %lu, missed: %lu\n", stStats.ulReceived, stStats.ulMissed);
+    }
+    break;
+
     default:
       printf("Invalid function... try again.\n");
       fflush(stdin);
@@ -1395,6 +1433,8 @@ void TestHeaterCtrl()
 #define SOL_GET_CURRENT          3
 #define SOL_CONF_EXIT_CONF       4
 #define SOL_CONF_EXIT_APP        5
+#define SOL_RUN_SCHEDULE         6
+#define SOL_SCHEDULE_EVENTS      10
 
 void TestSol()
 {
@@ -1484,6 +1524,7 @@ void TestSol()
       printf("  %d. Switch ON Sol.\n", SOL_CONF_SOL_ON);
       printf("  %d. Switch OFF Sol.\n", SOL_CONF_SOL_OFF);
       printf("  %d. Get total Solenoid current.\n", SOL_GET_CURRENT);
+      printf("  %d. Run timed on/off schedule (actuation timing).\n", SOL_RUN_SCHEDULE);
       printf("  %d. Exit conf. (Enter test loop)\n", SOL_CONF_EXIT_CONF);
       printf("  %d. Exit app.\n", SOL_CONF_EXIT_APP);
       fflush(stdin);
@@ -1586,6 +1627,64 @@ void TestSol()
 
         break;
       
+      case SOL_RUN_SCHEDULE:
+      {
+        CSolenoidSchedule obSchedule;
+        SolEventStruct astEvents[SOL_SCHEDULE_EVENTS];
+        SolEventResultStruct astResults[SOL_SCHEDULE_EVENTS];
+        SolScheduleStatsStruct stSchedStats;
+
+        nRetVal = obSol[nSolCh].OpenHal(szSolDevNames[nSolCh]);
+
+        if (nRetVal < 0)
+        {
+          printf("Error %d opening Sol Channel: %d\n", nRetVal, nSolCh + 1);
+          g_nExitApp = 1;
+          goto sol_end;
+        }
+
+        // On / off every 250 ms, run twice so that the second run is compensated
+        memset(astEvents, 0, sizeof (astEvents));
+        for (int nEvent = 0; nEvent < SOL_SCHEDULE_EVENTS; nEvent++)
+        {
+          astEvents[nEvent].unTimeMs = 250 * (nEvent + 1);
+          astEvents[nEvent].pobValve = &obSol[nSolCh];
+          astEvents[nEvent].bOn = (nEvent % 2) ? FALSE : TRUE;
+        }
+        obSchedule.Load(astEvents, SOL_SCHEDULE_EVENTS);
+
+        for (int nRun = 1; nRun <= 2; nRun++)
+        {
+          obSchedule.Start();
+          obSchedule.Wait();
+
+          obSchedule.GetResults(astResults, SOL_SCHEDULE_EVENTS);
+          for (int nEvent = 0; nEvent < SOL_SCHEDULE_EVENTS; nEvent++)
+          {
+            printf("Run %d, %s at %llu us: sent %llu us, ack'd %llu us, error %ld us, result %d\n", nRun,
+                   astEvents[nEvent].bOn ? "ON " : "OFF", astResults[nEvent].ullScheduledUs, astResults[nEvent].ullSentUs,
+                   astResults[nEvent].ullDoneUs, astResults[nEvent].lErrorUs, astResults[nEvent].nResult);
+          }
+
+          obSchedule.GetStats(&stSchedStats);
+          printf("Run %d: %lu events, %lu failed, error %ld .. %ld us (mean abs %.0f us), max late %u us, max round trip %u us, lead %u us, real time %d\n",
+                 nRun, stSchedStats.ulExecuted, stSchedStats.ulFailed, stSchedStats.lMinErrorUs, stSchedStats.lMaxErrorUs,
+                 stSchedStats.dMeanAbsErrorUs, stSchedStats.unMaxLateUs, stSchedStats.unMaxRoundTripUs, stSchedStats.unLeadUs,
+                 stSchedStats.bRealTime);
+        }
+
+        obSol[nSolCh].TurnOFFSolValve();
+        nRetVal = obSol[nSolCh].CloseHal();
+
+        if (nRetVal < 0)
+        {
+          printf("Error %d closing Sol Channel: %d\n", nRetVal, nSolCh + 1);
+          g_nExitApp = 1;
+          goto sol_end;
+        }
+      }
+      break;
+
       case SOL_CONF_EXIT_CONF:
         nExitConfLoop = 1;
         break;
@@ -1925,6 +2024,68 @@ void TestRTD(int nIndex)
 #define PREAMP_FUNC_STOP_BROADCAST_STR          30
 #define PREAMP_FUNC_EXIT_CONF     31
 #define PREAMP_FUNC_EXIT_APP      32
+#define PREAMP_FUNC_SNAPSHOT_CFG  33
+#define PREAMP_FUNC_RESTORE_CFG   34
+#define PREAMP_FUNC_CFG_CACHE     35
+
+// Time between two gettimeofday() readings, in ms
+static double ElapsedMs(const struct timeval &stStart, const struct timeval &stEnd)
+{
+  return (stEnd.tv_sec - stStart.tv_sec) * 1000.0 + (stEnd.tv_usec - stStart.tv_usec) / 1000.0;
+}
+
+// Read the settings one by one and as one snapshot, and compare the time taken
+static void TestPreampSnapshot(CPreampConfig &obPreampCfg, PreampConfigSnapshotStruct *pstSnapshot)
+{
+  struct timeval stStart, stEnd;
+  PreampConfigSnapshotStruct stSingle;
+  int nRetVal = 0;
+
+  memset(&stSingle, 0, sizeof (stSingle));
+  stSingle.unVersion = PREAMP_CFG_SNAPSHOT_VERSION;
+  stSingle.unFields = PREAMP_CFG_ALL & ~PREAMP_CFG_OFFSETS;
+
+  gettimeofday(&stStart, NULL);
+  if ( (nRetVal = obPreampCfg.GetBridgeGain(&stSingle.eGain)) >= 0 &&
+       (nRetVal = obPreampCfg.GetSamplingRate(&stSingle.eSamplingRate)) >= 0 &&
+       (nRetVal = obPreampCfg.GetACBridgeStatus(&stSingle.eACBridge)) >= 0 &&
+       (nRetVal = obPreampCfg.GetFilterStatus(&stSingle.eFilter)) >= 0 &&
+       (nRetVal = obPreampCfg.GetMovingAvgStatus(&stSingle.eMovAvg)) >= 0 &&
+       obPreampCfg.IsBaseLineAdjustable() )
+  {
+    stSingle.unFields |= PREAMP_CFG_OFFSETS;
+    for (int nOffset = MIN_PREAMP_OFFSET_TYPE; (nOffset < MAX_PREAMP_OFFSET_TYPE) && (nRetVal >= 0); nOffset++)
+    {
+      nRetVal = obPreampCfg.GetBridgeOffset((PREAMP_OFFSET_TYPE) nOffset, &stSingle.aeOffset[nOffset]);
+    }
+  }
+  gettimeofday(&stEnd, NULL);
+  if (nRetVal < 0)
+  {
+    printf("Error reading the settings one by one: %d\n", nRetVal);
+    return;
+  }
+  printf("One by one: %.1f ms\n", ElapsedMs(stStart, stEnd));
+
+  gettimeofday(&stStart, NULL);
+  nRetVal = obPreampCfg.GetConfigSnapshot(pstSnapshot);
+  gettimeofday(&stEnd, NULL);
+  if (nRetVal < 0)
+  {
+    printf("Error reading the snapshot: %d (settings read: 0x%02X)\n", nRetVal, pstSnapshot->unFields);
+    return;
+  }
+  printf("Snapshot:   %.1f ms\n", ElapsedMs(stStart, stEnd));
+
+  printf("Gain %d, Sampling rate %d, AC bridge %d, Filter %d, Moving avg %d", pstSnapshot->eGain,
+         pstSnapshot->eSamplingRate, pstSnapshot->eACBridge, pstSnapshot->eFilter, pstSnapshot->eMovAvg);
+  if (pstSnapshot->unFields & PREAMP_CFG_OFFSETS)
+  {
+    printf(", Offsets %d / %d / %d", pstSnapshot->aeOffset[BRIDGE_LEFT_COARSE],
+           pstSnapshot->aeOffset[BRIDGE_RIGHT_COARSE], pstSnapshot->aeOffset[BRIDGE_RIGHT_FINE]);
+  }
+  printf("\nDiffers from the settings read one by one: 0x%02X\n", CPreampConfig::DiffConfigSnapshot(stSingle, *pstSnapshot));
+}
 
 int TestPreamp(int nPres)
 {
@@ -1948,6 +2109,7 @@ int TestPreamp(int nPres)
 
   static CPreampStream obPreampStr[NR_PRE_CHANNELS];
   static CPreampConfig obPreampCfg[NR_PRE_CHANNELS];
+  static PreampConfigSnapshotStruct stCfgSnapshot;
 
   int nRetVal = 0;
   int nPreFunc = 0;
@@ -2011,6 +2173,9 @@ int TestPreamp(int nPres)
       printf("  %d: Get Bridge Right Detector status\n", PREAMP_FUNC_GET_BRIDGE_RIGHT_DET_STATUS);
       printf("  %d: Start Broadcast (through streaming object)\n", PREAMP_FUNC_START_BROADCAST_STR);
       printf("  %d: Stop Broadcast (through streaming object)\n", PREAMP_FUNC_STOP_BROADCAST_STR);
+      printf("  %d: Snapshot configuration (timed against single reads)\n", PREAMP_FUNC_SNAPSHOT_CFG);
+      printf("  %d: Restore configuration snapshot\n", PREAMP_FUNC_RESTORE_CFG);
+      printf("  %d: Configuration cache on/off (and bus reads saved)\n", PREAMP_FUNC_CFG_CACHE);
       printf("  %d: Exit config.\n", PREAMP_FUNC_EXIT_CONF);
       printf("  %d: Exit applicatin.\n", PREAMP_FUNC_EXIT_APP);
       fflush(stdin);
@@ -2592,6 +2757,72 @@ int TestPreamp(int nPres)
         }
         break;
 
+      case PREAMP_FUNC_SNAPSHOT_CFG:
+        TestPreampSnapshot(obPreampCfg[nPres], &stCfgSnapshot);
+        break;
+
+      case PREAMP_FUNC_RESTORE_CFG:
+        if (0 == stCfgSnapshot.unFields)
+        {
+          printf("Take a snapshot first\n");
+        }
+        else
+        {
+          struct timeval stStart, stEnd;
+          PreampConfigSnapshotStruct stNow;
+
+          gettimeofday(&stStart, NULL);
+          nRetVal = obPreampCfg[nPres].RestoreConfigSnapshot(stCfgSnapshot);
+          gettimeofday(&stEnd, NULL);
+          if (nRetVal < 0)
+          {
+            printf("Error restoring the snapshot: %d\n", nRetVal);
+          }
+          else if ( (nRetVal = obPreampCfg[nPres].GetConfigSnapshot(&stNow)) < 0)
+          {
+            printf("Restored in %.1f ms. Error reading back: %d\n", ElapsedMs(stStart, stEnd), nRetVal);
+          }
+          else
+          {
+            printf("Restored in %.1f ms. Differs from the snapshot: 0x%02X\n", ElapsedMs(stStart, stEnd),
+                   CPreampConfig::DiffConfigSnapshot(stCfgSnapshot, stNow));
+          }
+        }
+        break;
+
+      case PREAMP_FUNC_CFG_CACHE:
+        {
+          DevCacheStatsStruct stCacheStats;
+
+          if (obPreampCfg[nPres].GetConfigCacheStats(&stCacheStats) >= 0)
+          {
+            printf("Reads from the cache (bus transactions saved): %lu, from the board: %lu, "
+                   "values written through: %lu, invalidated: %lu\n",
+                   stCacheStats.ulHits, stCacheStats.ulMisses, stCacheStats.ulWrites,
+                   stCacheStats.ulInvalidations);
+          }
+
+          printf("1: Enable configuration cache\n");
+          printf("2: Disable configuration cache\n");
+          printf("3: Invalidate (e.g. after a board reset)\n");
+          printf("4: No change\n");
+          fflush(stdin);
+          scanf("%d", &nOptVal);
+
+          if (1 == nOptVal || 2 == nOptVal)
+          {
+            if ( (nRetVal = obPreampCfg[nPres].EnableConfigCache(1 == nOptVal)) < 0)
+            {
+              printf("Error setting configuration cache: %d\n", nRetVal);
+            }
+          }
+          else if (3 == nOptVal)
+          {
+            obPreampCfg[nPres].InvalidateConfigCache();
+          }
+        }
+        break;
+
       case PREAMP_FUNC_EXIT_CONF:
         nExitOptLoop = 1;
         break;
@@ -4733,12 +4964,16 @@ void PrintHelp()
   printf("  n: Test Serial Mode Control\n");
   printf("  g: Test IMB Communication\n");
   printf("  j: Test FPD G2\n");
+  printf("  T: Concurrency stress test (RTDs read from several threads)\n");
+  printf("  P: Telemetry poller (RTD temperatures and heater PWMs polled in the background)\n");
   printf("-n <value> (Optional):\n");
   printf("  Channel No.: 0 to 1 when 'app_mode' is p (Preamp)\n");
   printf("  Channel No.: 0 to 2 when 'app_mode' is u (Serial)\n");
   printf("  Time interval: In milliseconds, b/n RTD channel reads when 'app_mode' is t (RTD)\n");
   printf("  FID/FPD No.: 0 = BaseIO, 1 = backplane, when 'app_mode' is c(FID) or b(FPD)\n");
   printf("  Slot No.: 0 to 1 when 'app_mode' is j (FPD G2)\n");
+  printf("  Max. threads: 1 to 16 when 'app_mode' is T (Concurrency), default 8\n");
+  printf("  Poll period: In milliseconds when 'app_mode' is P (Telemetry poller), default 1000\n");
   printf("  Not valid for other modes.\n");
   printf("-c (Pre configure):\n");
   printf("  Optional pre-configure command line switch. If any of the\n");
@@ -4752,6 +4987,9 @@ void PrintHelp()
   printf("  Not specifying this switch will default to 700XA IO boards.\n");
   printf("-v (Verbose)\n");
   printf("  Not specifying this switch will disable the display of some messages during application execution.\n");
+  printf("-t <file> (Optional):\n");
+  printf("  Record the HAL transactions of the test and write them to <file> as a Chrome trace\n");
+  printf("  (open in chrome://tracing or ui.perfetto.dev).\n");
   
 }
 
@@ -4824,6 +5062,7 @@ void PrintHelp()
 #define IMB_FUNC_GET_FLASH_IMAGE             101
 
 #define IMB_FUNC_RESET_ALL_DATA_SECTIONS     102
+#define IMB_FUNC_FLASH_TRANSFER_BENCH        103
 
 
 void GenerateRandomString( unsigned char * szRandString, const int nLength )
@@ -5221,6 +5460,13 @@ static void TestIMBFactoryData(IMB_FACTORY_DATA_STRUCT2 & stSetDataStruct, IMB_F
 static void TestIMBMirrorData( IMB_MIRROR_DATA_STRUCT2  & stSetDataStruct, IMB_MIRROR_DATA_STRUCT2  & stGetDataStruct);
 static void TestIMBGlobalData( IMB_GLOBAL_DATA_STRUCT2  & stSetDataStruct, IMB_GLOBAL_DATA_STRUCT2  & stGetDataStruct);
 
+// Progress of the windowed flash image transfers
+static void PrintIMBTransferProgress(void *pvArg, unsigned int unBytesDone, unsigned int unBytesTotal)
+{
+  printf("\r  %u / %u bytes", unBytesDone, unBytesTotal);
+  fflush(stdout);
+}
+
 void TestIMBComm()
 {
   int nRetVal = 0;
@@ -5356,7 +5602,8 @@ void TestIMBComm()
       printf("  %*d. Set Flash Image.                 ",  2, IMB_FUNC_SET_FLASH_IMAGE );
       printf("  %*d. Get Flash Image.\n",                 2, IMB_FUNC_GET_FLASH_IMAGE );
 
-      printf("  %*d. Reset All Data Sections.\n",         2, IMB_FUNC_RESET_ALL_DATA_SECTIONS );
+      printf("  %*d. Reset All Data Sections.         ",  2, IMB_FUNC_RESET_ALL_DATA_SECTIONS );
+      printf("  %*d. Flash Transfer Window Bench.\n",    2, IMB_FUNC_FLASH_TRANSFER_BENCH );
 
 // NEW
       printf( "*****************************************************************************\n" );
@@ -7229,6 +7476,97 @@ void TestIMBComm()
     }
     break;
 
+    case IMB_FUNC_FLASH_TRANSFER_BENCH:
+    {
+      unsigned int nFlashSection = 0;
+      unsigned int nWindow = 0;
+      unsigned int nWriteBack = 0;
+
+      printf( "Enter the section to transfer (0:GLOBAL 1:FACTORY 2:MIRROR) : " );
+      fflush(stdin);
+      scanf("%u", &nFlashSection );
+
+      printf( "Enter the transfer window (2 - %d) : ", IMB_MAX_TRANSFER_WINDOW );
+      fflush(stdin);
+      scanf("%u", &nWindow );
+
+      printf( "Write the section back windowed (0:No 1:Yes) : " );
+      fflush(stdin);
+      scanf("%u", &nWriteBack );
+
+      unsigned int nFlashLen = sizeof(IMB_GLOBAL_DATA_STRUCT2);
+      if (IMB_FACTORY_FLASH_SECTION == nFlashSection)
+      {
+        nFlashLen = sizeof(IMB_FACTORY_DATA_STRUCT2);
+      }
+      else if (IMB_MIRROR_FLASH_SECTION == nFlashSection)
+      {
+        nFlashLen = sizeof(IMB_MIRROR_DATA_STRUCT2);
+      }
+
+      unsigned char *pbyImage1 = new unsigned char[nFlashLen];
+      unsigned char *pbyImageN = new unsigned char[nFlashLen];
+      unsigned int flashLenRead = 0;
+      IMBTransferStatsStruct stStats1, stStatsN;
+
+      memset(pbyImage1, 0, nFlashLen);
+      memset(pbyImageN, 0, nFlashLen);
+      oIMBComm.SetTransferProgress( PrintIMBTransferProgress, NULL );
+
+      // One chunk at a time, then windowed
+      oIMBComm.SetTransferWindow( 1 );
+      if ( (nRetVal = oIMBComm.GetFlashImage2( pbyImage1, (unsigned char) nFlashSection, 0, nFlashLen, flashLenRead )) < 0)
+      {
+        printf("\nCIMBComm::GetFlashImage2() failed : %d !!!\n", nRetVal);
+      }
+      oIMBComm.GetTransferStats( &stStats1 );
+
+      if (nRetVal >= 0)
+      {
+        if ( (nRetVal = oIMBComm.SetTransferWindow( nWindow )) < 0)
+        {
+          printf("\nCIMBComm::SetTransferWindow() failed : %d !!!\n", nRetVal);
+        }
+        else if ( (nRetVal = oIMBComm.GetFlashImage2( pbyImageN, (unsigned char) nFlashSection, 0, nFlashLen, flashLenRead )) < 0)
+        {
+          printf("\nCIMBComm::GetFlashImage2() windowed failed : %d !!!\n", nRetVal);
+        }
+        oIMBComm.GetTransferStats( &stStatsN );
+      }
+
+      if (nRetVal >= 0)
+      {
+        printf( "\n--------------------------------\n" );
+        printf( "Section %u, %u bytes, %u chunks\n", nFlashSection, nFlashLen, stStats1.unChunks );
+        printf( "Window  Time (ms)  Bytes/s   Sent  Retransmits  CRC\n" );
+        printf( "%6u %10.1f %8.0f %6u %12u  0x%04X\n", stStats1.unWindow, stStats1.ullElapsedUs / 1000.0,
+                stStats1.dBytesPerSec, stStats1.unChunksSent, stStats1.unRetransmits, stStats1.usImageCRC );
+        printf( "%6u %10.1f %8.0f %6u %12u  0x%04X\n", stStatsN.unWindow, stStatsN.ullElapsedUs / 1000.0,
+                stStatsN.dBytesPerSec, stStatsN.unChunksSent, stStatsN.unRetransmits, stStatsN.usImageCRC );
+        printf( "Images %s\n", (0 == memcmp(pbyImage1, pbyImageN, nFlashLen)) ? "match" : "DIFFER" );
+        printf( "--------------------------------\n" );
+      }
+
+      if (nRetVal >= 0 && nWriteBack && 0 == memcmp(pbyImage1, pbyImageN, nFlashLen))
+      {
+        // Writing back what was read leaves the section as it was
+        if ( (nRetVal = oIMBComm.SetFlashImage2( pbyImageN, (unsigned char) nFlashSection, 0, nFlashLen )) < 0)
+        {
+          printf("\nCIMBComm::SetFlashImage2() windowed failed : %d !!!\n", nRetVal);
+        }
+        oIMBComm.GetTransferStats( &stStatsN );
+        printf( "\nWrite: %.1f ms (with read back), %u chunks sent, %u retransmits, %u rounds, %s\n",
+                stStatsN.ullElapsedUs / 1000.0, stStatsN.unChunksSent, stStatsN.unRetransmits,
+                stStatsN.unRounds, stStatsN.bVerified ? "verified" : "NOT verified" );
+      }
+
+      oIMBComm.SetTransferWindow( IMB_DFLT_TRANSFER_WINDOW );
+      oIMBComm.SetTransferProgress( NULL, NULL );
+      delete [] pbyImage1;
+      delete [] pbyImageN;
+    }
+    break;
+
     default:
       printf("Invalid function... try again.\n");
       fflush(stdin);
@@ -10439,6 +10777,8 @@ void RunDiagsContinuous()
 #define APP_MODE_KEY_LOCK_CHG 26
 #define APP_MODE_FPD_G2       27
 #define APP_MODE_DIAG_CONT    28
+#define APP_MODE_CONCURRENCY  29
+#define APP_MODE_TELEMETRY    30
 
 int main (int argc, char *argv[])
 {
@@ -10457,7 +10797,7 @@ int main (int argc, char *argv[])
 
   while (argv[optind] != NULL)
   {
-    optVal = getopt(argc, argv, "m:n:avc");
+    optVal = getopt(argc, argv, "m:n:avct:");
 
     switch(optVal)
     {
@@ -10588,6 +10928,14 @@ int main (int argc, char *argv[])
           appMode = APP_MODE_KEY_LOCK_CHG;
           break;
 
+        case 'T':
+          appMode = APP_MODE_CONCURRENCY;
+          break;
+
+        case 'P':
+          appMode = APP_MODE_TELEMETRY;
+          break;
+
         default:
           printf("Not a valid mode.\n");
           PrintHelp();
@@ -10626,6 +10974,10 @@ int main (int argc, char *argv[])
       g_b370XAIOBoards = true;
       break;
 
+    case 't':
+      g_pszTraceFile = optarg;
+      break;
+
     default:
       printf("Improper usage\n");
       PrintHelp();
@@ -10638,6 +10990,12 @@ int main (int argc, char *argv[])
   {
     printf("Failed to install signal handler.\n");
   }
+
+  if (g_pszTraceFile)
+  {
+    CHALTrace::Enable(TRUE);
+    CHALTrace::SetThreadName("TestHAL");
+  }
                 
   switch(appMode)
   {
@@ -10762,8 +11120,33 @@ int main (int argc, char *argv[])
   case APP_MODE_FPD_G2:
     TestFPD_G2();
     break;
+
+  case APP_MODE_CONCURRENCY:
+    TestConcurrency(nIndexFlag ? nIndex : 0);
+    break;
+
+  case APP_MODE_TELEMETRY:
+    TestTelemetryPoller(nIndexFlag ? nIndex : 0);
+    break;
   }
 
+  if (g_pszTraceFile)
+  {
+    HALTraceStatsStruct stTraceStats;
+
+    CHALTrace::Enable(FALSE);
+    CHALTrace::GetStats(&stTraceStats);
+    if (CHALTrace::ExportChrome(g_pszTraceFile) < 0)
+    {
+      printf("Unable to write HAL trace to %s.\n", g_pszTraceFile);
+    }
+    else
+    {
+      printf("HAL trace: %lu calls from %u threads written to %s (%lu overwritten).\n",
+             stTraceStats.ulRecorded - stTraceStats.ulOverwritten, stTraceStats.unThreads,
+             g_pszTraceFile, stTraceStats.ulOverwritten);
+    }
+  }
 
   return 0;
   
@@ -10914,3 +11297,336 @@ void TestTempStability()
   }
 }
 
+//////////////////////////////////////////////////////////////////////
+//
+//   CONCURRENCY STRESS TEST
+//
+// Reads the RTDs from 1, 2, 4 ... nMaxThreads threads at once. Thread n reads RTD
+// (n % number of RTDs), so with more threads than RTDs several threads share an
+// object, and every thread also reads the last RTD. Reports the reads per second
+// and the failed reads for each thread count. Build the HAL and this app with
+// "make SANITIZE=thread" to run it under ThreadSanitizer.
+
+#define STRESS_MAX_THREADS    16
+#define STRESS_RUN_SECONDS    5
+
+struct StressThreadStruct {
+  CRTD *pobOwnRTD;        // RTD read by this thread (shared when threads > RTDs)
+  CRTD *pobSharedRTD;     // RTD read by all the threads
+  unsigned long ulReads;
+  unsigned long ulErrors;
+  int nLastError;
+};
+
+static int g_nStressStop = 0;
+
+static void *StressThread(void *pvArg)
+{
+  StressThreadStruct *pstThread = (StressThreadStruct *) pvArg;
+  long lRTDVal = 0;
+  int nRetVal = 0;
+
+  // Read the stop flag atomically - it is set by the main thread
+  while (__sync_fetch_and_add(&g_nStressStop, 0) == 0)
+  {
+    nRetVal = pstThread->pobOwnRTD->GetTempInMilliDegC(&lRTDVal);
+    pstThread->ulReads++;
+    if (nRetVal < 0)
+    {
+      pstThread->ulErrors++;
+      pstThread->nLastError = nRetVal;
+    }
+
+    nRetVal = pstThread->pobSharedRTD->GetTempInMilliDegC(&lRTDVal);
+    pstThread->ulReads++;
+    if (nRetVal < 0)
+    {
+      pstThread->ulErrors++;
+      pstThread->nLastError = nRetVal;
+    }
+  }
+
+  return NULL;
+}
+
+void TestConcurrency(int nMaxThreads)
+{
+  static char * szRTDDevNames[NR_RTD_CHANNELS];
+  int nNumRTDChannels = NR_RTD_CHANNELS;
+  if( g_b370XAIOBoards )
+  {
+    nNumRTDChannels = ANALYZER_NR_RTD_CHANNELS;
+    szRTDDevNames[0] = "RTD:ANALYZER_SLOT:RTD_1";
+    szRTDDevNames[1] = "RTD:ANALYZER_SLOT:RTD_2";
+  }
+  else
+  {
+#ifdef MODEL_700XA
+    szRTDDevNames[0] = "RTD:SLOT_2:RTD_1";
+    szRTDDevNames[1] = "RTD:SLOT_2:RTD_2";
+    szRTDDevNames[2] = "RTD:SLOT_2:RTD_3";
+    szRTDDevNames[3] = "RTD:SLOT_2:RTD_4";
+    szRTDDevNames[4] = "RTD:SLOT_2:RTD_5";
+#else
+    szRTDDevNames[0] = "RTD:ANALYZER_SLOT:RTD_1";
+    szRTDDevNames[1] = "RTD:ANALYZER_SLOT:RTD_2";
+#endif
+  }
+
+  static CRTD obRTD[NR_RTD_CHANNELS];
+  static StressThreadStruct astThreads[STRESS_MAX_THREADS];
+  pthread_t aThreadIds[STRESS_MAX_THREADS];
+  int nRetVal = 0;
+  int nOpened = 0;
+
+  if ((nMaxThreads <= 0) || (nMaxThreads > STRESS_MAX_THREADS))
+  {
+    nMaxThreads = 8;
+  }
+
+  // Open RTD Channels...
+  for (nOpened = 0; nOpened < nNumRTDChannels; nOpened++)
+  {
+    nRetVal = obRTD[nOpened].OpenHal(szRTDDevNames[nOpened]);
+    if (nRetVal < 0)
+    {
+      printf("Error %d opening RTD Channel: %d\n", nRetVal, nOpened + 1);
+      g_nExitApp = 1;
+      break;
+    }
+  }
+
+  printf("Threads, Reads/sec, Failed reads\n");
+
+  for (int nThreads = 1; (nThreads <= nMaxThreads) && (g_nExitApp != 1); nThreads *= 2)
+  {
+    struct timeval stStart, stEnd;
+    int nStarted = 0;
+
+    __sync_lock_test_and_set(&g_nStressStop, 0);
+    memset(astThreads, 0, sizeof (astThreads));
+
+    gettimeofday(&stStart, NULL);
+    for (nStarted = 0; nStarted < nThreads; nStarted++)
+    {
+      astThreads[nStarted].pobOwnRTD = &obRTD[nStarted % nNumRTDChannels];
+      astThreads[nStarted].pobSharedRTD = &obRTD[nNumRTDChannels - 1];
+      if (pthread_create(&aThreadIds[nStarted], NULL, StressThread, &astThreads[nStarted]) != 0)
+      {
+        printf("Failed to create thread %d\n", nStarted + 1);
+        g_nExitApp = 1;
+        break;
+      }
+    }
+
+    // Run for a while, or until Ctrl-C
+    for (int nSecs = 0; (nSecs < STRESS_RUN_SECONDS) && (g_nExitApp != 1); nSecs++)
+    {
+      sleep(1);
+    }
+
+    __sync_lock_test_and_set(&g_nStressStop, 1);
+    for (int nThread = 0; nThread < nStarted; nThread++)
+    {
+      pthread_join(aThreadIds[nThread], NULL);
+    }
+    gettimeofday(&stEnd, NULL);
+
+    unsigned long ulReads = 0;
+    unsigned long ulErrors = 0;
+    for (int nThread = 0; nThread < nStarted; nThread++)
+    {
+      ulReads += astThreads[nThread].ulReads;
+      ulErrors += astThreads[nThread].ulErrors;
+      if (astThreads[nThread].ulErrors)
+      {
+        printf("  Thread %d: %lu failed reads, last error %d\n", nThread + 1,
+               astThreads[nThread].ulErrors, astThreads[nThread].nLastError);
+      }
+    }
+
+    double dElapsed = (stEnd.tv_sec - stStart.tv_sec) + (stEnd.tv_usec - stStart.tv_usec) / 1000000.0;
+    printf("%7d, %9.1f, %lu\n", nStarted, (dElapsed > 0) ? (ulReads / dElapsed) : 0.0, ulErrors);
+  }
+
+  // Close RTD Channels...
+  for (int nRTDs = 0; nRTDs < nOpened; nRTDs++)
+  {
+    nRetVal = obRTD[nRTDs].CloseHal();
+    if (nRetVal < 0)
+    {
+      printf("Error %d closing RTD Channel: %d\n", nRetVal, nRTDs + 1);
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+//
+//   TELEMETRY POLLER TEST
+//
+// Polls the RTD temperatures and the heater PWMs in the background with
+// CTelemetryPoller, each every nPeriodMs (default 1000). Prints the latest
+// readings and the poller statistics once a second, until Ctrl-C. Then stops the
+// poller and prints the final statistics.
+
+#define TELEMETRY_TEST_DFLT_PERIOD_MS   1000
+
+static void PrintTelemetryStats(CTelemetryPoller &obPoller)
+{
+  TelemetryStatsStruct stStats;
+
+  if (obPoller.GetStats(&stStats) < 0)
+  {
+    printf("CTelemetryPoller::GetStats() failed\n");
+    return;
+  }
+
+  printf("  %.1f s: %lu reads (%.1f/s), %lu failed, %lu skipped, %.2f reads in progress on average "
+         "(max %u), max jitter %u us\n",
+         stStats.ullRunUs / 1000000.0, stStats.ulReads, stStats.dReadsPerSec, stStats.ulErrors,
+         stStats.ulSkipped, stStats.dBusyRatio, stStats.unMaxInFlight, stStats.unMaxJitterUs);
+}
+
+void TestTelemetryPoller(int nPeriodMs)
+{
+  static char * szRTDDevNames[NR_RTD_CHANNELS];
+  int nNumRTDChannels = NR_RTD_CHANNELS;
+  if( g_b370XAIOBoards )
+  {
+    nNumRTDChannels = ANALYZER_NR_RTD_CHANNELS;
+    szRTDDevNames[0] = "RTD:ANALYZER_SLOT:RTD_1";
+    szRTDDevNames[1] = "RTD:ANALYZER_SLOT:RTD_2";
+  }
+  else
+  {
+#ifdef MODEL_700XA
+    szRTDDevNames[0] = "RTD:SLOT_2:RTD_1";
+    szRTDDevNames[1] = "RTD:SLOT_2:RTD_2";
+    szRTDDevNames[2] = "RTD:SLOT_2:RTD_3";
+    szRTDDevNames[3] = "RTD:SLOT_2:RTD_4";
+    szRTDDevNames[4] = "RTD:SLOT_2:RTD_5";
+#else
+    szRTDDevNames[0] = "RTD:ANALYZER_SLOT:RTD_1";
+    szRTDDevNames[1] = "RTD:ANALYZER_SLOT:RTD_2";
+#endif
+  }
+
+  static char * szHtrDevNames[NR_HTR_CHANNELS]= {NULL,NULL,NULL,NULL};
+  int nNumHtrChannels = NR_HTR_CHANNELS;
+  if( g_b370XAIOBoards )
+  {
+    nNumHtrChannels = ANALYZER_NR_HTR_CHANNELS;
+    szHtrDevNames[0] = "HTR_CTRL:ANALYZER_SLOT:HTR_CTRL_1";
+    szHtrDevNames[1] = "HTR_CTRL:ANALYZER_SLOT:HTR_CTRL_2";
+  }
+  else
+  {
+    szHtrDevNames[0] = "HTR_CTRL:SLOT_2:HTR_CTRL_1";
+    szHtrDevNames[1] = "HTR_CTRL:SLOT_2:HTR_CTRL_2";
+    szHtrDevNames[2] = "HTR_CTRL:SLOT_2:HTR_CTRL_3";
+    szHtrDevNames[3] = "HTR_CTRL:SLOT_2:HTR_CTRL_4";
+  }
+
+  static CRTD obRTD[NR_RTD_CHANNELS];
+  static CHeaterCtrl obHtr[NR_HTR_CHANNELS];
+  CTelemetryPoller obPoller;
+  int nRetVal = 0;
+  int nRTDsOpened = 0;
+  int nHtrsOpened = 0;
+
+  if (nPeriodMs <= 0)
+  {
+    nPeriodMs = TELEMETRY_TEST_DFLT_PERIOD_MS;
+  }
+
+  // Open RTD Channels...
+  for (nRTDsOpened = 0; nRTDsOpened < nNumRTDChannels; nRTDsOpened++)
+  {
+    nRetVal = obRTD[nRTDsOpened].OpenHal(szRTDDevNames[nRTDsOpened]);
+    if (nRetVal < 0)
+    {
+      printf("Error %d opening RTD Channel: %d\n", nRetVal, nRTDsOpened + 1);
+      g_nExitApp = 1;
+      break;
+    }
+    obPoller.AddRTD(&obRTD[nRTDsOpened], TELEMETRY_RTD_TEMP, nPeriodMs);
+  }
+
+  // Open our heaters... Make sure you kill xpheaterrd before you run this program
+  for (nHtrsOpened = 0; (nHtrsOpened < nNumHtrChannels) && (g_nExitApp != 1); nHtrsOpened++)
+  {
+    nRetVal = obHtr[nHtrsOpened].OpenHal(szHtrDevNames[nHtrsOpened]);
+    if (nRetVal < 0)
+    {
+      printf("Error %d opening Htr Channel: %d\n", nRetVal, nHtrsOpened + 1);
+      g_nExitApp = 1;
+      break;
+    }
+    obPoller.AddHeater(&obHtr[nHtrsOpened], TELEMETRY_HTR_PWM, nPeriodMs);
+  }
+
+  if (g_nExitApp != 1)
+  {
+    nRetVal = obPoller.Start();
+    if (nRetVal < 0)
+    {
+      printf("CTelemetryPoller::Start() failed: %d\n", nRetVal);
+      g_nExitApp = 1;
+    }
+    else
+    {
+      printf("Polling %d RTD temperatures and %d heater PWMs every %d ms. Ctrl-C to stop.\n",
+             nRTDsOpened, nHtrsOpened, nPeriodMs);
+    }
+  }
+
+  while ((g_nExitApp != 1) && obPoller.IsRunning())
+  {
+    TelemetryValueStruct astValues[TELEMETRY_MAX_ITEMS];
+
+    sleep(1);
+
+    // Latest readings - RTD temperatures, then heater PWMs
+    int nNumValues = obPoller.GetTable(astValues, TELEMETRY_MAX_ITEMS);
+    for (int nValue = 0; nValue < nNumValues; nValue++)
+    {
+      if (0 == astValues[nValue].ullTimeUs)
+      {
+        printf("-, ");
+      }
+      else if (astValues[nValue].nLastResult < 0)
+      {
+        printf("err %d, ", astValues[nValue].nLastResult);
+      }
+      else
+      {
+        printf("%lld, ", astValues[nValue].llValue);
+      }
+    }
+    printf("\n");
+    PrintTelemetryStats(obPoller);
+  }
+
+  nRetVal = obPoller.Stop();
+  printf("Stop: %d, still running: %s\n", nRetVal, obPoller.IsRunning() ? "yes" : "no");
+  PrintTelemetryStats(obPoller);
+
+  // Close RTD and heater Channels...
+  for (int nRTDs = 0; nRTDs < nRTDsOpened; nRTDs++)
+  {
+    nRetVal = obRTD[nRTDs].CloseHal();
+    if (nRetVal < 0)
+    {
+      printf("Error %d closing RTD Channel: %d\n", nRetVal, nRTDs + 1);
+    }
+  }
+
+  for (int nHtrs = 0; nHtrs < nHtrsOpened; nHtrs++)
+  {
+    nRetVal = obHtr[nHtrs].CloseHal();
+    if (nRetVal < 0)
+    {
+      printf("CHeaterCtrl[%d].Close() failed: %d\n", nHtrs + 1, nRetVal);
+    }
+  }
+}
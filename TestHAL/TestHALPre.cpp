@@ -5,12 +5,22 @@
 #include <signal.h>
 #include <stdarg.h>
 #include <sys/time.h>
+#include <sys/resource.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
 
 #include "AnalogIn.h"
 #include "HeaterCtrl.h"
 #include "SolenoidCtrl.h"
 #include "RTD.h"
 #include "PreampStream.h"
+#include "SpikeFilter.h"
+#include "PreampFrameSync.h"
+#include "SampleCodec.h"
+#include "PeakDetector.h"
+#include "NoiseStats.h"
+#include "PreampSimSource.h"
 #include "PreampProtocol.h"
 
 
@@ -663,6 +673,840 @@ int TestPreamp(int nPres)
   return 0;
 }
 
+#define FRAME_TEST_BATCH_SIZE     32
+
+// Read both channels of a preamp as time aligned frames
+int TestPreampFrames()
+{
+  static char szPreDevNames[NR_PRE_CHANNELS][50] = { 
+    "PREAMP_STR:SLOT_2:PREAMP_1",
+    "PREAMP_STR:SLOT_2:PREAMP_2",
+  };
+
+  static CPreampStream obPreampStr[NR_PRE_CHANNELS];
+  static PreampFrameStruct astFrames[FRAME_TEST_BATCH_SIZE];
+  CPreampFrameSync obFrames;
+  PreampFrameStatsStruct stStats;
+  int nRetVal = 0;
+
+  for (int nPres = 0; nPres < NR_PRE_CHANNELS; nPres++)
+  {
+    if (obPreampStr[nPres].OpenHal(szPreDevNames[nPres]) < 0)
+    {
+      printf("Error opening Preamp Channel: %d\n", nPres + 1);
+      return 0;
+    }
+    obFrames.AddDetector(&obPreampStr[nPres]);
+
+    // Let -m y follow the channels from another process
+    obPreampStr[nPres].SetShmBroadcast(TRUE);
+  }
+
+  // Both channels are on one board - start them with one command (Mode 1)
+  obPreampStr[1].SetAllChBroadcastMode(TRUE, TRUE);
+  if (obPreampStr[0].SetAllChBroadcastMode(TRUE, FALSE) < 0)
+  {
+    printf("Error enabling broadcast mode on the Preamp\n");
+    return 0;
+  }
+
+  while (g_nExitApp != 1)
+  {
+    nRetVal = obFrames.ReadFrames(astFrames, FRAME_TEST_BATCH_SIZE, 1000);
+    if (nRetVal < 0)
+    {
+      printf("CPreampFrameSync::ReadFrames() failed: %d\n", nRetVal);
+      break;
+    }
+
+    for (int nFrame = 0; nFrame < nRetVal; nFrame++)
+    {
+      printf("%llu", astFrames[nFrame].ullTimeStamp);
+      for (unsigned int unDet = 0; unDet < obFrames.GetNumDetectors(); unDet++)
+      {
+        printf(", %u%s", astFrames[nFrame].aunBridgeData[unDet],
+               (astFrames[nFrame].abyFlags[unDet] & PREAMP_FRAME_SAMPLE_MISSING) ? " (missing)" : "");
+      }
+      printf("\n");
+    }
+  }
+
+  obFrames.GetStats(&stStats);
+  printf("%lu frames, %lu samples missing, %lu samples dropped\n",
+         stStats.ulFrames, stStats.ulMissing, stStats.ulDropped);
+
+  obPreampStr[0].SetAllChBroadcastMode(FALSE, FALSE);
+  obPreampStr[1].SetAllChBroadcastMode(FALSE, TRUE);
+  for (int nPres = 0; nPres < NR_PRE_CHANNELS; nPres++)
+  {
+    obPreampStr[nPres].CloseHal();
+  }
+
+  return 0;
+}
+
+#define SHM_TEST_BATCH_SIZE       64
+
+// Follow a preamp channel published to shared memory by another process (-m a)
+int TestPreampShmReader(int nPres)
+{
+  static char szPreDevNames[NR_PRE_CHANNELS][50] = { 
+    "PREAMP_STR:SLOT_2:PREAMP_1",
+    "PREAMP_STR:SLOT_2:PREAMP_2",
+  };
+
+  PreampShmSampleStruct astSamples[SHM_TEST_BATCH_SIZE];
+  PreampShmReaderStatsStruct stStats;
+  CPreampShmReader obReader;
+
+  if ( (nPres < 0) || (nPres >= NR_PRE_CHANNELS) )
+  {
+    return -1;
+  }
+
+  while (g_nExitApp != 1 && obReader.Open(szPreDevNames[nPres]) < 0)
+  {
+    printf("Waiting for Preamp Channel %d to be published...\n", nPres + 1);
+    sleep(1);
+  }
+
+  while (g_nExitApp != 1)
+  {
+    int nRetVal = obReader.Read(astSamples, SHM_TEST_BATCH_SIZE);
+    for (int nSample = 0; nSample < nRetVal; nSample++)
+    {
+      printf("%llu, %u%s\n", astSamples[nSample].ullTimeStamp, astSamples[nSample].unBridgeData,
+             (astSamples[nSample].byFlags & PREAMP_SAMPLE_SPIKE_FIXED) ? " (spike fixed)" : "");
+    }
+
+    if (nRetVal < SHM_TEST_BATCH_SIZE)
+    {
+      usleep(100000);
+    }
+  }
+
+  obReader.GetStats(&stStats);
+  printf("%lu samples read, %lu overrun\n", stStats.ulRead, stStats.ulOverrun);
+
+  return 0;
+}
+
+#define PREAMP_BENCH_SECONDS      10
+#define PREAMP_BENCH_BATCH_SIZE   256
+
+// CPU time (user + system) used by this process, in micro-seconds
+static unsigned long long GetCPUTimeUs()
+{
+  struct rusage stUsage;
+  getrusage(RUSAGE_SELF, &stUsage);
+  return (stUsage.ru_utime.tv_sec + stUsage.ru_stime.tv_sec) * 1000000ULL +
+         stUsage.ru_utime.tv_usec + stUsage.ru_stime.tv_usec;
+}
+
+static unsigned long long GetWallTimeUs()
+{
+  struct timeval stNow;
+  gettimeofday(&stNow, NULL);
+  return stNow.tv_sec * 1000000ULL + stNow.tv_usec;
+}
+
+static void PrintBenchResult(const char *pszPath, unsigned long ulSamples,
+                             unsigned long long ullWallUs, unsigned long long ullCPUUs)
+{
+  printf("%-8s: %lu samples, %.1f samples/sec, %.2f us CPU/sample, %.0f samples/CPU-sec\n",
+         pszPath, ulSamples,
+         ullWallUs ? ulSamples * 1000000.0 / ullWallUs : 0.0,
+         ulSamples ? (double)ullCPUUs / ulSamples : 0.0,
+         ullCPUUs ? ulSamples * 1000000.0 / ullCPUUs : 0.0);
+}
+
+// Compare the CPU cost of reading preamp samples one at a time against batch reads
+int BenchmarkPreamp(int nPres)
+{
+  static char szPreDevNames[NR_PRE_CHANNELS][50] = { 
+    "PREAMP_STR:SLOT_2:PREAMP_1",
+    "PREAMP_STR:SLOT_2:PREAMP_2",
+  };
+
+  CPreampStream obPreampStr;
+  static unsigned int aunBridgeData[PREAMP_BENCH_BATCH_SIZE];
+  static unsigned long long aullTS[PREAMP_BENCH_BATCH_SIZE];
+  static unsigned char abyFlags[PREAMP_BENCH_BATCH_SIZE];
+  unsigned long ulSamples = 0;
+  unsigned long long ullStartWall, ullStartCPU, ullEndWall;
+  int nRetVal = 0;
+
+  if ( (nPres < 0) || (nPres >= NR_PRE_CHANNELS) )
+  {
+    return -1;
+  }
+
+  if (obPreampStr.OpenHal(szPreDevNames[nPres]) < 0 ||
+      obPreampStr.SetBroadcastMode(TRUE) < 0)
+  {
+    printf("Error opening / starting Preamp Channel: %d\n", nPres + 1);
+    return 0;
+  }
+
+  printf("Benchmarking Preamp %d, %d seconds per read path...\n", nPres + 1, PREAMP_BENCH_SECONDS);
+
+  // Single sample reads
+  ullStartWall = GetWallTimeUs();
+  ullStartCPU = GetCPUTimeUs();
+  ullEndWall = ullStartWall + PREAMP_BENCH_SECONDS * 1000000ULL;
+  while (GetWallTimeUs() < ullEndWall && g_nExitApp != 1)
+  {
+    nRetVal = obPreampStr.ReadStreamData(&aunBridgeData[0], &aullTS[0], 1000);
+    if (nRetVal == ERR_SUCCESS)
+    {
+      ulSamples++;
+    }
+  }
+  PrintBenchResult("Single", ulSamples, GetWallTimeUs() - ullStartWall, GetCPUTimeUs() - ullStartCPU);
+
+  // Batch reads
+  ulSamples = 0;
+  ullStartWall = GetWallTimeUs();
+  ullStartCPU = GetCPUTimeUs();
+  ullEndWall = ullStartWall + PREAMP_BENCH_SECONDS * 1000000ULL;
+  while (GetWallTimeUs() < ullEndWall && g_nExitApp != 1)
+  {
+    nRetVal = obPreampStr.ReadStreamDataBatch(aunBridgeData, aullTS, abyFlags, PREAMP_BENCH_BATCH_SIZE, 100);
+    if (nRetVal > 0)
+    {
+      ulSamples += nRetVal;
+    }
+  }
+  PrintBenchResult("Batch", ulSamples, GetWallTimeUs() - ullStartWall, GetCPUTimeUs() - ullStartCPU);
+
+  PreampStreamStatsStruct stStats;
+  if (obPreampStr.GetStreamStats(&stStats) == ERR_SUCCESS)
+  {
+    printf("Stream  : %lu samples, %lu duplicates, %lu gaps (%lu samples missing), %lu out of order\n",
+           stStats.ulSamples, stStats.ulDuplicates, stStats.ulGaps, stStats.ulMissing, stStats.ulReordered);
+  }
+
+  obPreampStr.SetBroadcastMode(FALSE);
+  obPreampStr.CloseHal();
+
+  return 0;
+}
+
+
+#define FILT_BENCH_SAMPLES        1000000
+#define FILT_BENCH_SPIKE_EVERY    5000
+
+// The spike filter as CPreampStream had it before CSpikeFilter (std::vector, erase of
+// the oldest sample), kept here as the reference for output and cost
+class CLegacySpikeFilter {
+private:
+  std::vector <SpikeFiltSampleStruct> m_vstData;
+
+public:
+  BOOL Push(const SpikeFiltSampleStruct &stIn, SpikeFiltSampleStruct *pstOut)
+  {
+    m_vstData.push_back(stIn);
+    if (m_vstData.size() < 3)
+    {
+      return FALSE;
+    }
+
+    int nSlope1 = m_vstData[1].nBridgeVal - m_vstData[0].nBridgeVal;
+    int nSlope2 = m_vstData[2].nBridgeVal - m_vstData[1].nBridgeVal;
+    if ( ( abs (nSlope1) >= SPIKE_FILT_DFLT_SLOPE_THRESHOLD && abs (nSlope2) >= SPIKE_FILT_DFLT_SLOPE_THRESHOLD) &&
+         ( (nSlope1 < 0 && nSlope2 > 0) || (nSlope1 > 0 && nSlope2 < 0) ) )
+    {
+      m_vstData[1].nBridgeVal = (m_vstData[0].nBridgeVal + m_vstData[2].nBridgeVal) / 2;
+      m_vstData[1].byFlags |= PREAMP_SAMPLE_SPIKE_FIXED;
+    }
+
+    *pstOut = m_vstData[0];
+    m_vstData.erase(m_vstData.begin());
+    return TRUE;
+  }
+};
+
+static int g_anFiltIn[FILT_BENCH_SAMPLES];
+
+// Synthetic chromatogram - baseline with noise, a peak every 20000 samples and
+// single point spikes
+static void MakeTestChromatogram(int *pnSamples, unsigned int unNumSamples)
+{
+  srand(1);
+  for (unsigned int unSample = 0; unSample < unNumSamples; unSample++)
+  {
+    int nPos = (int)(unSample % 20000) - 10000;
+    int nVal = 1000000 + (rand() % 201) - 100;
+    if (nPos > -2000 && nPos < 2000)
+    {
+      nVal += (4000000 - nPos * nPos) / 2;
+    }
+    if ((unSample % FILT_BENCH_SPIKE_EVERY) == FILT_BENCH_SPIKE_EVERY / 2)
+    {
+      nVal += (unSample & 1) ? 500000 : -500000;
+    }
+    pnSamples[unSample] = nVal;
+  }
+}
+static int g_anFiltRef[FILT_BENCH_SAMPLES];
+static int g_anFiltOut[FILT_BENCH_SAMPLES];
+
+// Run a filter over the test signal. Returns the CPU time used and the number of
+// samples fixed.
+template <typename TFilter>
+static unsigned long long RunSpikeFilter(TFilter &obFilter, int *pnOut, unsigned long *pulFixed)
+{
+  SpikeFiltSampleStruct stIn, stOut;
+  unsigned int unOut = 0;
+  unsigned long long ullStartCPU = GetCPUTimeUs();
+
+  *pulFixed = 0;
+  for (unsigned int unSample = 0; unSample < FILT_BENCH_SAMPLES; unSample++)
+  {
+    stIn.nBridgeVal = g_anFiltIn[unSample];
+    stIn.ullTimestamp = unSample;
+    stIn.byFlags = 0;
+    if (obFilter.Push(stIn, &stOut))
+    {
+      pnOut[unOut++] = stOut.nBridgeVal;
+      if (stOut.byFlags & PREAMP_SAMPLE_SPIKE_FIXED)
+      {
+        (*pulFixed)++;
+      }
+    }
+  }
+
+  return GetCPUTimeUs() - ullStartCPU;
+}
+
+static void PrintFiltResult(const char *pszFilter, unsigned long long ullCPUUs, unsigned long ulFixed)
+{
+  printf("%-12s: %.1f ns/sample, %lu samples fixed\n", pszFilter,
+         ullCPUUs * 1000.0 / FILT_BENCH_SAMPLES, ulFixed);
+}
+
+// Check CSpikeFilter against the original spike filter and compare the cost per
+// sample of the filter types, on a synthetic chromatogram (no hardware needed)
+int BenchmarkSpikeFilter()
+{
+  static const struct {
+    const char *pszName;
+    SPIKE_FILT_TYPE_ENUM eType;
+    unsigned int unWindow;
+    int nThreshold;
+  } astFilters[] = {
+    { "Slope 3",   SPIKE_FILT_SLOPE,  3, SPIKE_FILT_DFLT_SLOPE_THRESHOLD },
+    { "Median 5",  SPIKE_FILT_MEDIAN, 5, 0 },
+    { "Median 9",  SPIKE_FILT_MEDIAN, 9, 0 },
+    { "Hampel 5",  SPIKE_FILT_HAMPEL, 5, SPIKE_FILT_DFLT_HAMPEL_THRESHOLD },
+    { "Hampel 9",  SPIKE_FILT_HAMPEL, 9, SPIKE_FILT_DFLT_HAMPEL_THRESHOLD },
+  };
+  unsigned long ulFixed = 0;
+  unsigned long long ullCPUUs = 0;
+
+  MakeTestChromatogram(g_anFiltIn, FILT_BENCH_SAMPLES);
+
+  CLegacySpikeFilter obLegacy;
+  ullCPUUs = RunSpikeFilter(obLegacy, g_anFiltRef, &ulFixed);
+  PrintFiltResult("Original", ullCPUUs, ulFixed);
+
+  for (unsigned int unFilt = 0; unFilt < sizeof (astFilters) / sizeof (astFilters[0]); unFilt++)
+  {
+    CSpikeFilter obFilter("bench");
+    if (obFilter.Configure(astFilters[unFilt].eType, astFilters[unFilt].unWindow, astFilters[unFilt].nThreshold) < 0)
+    {
+      printf("%-12s: invalid configuration\n", astFilters[unFilt].pszName);
+      continue;
+    }
+    ullCPUUs = RunSpikeFilter(obFilter, g_anFiltOut, &ulFixed);
+    PrintFiltResult(astFilters[unFilt].pszName, ullCPUUs, ulFixed);
+
+    // Window 3 slope filter must match the original sample for sample
+    if (SPIKE_FILT_SLOPE == astFilters[unFilt].eType)
+    {
+      unsigned long ulMismatch = 0;
+      for (unsigned int unSample = 0; unSample < FILT_BENCH_SAMPLES - 2; unSample++)
+      {
+        if (g_anFiltOut[unSample] != g_anFiltRef[unSample])
+        {
+          ulMismatch++;
+        }
+      }
+      printf("%-12s: %lu samples differ from the original filter\n", astFilters[unFilt].pszName, ulMismatch);
+    }
+  }
+
+  return 0;
+}
+
+
+#define CODEC_MAX_SAMPLES         FILT_BENCH_SAMPLES
+#define CODEC_BLOCK_SAMPLES       1024
+
+static unsigned char g_abyCodecBuf[SAMPLE_CODEC_MAX_ENCODED_SIZE(CODEC_MAX_SAMPLES)];
+
+// Read the values of a simulator sample file ("<time> <value>" per line). Returns the
+// number of samples, or -1 if the file cannot be opened.
+static int LoadSampleFile(const char *pszFile, int *pnSamples, unsigned int unMaxSamples,
+                          unsigned long *pulTextBytes)
+{
+  char szLine[200];
+  unsigned int unNumSamples = 0;
+
+  *pulTextBytes = 0;
+  FILE *pFile = fopen(pszFile, "r");
+  if (NULL == pFile)
+  {
+    printf("Cannot open %s\n", pszFile);
+    return -1;
+  }
+  while (unNumSamples < unMaxSamples && fgets(szLine, sizeof (szLine), pFile))
+  {
+    int nTs = 0, nValue = 0;
+    *pulTextBytes += strlen(szLine);
+    if (sscanf(szLine, "%d %d", &nTs, &nValue) == 2)
+    {
+      pnSamples[unNumSamples++] = nValue;
+    }
+  }
+  fclose(pFile);
+
+  return unNumSamples;
+}
+
+// Compression ratio and speed of the sample codec on a simulator sample file ("<time>
+// <value>" per line), or on a synthetic chromatogram if no file is given
+int ReportSampleCodec(const char *pszFile)
+{
+  static const struct {
+    const char *pszName;
+    SAMPLE_CODEC_PREDICTOR_ENUM ePredictor;
+  } astPredictors[] = {
+    { "Delta",   SAMPLE_CODEC_DELTA1 },
+    { "Delta 2", SAMPLE_CODEC_DELTA2 },
+  };
+  unsigned int unNumSamples = 0;
+  unsigned long ulTextBytes = 0;
+
+  if (pszFile)
+  {
+    int nNumSamples = LoadSampleFile(pszFile, g_anFiltIn, CODEC_MAX_SAMPLES, &ulTextBytes);
+    if (nNumSamples < 0)
+    {
+      return -1;
+    }
+    unNumSamples = nNumSamples;
+    printf("%s: %u samples, %lu bytes as text\n", pszFile, unNumSamples, ulTextBytes);
+  }
+  else
+  {
+    unNumSamples = CODEC_MAX_SAMPLES;
+    MakeTestChromatogram(g_anFiltIn, unNumSamples);
+    printf("Synthetic chromatogram: %u samples\n", unNumSamples);
+  }
+
+  if (0 == unNumSamples)
+  {
+    return 0;
+  }
+
+  for (unsigned int unPred = 0; unPred < sizeof (astPredictors) / sizeof (astPredictors[0]); unPred++)
+  {
+    CSampleEncoder obEncoder(astPredictors[unPred].ePredictor);
+    CSampleDecoder obDecoder(astPredictors[unPred].ePredictor);
+    unsigned int unEncoded = 0;
+    unsigned int unDecoded = 0;
+    unsigned int unPos = 0;
+    unsigned long ulMismatch = 0;
+
+    // Encode in blocks, as a stream would be
+    unsigned long long ullStartCPU = GetCPUTimeUs();
+    for (unsigned int unSample = 0; unSample < unNumSamples; unSample += CODEC_BLOCK_SAMPLES)
+    {
+      unsigned int unBlock = unNumSamples - unSample;
+      if (unBlock > CODEC_BLOCK_SAMPLES)
+      {
+        unBlock = CODEC_BLOCK_SAMPLES;
+      }
+      unEncoded += obEncoder.Encode(&g_anFiltIn[unSample], unBlock, &g_abyCodecBuf[unEncoded],
+                                    sizeof (g_abyCodecBuf) - unEncoded);
+    }
+    unsigned long long ullEncodeUs = GetCPUTimeUs() - ullStartCPU;
+
+    ullStartCPU = GetCPUTimeUs();
+    while (unDecoded < unNumSamples)
+    {
+      unsigned int unUsed = 0;
+      int nRetVal = obDecoder.Decode(&g_abyCodecBuf[unPos], unEncoded - unPos, &g_anFiltOut[unDecoded],
+                                     unNumSamples - unDecoded, &unUsed);
+      if (nRetVal <= 0)
+      {
+        break;
+      }
+      unDecoded += nRetVal;
+      unPos += unUsed;
+    }
+    unsigned long long ullDecodeUs = GetCPUTimeUs() - ullStartCPU;
+
+    for (unsigned int unSample = 0; unSample < unNumSamples; unSample++)
+    {
+      if (unSample >= unDecoded || g_anFiltOut[unSample] != g_anFiltIn[unSample])
+      {
+        ulMismatch++;
+      }
+    }
+
+    printf("%-8s: %u bytes, %.2f bytes/sample, ratio %.2f vs 32 bit", astPredictors[unPred].pszName,
+           unEncoded, (double) unEncoded / unNumSamples, 4.0 * unNumSamples / unEncoded);
+    if (ulTextBytes)
+    {
+      printf(", %.2f vs text", (double) ulTextBytes / unEncoded);
+    }
+    printf("\n          encode %.1f ns/sample, decode %.1f ns/sample, %lu samples differ\n",
+           ullEncodeUs * 1000.0 / unNumSamples, ullDecodeUs * 1000.0 / unNumSamples, ulMismatch);
+  }
+
+  return 0;
+}
+
+
+#define PEAK_CHECK_PERIOD_MS      20
+#define PEAK_CHECK_TOLERANCE_PCT  5     // Missed or extra peaks allowed, in % of the reference peaks
+
+struct RefPeakStruct {
+  unsigned int unApex;      // Sample number of the top
+  unsigned int unWidth;     // Samples at half the prominence
+};
+
+// Peaks of a whole chromatogram found offline, as the reference for CPeakDetector -
+// the tops of the moving average (over the slope window) that stand out at least
+// nMinHeight above the higher of the valleys on either side (prominence)
+static void FindPeaksOffline(const int *pnSamples, unsigned int unNumSamples,
+                             const PeakDetectConfigStruct &stConfig, std::vector<RefPeakStruct> *pvstPeaks)
+{
+  std::vector<int> vnSmooth(unNumSamples);
+  unsigned int unHalf = stConfig.unSlopeWindow / 2;
+  long long llSum = 0;
+  unsigned int unFrom = 0, unTo = 0;
+
+  for (unsigned int unSample = 0; unSample < unNumSamples; unSample++)
+  {
+    unsigned int unLast = (unSample + unHalf < unNumSamples) ? unSample + unHalf : unNumSamples - 1;
+    while (unTo <= unLast)
+    {
+      llSum += pnSamples[unTo++];
+    }
+    while (unFrom + unHalf < unSample)
+    {
+      llSum -= pnSamples[unFrom++];
+    }
+    vnSmooth[unSample] = (int) (llSum / (long long) (unTo - unFrom));
+  }
+
+  pvstPeaks->clear();
+  for (unsigned int unSample = 1; unSample + 1 < unNumSamples; unSample++)
+  {
+    int nTop = vnSmooth[unSample];
+    if (nTop <= vnSmooth[unSample - 1] || nTop < vnSmooth[unSample + 1])
+    {
+      continue;
+    }
+
+    // Lowest point on each side before a higher top
+    int nLeft = nTop;
+    for (unsigned int unPos = unSample; unPos > 0 && vnSmooth[unPos - 1] <= nTop; unPos--)
+    {
+      nLeft = (vnSmooth[unPos - 1] < nLeft) ? vnSmooth[unPos - 1] : nLeft;
+    }
+    int nRight = nTop;
+    for (unsigned int unPos = unSample + 1; unPos < unNumSamples && vnSmooth[unPos] <= nTop; unPos++)
+    {
+      nRight = (vnSmooth[unPos] < nRight) ? vnSmooth[unPos] : nRight;
+    }
+
+    int nProminence = nTop - ((nLeft > nRight) ? nLeft : nRight);
+    if (nProminence >= stConfig.nMinHeight)
+    {
+      RefPeakStruct stPeak;
+      unsigned int unFrom = unSample, unTo = unSample;
+      while (unFrom > 0 && vnSmooth[unFrom - 1] > nTop - nProminence / 2)
+      {
+        unFrom--;
+      }
+      while (unTo + 1 < unNumSamples && vnSmooth[unTo + 1] > nTop - nProminence / 2)
+      {
+        unTo++;
+      }
+      stPeak.unApex = unSample;
+      stPeak.unWidth = unTo - unFrom + 1;
+      pvstPeaks->push_back(stPeak);
+    }
+  }
+}
+
+// Check the streaming peak detector against the offline reference, on a simulator
+// sample file or on a synthetic chromatogram with known peaks (narrow, broad, small
+// and a fused pair), and measure its cost per sample. No hardware needed.
+int CheckPeakDetector(const char *pszFile)
+{
+  PeakDetectConfigStruct stConfig = { 10, 600, 3, 5000, 4 };
+  unsigned int unNumSamples = 0;
+
+  if (pszFile)
+  {
+    unsigned long ulTextBytes = 0;
+    int nNumSamples = LoadSampleFile(pszFile, g_anFiltIn, FILT_BENCH_SAMPLES, &ulTextBytes);
+    if (nNumSamples < 0)
+    {
+      return -1;
+    }
+    unNumSamples = nNumSamples;
+    printf("%s: %u samples\n", pszFile, unNumSamples);
+  }
+  else
+  {
+    static const PreampSynthPeakStruct astPeaks[] = {
+      {  30000,  400, 200000 },
+      {  60000, 1000, 150000 },   // Fused pair
+      {  63000, 1000, 120000 },
+      { 120000, 2500,  80000 },
+      { 200000,  300,  30000 },
+      { 250000, 5000,  60000 },
+      { 280000,  200,   3000 },   // Below the minimum height
+    };
+    PreampSynthStruct stSynth;
+    CPreampSynth obSynth;
+
+    memset(&stSynth, 0, sizeof (stSynth));
+    stSynth.nBaseline = 1000000;
+    stSynth.unNoise = 300;
+    stSynth.unCycleMs = 300000;
+    stSynth.unPeriodMs = PEAK_CHECK_PERIOD_MS;
+    stSynth.unNumPeaks = sizeof (astPeaks) / sizeof (astPeaks[0]);
+    memcpy(stSynth.astPeaks, astPeaks, sizeof (astPeaks));
+    if (obSynth.Configure(stSynth) < 0)
+    {
+      printf("Invalid synthetic chromatogram\n");
+      return -1;
+    }
+
+    unNumSamples = FILT_BENCH_SAMPLES;
+    for (unsigned int unSample = 0; unSample < unNumSamples; unSample++)
+    {
+      // Slow baseline drift on top
+      g_anFiltIn[unSample] = obSynth.Next() + (int) (unSample / 20);
+    }
+    printf("Synthetic chromatogram: %u samples, %u cycles of %u peaks\n", unNumSamples,
+           unNumSamples * PEAK_CHECK_PERIOD_MS / stSynth.unCycleMs, stSynth.unNumPeaks);
+  }
+
+  std::vector<RefPeakStruct> vstRef;
+  FindPeaksOffline(g_anFiltIn, unNumSamples, stConfig, &vstRef);
+
+  // Time stamps are sample numbers, so that the events index the samples
+  CPeakDetector obDetector;
+  obDetector.Configure(stConfig);
+  std::vector<unsigned int> vunApex;
+  unsigned long ulStarts = 0, ulEnds = 0;
+  PeakEventStruct astEvents[PEAK_DET_EVENT_QUEUE_LEN];
+  unsigned long long ullPushUs = 0;
+
+  for (unsigned int unSample = 0; unSample < unNumSamples; unSample += PEAK_DET_EVENT_QUEUE_LEN)
+  {
+    unsigned int unEnd = unSample + PEAK_DET_EVENT_QUEUE_LEN;
+    unEnd = (unEnd < unNumSamples) ? unEnd : unNumSamples;
+
+    unsigned long long ullStartCPU = GetCPUTimeUs();
+    for (unsigned int unPos = unSample; unPos < unEnd; unPos++)
+    {
+      obDetector.Push(g_anFiltIn[unPos], unPos);
+    }
+    ullPushUs += GetCPUTimeUs() - ullStartCPU;
+
+    unsigned int unNumEvents = obDetector.ReadEvents(astEvents, PEAK_DET_EVENT_QUEUE_LEN);
+    for (unsigned int unEvent = 0; unEvent < unNumEvents; unEvent++)
+    {
+      switch (astEvents[unEvent].eEvent)
+      {
+      case PEAK_EVENT_START:
+        ulStarts++;
+        break;
+      case PEAK_EVENT_APEX:
+        vunApex.push_back((unsigned int) astEvents[unEvent].ullTimeStamp);
+        break;
+      case PEAK_EVENT_END:
+        ulEnds++;
+        break;
+      }
+    }
+  }
+
+  // Match the tops, within the slope window or a tenth of the peak width
+  unsigned int unMatched = 0;
+  unsigned int unApex = 0;
+  unsigned long ulOffset = 0;
+  for (unsigned int unRef = 0; unRef < vstRef.size(); unRef++)
+  {
+    unsigned int unRefApex = vstRef[unRef].unApex;
+    unsigned int unTolerance = vstRef[unRef].unWidth / 10;
+    unTolerance = (unTolerance > stConfig.unSlopeWindow) ? unTolerance : stConfig.unSlopeWindow;
+
+    while (unApex < vunApex.size() && vunApex[unApex] + unTolerance < unRefApex)
+    {
+      unApex++;
+    }
+    if (unApex < vunApex.size() && vunApex[unApex] <= unRefApex + unTolerance)
+    {
+      ulOffset += abs((int) vunApex[unApex] - (int) unRefApex);
+      unMatched++;
+      unApex++;
+    }
+  }
+
+  printf("Reference: %u peaks. Detector: %u apex, %lu start, %lu end events\n",
+         (unsigned int) vstRef.size(), (unsigned int) vunApex.size(), ulStarts, ulEnds);
+  printf("Matched %u (apex %.1f samples off on average), missed %u, extra %u. %.1f ns/sample\n",
+         unMatched, unMatched ? (double) ulOffset / unMatched : 0.0, (unsigned int) vstRef.size() - unMatched,
+         (unsigned int) vunApex.size() - unMatched, ullPushUs * 1000.0 / unNumSamples);
+
+  // Rounded down, so a short run with few peaks must find all of them
+  unsigned int unMaxOff = (unsigned int) vstRef.size() * PEAK_CHECK_TOLERANCE_PCT / 100;
+  if (vstRef.size() - unMatched > unMaxOff || vunApex.size() - unMatched > unMaxOff)
+  {
+    printf("FAIL: more than %u missed or extra peaks (%d%% of the reference)\n", unMaxOff, PEAK_CHECK_TOLERANCE_PCT);
+    return 1;
+  }
+  printf("PASS: at most %u missed or extra peaks (%d%% of the reference)\n", unMaxOff, PEAK_CHECK_TOLERANCE_PCT);
+
+  return 0;
+}
+
+
+#define NOISE_CHECK_PERIOD_MS     20
+
+// Figures of samples [unFirst, unFirst + unNumSamples) the usual (two pass) way, as the
+// reference for CNoiseStats
+static void NoiseStatsOffline(const int *pnSamples, unsigned int unFirst, unsigned int unNumSamples,
+                              NoiseStatsStruct *pstStats)
+{
+  double dSum = 0.0, dTimeSum = 0.0;
+  int nMin = pnSamples[unFirst], nMax = pnSamples[unFirst];
+
+  for (unsigned int unSample = unFirst; unSample < unFirst + unNumSamples; unSample++)
+  {
+    dSum += pnSamples[unSample];
+    dTimeSum += unSample * NOISE_CHECK_PERIOD_MS / 1000.0;
+    nMin = (pnSamples[unSample] < nMin) ? pnSamples[unSample] : nMin;
+    nMax = (pnSamples[unSample] > nMax) ? pnSamples[unSample] : nMax;
+  }
+  double dMean = dSum / unNumSamples;
+  double dTimeMean = dTimeSum / unNumSamples;
+
+  double dSq = 0.0, dTimeSq = 0.0, dCo = 0.0;
+  for (unsigned int unSample = unFirst; unSample < unFirst + unNumSamples; unSample++)
+  {
+    double dDiff = pnSamples[unSample] - dMean;
+    double dTimeDiff = unSample * NOISE_CHECK_PERIOD_MS / 1000.0 - dTimeMean;
+    dSq += dDiff * dDiff;
+    dTimeSq += dTimeDiff * dTimeDiff;
+    dCo += dTimeDiff * dDiff;
+  }
+
+  memset(pstStats, 0, sizeof (*pstStats));
+  pstStats->ulSamples = unNumSamples;
+  pstStats->dMean = dMean;
+  pstStats->dStdDev = (unNumSamples > 1) ? sqrt(dSq / (unNumSamples - 1)) : 0.0;
+  pstStats->nMin = nMin;
+  pstStats->nMax = nMax;
+  pstStats->nPeakToPeak = nMax - nMin;
+  pstStats->dDrift = (dTimeSq > 0.0) ? dCo / dTimeSq : 0.0;
+}
+
+// Check the running noise and drift figures against the two pass reference, on a
+// simulator sample file or on a synthetic noisy, drifting baseline, and measure their
+// cost per sample. No hardware needed.
+int CheckNoiseStats(const char *pszFile)
+{
+  NoiseStatsConfigStruct stConfig = { 3, { 500, NOISE_STATS_DFLT_WINDOW, 0 } };
+  unsigned int unNumSamples = 0;
+
+  if (pszFile)
+  {
+    unsigned long ulTextBytes = 0;
+    int nNumSamples = LoadSampleFile(pszFile, g_anFiltIn, FILT_BENCH_SAMPLES, &ulTextBytes);
+    if (nNumSamples <= 0)
+    {
+      return -1;
+    }
+    unNumSamples = nNumSamples;
+    printf("%s: %u samples\n", pszFile, unNumSamples);
+  }
+  else
+  {
+    PreampSynthStruct stSynth;
+    CPreampSynth obSynth;
+
+    memset(&stSynth, 0, sizeof (stSynth));
+    stSynth.nBaseline = 1000000;
+    stSynth.unNoise = 300;
+    stSynth.unCycleMs = 60000;
+    stSynth.unPeriodMs = NOISE_CHECK_PERIOD_MS;
+    obSynth.Configure(stSynth);
+
+    unNumSamples = FILT_BENCH_SAMPLES;
+    for (unsigned int unSample = 0; unSample < unNumSamples; unSample++)
+    {
+      // Drift of 2.5 counts/s
+      g_anFiltIn[unSample] = obSynth.Next() + (int) (unSample / 20);
+    }
+    printf("Synthetic baseline: %u samples, noise 300, drift 2.5 counts/s\n", unNumSamples);
+  }
+
+  CNoiseStats obStats;
+  obStats.Configure(stConfig);
+
+  unsigned long long ullStartCPU = GetCPUTimeUs();
+  for (unsigned int unSample = 0; unSample < unNumSamples; unSample++)
+  {
+    obStats.Push(g_anFiltIn[unSample], (unsigned long long) unSample * NOISE_CHECK_PERIOD_MS);
+  }
+  unsigned long long ullPushUs = GetCPUTimeUs() - ullStartCPU;
+
+  for (unsigned int unWindow = 0; unWindow < stConfig.unNumWindows; unWindow++)
+  {
+    unsigned int unWindowSamples = stConfig.aunWindowSamples[unWindow];
+    NoiseStatsStruct stOnline, stRef;
+
+    // Last complete window, or everything for a window that never ends
+    if (unWindowSamples)
+    {
+      if (unNumSamples < unWindowSamples)
+      {
+        continue;
+      }
+      obStats.GetStats(unWindow, NULL, &stOnline);
+      NoiseStatsOffline(g_anFiltIn, (unNumSamples / unWindowSamples - 1) * unWindowSamples, unWindowSamples, &stRef);
+    }
+    else
+    {
+      obStats.GetStats(unWindow, &stOnline, NULL);
+      NoiseStatsOffline(g_anFiltIn, 0, unNumSamples, &stRef);
+    }
+
+    printf("Window %u (%u samples): mean %.1f, std dev %.2f, p-p %d, drift %.3f counts/s\n", unWindow,
+           unWindowSamples, stOnline.dMean, stOnline.dStdDev, stOnline.nPeakToPeak, stOnline.dDrift);
+    printf("  vs two pass: mean %.2g, std dev %.2g, drift %.2g counts/s off, %s\n",
+           fabs(stOnline.dMean - stRef.dMean), fabs(stOnline.dStdDev - stRef.dStdDev),
+           fabs(stOnline.dDrift - stRef.dDrift),
+           (stOnline.ulSamples == stRef.ulSamples && stOnline.nMin == stRef.nMin && stOnline.nMax == stRef.nMax) ?
+           "count / min / max same" : "count / min / max DIFFER");
+  }
+
+  printf("%.1f ns/sample for %u windows\n", ullPushUs * 1000.0 / unNumSamples, stConfig.unNumWindows);
+
+  return 0;
+}
+
 
 void PrintHelp()
 {
@@ -674,22 +1518,38 @@ void PrintHelp()
   printf("  t: Test RTD\n");
   printf("  h: Test Heater Control\n");
   printf("  p: Test Preamp - streaming\n");
+  printf("  b: Benchmark Preamp - single sample vs batch reads\n");
+  printf("  f: Benchmark spike filters - cost per sample (no hardware needed)\n");
+  printf("  a: Test Preamp - both channels as time aligned frames\n");
+  printf("  y: Follow a Preamp channel published by -m a in another process\n");
+  printf("  z: Sample codec - compression ratio of a sample file (-f), no hardware needed\n");
+  printf("  k: Peak detector - check against an offline reference (-f file), no hardware needed\n");
+  printf("  q: Noise statistics - check against a two pass computation (-f file), no hardware needed\n");
   printf("<value> (Optional):\n");
-  printf("  Channel No.:  0 to 1 when 'app_mode' is p\n");
+  printf("  Channel No.:  0 to 1 when 'app_mode' is p, b or y\n");
   printf("  Time interval: In milliseconds, b/n RTD channel reads when 'app_mode' is t\n");
   printf("  Not valid for other modes.\n");
+  printf("-f <file> (Optional): Simulator sample file when 'app_mode' is z, k or q\n");
 }
 
 #define APP_MODE_SOL    0
 #define APP_MODE_RTD    1
 #define APP_MODE_HTR    2
 #define APP_MODE_PREAMP 3
+#define APP_MODE_PREAMP_BENCH 4
+#define APP_MODE_FILT_BENCH   5
+#define APP_MODE_PREAMP_FRAMES 6
+#define APP_MODE_CODEC_REPORT  7
+#define APP_MODE_SHM_READER    8
+#define APP_MODE_PEAK_CHECK    9
+#define APP_MODE_NOISE_CHECK   10
 
 
 int main (int argc, char *argv[])
 {
   int optVal = 0;
   int appMode = 0;
+  const char *pszSampleFile = NULL;
 
   //char szDevName[] = "ANA_IN:SLOT_1:ANA_IN_1";
   //TestAnalogInput (szDevName);
@@ -705,7 +1565,7 @@ int main (int argc, char *argv[])
 
   while (argv[optind] != NULL)
   {
-    optVal = getopt(argc, argv, "m:n:v");
+    optVal = getopt(argc, argv, "m:n:vf:");
 
     switch(optVal)
     {
@@ -736,6 +1596,34 @@ int main (int argc, char *argv[])
           appMode = APP_MODE_PREAMP;
           break;
 
+        case 'b':
+          appMode = APP_MODE_PREAMP_BENCH;
+          break;
+
+        case 'f':
+          appMode = APP_MODE_FILT_BENCH;
+          break;
+
+        case 'a':
+          appMode = APP_MODE_PREAMP_FRAMES;
+          break;
+
+        case 'z':
+          appMode = APP_MODE_CODEC_REPORT;
+          break;
+
+        case 'y':
+          appMode = APP_MODE_SHM_READER;
+          break;
+
+        case 'k':
+          appMode = APP_MODE_PEAK_CHECK;
+          break;
+
+        case 'q':
+          appMode = APP_MODE_NOISE_CHECK;
+          break;
+
         default:
           printf("Not a valid mode.\n");
           PrintHelp();
@@ -766,6 +1654,10 @@ int main (int argc, char *argv[])
       g_nVerbose = 1;
       break;
 
+    case 'f':
+      pszSampleFile = optarg;
+      break;
+
     default:
       printf("Improper usage\n");
       PrintHelp();
@@ -779,6 +1671,8 @@ int main (int argc, char *argv[])
     printf("Failed to install signal handler.\n");
   }
                 
+  int nRetVal = 0;
+
   switch(appMode)
   {
   case APP_MODE_SOL:
@@ -799,9 +1693,43 @@ int main (int argc, char *argv[])
       DEBUG("Invalid channel number.\n");
     }
     break;
+
+  case APP_MODE_PREAMP_BENCH:
+    if (BenchmarkPreamp(nIndex) < 0)
+    {
+      printf("Invalid channel number.\n");
+    }
+    break;
+
+  case APP_MODE_FILT_BENCH:
+    BenchmarkSpikeFilter();
+    break;
+
+  case APP_MODE_PREAMP_FRAMES:
+    TestPreampFrames();
+    break;
+
+  case APP_MODE_CODEC_REPORT:
+    ReportSampleCodec(pszSampleFile);
+    break;
+
+  case APP_MODE_SHM_READER:
+    if (TestPreampShmReader(nIndex) < 0)
+    {
+      printf("Invalid channel number.\n");
+    }
+    break;
+
+  case APP_MODE_PEAK_CHECK:
+    nRetVal = CheckPeakDetector(pszSampleFile);
+    break;
+
+  case APP_MODE_NOISE_CHECK:
+    CheckNoiseStats(pszSampleFile);
+    break;
   }
 
-  return 0;
+  return (nRetVal ? EXIT_FAILURE : 0);
   
 }
 
@@ -0,0 +1,193 @@
+// TestWireFormat.cpp - round trip check of the byte order descriptors in WireLayouts.h
+//
+// Runs on the PC with the big endian conversion forced, so the swapping the PPC
+// target does is checked on x86. Each structure starts as the bytes a big endian
+// host would hold, with every listed multi-byte field set to a distinct value and
+// all other bytes to a pattern. HostToWire() must give the little endian wire
+// bytes of the protocol (fields byte reversed, everything else unchanged) and
+// WireToHost() must give the host bytes back.
+//
+// The fields are listed here again from the protocol headers, not taken from the
+// descriptors, so a field missing from a descriptor (or listed twice) fails.
+//
+// No hardware and no HAL library needed - exits non-zero if a structure fails.
+
+#define WIRE_HOST_BIG_ENDIAN  1
+
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "WireLayouts.h"
+
+struct WireFieldStruct {
+  unsigned int unOffset;    // Byte offset in the structure
+  unsigned int unSize;      // Bytes, swapped as one value
+};
+
+#define WIRE_TEST_FIELD(type, field)  { offsetof(type, field), sizeof (((type *) 0)->field) }
+#define WIRE_TEST_NUM_FIELDS(array)   (sizeof (array) / sizeof (array[0]))
+
+// Print the bytes of a structure, 16 per line
+static void DumpBytes(const char *pszLabel, const unsigned char *pbyData, unsigned int unSize)
+{
+  printf("  %s:", pszLabel);
+  for (unsigned int unByte = 0; unByte < unSize; unByte++)
+  {
+    printf("%s%02x", (unByte % 16) ? " " : "\n    ", pbyData[unByte]);
+  }
+  printf("\n");
+}
+
+// Round trip one structure. Returns 0 on success, 1 on failure.
+template <typename TStruct>
+static int CheckLayout(const char *pszName, const WireFieldStruct *pstFields, unsigned int unNumFields)
+{
+  unsigned char abyHost[sizeof (TStruct)];
+  unsigned char abyWire[sizeof (TStruct)];
+
+  for (unsigned int unByte = 0; unByte < sizeof (TStruct); unByte++)
+  {
+    abyHost[unByte] = abyWire[unByte] = (unsigned char) (0xA0 + unByte);
+  }
+
+  // Value byte 0 is the least significant - first on the wire, last on a big endian host
+  for (unsigned int unField = 0; unField < unNumFields; unField++)
+  {
+    const WireFieldStruct &stField = pstFields[unField];
+    for (unsigned int unByte = 0; unByte < stField.unSize; unByte++)
+    {
+      unsigned char byValue = (unsigned char) (0x10 * (unField + 1) + unByte + 1);
+      abyWire[stField.unOffset + unByte] = byValue;
+      abyHost[stField.unOffset + (WIRE_HOST_BIG_ENDIAN ? stField.unSize - 1 - unByte : unByte)] = byValue;
+    }
+  }
+
+  TStruct stData;
+  memcpy(&stData, abyHost, sizeof (TStruct));
+
+  HostToWire(stData);
+  int nToWire = memcmp(&stData, abyWire, sizeof (TStruct));
+  if (nToWire)
+  {
+    printf("FAIL: %s - HostToWire\n", pszName);
+    DumpBytes("expected", abyWire, sizeof (TStruct));
+    DumpBytes("got", (const unsigned char *) &stData, sizeof (TStruct));
+  }
+
+  WireToHost(stData);
+  int nToHost = memcmp(&stData, abyHost, sizeof (TStruct));
+  if (nToHost)
+  {
+    printf("FAIL: %s - WireToHost\n", pszName);
+    DumpBytes("expected", abyHost, sizeof (TStruct));
+    DumpBytes("got", (const unsigned char *) &stData, sizeof (TStruct));
+  }
+
+  if (nToWire || nToHost)
+  {
+    return 1;
+  }
+
+  printf("PASS: %-40s %4u bytes, %u fields swapped\n", pszName, (unsigned int) sizeof (TStruct), unNumFields);
+  return 0;
+}
+
+// Structure without multi-byte fields - must go out unchanged
+template <typename TStruct>
+static int CheckLayout(const char *pszName)
+{
+  return CheckLayout<TStruct>(pszName, NULL, 0);
+}
+
+static const WireFieldStruct s_astProcessValue[] = {
+  WIRE_TEST_FIELD(PROCESS_VALUE_STREAM_STRUCT, Value)
+};
+
+static const WireFieldStruct s_astHtrSolRtdData[] = {
+  WIRE_TEST_FIELD(HTR_SOL_RTD_DATA_STRUCT, htrsolDataUnion.PWMmPct)
+};
+
+static const WireFieldStruct s_astCmdHtr[] = {
+  WIRE_TEST_FIELD(CAN_CMD_HTR_STRUCT, stData.htrsolDataUnion.PWMmPct)
+};
+
+static const WireFieldStruct s_astCmdSol[] = {
+  WIRE_TEST_FIELD(CAN_CMD_SOL_STRUCT, stData.htrsolDataUnion.PWMmPct)
+};
+
+static const WireFieldStruct s_astEpcData[] = {
+  WIRE_TEST_FIELD(CAN_EPC_DATA_STRUCT, stData.BaseIOData.PressureMilliVolt)
+};
+
+static const WireFieldStruct s_astPreampData[] = {
+  WIRE_TEST_FIELD(PREAMP_DATA_STRUCT, preampData.Gain)
+};
+
+static const WireFieldStruct s_astCmdPreampData[] = {
+  WIRE_TEST_FIELD(CAN_CMD_PREAMP_DATA_STRUCT, stData.preampData.Gain)
+};
+
+static const WireFieldStruct s_astImbReadRequest[] = {
+  WIRE_TEST_FIELD(CAN_CMD_IMB_READ_DATA_REQUEST_STRUCT, nFlashOffset),
+  WIRE_TEST_FIELD(CAN_CMD_IMB_READ_DATA_REQUEST_STRUCT, nFlashLen)
+};
+
+static const WireFieldStruct s_astImbReadData[] = {
+  WIRE_TEST_FIELD(CAN_CMD_IMB_READ_DATA_STRUCT, nRequestOffset),
+  WIRE_TEST_FIELD(CAN_CMD_IMB_READ_DATA_STRUCT, nRequestLen),
+  WIRE_TEST_FIELD(CAN_CMD_IMB_READ_DATA_STRUCT, flashDataLen)
+};
+
+static const WireFieldStruct s_astImbWriteData[] = {
+  WIRE_TEST_FIELD(CAN_CMD_IMB_WRITE_DATA_STRUCT, uinFlashOffset),
+  WIRE_TEST_FIELD(CAN_CMD_IMB_WRITE_DATA_STRUCT, uinFlashLen)
+};
+
+#define CHECK_LAYOUT(type, fields)  CheckLayout<type>(#type, fields, WIRE_TEST_NUM_FIELDS(fields))
+
+int main(int argc, char *argv[])
+{
+  int nFailed = 0;
+
+  // Common structures
+  nFailed += CheckLayout<CmdAckUnion>("CmdAckUnion");
+  nFailed += CheckLayout<STATUS_STRUCT>("STATUS_STRUCT");
+  nFailed += CheckLayout<DEVICE_SYSTEM_INFO_STRUCT>("DEVICE_SYSTEM_INFO_STRUCT");
+  nFailed += CheckLayout<NACK_STRUCT>("NACK_STRUCT");
+  nFailed += CHECK_LAYOUT(PROCESS_VALUE_STREAM_STRUCT, s_astProcessValue);
+
+  // Heater / Solenoid / RTD
+  nFailed += CHECK_LAYOUT(HTR_SOL_RTD_DATA_STRUCT, s_astHtrSolRtdData);
+  nFailed += CHECK_LAYOUT(CAN_CMD_HTR_STRUCT, s_astCmdHtr);
+  nFailed += CheckLayout<CAN_CMD_HTR_STATUS_STRUCT>("CAN_CMD_HTR_STATUS_STRUCT");
+  nFailed += CheckLayout<CAN_CMD_HTR_SOL_RTD_SYSINFO_STRUCT>("CAN_CMD_HTR_SOL_RTD_SYSINFO_STRUCT");
+  nFailed += CHECK_LAYOUT(CAN_CMD_SOL_STRUCT, s_astCmdSol);
+  nFailed += CheckLayout<CMD_SOL_GET_STATUS_STRUCT>("CMD_SOL_GET_STATUS_STRUCT");
+
+  // EPC (Base IO)
+  nFailed += CHECK_LAYOUT(CAN_EPC_DATA_STRUCT, s_astEpcData);
+  nFailed += CheckLayout<CAN_BASEIO_STATUS_STRUCT>("CAN_BASEIO_STATUS_STRUCT");
+  nFailed += CheckLayout<CAN_BASEIO_SYSINFO_STRUCT>("CAN_BASEIO_SYSINFO_STRUCT");
+
+  // Preamp configuration
+  nFailed += CHECK_LAYOUT(PREAMP_DATA_STRUCT, s_astPreampData);
+  nFailed += CHECK_LAYOUT(CAN_CMD_PREAMP_DATA_STRUCT, s_astCmdPreampData);
+  nFailed += CheckLayout<CAN_CMD_PREAMP_STATUS_STRUCT>("CAN_CMD_PREAMP_STATUS_STRUCT");
+
+  // IMB
+  nFailed += CheckLayout<CAN_IMB_STATUS_STRUCT>("CAN_IMB_STATUS_STRUCT");
+  nFailed += CHECK_LAYOUT(CAN_CMD_IMB_READ_DATA_REQUEST_STRUCT, s_astImbReadRequest);
+  nFailed += CHECK_LAYOUT(CAN_CMD_IMB_READ_DATA_STRUCT, s_astImbReadData);
+  nFailed += CHECK_LAYOUT(CAN_CMD_IMB_WRITE_DATA_STRUCT, s_astImbWriteData);
+
+  if (nFailed)
+  {
+    printf("%d structures FAILED\n", nFailed);
+    return EXIT_FAILURE;
+  }
+
+  printf("All structures PASSED\n");
+  return 0;
+}
@@ -723,7 +723,6 @@ int CCAND::HandleTopLevelCmds()
 int CCAND::Register(CmdDataUnion& stCmdInfo)
 {
   int nRetVal = 0;
-  int nInitStep = 0;
   CANDRegInfo *pEntry = NULL;
   unsigned char SlotID, FnType, FnCount;
   
@@ -743,37 +742,24 @@ int CCAND::Register(CmdDataUnion& stCmdInfo)
     DEBUG1 ("Register: %d, %d, %d", SlotID, FnType, FnCount);
     pEntry = &ltRegList[SlotID][FnType][FnCount - 1];
       
-    //Open a board specific command response IPC channel
-    //IMPORTANT: CAND should always open it's transmit
-    //  IPC channel in Non-blocking mode
-    pEntry->m_cmdRespIPC = new CIPC;
-    if (pEntry->m_cmdRespIPC->IPC_InitIPC(
-          stCmdInfo.stRegCmdData.CmdRespIPCid,
-          CMD_RESP_PIPE_MAILBOX_ID,
-          IPC_SEND, IPC_OPEN_NONBLOCKING) < 0)
+    //Open a command response IPC channel. Devices registered with the
+    //  same IPC id share the channel.
+    pEntry->m_cmdRespIPC = OpenRespIPC(stCmdInfo.stRegCmdData.CmdRespIPCid,
+                                       CMD_RESP_PIPE_MAILBOX_ID);
+    if (NULL == pEntry->m_cmdRespIPC)
     {
       nRetVal = -1;
     }
-    else
-    {
-      nInitStep++;
-    }
       
     //If a stream IPC channel is required, open one!
     if (stCmdInfo.stRegCmdData.StreamRespIPCid)
     {
-      pEntry->m_streamRespIPC = new CIPC;
-      if (pEntry->m_streamRespIPC->IPC_InitIPC(
-            stCmdInfo.stRegCmdData.StreamRespIPCid,
-            CMD_STRM_PIPE_MAILBOX_ID,
-            IPC_SEND, IPC_OPEN_NONBLOCKING) < 0)
+      pEntry->m_streamRespIPC = OpenRespIPC(stCmdInfo.stRegCmdData.StreamRespIPCid,
+                                            CMD_STRM_PIPE_MAILBOX_ID);
+      if (NULL == pEntry->m_streamRespIPC)
       {
         nRetVal = -1;
       }
-      else
-      {
-        nInitStep++;
-      }
     }
 
     //If an error occurred, revert back and release newly created resources ...
@@ -782,24 +768,14 @@ int CCAND::Register(CmdDataUnion& stCmdInfo)
       //Release command response IPC information
       if (pEntry->m_cmdRespIPC)
       {
-        if (nInitStep >= 1)
-        {
-          pEntry->m_cmdRespIPC->IPC_Close();
-        }
-    
-        delete pEntry->m_cmdRespIPC;
+        CloseRespIPC(pEntry->m_cmdRespIPC);
         pEntry->m_cmdRespIPC = NULL;
       }
       
       //Release stream IPC information
       if (pEntry->m_streamRespIPC)
       {
-        if (nInitStep >= 2)
-        {
-          pEntry->m_streamRespIPC->IPC_Close();
-        }
-    
-        delete pEntry->m_streamRespIPC;
+        CloseRespIPC(pEntry->m_streamRespIPC);
         pEntry->m_streamRespIPC = NULL;
       }
     }
@@ -831,16 +807,14 @@ int CCAND::DeRegister(unsigned char SlotID, unsigned char FnType, unsigned char
     //Close and release the command response IPC
     if (pEntry->m_cmdRespIPC)
     {
-      pEntry->m_cmdRespIPC->IPC_Close();
-      delete pEntry->m_cmdRespIPC;
+      CloseRespIPC(pEntry->m_cmdRespIPC);
       pEntry->m_cmdRespIPC = NULL;
     }
 
     //Close and release the stream response IPC
     if (pEntry->m_streamRespIPC)
     {
-      pEntry->m_streamRespIPC->IPC_Close();
-      delete pEntry->m_streamRespIPC;
+      CloseRespIPC(pEntry->m_streamRespIPC);
       pEntry->m_streamRespIPC = NULL;
     }
 
@@ -876,6 +850,57 @@ CANDRegInfo* CCAND::GetMatchingEntry(unsigned char SlotID, unsigned char FnType,
   }
 }
 
+//Open (or get a reference to an already open) IPC channel to the upper layer
+CIPC* CCAND::OpenRespIPC(unsigned int unIPCid, int nMailboxID)
+{
+  CIPC *pobIPC = NULL;
+
+  for (list<CANDSharedIPC>::iterator it = m_ltSharedIPC.begin(); it != m_ltSharedIPC.end(); ++it)
+  {
+    if (it->unIPCid == unIPCid && it->nMailboxID == nMailboxID)
+    {
+      it->nRefCount++;
+      return it->pobIPC;
+    }
+  }
+
+  //IMPORTANT: CAND should always open it's transmit
+  //  IPC channel in Non-blocking mode
+  pobIPC = new CIPC;
+  if (pobIPC->IPC_InitIPC(unIPCid, nMailboxID, IPC_SEND, IPC_OPEN_NONBLOCKING) < 0)
+  {
+    delete pobIPC;
+    return NULL;
+  }
+
+  CANDSharedIPC stShared;
+  stShared.unIPCid = unIPCid;
+  stShared.nMailboxID = nMailboxID;
+  stShared.nRefCount = 1;
+  stShared.pobIPC = pobIPC;
+  m_ltSharedIPC.push_back(stShared);
+
+  return pobIPC;
+}
+
+//Release a reference to an IPC channel, close it with the last reference
+void CCAND::CloseRespIPC(CIPC *pobIPC)
+{
+  for (list<CANDSharedIPC>::iterator it = m_ltSharedIPC.begin(); it != m_ltSharedIPC.end(); ++it)
+  {
+    if (it->pobIPC == pobIPC)
+    {
+      if (--it->nRefCount == 0)
+      {
+        pobIPC->IPC_Close();
+        delete pobIPC;
+        m_ltSharedIPC.erase(it);
+      }
+      return;
+    }
+  }
+}
+
 //Log error messages
 void CCAND::LogError(CAND_ERRS eCANDError, long lLineNr)
 {
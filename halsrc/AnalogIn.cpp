@@ -108,6 +108,7 @@ int CAnalogIn::m_nROCIOAICount[4 * NR_ENUM_ROC_ANALOG_IN] =
 
 CAnalogIn::CAnalogIn()  // Default Constructor
 {
+  CHALLock obSPILock(&m_ExpSlotSPIMutex);
   m_bROCIO1_InitDone = false;
   m_bROCIO2_InitDone = false;
   m_bROCIO3_InitDone = false;
@@ -125,6 +126,7 @@ int CAnalogIn::OpenHal(char* pszDevName)
   int nRetVal = CBaseDev::OpenHal(pszDevName, FALSE);
   if ((nRetVal == ERR_SUCCESS) && (m_eCommType == SPI_COMM))
   {
+    CHALLock obSPILock(&m_ExpSlotSPIMutex);
     if ((m_bySlotID == 0) && !m_bROCIO1_InitDone)
     {
       m_bROCIO1_InitDone = true;
@@ -378,11 +380,15 @@ int CAnalogIn::GetCurrent(unsigned long *pCurrentNanoAmps)
       break;
 
     case SPI_COMM:
-      if( ERR_SUCCESS == GetROCIOReading() )
       {
-        int nStartIndex = (m_bySlotID - 1) * NR_ENUM_ROC_ANALOG_IN ;
-        *pCurrentNanoAmps = m_nROCIOAICount[m_byFnEnum-1 + nStartIndex];
-        *pCurrentNanoAmps = (*pCurrentNanoAmps) * (24000000 / 65536);
+        // The counts of all the channels on the card are read into a shared cache
+        CHALLock obSPILock(&m_ExpSlotSPIMutex);
+        if( ERR_SUCCESS == GetROCIOReading() )
+        {
+          int nStartIndex = (m_bySlotID - 1) * NR_ENUM_ROC_ANALOG_IN ;
+          *pCurrentNanoAmps = m_nROCIOAICount[m_byFnEnum-1 + nStartIndex];
+          *pCurrentNanoAmps = (*pCurrentNanoAmps) * (24000000 / 65536);
+        }
       }
       break;
     case SERIAL_COMM:
@@ -466,12 +472,16 @@ int CAnalogIn::GetVoltage(unsigned long *pMilliVolts)
 
     case SPI_COMM:
       //TODO: To be implemented
-      if( ERR_SUCCESS == GetROCIOReading() )
       {
-        int nStartIndex = (m_bySlotID - 1) * NR_ENUM_ROC_ANALOG_IN ;
-        *pMilliVolts = m_nROCIOAICount[m_byFnEnum-1 + nStartIndex];
-        //As per datasheet of AI-16 Module (ROC800-Series), Voltage reading is 91.55 uV/Count
-        *pMilliVolts = (unsigned long)((*pMilliVolts) * 0.09155); 
+        // The counts of all the channels on the card are read into a shared cache
+        CHALLock obSPILock(&m_ExpSlotSPIMutex);
+        if( ERR_SUCCESS == GetROCIOReading() )
+        {
+          int nStartIndex = (m_bySlotID - 1) * NR_ENUM_ROC_ANALOG_IN ;
+          *pMilliVolts = m_nROCIOAICount[m_byFnEnum-1 + nStartIndex];
+          //As per datasheet of AI-16 Module (ROC800-Series), Voltage reading is 91.55 uV/Count
+          *pMilliVolts = (unsigned long)((*pMilliVolts) * 0.09155); 
+        }
       }
       break;
     case SERIAL_COMM:
@@ -221,6 +221,9 @@ int CAnalogOut::SetCurrent(unsigned long CurrentNanoAmps)
     case SPI_COMM:
       if (m_nExpSlotSPIfd != -1)
       {
+        // The levels of all the outputs on the card are written together
+        CHALLock obSPILock(&m_ExpSlotSPIMutex);
+
         // Get start index into static array where we store the converted current (I) levels
         int nStartIndex = (m_bySlotID - 1) * NR_ENUM_ROC_ANALOG_OUT;
 
@@ -103,6 +103,8 @@
   
 #include "debug.h"
 #include "BaseDev.h"
+#include "WireLayouts.h"
+#include "HALTrace.h"
 
 #ifdef WIN32
 #define bzero(x, y) memset(x, 0, y)
@@ -114,6 +116,8 @@
 
 // TODO: DO we need lock files for each of the above???
 
+pthread_mutex_t CBaseDev::m_ExpSlotSPIMutex = PTHREAD_MUTEX_INITIALIZER;
+
 CBaseDev::CBaseDev()  // Default Constructor
 {
   // Initialize
@@ -128,6 +132,10 @@ CBaseDev::CBaseDev()  // Default Constructor
   m_pobUDP = NULL;
   m_fdFidBkpIgnite = -1;
   m_fdFidBkpGain = -1;
+  m_unPushPeriodMs = 0;
+  m_bPushSeqValid = FALSE;
+  m_byPushNextSeq = 0;
+  memset(&m_stPushStats, 0, sizeof (m_stPushStats));
 }
 
 CBaseDev::~CBaseDev() // Destructor
@@ -287,6 +295,9 @@ int CBaseDev::CloseHal()
   // Check if device is open
   if (m_bIsDevOpen)
   {
+    // The board may be reset before it is opened again
+    m_obCfgCache.Invalidate();
+
     // Check the type of communication mechanism being used.
     switch (m_eCommType)
     {
@@ -294,15 +305,17 @@ int CBaseDev::CloseHal()
       // Release memory allocated to m_pobCAN object
       if (m_pobCAN)
       {
-        nRetVal = m_pobCAN->CANCommClose();
-        delete m_pobCAN;
-        m_pobCAN = NULL;
-
+        // Release the reliability layer first - it stops the slot health
+        // probe thread from using this channel.
         if (m_pobReliabilityCAN)
         {
           delete m_pobReliabilityCAN;
           m_pobReliabilityCAN = NULL;
         }
+
+        nRetVal = m_pobCAN->CANCommClose();
+        delete m_pobCAN;
+        m_pobCAN = NULL;
       }
       else
       {
@@ -362,6 +375,8 @@ int CBaseDev::CloseHal()
     m_bIsDevOpen = FALSE;
     m_bySlotID = m_byFnType = m_byFnEnum = (unsigned char)-1;
     m_bIsStreaming = FALSE;
+    m_unPushPeriodMs = 0;
+    m_bPushSeqValid = FALSE;
   }
   else
   {
@@ -372,6 +387,18 @@ int CBaseDev::CloseHal()
   return nRetVal;
 }
 
+// Lock held for command / response exchanges with the device
+CHALMutex *CBaseDev::GetCmdLock()
+{
+  return m_pobCAN ? m_pobCAN->GetCmdLock() : NULL;
+}
+
+// Lock held while reading streaming data from the device
+CHALMutex *CBaseDev::GetStrmLock()
+{
+  return m_pobCAN ? m_pobCAN->GetStrmLock() : NULL;
+}
+
 // Translate device error into HAL error code.
 int CBaseDev::TransDevError(int nDevError)
 {
@@ -405,6 +432,416 @@ int CBaseDev::TransDevError(int nDevError)
   return nHALRetVal;
 }
 
+// Check that the device can be talked to over CAN
+int CBaseDev::CheckTxnChannel(const char *pszCaller)
+{
+  // Check if the device is open!
+  if (!m_bIsDevOpen)
+  {
+    // Function called before Open Call!
+    DEBUG2("CBaseDev::%s(): %s - Function called before Open Call!", pszCaller, m_szDevName);
+    return ERR_INVALID_SEQ;
+  }
+
+  switch (m_eCommType)
+  {
+  case CAN_COMM:
+    if (NULL == m_pobCAN || NULL == m_pobReliabilityCAN)
+    {
+      DEBUG2("CBaseDev::%s(): %s - Unexpected invalid pointer!", pszCaller, m_szDevName);
+      return ERR_INTERNAL_ERR;
+    }
+    break;
+
+  case SPI_COMM:
+    //TODO: To be implemented
+  case SERIAL_COMM:
+    //TODO:  To be implemented
+  case COMM_NONE:
+  default:
+    DEBUG2("CBaseDev::%s(): %s - Invalid switch case!", pszCaller, m_szDevName);
+    return ERR_INTERNAL_ERR;
+  }
+
+  return ERR_SUCCESS;
+}
+
+// Is the response of a request the late response of another command?
+static BOOL IsRespOfOtherCmd(const CDevTxn &obTxn)
+{
+  return (obTxn.GetRespBytes() >= (int) sizeof (CmdAckUnion) &&
+          GetCmdAckCommand(obTxn.GetRespBuf()) != obTxn.GetCommand());
+}
+
+// Evaluate the response of a completed request and set its result
+int CBaseDev::CompleteTxn(CDevTxn &obTxn)
+{
+  int nRetVal = obTxn.GetRespBytes();
+
+  if (nRetVal < 0)
+  {
+    DEBUG2("CBaseDev::Transact(): %s - Command %d failed with error code %d!", 
+           m_szDevName, obTxn.GetCommand(), nRetVal);
+  }
+  // Received response of a previously sent command. It says nothing of this
+  // command, nor of the board - it is neither cached nor cause to drop the cache.
+  else if (IsRespOfOtherCmd(obTxn))
+  {
+    DEBUG2("CBaseDev::Transact(): %s - Response of a different Command - %d, expected %d!", 
+           m_szDevName, GetCmdAckCommand(obTxn.GetRespBuf()), obTxn.GetCommand());
+    obTxn.SetResult(ERR_PROTOCOL);
+    return ERR_PROTOCOL;
+  }
+  // Check if the device ACK'd or NACK'd
+  else if (nRetVal >= (int) sizeof (CmdAckUnion) && GetCmdAckError(obTxn.GetRespBuf()) == 1)
+  {
+    // The error type follows the CmdAckUnion
+    nRetVal = TransDevError((nRetVal > (int) sizeof (CmdAckUnion)) ? obTxn.GetRespBuf()[sizeof (CmdAckUnion)] : -1);
+    DEBUG2("CBaseDev::Transact(): %s - Device sent a NACK for command %d! Dev error code = %d!", 
+           m_szDevName, obTxn.GetCommand(), nRetVal);
+  }
+  // Check if we got the correct response packet
+  else if (nRetVal == (int) obTxn.GetRespLen())
+  {
+    m_obCfgCache.Update(obTxn);
+    obTxn.FinishResp();
+    nRetVal = ERR_SUCCESS;
+  }
+  //Not the expected packet size
+  else
+  {
+    DEBUG2("CBaseDev::Transact(): %s - Unexpected packet size for command %d: %d", 
+           m_szDevName, obTxn.GetCommand(), nRetVal);
+    nRetVal = ERR_PROTOCOL;
+  }
+
+  // The board may have been reset - nothing kept of it can be trusted
+  if (nRetVal < 0)
+  {
+    m_obCfgCache.Invalidate();
+  }
+
+  obTxn.SetResult(nRetVal);
+
+  return nRetVal;
+}
+
+// Send the request's command to the device and wait for its response
+int CBaseDev::Transact(CDevTxn &obTxn, unsigned int unTimeOut)
+{
+  int nRetVal = CheckTxnChannel("Transact");
+  unsigned long long ullTraceUs = CHALTrace::Begin();
+  HAL_TRACE_EVENT_ENUM eTraceType = HAL_TRACE_TRANSACT;
+  int nAttempts = 0;
+
+  // The cache is looked up and updated in the same exchange as the device
+  CHALLock obCmdLock((ERR_SUCCESS == nRetVal) ? GetCmdLock() : NULL);
+
+  if (nRetVal < 0)
+  {
+    obTxn.SetRespBytes(nRetVal);
+    obTxn.SetResult(nRetVal);
+  }
+  else if (m_obCfgCache.Lookup(obTxn))
+  {
+    eTraceType = HAL_TRACE_CACHED;
+    nRetVal = obTxn.GetResult();
+  }
+  else
+  {
+    obTxn.PrepareCmd();
+
+    do
+    {
+      // Send a command and wait for ackowledgement from remote device
+      obTxn.SetRespBytes(m_pobReliabilityCAN->GetRemoteResp(obTxn.GetCmdBuf(),   // Command
+                                                            obTxn.GetCmdLen(),   // Size of command
+                                                            obTxn.GetRespBuf(),  // Response from remote board
+                                                            obTxn.GetRespLen(),  // Size of expected response
+                                                            FALSE,
+                                                            unTimeOut));
+      nAttempts += m_pobReliabilityCAN->m_nRetryAttempts;
+
+      //Received response of a previously sent command.
+      //Try sending the command again with remaining timeout interval.
+      int nRemTimeOut = IsRespOfOtherCmd(obTxn) ? m_pobReliabilityCAN->GetRemTimeOut() : 0;
+      unTimeOut = (nRemTimeOut > 0) ? (unsigned int) nRemTimeOut : 0;
+    } while (unTimeOut > 0);
+
+    nRetVal = CompleteTxn(obTxn);
+  }
+
+  // Failed requests too - they are the ones a trace is looked at for
+  if (ullTraceUs)
+  {
+    CHALTrace::Record(eTraceType, m_szDevName, m_bySlotID, obTxn.GetCommand(), m_byFnEnum, ullTraceUs,
+                      nAttempts, nRetVal);
+  }
+
+  return nRetVal;
+}
+
+// Send several requests to the device back to back and collect all responses
+int CBaseDev::TransactBatch(CDevTxn **apobTxn, int nNumTxn, unsigned int unTimeOut, BOOL bStreamingTx)
+{
+  int nRetVal = CheckTxnChannel("TransactBatch");
+  unsigned long long ullTraceUs = CHALTrace::Begin();
+  CDevTxn *apobSend[MAX_DEV_TXN_BATCH];
+  int nNumSend = 0;
+
+  if (NULL == apobTxn || nNumTxn <= 0 || nNumTxn > MAX_DEV_TXN_BATCH)
+  {
+    nRetVal = ERR_INVALID_ARGS;
+    nNumTxn = 0;
+  }
+
+  for (int nTxn = 0; nTxn < nNumTxn; nTxn++)
+  {
+    if (NULL == apobTxn[nTxn])
+    {
+      nRetVal = ERR_INVALID_ARGS;
+      nNumTxn = 0;
+    }
+  }
+
+  // The cache is looked up, updated and dropped in the same exchange as the device
+  CHALLock obCmdLock(GetCmdLock());
+
+  if (ERR_SUCCESS == nRetVal)
+  {
+    // A batch that changes a kept setting may read it back after the change, so
+    // then all of it goes to the device
+    BOOL bUseCache = TRUE;
+    for (int nTxn = 0; nTxn < nNumTxn; nTxn++)
+    {
+      if (m_obCfgCache.IsSetCommand(apobTxn[nTxn]->GetCommand()))
+      {
+        bUseCache = FALSE;
+      }
+    }
+
+    for (int nTxn = 0; nTxn < nNumTxn; nTxn++)
+    {
+      if (!bUseCache || !m_obCfgCache.Lookup(*apobTxn[nTxn]))
+      {
+        apobTxn[nTxn]->PrepareCmd();
+        apobSend[nNumSend++] = apobTxn[nTxn];
+      }
+    }
+
+    if (nNumSend > 0)
+    {
+      nRetVal = m_pobReliabilityCAN->GetRemoteRespBatch(apobSend, nNumSend, unTimeOut, bStreamingTx);
+    }
+  }
+  else
+  {
+    // Nothing is sent - every request fails
+    for (int nTxn = 0; nTxn < nNumTxn; nTxn++)
+    {
+      apobSend[nNumSend++] = apobTxn[nTxn];
+    }
+  }
+
+  if (nRetVal < 0)
+  {
+    m_obCfgCache.Invalidate();
+    for (int nTxn = 0; nTxn < nNumSend; nTxn++)
+    {
+      apobSend[nTxn]->SetRespBytes(nRetVal);
+      apobSend[nTxn]->SetResult(nRetVal);
+    }
+  }
+  else
+  {
+    for (int nTxn = 0; nTxn < nNumSend; nTxn++)
+    {
+      int nResult = CompleteTxn(*apobSend[nTxn]);
+      if (ERR_SUCCESS == nRetVal)
+      {
+        nRetVal = nResult;
+      }
+    }
+  }
+
+  // Failed batches too - they are the ones a trace is looked at for
+  if (ullTraceUs)
+  {
+    CHALTrace::Record(HAL_TRACE_BATCH, m_szDevName, m_bySlotID, (nNumTxn > 0) ? apobTxn[0]->GetCommand() : 0,
+                      m_byFnEnum, ullTraceUs, nNumTxn, nRetVal);
+  }
+
+  return nRetVal;
+}
+
+// Settings of the device class that the configuration cache may hold
+void CBaseDev::SetConfigCacheMap(const DevCacheMapStruct *pstMap, int nMapLen)
+{
+  m_obCfgCache.SetMap(pstMap, nMapLen);
+}
+
+// Get retry and latency statistics of the communication with this device
+int CBaseDev::GetCommStats(ReliabilityStatsStruct *pstStats)
+{
+  if (NULL == pstStats)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  if (!m_bIsDevOpen || NULL == m_pobReliabilityCAN)
+  {
+    return ERR_INVALID_SEQ;
+  }
+
+  return m_pobReliabilityCAN->GetStats(pstStats);
+}
+
+// Clear the communication statistics of this device
+int CBaseDev::ResetCommStats()
+{
+  if (!m_bIsDevOpen || NULL == m_pobReliabilityCAN)
+  {
+    return ERR_INVALID_SEQ;
+  }
+
+  m_pobReliabilityCAN->ResetStats();
+
+  return ERR_SUCCESS;
+}
+
+// Keep the configuration settings written to / read from the device
+int CBaseDev::EnableConfigCache(BOOL bEnable)
+{
+  CHALLock obCmdLock(GetCmdLock());
+
+  if (!m_obCfgCache.HasMap())
+  {
+    return ERR_NOT_IMPLEMENTED;
+  }
+
+  m_obCfgCache.Enable(bEnable);
+
+  return ERR_SUCCESS;
+}
+
+// Forget the kept settings
+void CBaseDev::InvalidateConfigCache()
+{
+  CHALLock obCmdLock(GetCmdLock());
+
+  m_obCfgCache.Invalidate();
+}
+
+// Get the configuration cache counters
+int CBaseDev::GetConfigCacheStats(DevCacheStatsStruct *pstStats)
+{
+  if (NULL == pstStats)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  CHALLock obCmdLock(GetCmdLock());
+
+  m_obCfgCache.GetStats(pstStats);
+
+  return ERR_SUCCESS;
+}
+
+// Note the period the device now pushes its process values at
+void CBaseDev::SetPushPeriod(unsigned int unPeriodMs)
+{
+  CHALLock obStrmLock(GetStrmLock());
+
+  if (unPeriodMs && !m_unPushPeriodMs)
+  {
+    m_bPushSeqValid = FALSE;
+    memset(&m_stPushStats, 0, sizeof (m_stPushStats));
+  }
+  else if (!unPeriodMs && m_unPushPeriodMs && m_pobCAN)
+  {
+    // Values pushed before the device stopped
+    m_pobCAN->CANFlushStreamPipe();
+  }
+
+  m_unPushPeriodMs = unPeriodMs;
+}
+
+// Read the next process value pushed by the device
+int CBaseDev::ReadPushedValue(DevStreamValueStruct *pstValue, unsigned int unTimeOut, const char *pszCaller)
+{
+  PROCESS_VALUE_STREAM_STRUCT stResp;
+  int nRetVal;
+
+  if (NULL == pstValue)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  nRetVal = CheckTxnChannel(pszCaller);
+  if (nRetVal < 0)
+  {
+    return nRetVal;
+  }
+
+  if (!m_bIsStreaming)
+  {
+    DEBUG2("CBaseDev::%s(): %s - Device not opened for streaming!", pszCaller, m_szDevName);
+    return ERR_INVALID_SEQ;
+  }
+
+  CHALLock obStrmLock(GetStrmLock());
+
+  nRetVal = m_pobCAN->CANRxStrmTimeout((unsigned char *) &stResp,  // Value pushed by the remote board
+                                       sizeof (stResp), unTimeOut); // Size of expected value
+  if (nRetVal == sizeof (stResp))
+  {
+    WireToHost(stResp);
+
+    if (m_bPushSeqValid && stResp.SeqNum != m_byPushNextSeq)
+    {
+      m_stPushStats.ulMissed += (unsigned char) (stResp.SeqNum - m_byPushNextSeq);
+    }
+    m_byPushNextSeq = (unsigned char) (stResp.SeqNum + 1);
+    m_bPushSeqValid = TRUE;
+    m_stPushStats.ulReceived++;
+
+    pstValue->eValue = (STREAM_VALUE_ENUM) stResp.ValueType;
+    pstValue->nValue = stResp.Value;
+    pstValue->ullTimeUs = CReliability::GetMonotonicTimeUs();
+
+    nRetVal = ERR_SUCCESS;
+  }
+  else if (nRetVal < 0)
+  {
+    if (nRetVal != ERR_TIMEOUT)
+    {
+      DEBUG2("CBaseDev::%s(): %s - CCANComm::CANRxStrmTimeout failed with error code %d!", pszCaller, m_szDevName, nRetVal);
+    }
+  }
+  else // if(nRetVal != sizeof (stResp))
+  {
+    DEBUG2("CBaseDev::%s(): %s - CCANComm::CANRxStrmTimeout - received unexpected number of bytes: %d!", pszCaller, m_szDevName, nRetVal);
+    nRetVal = ERR_PROTOCOL;
+  }
+
+  return nRetVal;
+}
+
+// Counters of the pushed process values
+int CBaseDev::GetPushStats(DevStreamStatsStruct *pstStats)
+{
+  if (NULL == pstStats)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  CHALLock obStrmLock(GetStrmLock());
+
+  *pstStats = m_stPushStats;
+
+  return ERR_SUCCESS;
+}
+
 /*------------------------------------------------------------------------------
  * Function return error message based on error code
  *-----------------------------------------------------------------------------*/
@@ -412,6 +849,7 @@ CHAR *CBaseDev::GetErrorMsg(ERR_CODE iErrorCode)
 {
   switch (iErrorCode)
   {
+    case ERR_SLOT_OFFLINE: return "Board is not responding, request not sent";
     case ERR_CMD_FAILED: return "Command execution failed";
     case ERR_OPEN_FILE: return "Unable to open file";
     case ERR_DATA_PENDING: return "Data not received completely";
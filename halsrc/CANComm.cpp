@@ -121,6 +121,7 @@
   
 #include "debug.h"
 #include "CANComm.h"
+#include "HALTrace.h"
 
 #define FRAGMENT_PACKET_H2D
 #ifdef FRAGMENT_PACKET_H2D
@@ -132,6 +133,7 @@
 
 CIPC CCANComm::m_obIPCCmdTx;
 int CCANComm::m_nInstances = 0; 
+pthread_mutex_t CCANComm::m_TxMutex = PTHREAD_MUTEX_INITIALIZER;
 
 CCANComm::CCANComm() // Default constructor
 {
@@ -143,6 +145,9 @@ CCANComm::CCANComm() // Default constructor
   m_byFnType = (unsigned char)-1; // Invalid Type, sure to fail
   m_byFnEnum = (unsigned char)-1; // Invalid Enum, sure to fail
   m_nRemTimeOut = 0;
+  m_pstMuxChannel = NULL;
+
+  CHALLock obTxLock(&m_TxMutex);
 
   // Do for first instance ONLY - only one Cmd TX Pipe needed per process to CAND
   if (m_nInstances++ == 0)
@@ -158,13 +163,17 @@ CCANComm::CCANComm() // Default constructor
 
 CCANComm::~CCANComm() // Default destructor
 {
-  // Close Cmd TX Pipe - only when destroying the last instance
-  if (--m_nInstances == 0)
   {
-    int nRetVal = m_obIPCCmdTx.IPC_Close();
-    if (nRetVal != ERR_SUCCESS)
+    CHALLock obTxLock(&m_TxMutex);
+
+    // Close Cmd TX Pipe - only when destroying the last instance
+    if (--m_nInstances == 0)
     {
-      DEBUG1("CCANComm::~CCANComm: Cmd TX Pipe - IPC_Close () failed with error code = %d!", nRetVal);
+      int nRetVal = m_obIPCCmdTx.IPC_Close();
+      if (nRetVal != ERR_SUCCESS)
+      {
+        DEBUG1("CCANComm::~CCANComm: Cmd TX Pipe - IPC_Close () failed with error code = %d!", nRetVal);
+      }
     }
   }
 
@@ -195,6 +204,9 @@ int CCANComm::CANCommOpen (unsigned char bySlotId,
   int nPipeTaskId = (bySlotId << 9) + (byFnType << 4) + byFnEnum;
   nPipeTaskId += 32768; // max_pid = 32768. Offset HAL pipe numbers to ensure that we don't use pipe names 
                         // that uses the pid numbers or enums to generate pipe names (example dbclient).
+
+  CHALLock obStrmLock(&m_obStrmLock);
+  CHALLock obCmdLock(&m_obCmdLock);
   
   // Check if the CAN Comm Channel is already open
   if (m_bIsCmdRespPipeOpen == TRUE)
@@ -209,27 +221,45 @@ int CCANComm::CANCommOpen (unsigned char bySlotId,
     memset (&stRegCmd, 0, sizeof (CANDCmdStruct));
     memset (&stResp, 0, sizeof (CANDRespStruct));
 
-    // Open Cmd Resp Pipe
-    if (!m_obIPCCmdRespRx.IPC_InitIPC (nPipeTaskId, CMD_RESP_PIPE_MAILBOX_ID, IPC_RECV))
+    if (CCANMux::IsEnabled())
     {
-      m_bIsCmdRespPipeOpen = TRUE;
+      // Use the process wide multiplexed connection - CAND is given the IPC id
+      // of the shared pipes instead of a device specific one
+      m_bIsStreaming = bIsStreaming;
+      if (CCANMux::Attach (bySlotId, byFnType, byFnEnum, bIsStreaming, &m_pstMuxChannel, &nPipeTaskId) == ERR_SUCCESS)
+      {
+        m_bIsCmdRespPipeOpen = TRUE;
+        m_bIsStreamPipeOpen = bIsStreaming;
+      }
+      else
+      {
+        DEBUG2("CCANComm::CANCommOpen: Error attaching to the multiplexed connection.");
+      }
     }
     else
     {
-      DEBUG2("CCANComm::CANCommOpen: Error calling CIPC::IPC_InitIPC.");
-    }
-
-    // Open pipe for streaming 
-    if (bIsStreaming)
-    {
-      m_bIsStreaming = bIsStreaming;
-      if (!m_obIPCStreamRx.IPC_InitIPC (nPipeTaskId, CMD_STRM_PIPE_MAILBOX_ID, IPC_RECV))
+      // Open Cmd Resp Pipe
+      if (!m_obIPCCmdRespRx.IPC_InitIPC (nPipeTaskId, CMD_RESP_PIPE_MAILBOX_ID, IPC_RECV))
       {
-        m_bIsStreamPipeOpen = TRUE;
+        m_bIsCmdRespPipeOpen = TRUE;
       }
       else
       {
-        DEBUG2("CCANComm: Error calling CIPC::IPC_InitIPC.");
+        DEBUG2("CCANComm::CANCommOpen: Error calling CIPC::IPC_InitIPC.");
+      }
+
+      // Open pipe for streaming 
+      if (bIsStreaming)
+      {
+        m_bIsStreaming = bIsStreaming;
+        if (!m_obIPCStreamRx.IPC_InitIPC (nPipeTaskId, CMD_STRM_PIPE_MAILBOX_ID, IPC_RECV))
+        {
+          m_bIsStreamPipeOpen = TRUE;
+        }
+        else
+        {
+          DEBUG2("CCANComm: Error calling CIPC::IPC_InitIPC.");
+        }
       }
     }
 
@@ -257,7 +287,7 @@ int CCANComm::CANCommOpen (unsigned char bySlotId,
                   
       // Register the device with CAND
       nCount = sizeof (CANDCmdStruct);
-      if (m_obIPCCmdTx.IPC_SendPacket ((void *) &stRegCmd, nCount) != nCount)
+      if (SendToCAND ((void *) &stRegCmd, nCount) != nCount)
       {
         // Sending registration command failed!
         nRetVal = ERR_INTERNAL_ERR;
@@ -284,6 +314,9 @@ int CCANComm::CANCommClose ()
   CANDCmdStruct stRegCmd;
   CANDRespStruct stResp;
 
+  CHALLock obStrmLock(&m_obStrmLock);
+  CHALLock obCmdLock(&m_obCmdLock);
+
   // Check if the CAN Comm Channel open
   if (m_bIsCmdRespPipeOpen == TRUE)
   {
@@ -304,7 +337,7 @@ int CCANComm::CANCommClose ()
 
     // Un-register the device from CAND
     nCount = sizeof (CANDCmdStruct);
-    if (m_obIPCCmdTx.IPC_SendPacket ((void *) &stRegCmd, nCount) == nCount)
+    if (SendToCAND ((void *) &stRegCmd, nCount) == nCount)
     {
       nRetVal = ERR_SUCCESS;
     }
@@ -473,7 +506,7 @@ int CCANComm::CANTxCmd (unsigned char* pbyData, // Pointer to data
 
       if( FN_FFB_STATUS == m_byFnType )
       {
-        if (m_obIPCCmdTx.IPC_SendPacket ((void *) &stRegCmd, nCount) != nCount)
+        if (SendToCAND ((void *) &stRegCmd, nCount) != nCount)
         {
           // Sending Tx command failed!
           nRetVal = ERR_INTERNAL_ERR;
@@ -494,7 +527,7 @@ int CCANComm::CANTxCmd (unsigned char* pbyData, // Pointer to data
 
     if( FN_FFB_STATUS != m_byFnType )
     {
-      if (m_obIPCCmdTx.IPC_SendPacket ((void *) byTxData, nTxDataIndex) != nTxDataIndex)
+      if (SendToCAND ((void *) byTxData, nTxDataIndex) != nTxDataIndex)
       {
         // Sending Tx command failed!
         nRetVal = ERR_INTERNAL_ERR;
@@ -517,7 +550,7 @@ int CCANComm::CANTxCmd (unsigned char* pbyData, // Pointer to data
     stRegCmd.CmdData.stTxData.PktLen = unDataLen + sizeof (DevAddrUnion);
         
     nCount = sizeof (CANDCmdStruct);
-    if (m_obIPCCmdTx.IPC_SendPacket ((void *) &stRegCmd, nCount) != nCount)
+    if (SendToCAND ((void *) &stRegCmd, nCount) != nCount)
     {
       // Sending Tx command failed!
       nRetVal = ERR_INTERNAL_ERR;
@@ -538,6 +571,7 @@ int CCANComm::CANTxCmd (unsigned char* pbyData, // Pointer to data
 int CCANComm::CANRxCmdRespBlocking (unsigned char* pbyData, // Pointer to write data to
                                     unsigned int unDataLen)  // Number of bytes to read
 {
+  CHALLock obCmdLock(&m_obCmdLock);
   return RxData (pbyData, unDataLen, FALSE, NULL);
 }
 
@@ -551,6 +585,7 @@ int CCANComm::CANRxCmdRespTimeout (unsigned char* pbyData, // Pointer to write d
                                    unsigned int unDataLen,        // Number of bytes to read  
                                    unsigned int unTimeOut/* = 1000*/)   // Timeout in milli-seconds 
 {
+  CHALLock obCmdLock(&m_obCmdLock);
   return RxData (pbyData, unDataLen, FALSE, &unTimeOut);
 }
 
@@ -562,7 +597,18 @@ int CCANComm::CANRxCmdRespTimeout (unsigned char* pbyData, // Pointer to write d
 int CCANComm::CANRxStrmBlocking (unsigned char* pbyData,  // Pointer to write data to
                                  unsigned int unDataLen)  // Number of bytes to read
 {
-  return RxData (pbyData, unDataLen, TRUE, NULL);
+  CHALLock obStrmLock(&m_obStrmLock);
+
+  unsigned long long ullTraceUs = CHALTrace::Begin();
+
+  int nRetVal = RxData (pbyData, unDataLen, TRUE, NULL);
+
+  if (ullTraceUs)
+  {
+    CHALTrace::Record(HAL_TRACE_STREAM_READ, NULL, m_bySlotID, m_byFnType, m_byFnEnum, ullTraceUs, unDataLen, nRetVal);
+  }
+
+  return nRetVal;
 }
 
 // Read streaming data from remote device. The user can specify a time out in 
@@ -578,8 +624,17 @@ int CCANComm::CANRxStrmTimeout (unsigned char* pbyData, // Pointer to write data
 {
   int nRetVal = ERR_SUCCESS;
 
+  CHALLock obStrmLock(&m_obStrmLock);
+
+  unsigned long long ullTraceUs = CHALTrace::Begin();
+
   nRetVal = RxData (pbyData, unDataLen, TRUE, &unTimeOut);
 
+  if (ullTraceUs)
+  {
+    CHALTrace::Record(HAL_TRACE_STREAM_READ, NULL, m_bySlotID, m_byFnType, m_byFnEnum, ullTraceUs, unDataLen, nRetVal);
+  }
+
   //Store the remaining time out of the specified timeout value
   if (punRemTimeout)
   {
@@ -594,16 +649,28 @@ int CCANComm::CANFlushCmdRespPipe ()
   int nRetVal = ERR_SUCCESS;
   int nErrorCode = 0;
 
+  CHALLock obCmdLock(&m_obCmdLock);
+
   // Check if the Pipe is open before trying to flush it
   if (m_bIsCmdRespPipeOpen)
   {
     // Flush the pipe
-    nErrorCode = m_obIPCCmdRespRx.IPC_Flush();
+    if (m_pstMuxChannel)
+    {
+      CCANMux::Flush (m_pstMuxChannel, FALSE);
+    }
+    else
+    {
+      nErrorCode = m_obIPCCmdRespRx.IPC_Flush();
+    }
     if (nErrorCode < 0)
     {
       nRetVal = ERR_INTERNAL_ERR;
       DEBUG2("CCANComm::CANFlushCmdRespPipe: Cmd Resp Pipe - IPC_Flush () failed with error code = %d!", nErrorCode);
     }
+
+    // Drop any partially received fragmented response as well
+    m_obCmdRespFrag.Flush();
   }
   else
   {
@@ -620,6 +687,15 @@ int CCANComm::CloseRxPipes()
 {
   int nRetVal = ERR_SUCCESS;
 
+  // Detach from the multiplexed connection
+  if (m_pstMuxChannel)
+  {
+    CCANMux::Detach (m_pstMuxChannel);
+    m_pstMuxChannel = NULL;
+    m_bIsCmdRespPipeOpen = FALSE;
+    m_bIsStreamPipeOpen = FALSE;
+  }
+
   // Close Cmd Resp Pipe
   if (m_bIsCmdRespPipeOpen)
   {
@@ -655,7 +731,13 @@ int CCANComm::RxData (unsigned char* pbyData, // Pointer to write data to
   CANDRespStruct stResp;
   int nBytesRxd = 0;
   INT32 nRemTimeout;// = *punTimeout;//Using the same datatype as in IPC library
-  m_nRemTimeOut = 0;
+
+  // The remaining time-out of stream reads is returned through punTimeout, 
+  // GetRemTimeOut() reports the last command response only
+  if (bStrmPipe == FALSE)
+  {
+    m_nRemTimeOut = 0;
+  }
 
   CFragment *pobFragment;
   BOOL bLoopExit = FALSE;
@@ -690,7 +772,12 @@ int CCANComm::RxData (unsigned char* pbyData, // Pointer to write data to
     {
       memset (&stResp, 0, nCount);
     
-      if (bStrmPipe)
+      if (m_pstMuxChannel)
+      {
+        // Device queue on the multiplexed connection
+        nBytesRxd = CCANMux::Receive (m_pstMuxChannel, bStrmPipe, &stResp, punTimeout ? &nRemTimeout : NULL);
+      }
+      else if (bStrmPipe)
       {
         if (punTimeout == NULL) // Blocking receive
         {
@@ -809,7 +896,10 @@ int CCANComm::RxData (unsigned char* pbyData, // Pointer to write data to
     } // while ( !(bLoopExit) )
 
 
-    m_nRemTimeOut = nRemTimeout;
+    if (bStrmPipe == FALSE)
+    {
+      m_nRemTimeOut = nRemTimeout;
+    }
   }
 
   return nRetVal;
@@ -825,6 +915,9 @@ int CCANComm::CANGetRemoteResp (unsigned char* pbyCmd,  // Data to form command
 {
   int nRetVal = ERR_SUCCESS;
 
+  // The command and its response are one exchange
+  CHALLock obCmdLock(&m_obCmdLock);
+
   // Check input pointers
   if (pbyCmd == NULL || 
       pbyRespData == NULL)
@@ -844,7 +937,14 @@ int CCANComm::CANGetRemoteResp (unsigned char* pbyCmd,  // Data to form command
 #endif
 
 #warning "FLUSHING RX PIPE BEFORE RECEIVING A RESPONSE - TESTING"
-  m_obIPCCmdRespRx.IPC_Flush();
+  if (m_pstMuxChannel)
+  {
+    CCANMux::Flush (m_pstMuxChannel, FALSE);
+  }
+  else
+  {
+    m_obIPCCmdRespRx.IPC_Flush();
+  }
 
 #warning "FLUSHING CMD RESP PACKET DE-FRAGMENTER"
   m_obCmdRespFrag.Flush();
@@ -868,6 +968,12 @@ int CCANComm::CANGetRemoteResp (unsigned char* pbyCmd,  // Data to form command
 //Return Receive Pipe File Descriptor - Streaming data from remote board
 int CCANComm::CANGetRxStrmFd()
 { 
+  // On the multiplexed connection, an fd that is readable while stream data is queued
+  if (m_pstMuxChannel)
+  {
+    return CCANMux::GetStreamFd (m_pstMuxChannel);
+  }
+
   return m_obIPCStreamRx.GetFd();
 }
 
@@ -876,11 +982,20 @@ int CCANComm::CANFlushStreamPipe ()
   int nRetVal = ERR_SUCCESS;
   int nErrorCode = 0;
 
+  CHALLock obStrmLock(&m_obStrmLock);
+
   // Check if the Pipe is open before trying to flush it
   if (m_bIsStreamPipeOpen )
   {
     // Flush the pipe
-    nErrorCode = m_obIPCStreamRx.IPC_Flush();
+    if (m_pstMuxChannel)
+    {
+      CCANMux::Flush (m_pstMuxChannel, TRUE);
+    }
+    else
+    {
+      nErrorCode = m_obIPCStreamRx.IPC_Flush();
+    }
     if (nErrorCode < 0)
     {
       nRetVal = ERR_INTERNAL_ERR;
@@ -903,4 +1018,28 @@ int CCANComm::GetRemTimeOut()
   return m_nRemTimeOut;
 }
 
+// Slot address of the remote device this channel was opened for
+unsigned char CCANComm::GetSlotID()
+{
+  return m_bySlotID;
+}
+
+// Lock held for command / response exchanges with the device
+CHALMutex *CCANComm::GetCmdLock()
+{
+  return &m_obCmdLock;
+}
 
+// Lock held while reading streaming data from the device
+CHALMutex *CCANComm::GetStrmLock()
+{
+  return &m_obStrmLock;
+}
+
+// Write a packet to the Command TX Pipe. The pipe is shared by all the objects in 
+// the process; packets from different threads must not be interleaved.
+int CCANComm::SendToCAND (void *pvData, int nCount)
+{
+  CHALLock obTxLock(&m_TxMutex);
+  return m_obIPCCmdTx.IPC_SendPacket (pvData, nCount);
+}
@@ -0,0 +1,590 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                     10241 West Little York, Suite 200
+ * *                            Houston, TX 77040
+ * *
+ * *
+ * *  Filename: CANMux.cpp
+ * *
+ * *  Description: One multiplexed connection from CAND per process, with
+ * *               received CAN packets demultiplexed to the devices.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include "FixEndian.h"
+
+#include "debug.h"
+#include "CANMux.h"
+
+// How long the demultiplexer thread waits for data before checking whether it
+// is still needed (ms)
+#define CAN_MUX_IDLE_POLL_INTERVAL  100
+
+// Queue of packets received for one device
+struct CANMuxQueueStruct {
+  CANDRespStruct *pstPkts;
+  int nSize;
+  int nHead;
+  int nCount;
+  pthread_cond_t Cond;    // Signalled when a packet is queued
+};
+
+struct CANMuxChannelStruct {
+  unsigned char bySlotId;
+  unsigned char byFnType;
+  unsigned char byFnEnum;
+  CANMuxQueueStruct stRespQ;
+  CANMuxQueueStruct stStrmQ;
+  int anNotifyFd[2];      // Stream notification pipe - created by GetStreamFd()
+};
+
+BOOL CCANMux::m_bEnabled = FALSE;
+pthread_mutex_t CCANMux::m_Mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_t CCANMux::m_DemuxThread;
+BOOL CCANMux::m_bDemuxThreadRunning = FALSE;
+BOOL CCANMux::m_bPipesOpen = FALSE;
+int CCANMux::m_nPipeTaskId = 0;
+CIPC CCANMux::m_obIPCCmdRespRx;
+CIPC CCANMux::m_obIPCStreamRx;
+CANMuxChannelStruct *CCANMux::m_apstChannels[CAN_MUX_MAX_CHANNELS];
+int CCANMux::m_nChannels = 0;
+CANMuxStatsStruct CCANMux::m_stStats;
+
+// Queue helpers - called with m_Mutex held
+static void InitQueue(CANMuxQueueStruct *pstQueue, int nSize)
+{
+  pthread_condattr_t stAttr;
+
+  pstQueue->pstPkts = (nSize > 0) ? new CANDRespStruct[nSize] : NULL;
+  pstQueue->nSize = nSize;
+  pstQueue->nHead = 0;
+  pstQueue->nCount = 0;
+
+  // Timed waits use the monotonic clock, like the rest of the reliability layer
+  pthread_condattr_init(&stAttr);
+  pthread_condattr_setclock(&stAttr, CLOCK_MONOTONIC);
+  pthread_cond_init(&pstQueue->Cond, &stAttr);
+  pthread_condattr_destroy(&stAttr);
+}
+
+static void FreeQueue(CANMuxQueueStruct *pstQueue)
+{
+  delete [] pstQueue->pstPkts;
+  pstQueue->pstPkts = NULL;
+  pthread_cond_destroy(&pstQueue->Cond);
+}
+
+// Set or clear the stream notification for a channel
+static void NotifyStream(CANMuxChannelStruct *pstChannel, BOOL bDataQueued)
+{
+  unsigned char byDummy = 0;
+
+  if (pstChannel->anNotifyFd[0] < 0)
+  {
+    return;
+  }
+
+  // The notification pipe holds one byte while stream data is queued
+  if (bDataQueued)
+  {
+    if (write(pstChannel->anNotifyFd[1], &byDummy, 1) != 1)
+    {
+      DEBUG2("CCANMux: Stream notification write failed! errno = %d", errno);
+    }
+  }
+  else
+  {
+    while (read(pstChannel->anNotifyFd[0], &byDummy, 1) == 1)
+    {
+    }
+  }
+}
+
+// Use the multiplexed connection (or not) for devices opened from now on
+void CCANMux::Enable(BOOL bEnable)
+{
+  pthread_mutex_lock(&m_Mutex);
+  m_bEnabled = bEnable;
+  pthread_mutex_unlock(&m_Mutex);
+}
+
+BOOL CCANMux::IsEnabled()
+{
+  BOOL bEnabled;
+
+  pthread_mutex_lock(&m_Mutex);
+  bEnabled = m_bEnabled;
+  pthread_mutex_unlock(&m_Mutex);
+
+  return bEnabled;
+}
+
+// Counters for the multiplexed connection
+void CCANMux::GetStats(CANMuxStatsStruct *pstStats)
+{
+  if (pstStats)
+  {
+    pthread_mutex_lock(&m_Mutex);
+    *pstStats = m_stStats;
+    pstStats->nOpenChannels = m_nChannels;
+    pthread_mutex_unlock(&m_Mutex);
+  }
+}
+
+// Attach a device to the shared pipes
+int CCANMux::Attach(unsigned char bySlotId, unsigned char byFnType, unsigned char byFnEnum,
+                    BOOL bIsStreaming, CANMuxChannelStruct **ppstChannel, int *pnPipeTaskId)
+{
+  int nRetVal = ERR_SUCCESS;
+  int nFree = -1;
+
+  if (ppstChannel == NULL || pnPipeTaskId == NULL)
+  {
+    DEBUG2("CCANMux::Attach: Invalid arguments!");
+    return ERR_INVALID_ARGS;
+  }
+
+  pthread_mutex_lock(&m_Mutex);
+
+  for (int nCount = 0; nCount < CAN_MUX_MAX_CHANNELS; nCount++)
+  {
+    CANMuxChannelStruct *pstChannel = m_apstChannels[nCount];
+    if (pstChannel == NULL)
+    {
+      if (nFree < 0)
+      {
+        nFree = nCount;
+      }
+    }
+    else if (pstChannel->bySlotId == bySlotId &&
+             pstChannel->byFnType == byFnType &&
+             pstChannel->byFnEnum == byFnEnum)
+    {
+      nRetVal = ERR_DEV_IN_USE;
+      DEBUG2("CCANMux::Attach: Device %d:%d:%d already open in this process!", bySlotId, byFnType, byFnEnum);
+      break;
+    }
+  }
+
+  if (nRetVal == ERR_SUCCESS && nFree < 0)
+  {
+    nRetVal = ERR_INTERNAL_ERR;
+    DEBUG2("CCANMux::Attach: Too many devices open on the multiplexed connection!");
+  }
+
+  if (nRetVal == ERR_SUCCESS && !m_bPipesOpen)
+  {
+    nRetVal = OpenPipes();
+  }
+
+  if (nRetVal == ERR_SUCCESS && !m_bDemuxThreadRunning)
+  {
+    pthread_attr_t stAttr;
+    pthread_attr_init(&stAttr);
+    pthread_attr_setdetachstate(&stAttr, PTHREAD_CREATE_DETACHED);
+    if (0 == pthread_create(&m_DemuxThread, &stAttr, DemuxThread, NULL))
+    {
+      m_bDemuxThreadRunning = TRUE;
+    }
+    else
+    {
+      nRetVal = ERR_INTERNAL_ERR;
+      DEBUG1("CCANMux::Attach: Unable to start the demultiplexer thread!");
+    }
+    pthread_attr_destroy(&stAttr);
+  }
+
+  if (nRetVal == ERR_SUCCESS)
+  {
+    CANMuxChannelStruct *pstChannel = new CANMuxChannelStruct;
+    pstChannel->bySlotId = bySlotId;
+    pstChannel->byFnType = byFnType;
+    pstChannel->byFnEnum = byFnEnum;
+    InitQueue(&pstChannel->stRespQ, CAN_MUX_RESP_QUEUE_LEN);
+    InitQueue(&pstChannel->stStrmQ, bIsStreaming ? CAN_MUX_STRM_QUEUE_LEN : 0);
+    pstChannel->anNotifyFd[0] = -1;
+    pstChannel->anNotifyFd[1] = -1;
+
+    m_apstChannels[nFree] = pstChannel;
+    m_nChannels++;
+
+    *ppstChannel = pstChannel;
+    *pnPipeTaskId = m_nPipeTaskId;
+  }
+
+  pthread_mutex_unlock(&m_Mutex);
+
+  return nRetVal;
+}
+
+// Detach a device. Packets still queued for it are dropped.
+void CCANMux::Detach(CANMuxChannelStruct *pstChannel)
+{
+  if (pstChannel == NULL)
+  {
+    return;
+  }
+
+  pthread_mutex_lock(&m_Mutex);
+
+  for (int nCount = 0; nCount < CAN_MUX_MAX_CHANNELS; nCount++)
+  {
+    if (m_apstChannels[nCount] == pstChannel)
+    {
+      m_apstChannels[nCount] = NULL;
+      m_nChannels--;
+      break;
+    }
+  }
+
+  // The demultiplexer thread closes the shared pipes and exits once it sees
+  // that no device is left
+  pthread_mutex_unlock(&m_Mutex);
+
+  if (pstChannel->anNotifyFd[0] >= 0)
+  {
+    close(pstChannel->anNotifyFd[0]);
+    close(pstChannel->anNotifyFd[1]);
+  }
+  FreeQueue(&pstChannel->stRespQ);
+  FreeQueue(&pstChannel->stStrmQ);
+  delete pstChannel;
+}
+
+// Get the next packet queued for a device
+int CCANMux::Receive(CANMuxChannelStruct *pstChannel, BOOL bStrmPipe,
+                     CANDRespStruct *pstResp, INT32 *pnTimeout)
+{
+  int nRetVal = ERR_TIMEOUT;
+  struct timespec stDeadline;
+
+  if (pstChannel == NULL || pstResp == NULL)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  CANMuxQueueStruct *pstQueue = bStrmPipe ? &pstChannel->stStrmQ : &pstChannel->stRespQ;
+
+  if (pnTimeout)
+  {
+    INT32 nTimeout = (*pnTimeout > 0) ? *pnTimeout : 0;
+    clock_gettime(CLOCK_MONOTONIC, &stDeadline);
+    stDeadline.tv_sec += nTimeout / 1000;
+    stDeadline.tv_nsec += (nTimeout % 1000) * 1000000L;
+    if (stDeadline.tv_nsec >= 1000000000L)
+    {
+      stDeadline.tv_sec++;
+      stDeadline.tv_nsec -= 1000000000L;
+    }
+  }
+
+  pthread_mutex_lock(&m_Mutex);
+
+  while (pstQueue->nCount == 0)
+  {
+    if (pnTimeout == NULL)
+    {
+      pthread_cond_wait(&pstQueue->Cond, &m_Mutex);
+    }
+    else if (pthread_cond_timedwait(&pstQueue->Cond, &m_Mutex, &stDeadline) == ETIMEDOUT)
+    {
+      break;
+    }
+  }
+
+  if (pstQueue->nCount > 0)
+  {
+    *pstResp = pstQueue->pstPkts[pstQueue->nHead];
+    pstQueue->nHead = (pstQueue->nHead + 1) % pstQueue->nSize;
+    pstQueue->nCount--;
+    if (bStrmPipe && pstQueue->nCount == 0)
+    {
+      NotifyStream(pstChannel, FALSE);
+    }
+    nRetVal = sizeof (CANDRespStruct);
+  }
+
+  pthread_mutex_unlock(&m_Mutex);
+
+  // Time left of the specified timeout
+  if (pnTimeout)
+  {
+    struct timespec stNow;
+    clock_gettime(CLOCK_MONOTONIC, &stNow);
+    long lRemMs = (stDeadline.tv_sec - stNow.tv_sec) * 1000L +
+                  (stDeadline.tv_nsec - stNow.tv_nsec) / 1000000L;
+    *pnTimeout = (lRemMs > 0) ? (INT32)lRemMs : 0;
+  }
+
+  return nRetVal;
+}
+
+// Drop all packets queued for a device
+void CCANMux::Flush(CANMuxChannelStruct *pstChannel, BOOL bStrmPipe)
+{
+  if (pstChannel == NULL)
+  {
+    return;
+  }
+
+  pthread_mutex_lock(&m_Mutex);
+  CANMuxQueueStruct *pstQueue = bStrmPipe ? &pstChannel->stStrmQ : &pstChannel->stRespQ;
+  if (pstQueue->nCount > 0)
+  {
+    pstQueue->nHead = 0;
+    pstQueue->nCount = 0;
+    if (bStrmPipe)
+    {
+      NotifyStream(pstChannel, FALSE);
+    }
+  }
+  pthread_mutex_unlock(&m_Mutex);
+}
+
+// Fd readable while stream data is queued for the device
+int CCANMux::GetStreamFd(CANMuxChannelStruct *pstChannel)
+{
+  int nFd = -1;
+
+  if (pstChannel == NULL)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  pthread_mutex_lock(&m_Mutex);
+
+  // Created on first use - most devices are never select()'ed on
+  if (pstChannel->anNotifyFd[0] < 0)
+  {
+    if (pipe(pstChannel->anNotifyFd) == 0)
+    {
+      fcntl(pstChannel->anNotifyFd[0], F_SETFL, O_NONBLOCK);
+      fcntl(pstChannel->anNotifyFd[1], F_SETFL, O_NONBLOCK);
+      if (pstChannel->stStrmQ.nCount > 0)
+      {
+        NotifyStream(pstChannel, TRUE);
+      }
+    }
+    else
+    {
+      pstChannel->anNotifyFd[0] = -1;
+      pstChannel->anNotifyFd[1] = -1;
+      DEBUG2("CCANMux::GetStreamFd: Unable to create notification pipe! errno = %d", errno);
+    }
+  }
+  nFd = pstChannel->anNotifyFd[0];
+
+  pthread_mutex_unlock(&m_Mutex);
+
+  return nFd;
+}
+
+// Open the shared pipes - called with m_Mutex held
+int CCANMux::OpenPipes()
+{
+  m_nPipeTaskId = CAN_MUX_PIPE_TASK_ID_BASE + getpid();
+
+  if (m_obIPCCmdRespRx.IPC_InitIPC(m_nPipeTaskId, CMD_RESP_PIPE_MAILBOX_ID, IPC_RECV))
+  {
+    DEBUG1("CCANMux::OpenPipes: Error opening the shared Cmd Resp Pipe %d!", m_nPipeTaskId);
+    return ERR_INTERNAL_ERR;
+  }
+
+  if (m_obIPCStreamRx.IPC_InitIPC(m_nPipeTaskId, CMD_STRM_PIPE_MAILBOX_ID, IPC_RECV))
+  {
+    DEBUG1("CCANMux::OpenPipes: Error opening the shared Stream Pipe %d!", m_nPipeTaskId);
+    m_obIPCCmdRespRx.IPC_Close();
+    return ERR_INTERNAL_ERR;
+  }
+
+  m_bPipesOpen = TRUE;
+
+  return ERR_SUCCESS;
+}
+
+// Close the shared pipes - called with m_Mutex held
+void CCANMux::ClosePipes()
+{
+  if (m_bPipesOpen)
+  {
+    m_obIPCCmdRespRx.IPC_Close();
+    m_obIPCStreamRx.IPC_Close();
+    m_bPipesOpen = FALSE;
+  }
+}
+
+// Read and dispatch whatever is in a shared pipe. CAND writes whole CANDRespStruct
+// packets; a partial packet is kept in the buffer until the rest arrives.
+void CCANMux::ReadPipe(int nFd, CANDRespStruct *pstBuf, int *pnBufBytes)
+{
+  int nBufSize = CAN_MUX_READ_BATCH * sizeof (CANDRespStruct);
+
+  // Read the FIFO behind the CIPC object directly, to get many packets per call -
+  // the CIPC receive calls return one packet each. This relies on CIPC adding no
+  // framing: the pipe holds the bytes CAND passed to IPC_SendPacket() and nothing
+  // else. Should CIPC ever add a header, go back to IPC_RecvPacketTimeout() here.
+  int nBytesRxd = read(nFd, (unsigned char *) pstBuf + *pnBufBytes, nBufSize - *pnBufBytes);
+
+  if (nBytesRxd <= 0)
+  {
+    if (nBytesRxd < 0 && errno != EAGAIN && errno != EINTR)
+    {
+      DEBUG2("CCANMux::ReadPipe: read() failed! errno = %d", errno);
+    }
+    return;
+  }
+
+  *pnBufBytes += nBytesRxd;
+  int nNumPkts = *pnBufBytes / sizeof (CANDRespStruct);
+  int nUsedBytes = nNumPkts * sizeof (CANDRespStruct);
+
+  pthread_mutex_lock(&m_Mutex);
+  m_stStats.ulPipeReads++;
+  Dispatch(pstBuf, nNumPkts);
+  pthread_mutex_unlock(&m_Mutex);
+
+  *pnBufBytes -= nUsedBytes;
+  if (*pnBufBytes > 0)
+  {
+    memmove(pstBuf, (unsigned char *) pstBuf + nUsedBytes, *pnBufBytes);
+  }
+}
+
+// Queue received packets for the devices they are addressed to - called with m_Mutex held
+void CCANMux::Dispatch(const CANDRespStruct *pstPkts, int nNumPkts)
+{
+  for (int nPkt = 0; nPkt < nNumPkts; nPkt++)
+  {
+    const CANDRespStruct *pstPkt = &pstPkts[nPkt];
+    DevAddrUnion DevAddr;
+    CANMuxChannelStruct *pstChannel = NULL;
+
+    m_stStats.ulPktsRxd++;
+
+    // Device address from the CAN header
+    memcpy(&DevAddr.usDevAd, pstPkt->stRespData.stRxData.PktData, sizeof (DevAddrUnion));
+    FixEndian(DevAddr.usDevAd);
+    unsigned char bySlotId = GetSlotID(&DevAddr.usDevAd);
+    unsigned char byFnType = GetFnType(&DevAddr.usDevAd);
+    unsigned char byFnEnum = GetFnCount(&DevAddr.usDevAd);
+
+    for (int nCount = 0; nCount < CAN_MUX_MAX_CHANNELS; nCount++)
+    {
+      CANMuxChannelStruct *pstCandidate = m_apstChannels[nCount];
+      if (pstCandidate &&
+          pstCandidate->bySlotId == bySlotId &&
+          pstCandidate->byFnType == byFnType &&
+          pstCandidate->byFnEnum == byFnEnum)
+      {
+        pstChannel = pstCandidate;
+        break;
+      }
+    }
+
+    BOOL bStrmPkt = (STREAM_DATA == pstPkt->RespType);
+    CANMuxQueueStruct *pstQueue = NULL;
+    if (pstChannel)
+    {
+      pstQueue = bStrmPkt ? &pstChannel->stStrmQ : &pstChannel->stRespQ;
+    }
+
+    // Closed in the meantime, or stream data for a device not opened for streaming
+    if (pstQueue == NULL || pstQueue->nSize == 0)
+    {
+      m_stStats.ulPktsUnknown++;
+      continue;
+    }
+
+    // Queue full - drop the oldest packet to make room for this one, so a slow
+    // reader gets the latest data (counted in ulPktsDropped)
+    if (pstQueue->nCount == pstQueue->nSize)
+    {
+      pstQueue->nHead = (pstQueue->nHead + 1) % pstQueue->nSize;
+      pstQueue->nCount--;
+      m_stStats.ulPktsDropped++;
+    }
+
+    pstQueue->pstPkts[(pstQueue->nHead + pstQueue->nCount) % pstQueue->nSize] = *pstPkt;
+    pstQueue->nCount++;
+    pthread_cond_broadcast(&pstQueue->Cond);
+
+    if (bStrmPkt && pstQueue->nCount == 1)
+    {
+      NotifyStream(pstChannel, TRUE);
+    }
+  }
+}
+
+// Read the shared pipes and dispatch the packets. Exits (closing the pipes)
+// when no device is left on the multiplexed connection.
+void *CCANMux::DemuxThread(void *pvArg)
+{
+  CANDRespStruct astRespBuf[CAN_MUX_READ_BATCH];
+  CANDRespStruct astStrmBuf[CAN_MUX_READ_BATCH];
+  int nRespBufBytes = 0;
+  int nStrmBufBytes = 0;
+  struct pollfd astPollFd[2];
+
+  while (TRUE)
+  {
+    pthread_mutex_lock(&m_Mutex);
+    if (m_nChannels == 0)
+    {
+      ClosePipes();
+      m_bDemuxThreadRunning = FALSE;
+      pthread_mutex_unlock(&m_Mutex);
+      break;
+    }
+    astPollFd[0].fd = m_obIPCCmdRespRx.GetFd();
+    astPollFd[1].fd = m_obIPCStreamRx.GetFd();
+    pthread_mutex_unlock(&m_Mutex);
+
+    astPollFd[0].events = POLLIN;
+    astPollFd[1].events = POLLIN;
+    astPollFd[0].revents = 0;
+    astPollFd[1].revents = 0;
+
+    int nReady = poll(astPollFd, 2, CAN_MUX_IDLE_POLL_INTERVAL);
+    if (nReady < 0)
+    {
+      if (errno != EINTR)
+      {
+        DEBUG1("CCANMux::DemuxThread: poll() failed! errno = %d", errno);
+        usleep(CAN_MUX_IDLE_POLL_INTERVAL * 1000);
+      }
+      continue;
+    }
+
+    if (astPollFd[0].revents & POLLIN)
+    {
+      ReadPipe(astPollFd[0].fd, astRespBuf, &nRespBufBytes);
+    }
+    if (astPollFd[1].revents & POLLIN)
+    {
+      ReadPipe(astPollFd[1].fd, astStrmBuf, &nStrmBufBytes);
+    }
+
+    // No writer on a pipe (CAND not running) - avoid spinning on POLLHUP
+    if ((astPollFd[0].revents | astPollFd[1].revents) & (POLLHUP | POLLERR))
+    {
+      usleep(CAN_MUX_IDLE_POLL_INTERVAL * 1000);
+    }
+  }
+
+  return NULL;
+}
@@ -0,0 +1,181 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                     10241 West Little York, Suite 200
+ * *                            Houston, TX 77040
+ * *
+ * *
+ * *  Filename: DevConfigCache.cpp
+ * *
+ * *  Description: Write-through cache of the configuration settings of a
+ * *               device function.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+#include <string.h>
+
+#include "DevConfigCache.h"
+
+CDevConfigCache::CDevConfigCache()
+{
+  m_pstMap = NULL;
+  m_nMapLen = 0;
+  m_bEnabled = FALSE;
+  memset(m_astEntry, 0, sizeof (m_astEntry));
+  memset(&m_stStats, 0, sizeof (m_stStats));
+}
+
+// Settings of the device class
+void CDevConfigCache::SetMap(const DevCacheMapStruct *pstMap, int nMapLen)
+{
+  if (NULL == pstMap || nMapLen < 0)
+  {
+    nMapLen = 0;
+  }
+  else if (nMapLen > DEV_CACHE_MAX_ENTRIES)
+  {
+    nMapLen = DEV_CACHE_MAX_ENTRIES;
+  }
+
+  m_pstMap = pstMap;
+  m_nMapLen = nMapLen;
+  memset(m_astEntry, 0, sizeof (m_astEntry));
+}
+
+// Turn the cache on / off
+void CDevConfigCache::Enable(BOOL bEnable)
+{
+  memset(m_astEntry, 0, sizeof (m_astEntry));
+  m_bEnabled = bEnable && HasMap();
+}
+
+// Forget all values
+void CDevConfigCache::Invalidate()
+{
+  if (m_bEnabled)
+  {
+    memset(m_astEntry, 0, sizeof (m_astEntry));
+    m_stStats.ulInvalidations++;
+  }
+}
+
+// Entry of a get command
+CDevConfigCache::EntryStruct *CDevConfigCache::FindGetEntry(unsigned char byCommand)
+{
+  for (int nRow = 0; nRow < m_nMapLen; nRow++)
+  {
+    if (m_pstMap[nRow].byGetCmd == byCommand)
+    {
+      return &m_astEntry[nRow];
+    }
+  }
+
+  return NULL;
+}
+
+void CDevConfigCache::Store(EntryStruct *pstEntry, const unsigned char *pbyData, unsigned int unLen)
+{
+  if (unLen > DEV_CACHE_MAX_DATA)
+  {
+    pstEntry->bValid = FALSE;
+    return;
+  }
+
+  memcpy(pstEntry->abyData, pbyData, unLen);
+  pstEntry->unLen = unLen;
+  pstEntry->bValid = TRUE;
+}
+
+// Does a request change a cached setting?
+BOOL CDevConfigCache::IsSetCommand(unsigned char byCommand) const
+{
+  for (int nRow = 0; nRow < m_nMapLen; nRow++)
+  {
+    if (m_pstMap[nRow].bySetCmd == byCommand)
+    {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+// Answer a get request from the cache
+BOOL CDevConfigCache::Lookup(CDevTxn &obTxn)
+{
+  if (!m_bEnabled)
+  {
+    return FALSE;
+  }
+
+  EntryStruct *pstEntry = FindGetEntry(obTxn.GetCommand());
+  if (NULL == pstEntry)
+  {
+    return FALSE;
+  }
+
+  if ( !pstEntry->bValid || (sizeof (CmdAckUnion) + pstEntry->unLen != obTxn.GetRespLen()) )
+  {
+    m_stStats.ulMisses++;
+    return FALSE;
+  }
+
+  // As the device would have answered
+  unsigned char *pbyResp = obTxn.GetRespBuf();
+  memset(pbyResp, 0, sizeof (CmdAckUnion));
+  SetCmdAckCommand(pbyResp, obTxn.GetCommand());
+  memcpy(pbyResp + sizeof (CmdAckUnion), pstEntry->abyData, pstEntry->unLen);
+  obTxn.SetRespBytes(obTxn.GetRespLen());
+  obTxn.FinishResp();
+  obTxn.SetResult(ERR_SUCCESS);
+
+  m_stStats.ulHits++;
+  return TRUE;
+}
+
+// Take in an ACK'd request
+void CDevConfigCache::Update(CDevTxn &obTxn)
+{
+  if (!m_bEnabled)
+  {
+    return;
+  }
+
+  unsigned char byCommand = obTxn.GetCommand();
+
+  EntryStruct *pstEntry = FindGetEntry(byCommand);
+  if (pstEntry)
+  {
+    Store(pstEntry, obTxn.GetRespBuf() + sizeof (CmdAckUnion), obTxn.GetRespLen() - sizeof (CmdAckUnion));
+    return;
+  }
+
+  for (int nRow = 0; nRow < m_nMapLen; nRow++)
+  {
+    const DevCacheMapStruct &stRow = m_pstMap[nRow];
+    if (stRow.bySetCmd != byCommand)
+    {
+      continue;
+    }
+
+    pstEntry = FindGetEntry(stRow.byGetCmd);
+    if (stRow.bWriteThrough)
+    {
+      // The command is in wire order once it has been sent
+      Store(pstEntry, obTxn.GetCmdBuf() + sizeof (CmdAckUnion), obTxn.GetCmdLen() - sizeof (CmdAckUnion));
+      m_stStats.ulWrites++;
+    }
+    else
+    {
+      pstEntry->bValid = FALSE;
+    }
+  }
+}
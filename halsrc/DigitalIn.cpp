@@ -186,6 +186,7 @@ int CDigitalIn::GetDigitalInStatus(BOOL* pbStatus)      // Pointer to write stat
     case SPI_COMM:
       if (m_nExpSlotSPIfd != -1)
       {
+        CHALLock obSPILock(&m_ExpSlotSPIMutex);
         char  * szCmdData = "bn 0x00";
         char  szRespData[DATA_BUFF_SZ] = {0};
         if (write (m_nExpSlotSPIfd, szCmdData, strlen (szCmdData)) != (int) strlen (szCmdData))
@@ -196,6 +196,8 @@ int CDigitalOut::SetDigitalOutStatus(BOOL bStatus)
     case SPI_COMM:
       if (m_nExpSlotSPIfd != -1)
       {
+        // The states of all the outputs on the card are written together
+        CHALLock obSPILock(&m_ExpSlotSPIMutex);
         int nStartIndex = (m_bySlotID - 1) * NR_ENUM_ROC_DIGITAL_OUT;
         if( TRUE == bStatus )
         {
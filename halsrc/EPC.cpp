@@ -93,9 +93,29 @@
   
 #include "debug.h"
 #include "EPC.h"
+#include "WireLayouts.h"
+
+// Requests to the EPC function - set commands get a status back, get commands
+// get the Base IO data union back.
+typedef CDevRequest<CAN_EPC_DATA_STRUCT, CAN_BASEIO_STATUS_STRUCT> CEPCSetRequest;
+typedef CDevRequest<CmdAckUnion, CAN_BASEIO_STATUS_STRUCT>         CEPCCmdRequest;
+typedef CDevRequest<CmdAckUnion, CAN_EPC_DATA_STRUCT>              CEPCGetRequest;
+
+#ifdef MODEL_370XA
+// Settings the configuration cache may hold. The board has no read back of the
+// pressure setpoint or of the compensation values.
+static const DevCacheMapStruct s_astEPCCacheMap[] = {
+  { CMD_EPC_FN_SET_PROP_GAIN,  CMD_EPC_FN_GET_PROP_GAIN,  TRUE },
+  { CMD_EPC_FN_SET_INT_GAIN,   CMD_EPC_FN_GET_INT_GAIN,   TRUE },
+  { CMD_EPC_FN_SET_DIFF_GAIN,  CMD_EPC_FN_GET_DIFF_GAIN,  TRUE },
+};
+#endif //#ifdef MODEL_370XA
 
 CEPC::CEPC()  // Default Constructor
 {
+#ifdef MODEL_370XA
+  SetConfigCacheMap(s_astEPCCacheMap, sizeof (s_astEPCCacheMap) / sizeof (s_astEPCCacheMap[0]));
+#endif //#ifdef MODEL_370XA
 }
 
 CEPC::~CEPC() // Destructor
@@ -103,14 +123,20 @@ CEPC::~CEPC() // Destructor
 }
 
 // Open the device. Returns 0 on success, negative error code on failure.
-int CEPC::OpenHal (char* pszDevName)
+int CEPC::OpenHal (char* pszDevName, BOOL Stream /*= FALSE*/)
 {
-  return CBaseDev::OpenHal (pszDevName, FALSE);
+  return CBaseDev::OpenHal (pszDevName, Stream);
 }
 
 // Closes the device. Returns 0 on success, negative error code on failure.
 int CEPC::CloseHal ()
 {
+  // The board would keep pushing to a closed device
+  if (m_unPushPeriodMs)
+  {
+    SetStreamPeriod (0);
+  }
+
   return CBaseDev::CloseHal ();
 }
 
@@ -126,80 +152,22 @@ int CEPC::GetBoardInfo (unsigned char* byFirmwareVerMaj,    // Firmware Version
                         unsigned char* byFirmwareVerBuild,    // Firmware Version - Build Number
                         unsigned char* byBoardRevision)     // Board Revision
 {
-  int nRetVal = ERR_SUCCESS;
-  
-  CmdAckUnion stCmd = {0};
-  CAN_BASEIO_SYSINFO_STRUCT stResp = {0};
+  CDevRequest<CmdAckUnion, CAN_BASEIO_SYSINFO_STRUCT> obReq(BD_GET_SYSTEM_INFO);
+  int nRetVal;
   
   if ( (NULL == byFirmwareVerMaj) || (NULL == byFirmwareVerMin) || 
        (NULL == byFirmwareVerBuild) || (NULL == byBoardRevision))
   {
     return ERR_INVALID_ARGS;
   }
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        SetCmdAckCommand(&stCmd.byCmdAck, BD_GET_SYSTEM_INFO);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd, // Command
-                                                     sizeof (stCmd),        // Size of command
-                                                     (unsigned char *)&stResp,  // Response from remote board
-                                                     sizeof(stResp));     // Size of expected response
-
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof(stResp))
-        {
-          *byFirmwareVerMaj = stResp.stData.majorVer;
-          *byFirmwareVerMin = stResp.stData.minorVer;
-          *byFirmwareVerBuild = stResp.stData.buildVer;
-          *byBoardRevision = stResp.stData.Revision;
-          nRetVal = ERR_SUCCESS;
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CEPC::GetBoardInfo(): Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CEPC::GetBoardInfo(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CEPC::GetBoardInfo(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CEPC::GetBoardInfo(): Invalid switch case!");
-      break;
-    }
-  }
-  else
+
+  nRetVal = Transact(obReq);
+  if (ERR_SUCCESS == nRetVal)
   {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CEPC::GetBoardInfo(): Function called before Open Call!");
+    *byFirmwareVerMaj = obReq.Resp().stData.majorVer;
+    *byFirmwareVerMin = obReq.Resp().stData.minorVer;
+    *byFirmwareVerBuild = obReq.Resp().stData.buildVer;
+    *byBoardRevision = obReq.Resp().stData.Revision;
   }
 
   return nRetVal;
@@ -208,76 +176,18 @@ int CEPC::GetBoardInfo (unsigned char* byFirmwareVerMaj,    // Firmware Version
 // Gets the Pressure in Milli Volts
 int CEPC::GetPressure (unsigned long* PressureMilliVolt)
 {
-  int nRetVal = ERR_SUCCESS;
-
-  CmdAckUnion stCmd = {0};
-  CAN_EPC_DATA_STRUCT stResp = {0};
+  CEPCGetRequest obReq(CMD_EPC_FN_GET_PRESSURE);
+  int nRetVal;
 
   if (NULL == PressureMilliVolt)
   {
     return ERR_INVALID_ARGS;
   }
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        SetCmdAckCommand(&stCmd.byCmdAck, CMD_EPC_FN_GET_PRESSURE);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd, // Command
-                                                     sizeof (stCmd),        // Size of command
-                                                     (unsigned char *) &stResp, // Response from remote board
-                                                     sizeof (stResp));      // Size of expected response
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          FixEndian(stResp.stData.BaseIOData.PressureMilliVolt);
-          *PressureMilliVolt = stResp.stData.BaseIOData.PressureMilliVolt;
-          nRetVal = ERR_SUCCESS;
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CEPC::GetPressure(): Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CEPC::GetPressure(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CEPC::GetPressure(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented      
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CEPC::GetPressure(): Invalid switch case!");
-      break;
-    }
-  }
-  else
+
+  nRetVal = Transact(obReq);
+  if (ERR_SUCCESS == nRetVal)
   {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CEPC::GetPressure(): Function called before Open Call!");
+    *PressureMilliVolt = obReq.Resp().stData.BaseIOData.PressureMilliVolt;
   }
 
   return nRetVal;
@@ -286,1089 +196,291 @@ int CEPC::GetPressure (unsigned long* PressureMilliVolt)
 // Sets the Pressure in Milli Volts
 int CEPC::SetPressure (unsigned long PressureMilliVolt)
 {
-  int nRetVal = ERR_SUCCESS;
-
-  CAN_EPC_DATA_STRUCT stCmd = {0};
-  CAN_BASEIO_STATUS_STRUCT stResp = {0};
-
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
 #ifdef MODEL_370XA
-        SetCmdAckCommand(&stCmd.stCmd.byCmdAck, CMD_EPC_FN_SET_EPC_CTRL_ON_PID);
+  CEPCSetRequest obReq(CMD_EPC_FN_SET_EPC_CTRL_ON_PID);
 #else //#ifdef MODEL_370XA
-        SetCmdAckCommand(&stCmd.stCmd.byCmdAck, CMD_EPC_FN_SET_PRESSURE);
+  CEPCSetRequest obReq(CMD_EPC_FN_SET_PRESSURE);
 #endif //#ifdef MODEL_370XA
 
-        stCmd.stData.BaseIOData.PressureMilliVolt = PressureMilliVolt;
-
-        FixEndian(stCmd.stData.BaseIOData.PressureMilliVolt);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd, // Command
-                                                     sizeof (stCmd),        // Size of command
-                                                     (unsigned char *) &stResp, // Response from remote board
-                                                     sizeof (stResp));      // Size of expected response
-
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          // Check if the device ACK'd or NACK'd
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.StatusDataUnion.ErrorType);
-            DEBUG2("CEPC::SetPressure(): Device sent a NACK! Dev error code = %d!", nRetVal);
-
-          }
-          else
-          {
-            nRetVal = ERR_SUCCESS;
-          }
-
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CEPC::SetPressure(): Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CEPC::SetPressure(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CEPC::SetPressure(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CEPC::SetPressure(): Invalid switch case!");
-      break;
-    }
-  }
-  else
-  {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CEPC::SetPressure(): Function called before Open Call!");
-  }
+  obReq.Cmd().stData.BaseIOData.PressureMilliVolt = PressureMilliVolt;
 
-  return nRetVal;
+  return Transact(obReq);
 }
 
 // Gets the on-board temperature in Milli Degree C.
 int CEPC::GetOnBoardTemp(int* TempMilliDegC)
 {
-  int nRetVal = ERR_SUCCESS;
-
-  CmdAckUnion stCmd = {0};
-  CAN_EPC_DATA_STRUCT stResp = {0};
+  CEPCGetRequest obReq(CMD_EPC_FN_GET_ON_BD_TEMP);
+  int nRetVal;
 
   if (NULL == TempMilliDegC)
   {
     return ERR_INVALID_ARGS;
   }
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        SetCmdAckCommand(&stCmd.byCmdAck, CMD_EPC_FN_GET_ON_BD_TEMP);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd, // Command
-                                                     sizeof (stCmd),        // Size of command
-                                                     (unsigned char *) &stResp, // Response from remote board
-                                                     sizeof (stResp));      // Size of expected response
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          FixEndian(stResp.stData.BaseIOData.OnBdTempmDegC);
-          *TempMilliDegC = stResp.stData.BaseIOData.OnBdTempmDegC;
-          nRetVal = ERR_SUCCESS;
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CEPC::GetOnBoardTemp(): Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CEPC::GetOnBoardTemp(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CEPC::GetOnBoardTemp(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented      
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CEPC::GetOnBoardTemp(): Invalid switch case!");
-      break;
-    }
-  }
-  else
+
+  nRetVal = Transact(obReq);
+  if (ERR_SUCCESS == nRetVal)
   {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CEPC::GetOnBoardTemp(): Function called before Open Call!");
+    *TempMilliDegC = obReq.Resp().stData.BaseIOData.OnBdTempmDegC;
   }
 
   return nRetVal;
 }
 
-
-#ifdef MODEL_370XA
-
-// Set Heater Channel PWM in milli %
-int CEPC::SetPWMMilliP (int nTempMilliP)
+// Gets the Pressure in Milli Volts and the on-board temperature in Milli Degree C in one round trip
+int CEPC::GetPressureAndTemp(unsigned long* PressureMilliVolt, int* TempMilliDegC)
 {
-  int nRetVal = ERR_SUCCESS;
+  CEPCGetRequest obPressReq(CMD_EPC_FN_GET_PRESSURE);
+  CEPCGetRequest obTempReq(CMD_EPC_FN_GET_ON_BD_TEMP);
+  CDevTxn *apobTxn[] = { &obPressReq, &obTempReq };
+  int nRetVal;
 
-  CAN_EPC_DATA_STRUCT stCmd = {0};
-  CAN_BASEIO_STATUS_STRUCT stResp = {0};
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
+  if (NULL == PressureMilliVolt || NULL == TempMilliDegC)
   {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        SetCmdAckCommand(&stCmd.stCmd.byCmdAck, CMD_EPC_FN_SET_EPC_CTRL_ON_PWM);
-        
-        stCmd.stData.BaseIOData.PWMmPct = nTempMilliP;    // Data
-
-        FixEndian(stCmd.stData.BaseIOData.PWMmPct);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd,  // Command
-                                                     sizeof (stCmd),          // Size of command
-                                                     (unsigned char *) &stResp,     // Response from remote board
-                                                     sizeof (stResp));        // Size of expected response
-
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          // Check if the device ACK'd or NACK'd
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.StatusDataUnion.ErrorType);
-            DEBUG2("CEPC::SetPWMMilliP: Device sent a NACK! Dev error code = %d!", nRetVal);
-
-          }
-          else
-          {
-            nRetVal = ERR_SUCCESS;
-          }
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CEPC::SetPWMMIlliP(): Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CEPC::SetPWMMilliP(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CEPC::SetPWMMilliP(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CEPC::SetPWMMilliP(): Invalid switch case!");
-      break;
-    }
+    return ERR_INVALID_ARGS;
   }
-  else
+
+  nRetVal = TransactBatch(apobTxn, sizeof (apobTxn) / sizeof (apobTxn[0]));
+  if (ERR_SUCCESS == nRetVal)
   {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CEPC::SetPWMMilliP: Function called before Open Call!");
+    *PressureMilliVolt = obPressReq.Resp().stData.BaseIOData.PressureMilliVolt;
+
+    *TempMilliDegC = obTempReq.Resp().stData.BaseIOData.OnBdTempmDegC;
   }
 
   return nRetVal;
 }
 
-int CEPC::TurnEPCOff () // Turn Heater OFF
+// Have the board push its process values every PeriodMs (0 - stop)
+int CEPC::SetStreamPeriod (unsigned int PeriodMs)
 {
-  int nRetVal = ERR_SUCCESS;
+  CEPCSetRequest obReq(CMD_EPC_FN_SET_STREAM_PERIOD);
+  int nRetVal;
 
-  CmdAckUnion stCmd = {0};
-  CAN_BASEIO_STATUS_STRUCT stResp = {0};
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
+  if (m_bIsDevOpen && !m_bIsStreaming)
   {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        SetCmdAckCommand(&stCmd.byCmdAck, CMD_EPC_FN_SET_EPC_CTRL_OFF);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd,  // Command
-                                                     sizeof (stCmd),    // Size of command
-                                                     (unsigned char *) &stResp, // Response from remote board
-                                                     sizeof (stResp));    // Size of expected response
-
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          // Check if the device ACK'd or NACK'd
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.StatusDataUnion.ErrorType);
-            DEBUG2("CEPC::TurnEPCOff: Device sent a NACK! Dev error code = %d!", nRetVal);
-          }
-          else
-          {
-            nRetVal = ERR_SUCCESS;
-          }
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CEPC::TurnEPCOff(): Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CEPC::TurnEPCOff(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CEPC::TurnEPCOff(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CEPC::TurnEPCOff(): Invalid switch case!");
-      break;
-    }
+    DEBUG2("CEPC::SetStreamPeriod(): %s - Device not opened for streaming!", m_szDevName);
+    return ERR_INVALID_SEQ;
   }
-  else
+
+  obReq.Cmd().stData.BaseIOData.StreamPeriodMs = PeriodMs;
+
+  nRetVal = Transact(obReq);
+  if (ERR_SUCCESS == nRetVal)
   {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CEPC::TurnEPCOff: Function called before Open Call!");
+    SetPushPeriod (PeriodMs);
   }
 
   return nRetVal;
 }
 
-// Get Heater PWM in milli %
-int CEPC::GetPWMMilliP(unsigned int* pnPWMMilliP)
+// Read the next pushed value
+int CEPC::ReadStreamData (DevStreamValueStruct* Value, unsigned int Timeout)
 {
-  int nRetVal = ERR_SUCCESS;
+  return ReadPushedValue (Value, Timeout, "ReadStreamData");
+}
 
-  CmdAckUnion stCmd = {0};
-  CAN_EPC_DATA_STRUCT stResp = {0};
+// Counters of the pushed values
+int CEPC::GetStreamStats (DevStreamStatsStruct* Stats)
+{
+  return GetPushStats (Stats);
+}
 
-  if (NULL == pnPWMMilliP)
-  {
-    return ERR_INVALID_ARGS;
-  }
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        SetCmdAckCommand(&stCmd.byCmdAck, CMD_EPC_FN_GET_EPC_PWM);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd,  // Command
-                                                     sizeof (stCmd),    // Size of command
-                                                     (unsigned char *) &stResp, // Response from remote board
-                                                     sizeof (stResp));    // Size of expected response
-
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          FixEndian(stResp.stData.BaseIOData.PWMmPct);
-          *pnPWMMilliP = stResp.stData.BaseIOData.PWMmPct;
-          nRetVal = ERR_SUCCESS;
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CEPC::GetPWMMilliP: Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CEPC::GetPWMMilliP(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CEPC::GetPWMMilliP(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CEPC::GetPWMMilliP(): Invalid switch case!");
-      break;
-    }
-  }
-  else
+// Return Receive Pipe File Descriptor
+int CEPC::GetRxStreamingFd ()
+{
+  if (NULL == m_pobCAN)
   {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CEPC::GetPWMMilliP: Function called before Open Call!");
+    DEBUG2("CEPC::GetRxStreamingFd(): Unexpected invalid pointer!");
+    return ERR_INTERNAL_ERR;
   }
 
-  return nRetVal;
+  return m_pobCAN->CANGetRxStrmFd();
 }
 
 
-// Set the proportional gain (milli
-int CEPC::SetPropGain(unsigned long ulPropGainMilli)
-{ 
-  int nRetVal = ERR_SUCCESS;
+#ifdef MODEL_370XA
 
-  CAN_EPC_DATA_STRUCT stCmd = {0};
-  CAN_BASEIO_STATUS_STRUCT stResp = {0};
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        SetCmdAckCommand(&stCmd.stCmd.byCmdAck, CMD_EPC_FN_SET_PROP_GAIN);
-        
-        stCmd.stData.BaseIOData.PropGain = ulPropGainMilli;   // Data
-
-        FixEndian(stCmd.stData.BaseIOData.PropGain);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd,  // Command
-                                                     sizeof (stCmd),    // Size of command
-                                                     (unsigned char *) &stResp, // Response from remote board
-                                                     sizeof (stResp));    // Size of expected response
-
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          // Check if the device ACK'd or NACK'd
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.StatusDataUnion.ErrorType);
-            DEBUG2("CEPC::SetPropGain(): Device sent a NACK! Dev error code = %d!", nRetVal);
-          }
-          else
-          {
-            nRetVal = ERR_SUCCESS;
-          }
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CEPC::SetPropGain(): Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CEPC::SetPropGain(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CEPC::SetPropGain(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CEPC::SetPropGain(): Invalid switch case!");
-      break;
-    }
-  }
-  else
-  {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CEPC::SetPropGain(): Function called before Open Call!");
-  }
+// Set Heater Channel PWM in milli %
+int CEPC::SetPWMMilliP (int nTempMilliP)
+{
+  CEPCSetRequest obReq(CMD_EPC_FN_SET_EPC_CTRL_ON_PWM);
 
-  return nRetVal;
+  obReq.Cmd().stData.BaseIOData.PWMmPct = nTempMilliP;
 
+  return Transact(obReq);
 }
 
-// Set the integral gain (milli)    
-int CEPC::SetIntGain(unsigned long ulIntGainMilli)
-{ 
-  int nRetVal = ERR_SUCCESS;
+int CEPC::TurnEPCOff () // Turn Heater OFF
+{
+  CEPCCmdRequest obReq(CMD_EPC_FN_SET_EPC_CTRL_OFF);
 
-  CAN_EPC_DATA_STRUCT stCmd = {0};
-  CAN_BASEIO_STATUS_STRUCT stResp = {0};
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
+  return Transact(obReq);
+}
+
+int CEPC::GetPWMMilliP(unsigned int* pnPWMMilliP)
+{
+  CEPCGetRequest obReq(CMD_EPC_FN_GET_EPC_PWM);
+  int nRetVal;
+
+  if (NULL == pnPWMMilliP)
   {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        SetCmdAckCommand(&stCmd.stCmd.byCmdAck, CMD_EPC_FN_SET_INT_GAIN);
-        
-        stCmd.stData.BaseIOData.IntGain = ulIntGainMilli;   // Data
-
-        FixEndian(stCmd.stData.BaseIOData.IntGain);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd,  // Command
-                                                     sizeof (stCmd),    // Size of command
-                                                     (unsigned char *) &stResp, // Response from remote board
-                                                     sizeof (stResp));    // Size of expected response
-
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          // Check if the device ACK'd or NACK'd
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.StatusDataUnion.ErrorType);
-            DEBUG2("CEPC::SetIntGain(): Device sent a NACK! Dev error code = %d!", nRetVal);
-          }
-          else
-          {
-            nRetVal = ERR_SUCCESS;
-          }
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CEPC::SetIntGain(): Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CEPC::SetIntGain(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CEPC::SetIntGain(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CEPC::SetIntGain(): Invalid switch case!");
-      break;
-    }
+    return ERR_INVALID_ARGS;
   }
-  else
+
+  nRetVal = Transact(obReq);
+  if (ERR_SUCCESS == nRetVal)
   {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CEPC::SetIntGain(): Function called before Open Call!");
+    *pnPWMMilliP = obReq.Resp().stData.BaseIOData.PWMmPct;
   }
 
   return nRetVal;
+}
+
+int CEPC::SetPropGain(unsigned long ulPropGainMilli)
+{
+  CEPCSetRequest obReq(CMD_EPC_FN_SET_PROP_GAIN);
+
+  obReq.Cmd().stData.BaseIOData.PropGain = ulPropGainMilli;
+
+  return Transact(obReq);
+}
+
+int CEPC::SetIntGain(unsigned long ulIntGainMilli)
+{
+  CEPCSetRequest obReq(CMD_EPC_FN_SET_INT_GAIN);
 
+  obReq.Cmd().stData.BaseIOData.IntGain = ulIntGainMilli;
+
+  return Transact(obReq);
 }
 
-// Set the differential gain (milli)
 int CEPC::SetDiffGain(unsigned long ulDiffGainMilli)
 {
-  int nRetVal = ERR_SUCCESS;
+  CEPCSetRequest obReq(CMD_EPC_FN_SET_DIFF_GAIN);
 
-  CAN_EPC_DATA_STRUCT stCmd = {0};
-  CAN_BASEIO_STATUS_STRUCT stResp = {0};
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        SetCmdAckCommand(&stCmd.stCmd.byCmdAck, CMD_EPC_FN_SET_DIFF_GAIN);
-        
-        stCmd.stData.BaseIOData.DiffGain = ulDiffGainMilli;   // Data
-
-        FixEndian(stCmd.stData.BaseIOData.DiffGain);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd,  // Command
-                                                     sizeof (stCmd),    // Size of command
-                                                     (unsigned char *) &stResp, // Response from remote board
-                                                     sizeof (stResp));    // Size of expected response
-
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          // Check if the device ACK'd or NACK'd
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.StatusDataUnion.ErrorType);
-            DEBUG2("CEPC::SetDiffGain(): Device sent a NACK! Dev error code = %d!", nRetVal);
-
-          }
-          else
-          {
-            nRetVal = ERR_SUCCESS;
-          }
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CEPC::SetDiffGain(): Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CEPC::SetDiffGain(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CEPC::SetDiffGain(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CEPC::SetDiffGain(): Invalid switch case!");
-      break;
-    }
-  }
-  else
-  {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CEPC::SetDiffGain(): Function called before Open Call!");
-  }
+  obReq.Cmd().stData.BaseIOData.DiffGain = ulDiffGainMilli;
 
-  return nRetVal;
+  return Transact(obReq);
+}
+
+// Set all three PID gains in one round trip
+int CEPC::SetPIDGains(unsigned long ulPropGainMilli, unsigned long ulIntGainMilli, unsigned long ulDiffGainMilli)
+{
+  CEPCSetRequest obPropReq(CMD_EPC_FN_SET_PROP_GAIN);
+  CEPCSetRequest obIntReq(CMD_EPC_FN_SET_INT_GAIN);
+  CEPCSetRequest obDiffReq(CMD_EPC_FN_SET_DIFF_GAIN);
+  CDevTxn *apobTxn[] = { &obPropReq, &obIntReq, &obDiffReq };
+
+  obPropReq.Cmd().stData.BaseIOData.PropGain = ulPropGainMilli;
+
+  obIntReq.Cmd().stData.BaseIOData.IntGain = ulIntGainMilli;
 
+  obDiffReq.Cmd().stData.BaseIOData.DiffGain = ulDiffGainMilli;
+
+  return TransactBatch(apobTxn, sizeof (apobTxn) / sizeof (apobTxn[0]));
 }
 
 int CEPC::GetPropGain(unsigned long *pulPropGainMilli)
 {
-  int nRetVal = ERR_SUCCESS;
-
-  CmdAckUnion stCmd = {0};
-  CAN_EPC_DATA_STRUCT stResp = {0};
+  CEPCGetRequest obReq(CMD_EPC_FN_GET_PROP_GAIN);
+  int nRetVal;
 
   if (NULL == pulPropGainMilli)
   {
     return ERR_INVALID_ARGS;
   }
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        SetCmdAckCommand(&stCmd.byCmdAck, CMD_EPC_FN_GET_PROP_GAIN);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd,  // Command
-                                                     sizeof (stCmd),    // Size of command
-                                                     (unsigned char *) &stResp, // Response from remote board
-                                                     sizeof (stResp));    // Size of expected response
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          FixEndian(stResp.stData.BaseIOData.PropGain);
-          *pulPropGainMilli = stResp.stData.BaseIOData.PropGain;
-          nRetVal = ERR_SUCCESS;
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CEPC::GetPropGain(): Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CEPC::GetPropGain(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CEPC::GetPropGain(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CEPC::GetPropGain(): Invalid switch case!");
-      break;
-    }
-  }
-  else
+
+  nRetVal = Transact(obReq);
+  if (ERR_SUCCESS == nRetVal)
   {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CEPC::GetPropGain(): Function called before Open Call!");
+    *pulPropGainMilli = obReq.Resp().stData.BaseIOData.PropGain;
   }
 
   return nRetVal;
-
 }
 
-// Get the integral gain (milli)
 int CEPC::GetIntGain(unsigned long *pulIntGainMilli)
-{ 
-  int nRetVal = ERR_SUCCESS;
-
-  CmdAckUnion stCmd = {0};
-  CAN_EPC_DATA_STRUCT stResp = {0};
+{
+  CEPCGetRequest obReq(CMD_EPC_FN_GET_INT_GAIN);
+  int nRetVal;
 
   if (NULL == pulIntGainMilli)
   {
     return ERR_INVALID_ARGS;
   }
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        SetCmdAckCommand(&stCmd.byCmdAck, CMD_EPC_FN_GET_INT_GAIN);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd,  // Command
-                                                     sizeof (stCmd),    // Size of command
-                                                     (unsigned char *) &stResp, // Response from remote board
-                                                     sizeof (stResp));    // Size of expected response
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          FixEndian(stResp.stData.BaseIOData.IntGain);
-          *pulIntGainMilli = stResp.stData.BaseIOData.IntGain;
-          nRetVal = ERR_SUCCESS;
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CEPC::GetPropGain(): Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CEPC::GetPropGain(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CEPC::GetPropGain(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CEPC::GetPropGain(): Invalid switch case!");
-      break;
-    }
-  }
-  else
+
+  nRetVal = Transact(obReq);
+  if (ERR_SUCCESS == nRetVal)
   {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CEPC::GetPropGain(): Function called before Open Call!");
+    *pulIntGainMilli = obReq.Resp().stData.BaseIOData.IntGain;
   }
 
   return nRetVal;
-
 }
 
-// Get the differential gain (milli)
 int CEPC::GetDiffGain(unsigned long *pulDiffGainMilli)
-{ 
-  int nRetVal = ERR_SUCCESS;
-
-  CmdAckUnion stCmd = {0};
-  CAN_EPC_DATA_STRUCT stResp = {0};
+{
+  CEPCGetRequest obReq(CMD_EPC_FN_GET_DIFF_GAIN);
+  int nRetVal;
 
   if (NULL == pulDiffGainMilli)
   {
     return ERR_INVALID_ARGS;
   }
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        SetCmdAckCommand(&stCmd.byCmdAck, CMD_EPC_FN_GET_DIFF_GAIN);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd,  // Command
-                                                     sizeof (stCmd),    // Size of command
-                                                     (unsigned char *) &stResp, // Response from remote board
-                                                     sizeof (stResp));    // Size of expected response
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          FixEndian(stResp.stData.BaseIOData.DiffGain);
-          *pulDiffGainMilli = stResp.stData.BaseIOData.DiffGain;
-          nRetVal = ERR_SUCCESS;
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CEPC::GetPropGain(): Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CEPC::GetPropGain(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CEPC::GetPropGain(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CEPC::GetPropGain(): Invalid switch case!");
-      break;
-    }
-  }
-  else
+
+  nRetVal = Transact(obReq);
+  if (ERR_SUCCESS == nRetVal)
   {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CEPC::GetPropGain(): Function called before Open Call!");
+    *pulDiffGainMilli = obReq.Resp().stData.BaseIOData.DiffGain;
   }
 
   return nRetVal;
 }
 
-
-int CEPC::SetPressCompBaseTemp(float fBaseTemp)
+// Get all three PID gains in one round trip
+int CEPC::GetPIDGains(unsigned long *pulPropGainMilli, unsigned long *pulIntGainMilli, unsigned long *pulDiffGainMilli)
 {
-  int nRetVal = ERR_SUCCESS;
+  CEPCGetRequest obPropReq(CMD_EPC_FN_GET_PROP_GAIN);
+  CEPCGetRequest obIntReq(CMD_EPC_FN_GET_INT_GAIN);
+  CEPCGetRequest obDiffReq(CMD_EPC_FN_GET_DIFF_GAIN);
+  CDevTxn *apobTxn[] = { &obPropReq, &obIntReq, &obDiffReq };
+  int nRetVal;
 
-  CAN_EPC_DATA_STRUCT stCmd = {0};
-  CAN_BASEIO_STATUS_STRUCT stResp = {0};
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
+  if (NULL == pulPropGainMilli || NULL == pulIntGainMilli || NULL == pulDiffGainMilli)
   {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        SetCmdAckCommand(&stCmd.stCmd.byCmdAck, CMD_EPC_FN_SET_TEMP_COMP_BASE);
-        
-        stCmd.stData.BaseIOData.CompFactor = fBaseTemp;   // Data
-
-        FixEndian(stCmd.stData.BaseIOData.CompFactor);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd,  // Command
-                                                     sizeof (stCmd),    // Size of command
-                                                     (unsigned char *) &stResp, // Response from remote board
-                                                     sizeof (stResp));    // Size of expected response
-
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          // Check if the device ACK'd or NACK'd
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.StatusDataUnion.ErrorType);
-            DEBUG2("CEPC::SetPressCorrBaseTemp(): Device sent a NACK! Dev error code = %d!", nRetVal);
-
-          }
-          else
-          {
-            nRetVal = ERR_SUCCESS;
-          }
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CEPC::SetPressCorrBaseTemp(): Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CEPC::SetPressCorrBaseTemp(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CEPC::SetPressCorrBaseTemp(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CEPC::SetPressCorrBaseTemp(): Invalid switch case!");
-      break;
-    }
+    return ERR_INVALID_ARGS;
   }
-  else
+
+  nRetVal = TransactBatch(apobTxn, sizeof (apobTxn) / sizeof (apobTxn[0]));
+  if (ERR_SUCCESS == nRetVal)
   {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CEPC::SetPressCorrBaseTemp(): Function called before Open Call!");
+    *pulPropGainMilli = obPropReq.Resp().stData.BaseIOData.PropGain;
+
+    *pulIntGainMilli = obIntReq.Resp().stData.BaseIOData.IntGain;
+
+    *pulDiffGainMilli = obDiffReq.Resp().stData.BaseIOData.DiffGain;
   }
 
   return nRetVal;
-
 }
 
+int CEPC::SetPressCompBaseTemp(float fBaseTemp)
+{
+  CEPCSetRequest obReq(CMD_EPC_FN_SET_TEMP_COMP_BASE);
+
+  obReq.Cmd().stData.BaseIOData.CompFactor = fBaseTemp;
+
+  return Transact(obReq);
+}
 
 int CEPC::SetPressCompCorr(float fPressCorr)
 {
-  int nRetVal = ERR_SUCCESS;
+  CEPCSetRequest obReq(CMD_EPC_FN_SET_TEMP_COMP_CORR);
 
-  CAN_EPC_DATA_STRUCT stCmd = {0};
-  CAN_BASEIO_STATUS_STRUCT stResp = {0};
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        SetCmdAckCommand(&stCmd.stCmd.byCmdAck, CMD_EPC_FN_SET_TEMP_COMP_CORR);
-        
-        stCmd.stData.BaseIOData.CompFactor = fPressCorr;    // Data
-
-        FixEndian(stCmd.stData.BaseIOData.CompFactor);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd,  // Command
-                                                     sizeof (stCmd),    // Size of command
-                                                     (unsigned char *) &stResp, // Response from remote board
-                                                     sizeof (stResp));    // Size of expected response
-
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          // Check if the device ACK'd or NACK'd
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.StatusDataUnion.ErrorType);
-            DEBUG2("CEPC::SetPressCorrBaseTemp(): Device sent a NACK! Dev error code = %d!", nRetVal);
-
-          }
-          else
-          {
-            nRetVal = ERR_SUCCESS;
-          }
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CEPC::SetPressCorrBaseTemp(): Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CEPC::SetPressCorrBaseTemp(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CEPC::SetPressCorrBaseTemp(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CEPC::SetPressCorrBaseTemp(): Invalid switch case!");
-      break;
-    }
-  }
-  else
-  {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CEPC::SetPressCorrBaseTemp(): Function called before Open Call!");
-  }
-
-  return nRetVal;
+  obReq.Cmd().stData.BaseIOData.CompFactor = fPressCorr;
 
+  return Transact(obReq);
 }
 
 #endif //#ifdef MODEL_370XA
-
-
@@ -69,6 +69,7 @@
 #include "debug.h"
 
 #include "FID_DAC_AD5570ARSZ.h"
+#include "HALLock.h"
 
 #define DATA_BUFF_SZ      256
 
@@ -80,6 +81,7 @@
 
 unsigned short CFID_DAC1_AD5570ARSZ::m_usDAC1Count = 0;
 unsigned short CFID_DAC2_AD5570ARSZ::m_usDAC2Count = 0;
+pthread_mutex_t CDAC_AD5570ARSZ::m_DACMutex = PTHREAD_MUTEX_INITIALIZER;
 
 CDAC_AD5570ARSZ::CDAC_AD5570ARSZ(const char *pszDevPath)
 {
@@ -192,6 +194,7 @@ CFID_DAC2_AD5570ARSZ::CFID_DAC2_AD5570ARSZ(int nFidNo) : CDAC_AD5570ARSZ((nFidNo
 
 int CFID_DAC1_AD5570ARSZ::GetCount(unsigned short &usDACCount)
 {
+  CHALLock obDACLock(&m_DACMutex);
 #ifdef DAC_OUT_CONNECTED_TO_MISO
   return CDAC_AD5570ARSZ::GetCount(usDACCount);
 #else
@@ -202,6 +205,7 @@ int CFID_DAC1_AD5570ARSZ::GetCount(unsigned short &usDACCount)
 
 int CFID_DAC2_AD5570ARSZ::GetCount(unsigned short &usDACCount)
 {
+  CHALLock obDACLock(&m_DACMutex);
 #ifdef DAC_OUT_CONNECTED_TO_MISO
   return CDAC_AD5570ARSZ::GetCount(usDACCount);
 #else
@@ -212,12 +216,15 @@ int CFID_DAC2_AD5570ARSZ::GetCount(unsigned short &usDACCount)
 
 int CFID_DAC1_AD5570ARSZ::SetCount(unsigned short usDACCount)
 {
+  // The cached count and the DAC must not be set to different values by two threads
+  CHALLock obDACLock(&m_DACMutex);
   m_usDAC1Count = usDACCount;
   return CDAC_AD5570ARSZ::SetCount(usDACCount);
 }
 
 int CFID_DAC2_AD5570ARSZ::SetCount(unsigned short usDACCount)
 {
+  CHALLock obDACLock(&m_DACMutex);
   m_usDAC2Count = usDACCount;
   return CDAC_AD5570ARSZ::SetCount(usDACCount);
 }
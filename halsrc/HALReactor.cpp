@@ -0,0 +1,391 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                     10241 West Little York, Suite 200
+ * *                            Houston, TX 77040
+ * *
+ * *
+ * *  Filename: HALReactor.cpp
+ * *
+ * *  Description: Event loop for servicing many HAL objects from one
+ * *               thread.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+#include "debug.h"
+#include "Reliability.h"  // For CReliability::GetMonotonicTimeUs()
+#include "HALReactor.h"
+
+// Number of ready fds collected per epoll_wait()
+#define HAL_REACTOR_EVENT_BATCH   16
+
+// epoll user data of the wake up pipe (source ids are 0 .. HAL_REACTOR_MAX_SOURCES - 1)
+#define HAL_REACTOR_WAKE_ID       0xFFFFFFFF
+
+CHALReactor::CHALReactor() // Default Constructor
+{
+  m_nEpollFd = -1;
+  m_anWakeFd[0] = -1;
+  m_anWakeFd[1] = -1;
+  m_bStop = FALSE;
+  memset(m_astSources, 0, sizeof (m_astSources));
+  memset(m_astTimers, 0, sizeof (m_astTimers));
+}
+
+CHALReactor::~CHALReactor() // Destructor
+{
+  Close();
+}
+
+// Create the reactor's epoll and wake up fds
+int CHALReactor::Open()
+{
+  struct epoll_event stEvent;
+
+  if (m_nEpollFd >= 0)
+  {
+    DEBUG2("CHALReactor::Open: Unexpected sequence! Reactor already open!");
+    return ERR_INVALID_SEQ;
+  }
+
+  m_nEpollFd = epoll_create(HAL_REACTOR_MAX_SOURCES + 1);
+  if (m_nEpollFd < 0)
+  {
+    DEBUG1("CHALReactor::Open: epoll_create() failed! errno = %d", errno);
+    return ERR_INTERNAL_ERR;
+  }
+
+  if (pipe(m_anWakeFd) != 0)
+  {
+    DEBUG1("CHALReactor::Open: pipe() failed! errno = %d", errno);
+    m_anWakeFd[0] = -1;
+    m_anWakeFd[1] = -1;
+    Close();
+    return ERR_INTERNAL_ERR;
+  }
+  fcntl(m_anWakeFd[0], F_SETFL, O_NONBLOCK);
+  fcntl(m_anWakeFd[1], F_SETFL, O_NONBLOCK);
+
+  memset(&stEvent, 0, sizeof (stEvent));
+  stEvent.events = EPOLLIN;
+  stEvent.data.u32 = HAL_REACTOR_WAKE_ID;
+  if (epoll_ctl(m_nEpollFd, EPOLL_CTL_ADD, m_anWakeFd[0], &stEvent) != 0)
+  {
+    DEBUG1("CHALReactor::Open: epoll_ctl() failed! errno = %d", errno);
+    Close();
+    return ERR_INTERNAL_ERR;
+  }
+
+  m_bStop = FALSE;
+
+  return ERR_SUCCESS;
+}
+
+// Release the reactor's fds. The devices' fds are not closed.
+int CHALReactor::Close()
+{
+  if (m_nEpollFd >= 0)
+  {
+    close(m_nEpollFd);
+    m_nEpollFd = -1;
+  }
+
+  if (m_anWakeFd[0] >= 0)
+  {
+    close(m_anWakeFd[0]);
+    close(m_anWakeFd[1]);
+    m_anWakeFd[0] = -1;
+    m_anWakeFd[1] = -1;
+  }
+
+  memset(m_astSources, 0, sizeof (m_astSources));
+  memset(m_astTimers, 0, sizeof (m_astTimers));
+
+  return ERR_SUCCESS;
+}
+
+// Watch a file descriptor for readability
+int CHALReactor::AddFd(int nFd, HALReactorCallback pfnCallback, void *pvArg)
+{
+  struct epoll_event stEvent;
+  int nId;
+
+  if (nFd < 0 || pfnCallback == NULL)
+  {
+    DEBUG2("CHALReactor::AddFd: Invalid arguments!");
+    return ERR_INVALID_ARGS;
+  }
+
+  if (m_nEpollFd < 0)
+  {
+    DEBUG2("CHALReactor::AddFd: Unexpected sequence! Reactor not open!");
+    return ERR_INVALID_SEQ;
+  }
+
+  for (nId = 0; nId < HAL_REACTOR_MAX_SOURCES; nId++)
+  {
+    if (!m_astSources[nId].bInUse)
+    {
+      break;
+    }
+  }
+
+  if (nId == HAL_REACTOR_MAX_SOURCES)
+  {
+    DEBUG2("CHALReactor::AddFd: Too many sources!");
+    return ERR_MEMORY_ERR;
+  }
+
+  memset(&stEvent, 0, sizeof (stEvent));
+  stEvent.events = EPOLLIN;
+  stEvent.data.u32 = nId;
+  if (epoll_ctl(m_nEpollFd, EPOLL_CTL_ADD, nFd, &stEvent) != 0)
+  {
+    DEBUG2("CHALReactor::AddFd: epoll_ctl() failed for fd %d! errno = %d", nFd, errno);
+    return (EEXIST == errno) ? ERR_DEV_IN_USE : ERR_INTERNAL_ERR;
+  }
+
+  m_astSources[nId].nFd = nFd;
+  m_astSources[nId].pfnCallback = pfnCallback;
+  m_astSources[nId].pvArg = pvArg;
+  m_astSources[nId].bInUse = TRUE;
+
+  return nId;
+}
+
+// Stop watching a source
+int CHALReactor::Remove(int nId)
+{
+  struct epoll_event stEvent;
+
+  if (nId < 0 || nId >= HAL_REACTOR_MAX_SOURCES || !m_astSources[nId].bInUse)
+  {
+    DEBUG2("CHALReactor::Remove: Invalid source id %d!", nId);
+    return ERR_INVALID_ARGS;
+  }
+
+  // Pre 2.6.9 kernels require a non-NULL event for EPOLL_CTL_DEL
+  memset(&stEvent, 0, sizeof (stEvent));
+  epoll_ctl(m_nEpollFd, EPOLL_CTL_DEL, m_astSources[nId].nFd, &stEvent);
+  m_astSources[nId].bInUse = FALSE;
+
+  return ERR_SUCCESS;
+}
+
+// Call back after unIntervalMs, and every unIntervalMs after that if bPeriodic
+int CHALReactor::AddTimer(unsigned int unIntervalMs, BOOL bPeriodic, HALReactorCallback pfnCallback, void *pvArg)
+{
+  int nId;
+
+  if (pfnCallback == NULL || (bPeriodic && unIntervalMs == 0))
+  {
+    DEBUG2("CHALReactor::AddTimer: Invalid arguments!");
+    return ERR_INVALID_ARGS;
+  }
+
+  for (nId = 0; nId < HAL_REACTOR_MAX_TIMERS; nId++)
+  {
+    if (!m_astTimers[nId].bInUse)
+    {
+      break;
+    }
+  }
+
+  if (nId == HAL_REACTOR_MAX_TIMERS)
+  {
+    DEBUG2("CHALReactor::AddTimer: Too many timers!");
+    return ERR_MEMORY_ERR;
+  }
+
+  m_astTimers[nId].unIntervalMs = unIntervalMs;
+  m_astTimers[nId].ullDueUs = CReliability::GetMonotonicTimeUs() + unIntervalMs * 1000ULL;
+  m_astTimers[nId].bPeriodic = bPeriodic;
+  m_astTimers[nId].pfnCallback = pfnCallback;
+  m_astTimers[nId].pvArg = pvArg;
+  m_astTimers[nId].bInUse = TRUE;
+
+  return nId;
+}
+
+// Cancel a timer
+int CHALReactor::RemoveTimer(int nId)
+{
+  if (nId < 0 || nId >= HAL_REACTOR_MAX_TIMERS || !m_astTimers[nId].bInUse)
+  {
+    DEBUG2("CHALReactor::RemoveTimer: Invalid timer id %d!", nId);
+    return ERR_INVALID_ARGS;
+  }
+
+  m_astTimers[nId].bInUse = FALSE;
+
+  return ERR_SUCCESS;
+}
+
+// Time (ms) until the next timer is due, -1 if none
+int CHALReactor::GetTimerWait(unsigned long long ullNowUs)
+{
+  int nWaitMs = -1;
+
+  for (int nId = 0; nId < HAL_REACTOR_MAX_TIMERS; nId++)
+  {
+    if (m_astTimers[nId].bInUse)
+    {
+      int nTimerWaitMs = 0;
+      if (m_astTimers[nId].ullDueUs > ullNowUs)
+      {
+        // Round up, so the timer is due when the wait ends
+        nTimerWaitMs = (int)((m_astTimers[nId].ullDueUs - ullNowUs + 999) / 1000);
+      }
+      if (nWaitMs < 0 || nTimerWaitMs < nWaitMs)
+      {
+        nWaitMs = nTimerWaitMs;
+      }
+    }
+  }
+
+  return nWaitMs;
+}
+
+// Call back the timers that are due
+int CHALReactor::RunTimers()
+{
+  int nCallbacks = 0;
+  unsigned long long ullNowUs = CReliability::GetMonotonicTimeUs();
+
+  for (int nId = 0; nId < HAL_REACTOR_MAX_TIMERS; nId++)
+  {
+    TimerStruct *pstTimer = &m_astTimers[nId];
+    if (!pstTimer->bInUse || pstTimer->ullDueUs > ullNowUs)
+    {
+      continue;
+    }
+
+    if (pstTimer->bPeriodic)
+    {
+      // Keep to the original schedule; skip periods missed by a slow callback
+      pstTimer->ullDueUs += pstTimer->unIntervalMs * 1000ULL;
+      if (pstTimer->ullDueUs <= ullNowUs)
+      {
+        pstTimer->ullDueUs = ullNowUs + pstTimer->unIntervalMs * 1000ULL;
+      }
+    }
+    else
+    {
+      pstTimer->bInUse = FALSE;
+    }
+
+    pstTimer->pfnCallback(nId, pstTimer->pvArg);
+    nCallbacks++;
+  }
+
+  return nCallbacks;
+}
+
+// Wait and call back the ready sources and due timers
+int CHALReactor::RunOnce(int nTimeoutMs)
+{
+  struct epoll_event astEvents[HAL_REACTOR_EVENT_BATCH];
+  int nCallbacks = 0;
+
+  if (m_nEpollFd < 0)
+  {
+    DEBUG2("CHALReactor::RunOnce: Unexpected sequence! Reactor not open!");
+    return ERR_INVALID_SEQ;
+  }
+
+  // Do not sleep past the next timer
+  int nTimerWaitMs = GetTimerWait(CReliability::GetMonotonicTimeUs());
+  if (nTimerWaitMs >= 0 && (nTimeoutMs < 0 || nTimerWaitMs < nTimeoutMs))
+  {
+    nTimeoutMs = nTimerWaitMs;
+  }
+
+  int nReady = epoll_wait(m_nEpollFd, astEvents, HAL_REACTOR_EVENT_BATCH, nTimeoutMs);
+  if (nReady < 0)
+  {
+    if (EINTR != errno)
+    {
+      DEBUG1("CHALReactor::RunOnce: epoll_wait() failed! errno = %d", errno);
+      return ERR_INTERNAL_ERR;
+    }
+    nReady = 0;
+  }
+
+  for (int nCount = 0; nCount < nReady; nCount++)
+  {
+    unsigned int unId = astEvents[nCount].data.u32;
+
+    // Only Stop() writes to the wake up pipe - the stop is taken over here, by
+    // the reactor's thread, so m_bStop is not shared with the caller of Stop()
+    if (HAL_REACTOR_WAKE_ID == unId)
+    {
+      unsigned char abyDummy[16];
+      while (read(m_anWakeFd[0], abyDummy, sizeof (abyDummy)) > 0)
+      {
+        m_bStop = TRUE;
+      }
+      continue;
+    }
+
+    // Removed by an earlier callback in this batch
+    if (unId >= HAL_REACTOR_MAX_SOURCES || !m_astSources[unId].bInUse)
+    {
+      continue;
+    }
+
+    m_astSources[unId].pfnCallback((int)unId, m_astSources[unId].pvArg);
+    nCallbacks++;
+  }
+
+  nCallbacks += RunTimers();
+
+  return nCallbacks;
+}
+
+// Call RunOnce() until Stop() is called
+int CHALReactor::Run()
+{
+  int nRetVal = ERR_SUCCESS;
+
+  while (!m_bStop)
+  {
+    nRetVal = RunOnce(-1);
+    if (nRetVal < 0)
+    {
+      break;
+    }
+    nRetVal = ERR_SUCCESS;
+  }
+
+  m_bStop = FALSE;
+
+  return nRetVal;
+}
+
+// Make Run() return - signalled through the wake up pipe, which also ends the wait
+void CHALReactor::Stop()
+{
+  unsigned char byDummy = 0;
+
+  if (m_anWakeFd[1] >= 0)
+  {
+    if (write(m_anWakeFd[1], &byDummy, 1) != 1)
+    {
+      // Pipe full - a wake up is already pending
+    }
+  }
+}
@@ -0,0 +1,402 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                     10241 West Little York, Suite 200
+ * *                            Houston, TX 77040
+ * *
+ * *
+ * *  Filename: HALTrace.cpp
+ * *
+ * *  Description: Recording of HAL transactions for a timeline view.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "debug.h"
+#include "HALTrace.h"
+#include "Reliability.h"  // For GetMonotonicTimeUs()
+
+// The copy of a ring by the export races with its owner overwriting the oldest
+// events, by design - those are found and left out after the copy. It is not
+// instrumented in a ThreadSanitizer build (make SANITIZE=thread), which would
+// report it on every wrap of a ring.
+#if defined(__SANITIZE_THREAD__)
+#define HAL_TRACE_NO_TSAN   __attribute__ ((no_sanitize_thread))
+#else
+#define HAL_TRACE_NO_TSAN
+#endif
+
+volatile BOOL CHALTrace::m_bEnabled = FALSE;
+pthread_mutex_t CHALTrace::m_Mutex = PTHREAD_MUTEX_INITIALIZER;
+CHALTrace::ThreadBufStruct *CHALTrace::m_apstBufs[HAL_TRACE_MAX_THREADS];
+int CHALTrace::m_nNumBufs = 0;
+unsigned long CHALTrace::m_ulUntraced = 0;
+unsigned long CHALTrace::m_ulDiscarded = 0;
+
+// Ring of each thread
+static pthread_key_t s_BufKey;
+static pthread_once_t s_BufKeyOnce = PTHREAD_ONCE_INIT;
+
+// Kept for threads that found no ring left, so they don't look again on every event
+static char s_cNoBuf;
+
+static const char *s_apszTypeNames[] = { "transact", "cached", "batch", "attempt", "stream" };
+
+void CHALTrace::CreateKey()
+{
+  pthread_key_create(&s_BufKey, ThreadExited);
+}
+
+unsigned long long CHALTrace::Now()
+{
+  return CReliability::GetMonotonicTimeUs();
+}
+
+// Turn recording on / off
+void CHALTrace::Enable(BOOL bEnable)
+{
+  pthread_once(&s_BufKeyOnce, CreateKey);
+  m_bEnabled = bEnable;
+}
+
+// A thread with a ring has ended. Its events stay for the export.
+void CHALTrace::ThreadExited(void *pvBuf)
+{
+  if (pvBuf != &s_cNoBuf)
+  {
+    pthread_mutex_lock(&m_Mutex);
+    ((ThreadBufStruct *) pvBuf)->bExited = TRUE;
+    pthread_mutex_unlock(&m_Mutex);
+  }
+}
+
+// Give the calling thread a ring - a new one, or when all are taken, the ring of
+// a thread that has ended
+CHALTrace::ThreadBufStruct *CHALTrace::AddThreadBuf()
+{
+  ThreadBufStruct *pstBuf = NULL;
+
+  pthread_mutex_lock(&m_Mutex);
+
+  if (m_nNumBufs < HAL_TRACE_MAX_THREADS)
+  {
+    pstBuf = new ThreadBufStruct;
+    m_apstBufs[m_nNumBufs++] = pstBuf;
+  }
+  else
+  {
+    for (int nBuf = 0; nBuf < m_nNumBufs; nBuf++)
+    {
+      if (m_apstBufs[nBuf]->bExited)
+      {
+        pstBuf = m_apstBufs[nBuf];
+        m_ulDiscarded += pstBuf->ulCount;
+        break;
+      }
+    }
+  }
+
+  if (pstBuf)
+  {
+    pstBuf->lTid = syscall(SYS_gettid);
+    pstBuf->szThreadName[0] = '\0';
+    pstBuf->bExited = FALSE;
+    pstBuf->ulCount = 0;
+  }
+  else
+  {
+    DEBUG2("CHALTrace::AddThreadBuf(): No trace buffer left for thread %ld!", (long) syscall(SYS_gettid));
+  }
+
+  pthread_mutex_unlock(&m_Mutex);
+
+  pthread_setspecific(s_BufKey, pstBuf ? (void *) pstBuf : (void *) &s_cNoBuf);
+
+  return pstBuf;
+}
+
+CHALTrace::ThreadBufStruct *CHALTrace::GetThreadBuf()
+{
+  void *pvBuf = pthread_getspecific(s_BufKey);
+
+  if (NULL == pvBuf)
+  {
+    return AddThreadBuf();
+  }
+
+  return (pvBuf == &s_cNoBuf) ? NULL : (ThreadBufStruct *) pvBuf;
+}
+
+// Record a call that started at ullStartUs and ends now
+void CHALTrace::Record(HAL_TRACE_EVENT_ENUM eType, const char *pszName, unsigned char bySlot,
+                       unsigned char byCommand, unsigned char byFnEnum, unsigned long long ullStartUs,
+                       int nCount, int nResult)
+{
+  ThreadBufStruct *pstBuf = GetThreadBuf();
+
+  if (NULL == pstBuf)
+  {
+    __sync_fetch_and_add(&m_ulUntraced, 1);
+    return;
+  }
+
+  unsigned long ulCount = pstBuf->ulCount;
+  HALTraceEventStruct &stEvent = pstBuf->astEvents[ulCount % HAL_TRACE_THREAD_EVENTS];
+
+  stEvent.ullStartUs = ullStartUs;
+  stEvent.ullEndUs = Now();
+  stEvent.nResult = nResult;
+  stEvent.usCount = (unsigned short) nCount;
+  stEvent.byType = (unsigned char) eType;
+  stEvent.bySlot = bySlot;
+  stEvent.byCommand = byCommand;
+  stEvent.byFnEnum = byFnEnum;
+  if (pszName)
+  {
+    strncpy(stEvent.szName, pszName, sizeof (stEvent.szName) - 1);
+    stEvent.szName[sizeof (stEvent.szName) - 1] = '\0';
+  }
+  else
+  {
+    stEvent.szName[0] = '\0';
+  }
+
+  // The event must be complete before the export can see it
+  __sync_synchronize();
+  pstBuf->ulCount = ulCount + 1;
+}
+
+// Name the calling thread in the export
+void CHALTrace::SetThreadName(const char *pszName)
+{
+  if (!m_bEnabled || NULL == pszName)
+  {
+    return;
+  }
+
+  ThreadBufStruct *pstBuf = GetThreadBuf();
+  if (pstBuf)
+  {
+    pthread_mutex_lock(&m_Mutex);
+    strncpy(pstBuf->szThreadName, pszName, sizeof (pstBuf->szThreadName) - 1);
+    pstBuf->szThreadName[sizeof (pstBuf->szThreadName) - 1] = '\0';
+    pthread_mutex_unlock(&m_Mutex);
+  }
+}
+
+// Drop the recorded events
+int CHALTrace::Clear()
+{
+  if (m_bEnabled)
+  {
+    DEBUG2("CHALTrace::Clear(): Trace is on!");
+    return ERR_INVALID_SEQ;
+  }
+
+  pthread_mutex_lock(&m_Mutex);
+  for (int nBuf = 0; nBuf < m_nNumBufs; nBuf++)
+  {
+    m_apstBufs[nBuf]->ulCount = 0;
+  }
+  m_ulUntraced = 0;
+  m_ulDiscarded = 0;
+  pthread_mutex_unlock(&m_Mutex);
+
+  return ERR_SUCCESS;
+}
+
+// Copy out the events of a ring, oldest first. The owner may be recording while
+// this runs - events it may have overwritten during the copy are left out.
+HAL_TRACE_NO_TSAN int CHALTrace::Snapshot(ThreadBufStruct *pstBuf, HALTraceEventStruct *pstEvents)
+{
+  unsigned long ulCount = pstBuf->ulCount;
+  __sync_synchronize();
+
+  unsigned long ulFirst = (ulCount > HAL_TRACE_THREAD_EVENTS) ? ulCount - HAL_TRACE_THREAD_EVENTS : 0;
+  for (unsigned long ulEvent = ulFirst; ulEvent < ulCount; ulEvent++)
+  {
+    pstEvents[ulEvent - ulFirst] = pstBuf->astEvents[ulEvent % HAL_TRACE_THREAD_EVENTS];
+  }
+
+  // The event being written after the last one published takes the slot of the
+  // oldest one still in the ring
+  __sync_synchronize();
+  unsigned long ulNewCount = pstBuf->ulCount;
+  unsigned long ulValid = (ulNewCount + 1 > HAL_TRACE_THREAD_EVENTS) ? ulNewCount + 1 - HAL_TRACE_THREAD_EVENTS : 0;
+  if (ulValid <= ulFirst)
+  {
+    return (int) (ulCount - ulFirst);
+  }
+  if (ulValid >= ulCount)
+  {
+    return 0;
+  }
+
+  memmove(pstEvents, pstEvents + (ulValid - ulFirst), (ulCount - ulValid) * sizeof (HALTraceEventStruct));
+  return (int) (ulCount - ulValid);
+}
+
+// Write a string as a JSON string
+static void WriteJsonString(FILE *fp, const char *pszText)
+{
+  fputc('"', fp);
+  for (; *pszText; pszText++)
+  {
+    if ('"' == *pszText || '\\' == *pszText)
+    {
+      fprintf(fp, "\\%c", *pszText);
+    }
+    else if ((unsigned char) *pszText < 0x20)
+    {
+      fprintf(fp, "\\u%04x", (unsigned char) *pszText);
+    }
+    else
+    {
+      fputc(*pszText, fp);
+    }
+  }
+  fputc('"', fp);
+}
+
+// Write the recorded events as Chrome trace event JSON
+int CHALTrace::ExportChrome(const char *pszFileName)
+{
+  int nRetVal = ERR_SUCCESS;
+  BOOL bFirst = TRUE;
+  long lPid = (long) getpid();
+  char szLabel[HAL_TRACE_NAME_LEN + 32];
+
+  if (NULL == pszFileName)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  HALTraceEventStruct *pstEvents = new HALTraceEventStruct[HAL_TRACE_THREAD_EVENTS];
+
+  FILE *fp = fopen(pszFileName, "w");
+  if (NULL == fp)
+  {
+    DEBUG2("CHALTrace::ExportChrome(): Unable to open %s!", pszFileName);
+    delete [] pstEvents;
+    return ERR_OPEN_FILE;
+  }
+
+  fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+  pthread_mutex_lock(&m_Mutex);
+
+  for (int nBuf = 0; nBuf < m_nNumBufs; nBuf++)
+  {
+    ThreadBufStruct *pstBuf = m_apstBufs[nBuf];
+
+    // Track name
+    if (pstBuf->szThreadName[0])
+    {
+      strcpy(szLabel, pstBuf->szThreadName);
+    }
+    else
+    {
+      sprintf(szLabel, "Thread %ld", pstBuf->lTid);
+    }
+    fprintf(fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%ld,\"tid\":%ld,\"args\":{\"name\":",
+            bFirst ? "" : ",\n", lPid, pstBuf->lTid);
+    WriteJsonString(fp, szLabel);
+    fprintf(fp, "}}");
+    bFirst = FALSE;
+
+    int nNumEvents = Snapshot(pstBuf, pstEvents);
+    for (int nEvent = 0; nEvent < nNumEvents; nEvent++)
+    {
+      const HALTraceEventStruct &stEvent = pstEvents[nEvent];
+      const char *pszType = (stEvent.byType < sizeof (s_apszTypeNames) / sizeof (s_apszTypeNames[0])) ?
+                            s_apszTypeNames[stEvent.byType] : "?";
+
+      switch (stEvent.byType)
+      {
+      case HAL_TRACE_ATTEMPT:
+        sprintf(szLabel, "Attempt %d cmd %d", stEvent.usCount, stEvent.byCommand);
+        break;
+      case HAL_TRACE_STREAM_READ:
+        sprintf(szLabel, "Stream read slot %d", stEvent.bySlot);
+        break;
+      case HAL_TRACE_BATCH:
+        sprintf(szLabel, "%s batch of %d", stEvent.szName, stEvent.usCount);
+        break;
+      default:
+        sprintf(szLabel, "%s cmd %d", stEvent.szName, stEvent.byCommand);
+        break;
+      }
+
+      fprintf(fp, ",\n{\"name\":");
+      WriteJsonString(fp, szLabel);
+      fprintf(fp, ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%llu,\"pid\":%ld,\"tid\":%ld,"
+              "\"args\":{\"dev\":",
+              pszType, stEvent.ullStartUs, stEvent.ullEndUs - stEvent.ullStartUs, lPid, pstBuf->lTid);
+      WriteJsonString(fp, stEvent.szName);
+      if (HAL_TRACE_STREAM_READ == stEvent.byType)
+      {
+        fprintf(fp, ",\"slot\":%d,\"fn_type\":%d,\"fn_enum\":%d", stEvent.bySlot, stEvent.byCommand, stEvent.byFnEnum);
+      }
+      else
+      {
+        fprintf(fp, ",\"slot\":%d,\"cmd\":%d,\"count\":%d", stEvent.bySlot, stEvent.byCommand, stEvent.usCount);
+      }
+      fprintf(fp, ",\"result\":%d}}", stEvent.nResult);
+    }
+  }
+
+  pthread_mutex_unlock(&m_Mutex);
+
+  fprintf(fp, "\n]}\n");
+
+  if (ferror(fp))
+  {
+    DEBUG2("CHALTrace::ExportChrome(): Unable to write %s!", pszFileName);
+    nRetVal = ERR_OPEN_FILE;
+  }
+  fclose(fp);
+
+  delete [] pstEvents;
+
+  return nRetVal;
+}
+
+int CHALTrace::GetStats(HALTraceStatsStruct *pstStats)
+{
+  if (NULL == pstStats)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  memset(pstStats, 0, sizeof (*pstStats));
+
+  pthread_mutex_lock(&m_Mutex);
+  for (int nBuf = 0; nBuf < m_nNumBufs; nBuf++)
+  {
+    unsigned long ulCount = m_apstBufs[nBuf]->ulCount;
+    pstStats->ulRecorded += ulCount;
+    if (ulCount > HAL_TRACE_THREAD_EVENTS)
+    {
+      pstStats->ulOverwritten += ulCount - HAL_TRACE_THREAD_EVENTS;
+    }
+  }
+  pstStats->unThreads = m_nNumBufs;
+  pstStats->ulRecorded += m_ulDiscarded;
+  pstStats->ulOverwritten += m_ulDiscarded;
+  pstStats->ulUntraced = m_ulUntraced;
+  pthread_mutex_unlock(&m_Mutex);
+
+  return ERR_SUCCESS;
+}
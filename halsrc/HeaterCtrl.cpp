@@ -85,9 +85,43 @@
   
 #include "debug.h"
 #include "HeaterCtrl.h"
+#include "WireLayouts.h"
+
+// Requests to the heater function - set commands get a status back, get commands
+// get the data union back.
+typedef CDevRequest<CAN_CMD_HTR_STRUCT, CAN_CMD_HTR_STATUS_STRUCT> CHtrSetRequest;
+typedef CDevRequest<CmdAckUnion, CAN_CMD_HTR_STATUS_STRUCT>        CHtrCmdRequest;
+typedef CDevRequest<CmdAckUnion, CAN_CMD_HTR_STRUCT>               CHtrGetRequest;
+
+// Settings the configuration cache may hold. The board has no read back of the
+// temperature / PWM setpoints.
+static const DevCacheMapStruct s_astHtrCacheMap[] = {
+  { CMD_HTR_FN_SET_PROP_GAIN,        CMD_HTR_FN_GET_PROP_GAIN,        TRUE  },
+  { CMD_HTR_FN_SET_INT_GAIN,         CMD_HTR_FN_GET_INT_GAIN,         TRUE  },
+  { CMD_HTR_FN_SET_DIFF_GAIN,        CMD_HTR_FN_GET_DIFF_GAIN,        TRUE  },
+  { CMD_HTR_FN_SET_HTR_TYPE,         CMD_HTR_FN_GET_HTR_TYPE,         TRUE  },
+  { CMD_HTR_FN_SET_COMP_BASE_TEMP,   CMD_HTR_FN_GET_COMP_BASE_TEMP,   TRUE  },
+  { CMD_HTR_FN_MARK_COMP_BASE_TEMP,  CMD_HTR_FN_GET_COMP_BASE_TEMP,   FALSE },  // Board takes its own temperature
+  { CMD_HTR_FN_SET_COMP_TEMP_SLOPE,  CMD_HTR_FN_GET_COMP_TEMP_SLOPE,  TRUE  },
+};
+
+typedef struct
+{
+  CAN_CMD_HTR_STRUCT s;
+  unsigned char ucRTDndx;
+} 
+#ifndef WIN32
+  __attribute (( packed )) 
+#endif 
+  CAN_CMD_HTR_RTD_LEAD_STRUCT;
+
+WIRE_LAYOUT_BEGIN(CAN_CMD_HTR_RTD_LEAD_STRUCT)
+  WIRE_STRUCT(s)
+WIRE_LAYOUT_END()
 
 CHeaterCtrl::CHeaterCtrl()  // Default Constructor
 {
+  SetConfigCacheMap(s_astHtrCacheMap, sizeof (s_astHtrCacheMap) / sizeof (s_astHtrCacheMap[0]));
 }
 
 CHeaterCtrl::~CHeaterCtrl() // Destructor
@@ -95,19 +129,25 @@ CHeaterCtrl::~CHeaterCtrl() // Destructor
 }
 
 // Open the device. Returns 0 on success, negative error code on failure.
-int CHeaterCtrl::OpenHal (char* pszDevName)
+int CHeaterCtrl::OpenHal (char* pszDevName, BOOL Stream /*= FALSE*/)
 {
   if (NULL == pszDevName)
   {
     return ERR_INVALID_ARGS;
   }
 
-  return CBaseDev::OpenHal (pszDevName, FALSE);
+  return CBaseDev::OpenHal (pszDevName, Stream);
 }
 
 // Closes the device. Returns 0 on success, negative error code on failure.
 int CHeaterCtrl::CloseHal ()
 {
+  // The board would keep pushing to a closed device
+  if (m_unPushPeriodMs)
+  {
+    SetStreamPeriod (0);
+  }
+
   return CBaseDev::CloseHal ();
 }
 
@@ -127,80 +167,22 @@ int CHeaterCtrl::GetBoardInfo ( unsigned char* byFirmwareVerMaj,  // Firmware Ve
                                 unsigned char* byFirmwareVerBuild,  // Firmware Version - Build Number
                                 unsigned char* byBoardRevision)   // Board Revision 
 {
-  int nRetVal = ERR_SUCCESS;
-  
-  CmdAckUnion stCmd = {0};
-  CAN_CMD_HTR_SOL_RTD_SYSINFO_STRUCT stResp = {0};
+  CDevRequest<CmdAckUnion, CAN_CMD_HTR_SOL_RTD_SYSINFO_STRUCT> obReq(BD_GET_SYSTEM_INFO);
+  int nRetVal;
   
   if ( (NULL == byFirmwareVerMaj) || (NULL == byFirmwareVerMin) || 
        (NULL == byFirmwareVerBuild) || (NULL == byBoardRevision))
   {
     return ERR_INVALID_ARGS;
   }
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        SetCmdAckCommand(&stCmd.byCmdAck, BD_GET_SYSTEM_INFO);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd, // Command
-                                                     sizeof (stCmd),        // Size of command
-                                                     (unsigned char *)&stResp,  // Response from remote board
-                                                     sizeof(stResp));     // Size of expected response
-
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof(stResp))
-        {
-          *byFirmwareVerMaj = stResp.stData.majorVer;
-          *byFirmwareVerMin = stResp.stData.minorVer;
-          *byFirmwareVerBuild = stResp.stData.buildVer;
-          *byBoardRevision = stResp.stData.Revision;
-          nRetVal = ERR_SUCCESS;
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CHeaterCtrl::GetBoardInfo(): Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CHeaterCtrl::GetBoardInfo(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CHeaterCtrl::GetBoardInfo(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CHeaterCtrl::GetBoardInfo(): Invalid switch case!");
-      break;
-    }
-  }
-  else
+
+  nRetVal = Transact(obReq);
+  if (ERR_SUCCESS == nRetVal)
   {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CHeaterCtrl::GetBoardInfo: Function called before Open Call!");
+    *byFirmwareVerMaj = obReq.Resp().stData.majorVer;
+    *byFirmwareVerMin = obReq.Resp().stData.minorVer;
+    *byFirmwareVerBuild = obReq.Resp().stData.buildVer;
+    *byBoardRevision = obReq.Resp().stData.Revision;
   }
 
   return nRetVal;
@@ -209,366 +191,45 @@ int CHeaterCtrl::GetBoardInfo ( unsigned char* byFirmwareVerMaj,  // Firmware Ve
 // Set Channel Temp in milli degree C
 int CHeaterCtrl::SetChTempMilliDegC (int nTempMilliDegC)
 {
-  int nRetVal = ERR_SUCCESS;
+  CHtrSetRequest obReq(CMD_HTR_FN_SET_HTR_CTRL_ON_PID);
 
-  CAN_CMD_HTR_STRUCT stCmd = {0};
-  CAN_CMD_HTR_STATUS_STRUCT stResp = {0};
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        
-        //stCmd.stCmd.Command = CMD_HTR_FN_SET_HTR_CTRL_ON_PID; // Command 
-        SetCmdAckCommand(&stCmd.stCmd.byCmdAck, CMD_HTR_FN_SET_HTR_CTRL_ON_PID);
-        
-        stCmd.stData.htrsolDataUnion.TempmDegC = nTempMilliDegC;  // Data
-
-        FixEndian(stCmd.stData.htrsolDataUnion.TempmDegC);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd, // Command
-                                                     sizeof (stCmd),        // Size of command
-                                                     (unsigned char *) &stResp, // Response from remote board
-                                                     sizeof (stResp));      // Size of expected response
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          // Check if the device ACK'd or NACK'd
-          //if (stResp.stCmd.Err == 1)
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.StatusDataUnion.ErrorType);
-            DEBUG2("CHeaterCtrl::SetChTempMilliDegC: Device sent a NACK! Dev error code = %d!", nRetVal);
-          }
-          else
-          {
-            nRetVal = ERR_SUCCESS;
-          }
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CHeaterCtrl::SetChTempMilliDegC(): Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CHeaterCtrl::SetChTempMilliDegC(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CHeaterCtrl::SetChTempMilliDegC(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CHeaterCtrl::SetChTempMilliDegC(): Invalid switch case!");
-      break;
-    }
-  }
-  else
-  {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CHeaterCtrl::SetChTempMilliDegC: Function called before Open Call!");
-  }
+  obReq.Cmd().stData.htrsolDataUnion.TempmDegC = nTempMilliDegC;
 
-  return nRetVal;
+  return Transact(obReq);
 }
 
 // Set Heater Channel PWM in milli %
 int CHeaterCtrl::SetChPWMMilliP (int nTempMilliP)
 {
-  int nRetVal = ERR_SUCCESS;
+  CHtrSetRequest obReq(CMD_HTR_FN_SET_HTR_CTRL_ON_PWM);
 
-  CAN_CMD_HTR_STRUCT stCmd = {0};
-  CAN_CMD_HTR_STATUS_STRUCT stResp = {0};
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        //stCmd.stCmd.Command = CMD_HTR_FN_SET_HTR_CTRL_ON_PWM; // Command 
-        SetCmdAckCommand(&stCmd.stCmd.byCmdAck, CMD_HTR_FN_SET_HTR_CTRL_ON_PWM);
-        
-        stCmd.stData.htrsolDataUnion.PWMmPct = nTempMilliP;   // Data
-
-        FixEndian(stCmd.stData.htrsolDataUnion.PWMmPct);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd, // Command
-                                                     sizeof (stCmd),        // Size of command
-                                                     (unsigned char *) &stResp, // Response from remote board
-                                                     sizeof (stResp));      // Size of expected response
-
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          // Check if the device ACK'd or NACK'd
-          //if (stResp.stCmd.Err == 1)
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.StatusDataUnion.ErrorType);
-            DEBUG2("CHeaterCtrl::GetHtrChPWMMilliP: Device sent a NACK! Dev error code = %d!", nRetVal);
-
-          }
-          else
-          {
-            nRetVal = ERR_SUCCESS;
-          }
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CHeaterCtrl::SeChPWMMIlliP(): Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CHeaterCtrl::SetChPWMMilliP(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CHeaterCtrl::SetChPWMMilliP(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CHeaterCtrl::SetChPWMMilliP(): Invalid switch case!");
-      break;
-    }
-  }
-  else
-  {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CHeaterCtrl::SetChPWMMilliP: Function called before Open Call!");
-  }
+  obReq.Cmd().stData.htrsolDataUnion.PWMmPct = nTempMilliP;
 
-  return nRetVal;
+  return Transact(obReq);
 }
 
 int CHeaterCtrl::TurnHtrOff () // Turn Heater OFF
 {
-  
-  int nRetVal = ERR_SUCCESS;
+  CHtrCmdRequest obReq(CMD_HTR_FN_SET_HTR_CTRL_OFF);
 
-  //CMD_ACK_STRUCT stCmd = {0};
-  CmdAckUnion stCmd = {0};
-  CAN_CMD_HTR_STATUS_STRUCT stResp = {0};
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        SetCmdAckCommand(&stCmd.byCmdAck, CMD_HTR_FN_SET_HTR_CTRL_OFF);
-        //stCmd.stCmdAck.Command = CMD_HTR_FN_SET_HTR_CTRL_OFF; // Command 
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd, // Command
-                                                     sizeof (stCmd),        // Size of command
-                                                     (unsigned char *) &stResp, // Response from remote board
-                                                     sizeof (stResp));      // Size of expected response
-
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          // Check if the device ACK'd or NACK'd
-          //if (stResp.stCmd.Err == 1)
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.StatusDataUnion.ErrorType);
-            DEBUG2("CHeaterCtrl::TurnHtrOff: Device sent a NACK! Dev error code = %d!", nRetVal);
-          }
-          else
-          {
-            nRetVal = ERR_SUCCESS;
-          }
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CHeaterCtrl::TurnHtrOff(): Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CHeaterCtrl::TurnHtrOff(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CHeaterCtrl::TurnHtrOff(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CHeaterCtrl::TurnHtrOff(): Invalid switch case!");
-      break;
-    }
-  }
-  else
-  {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CHeaterCtrl::TurnHtrOff: Function called before Open Call!");
-  }
-
-  return nRetVal;
+  return Transact(obReq);
 }
 
 // Get Heater PWM in milli %
 int CHeaterCtrl::GetHtrChPWMMilliP (unsigned int* pnPWMMilliP)
 {
-  int nRetVal = ERR_SUCCESS;
-
-  CmdAckUnion stCmd = {0};
-  CAN_CMD_HTR_STRUCT stResp = {0};
+  CHtrGetRequest obReq(CMD_HTR_FN_GET_HTR_PWM);
+  int nRetVal;
 
   if (NULL == pnPWMMilliP)
   {
     return ERR_INVALID_ARGS;
   }
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        //stCmd.Command = CMD_HTR_FN_GET_HTR_PWM; // Command 
-        SetCmdAckCommand(&stCmd.byCmdAck, CMD_HTR_FN_GET_HTR_PWM);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd, // Command
-                                                     sizeof (stCmd),        // Size of command
-                                                     (unsigned char *) &stResp, // Response from remote board
-                                                     sizeof (stResp));      // Size of expected response
-
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          // Check if the device ACK'd or NACK'd
-          //if (stResp.stCmd.Err == 1)
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.htrsolDataUnion.ErrorType);
-            DEBUG2("CHeaterCtrl::GetHtrChPWMMilliP: Device sent a NACK! Dev error code = %d!", nRetVal);
-
-          }
-          else
-          {
-            FixEndian(stResp.stData.htrsolDataUnion.PWMmPct);
-            *pnPWMMilliP = stResp.stData.htrsolDataUnion.PWMmPct;
-            nRetVal = ERR_SUCCESS;
-          }
-        }
-        else if (nRetVal == sizeof (CmdAckUnion))
-        {
-          // Device did not understand our command and sent us a NACK
-          // Check if the device ACK'd or NACK'd
-          //if (stResp.stCmd.Err == 1)
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.htrsolDataUnion.ErrorType);
-            DEBUG2("CHeaterCtrl::GetHtrChPWMMilliP: Device sent a NACK! Dev error code = %d!", nRetVal);
-
-          }
-          else
-          {
-            DEBUG2("CHeaterCtrl::GetHtrChPWMMilliP: Device sent a ACK, but response packet size is invalid!: %d", 
-                   nRetVal);
-            nRetVal = ERR_PROTOCOL;
-          }
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CHeaterCtrl::GetHtrChPWMMilliP: Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CHeaterCtrl::GetHtrChPWMMilliP(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CHeaterCtrl::GetHtrChPWMMilliP(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CHeaterCtrl::GetHtrChPWMMilliP(): Invalid switch case!");
-      break;
-    }
-  }
-  else
+
+  nRetVal = Transact(obReq);
+  if (ERR_SUCCESS == nRetVal)
   {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CHeaterCtrl::GetHtrChPWMMilliP: Function called before Open Call!");
+    *pnPWMMilliP = obReq.Resp().stData.htrsolDataUnion.PWMmPct;
   }
 
   return nRetVal;
@@ -577,105 +238,18 @@ int CHeaterCtrl::GetHtrChPWMMilliP (unsigned int* pnPWMMilliP)
 // Get heater current in Micro Amps.
 int CHeaterCtrl::GetHtrCurrent (int* pnHtrCurrentMicroAmps)
 {
-  int nRetVal = ERR_SUCCESS;
-
-  CmdAckUnion stCmd = {0};
-  CAN_CMD_HTR_STRUCT stResp = {0};
+  CHtrGetRequest obReq(CMD_HTR_FN_GET_HTR_TOT_CURRENT);
+  int nRetVal;
   
   if (NULL == pnHtrCurrentMicroAmps)
   {
     return ERR_INVALID_ARGS;
   }
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        //stCmd.Command = CMD_HTR_FN_GET_HTR_TOT_CURRENT; // Command 
-        SetCmdAckCommand(&stCmd.byCmdAck, CMD_HTR_FN_GET_HTR_TOT_CURRENT);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd, // Command
-                                                     sizeof (stCmd),        // Size of command
-                                                     (unsigned char *) &stResp, // Response from remote board
-                                                     sizeof (stResp));      // Size of expected response
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          // Check if the device ACK'd or NACK'd
-          //if (stResp.stCmd.Err == 1)
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.htrsolDataUnion.ErrorType);
-            DEBUG2("CHeaterCtrl::GetHtrCurrent: Device sent a NACK! Dev error code = %d!", nRetVal);
-
-          }
-          else
-          {
-            *pnHtrCurrentMicroAmps = stResp.stData.htrsolDataUnion.HtrCurrent;
-            nRetVal = ERR_SUCCESS;
-          }
-        }
-        else if (nRetVal == sizeof (CMD_ACK_STRUCT))
-        {
-          // Device did not understand our command and sent us a NACK
-          // Check if the device ACK'd or NACK'd
-          //if (stResp.stCmd.Err == 1)
-
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.htrsolDataUnion.ErrorType);
-            DEBUG2("CHeaterCtrl::GetHtrCurrent: Device sent a NACK! Dev error code = %d!", nRetVal);
-
-          }
-          else
-          {
-            DEBUG2("CHeaterCtrl::GetHtrCurrent: Device sent a ACK, but response packet size is invalid!: %d", nRetVal);
-            nRetVal = ERR_PROTOCOL;
-          }
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CHeaterCtrl::GetHtrCurrent: Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CHeaterCtrl::GetHtrCurrent(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CHeaterCtrl::GetHtrCurrent(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CHeaterCtrl::GetHtrCurrent(): Invalid switch case!");
-      break;
-    }
-  }
-  else
+
+  nRetVal = Transact(obReq);
+  if (ERR_SUCCESS == nRetVal)
   {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CHeaterCtrl::GetHtrCurrent: Function called before Open Call!");
+    *pnHtrCurrentMicroAmps = obReq.Resp().stData.htrsolDataUnion.HtrCurrent;
   }
 
   return nRetVal;
@@ -684,374 +258,89 @@ int CHeaterCtrl::GetHtrCurrent (int* pnHtrCurrentMicroAmps)
 // Set the proportional gain (milli
 int CHeaterCtrl::SetChPropGain(unsigned long ulPropGainMilli)
 { 
-  int nRetVal = ERR_SUCCESS;
+  CHtrSetRequest obReq(CMD_HTR_FN_SET_PROP_GAIN);
 
-  CAN_CMD_HTR_STRUCT stCmd = {0};
-  CAN_CMD_HTR_STATUS_STRUCT stResp = {0};
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        //stCmd.stCmd.Command = CMD_HTR_FN_SET_HTR_CTRL_ON_PWM; // Command 
-        SetCmdAckCommand(&stCmd.stCmd.byCmdAck, CMD_HTR_FN_SET_PROP_GAIN);
-        
-        stCmd.stData.htrsolDataUnion.PropGain = ulPropGainMilli;    // Data
-
-        FixEndian(stCmd.stData.htrsolDataUnion.PropGain);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd, // Command
-                                                     sizeof (stCmd),        // Size of command
-                                                     (unsigned char *) &stResp, // Response from remote board
-                                                     sizeof (stResp));      // Size of expected response
-
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          // Check if the device ACK'd or NACK'd
-          //if (stResp.stCmd.Err == 1)
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.StatusDataUnion.ErrorType);
-            DEBUG2("CHeaterCtrl::SetChPropGain(): Device sent a NACK! Dev error code = %d!", nRetVal);
-
-          }
-          else
-          {
-            nRetVal = ERR_SUCCESS;
-          }
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CHeaterCtrl::SetChPropGain(): Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CHeaterCtrl::SetChPropGain(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CHeaterCtrl::SetChPropGain(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CHeaterCtrl::SetChPropGain(): Invalid switch case!");
-      break;
-    }
-  }
-  else
-  {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CHeaterCtrl::SetChPropGain(): Function called before Open Call!");
-  }
-
-  return nRetVal;
+  obReq.Cmd().stData.htrsolDataUnion.PropGain = ulPropGainMilli;
 
+  return Transact(obReq);
 }
 
-// Set the integral gain (milli)    
+// Set the integral gain (milli)
 int CHeaterCtrl::SetChIntGain(unsigned long ulIntGainMilli)
-{ 
-  int nRetVal = ERR_SUCCESS;
-
-  CAN_CMD_HTR_STRUCT stCmd = {0};
-  CAN_CMD_HTR_STATUS_STRUCT stResp = {0};
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        //stCmd.stCmd.Command = CMD_HTR_FN_SET_HTR_CTRL_ON_PWM; // Command 
-        SetCmdAckCommand(&stCmd.stCmd.byCmdAck, CMD_HTR_FN_SET_INT_GAIN);
-        
-        stCmd.stData.htrsolDataUnion.IntGain = ulIntGainMilli;    // Data
-
-        FixEndian(stCmd.stData.htrsolDataUnion.IntGain);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd, // Command
-                                                     sizeof (stCmd),        // Size of command
-                                                     (unsigned char *) &stResp, // Response from remote board
-                                                     sizeof (stResp));      // Size of expected response
-
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          // Check if the device ACK'd or NACK'd
-          //if (stResp.stCmd.Err == 1)
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.StatusDataUnion.ErrorType);
-            DEBUG2("CHeaterCtrl::SetChIntGain(): Device sent a NACK! Dev error code = %d!", nRetVal);
-
-          }
-          else
-          {
-            nRetVal = ERR_SUCCESS;
-          }
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CHeaterCtrl::SetChIntGain(): Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CHeaterCtrl::SetChIntGain(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CHeaterCtrl::SetChIntGain(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CHeaterCtrl::SetChIntGain(): Invalid switch case!");
-      break;
-    }
-  }
-  else
-  {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CHeaterCtrl::SetChIntGain(): Function called before Open Call!");
-  }
+{
+  CHtrSetRequest obReq(CMD_HTR_FN_SET_INT_GAIN);
 
-  return nRetVal;
+  obReq.Cmd().stData.htrsolDataUnion.IntGain = ulIntGainMilli;
 
+  return Transact(obReq);
 }
 
 // Set the differential gain (direct value)
 int CHeaterCtrl::SetChDiffGain(unsigned long ulDiffGain)
 {
-  int nRetVal = ERR_SUCCESS;
+  CHtrSetRequest obReq(CMD_HTR_FN_SET_DIFF_GAIN);
 
-  CAN_CMD_HTR_STRUCT stCmd = {0};
-  CAN_CMD_HTR_STATUS_STRUCT stResp = {0};
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        //stCmd.stCmd.Command = CMD_HTR_FN_SET_HTR_CTRL_ON_PWM; // Command 
-        SetCmdAckCommand(&stCmd.stCmd.byCmdAck, CMD_HTR_FN_SET_DIFF_GAIN);
-        
-        stCmd.stData.htrsolDataUnion.DiffGain = ulDiffGain;   // Data
-
-        FixEndian(stCmd.stData.htrsolDataUnion.DiffGain);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd, // Command
-                                                     sizeof (stCmd),        // Size of command
-                                                     (unsigned char *) &stResp, // Response from remote board
-                                                     sizeof (stResp));      // Size of expected response
-
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          // Check if the device ACK'd or NACK'd
-          //if (stResp.stCmd.Err == 1)
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.StatusDataUnion.ErrorType);
-            DEBUG2("CHeaterCtrl::SetChDiffGain(): Device sent a NACK! Dev error code = %d!", nRetVal);
-
-          }
-          else
-          {
-            nRetVal = ERR_SUCCESS;
-          }
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CHeaterCtrl::SetChDiffGain(): Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CHeaterCtrl::SetChDiffGain(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CHeaterCtrl::SetChDiffGain(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CHeaterCtrl::SetChDiffGain(): Invalid switch case!");
-      break;
-    }
-  }
-  else
-  {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CHeaterCtrl::SetChDiffGain(): Function called before Open Call!");
-  }
+  obReq.Cmd().stData.htrsolDataUnion.DiffGain = ulDiffGain;
 
-  return nRetVal;
+  return Transact(obReq);
+}
+
+// Set all three PID gains in one round trip
+int CHeaterCtrl::SetChPIDGains(unsigned long ulPropGainMilli, unsigned long ulIntGainMilli, unsigned long ulDiffGain)
+{
+  CHtrSetRequest obPropReq(CMD_HTR_FN_SET_PROP_GAIN);
+  CHtrSetRequest obIntReq(CMD_HTR_FN_SET_INT_GAIN);
+  CHtrSetRequest obDiffReq(CMD_HTR_FN_SET_DIFF_GAIN);
+  CDevTxn *apobTxn[] = { &obPropReq, &obIntReq, &obDiffReq };
+
+  obPropReq.Cmd().stData.htrsolDataUnion.PropGain = ulPropGainMilli;
+
+  obIntReq.Cmd().stData.htrsolDataUnion.IntGain = ulIntGainMilli;
+
+  obDiffReq.Cmd().stData.htrsolDataUnion.DiffGain = ulDiffGain;
 
+  return TransactBatch(apobTxn, sizeof (apobTxn) / sizeof (apobTxn[0]));
 }
 
 // Get Temp in milli degree C
 int CHeaterCtrl::GetHtrChTempMilliDegC (int* pnTempMilliDegC) 
 {
-  int nRetVal = ERR_SUCCESS;
-
-  CmdAckUnion stCmd = {0};
-  CAN_CMD_HTR_STRUCT stResp = {0};
+  CHtrGetRequest obReq(CMD_HTR_FN_GET_TEMP_MDEG);
+  int nRetVal;
 
   if (NULL == pnTempMilliDegC)
   {
     return ERR_INVALID_ARGS;
   }
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
+
+  nRetVal = Transact(obReq);
+  if (ERR_SUCCESS == nRetVal)
   {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        //stCmd.Command = CMD_HTR_FN_GET_TEMP_MDEG; // Command 
-        SetCmdAckCommand(&stCmd.byCmdAck, CMD_HTR_FN_GET_TEMP_MDEG);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd, // Command
-                                                     sizeof (stCmd),        // Size of command
-                                                     (unsigned char *) &stResp, // Response from remote board
-                                                     sizeof (stResp));      // Size of expected response
-
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          // Check if the device ACK'd or NACK'd
-          //if (stResp.stCmd.Err == 1)
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.htrsolDataUnion.ErrorType);
-            DEBUG2("CHeaterCtrl::GetHtrChTempMilliDegC: Device sent a NACK! Dev error code = %d!", nRetVal);
-
-          }
-          else
-          {
-            FixEndian(stResp.stData.htrsolDataUnion.TempmDegC);
-            *pnTempMilliDegC = stResp.stData.htrsolDataUnion.TempmDegC;
-            nRetVal = ERR_SUCCESS;
-          }
-        }
-        else if (nRetVal == sizeof (CmdAckUnion))
-        {
-          // Device did not understand our command and sent us a NACK
-          // Check if the device ACK'd or NACK'd
-          //if (stResp.stCmd.Err == 1)
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.htrsolDataUnion.ErrorType);
-            DEBUG2("CHeaterCtrl::GetHtrChTempMilliDegC: Device sent a NACK! Dev error code = %d!", nRetVal);
-
-          }
-          else
-          {
-            nRetVal = ERR_PROTOCOL;
-            DEBUG2("CHeaterCtrl::GetHtrChTempMilliDegC: Device sent a ACK, but response packet size is invalid!: %d", 
-                   nRetVal);
-          }
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CHeaterCtrl::GetHtrChTempMilliDegC: Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CHeaterCtrl::GetHtrChTempMilliDegC(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CHeaterCtrl::GetHtrChTempMilliDegC(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CHeaterCtrl::GetHtrChTempMilliDegC(): Invalid switch case!");
-      break;
-    }
+    *pnTempMilliDegC = obReq.Resp().stData.htrsolDataUnion.TempmDegC;
   }
-  else
+
+  return nRetVal;
+}
+
+// Get Temp in milli degree C and PWM in milli % in one round trip
+int CHeaterCtrl::GetHtrChTempAndPWM (int* pnTempMilliDegC, unsigned int* pnPWMMilliP)
+{
+  CHtrGetRequest obTempReq(CMD_HTR_FN_GET_TEMP_MDEG);
+  CHtrGetRequest obPWMReq(CMD_HTR_FN_GET_HTR_PWM);
+  CDevTxn *apobTxn[] = { &obTempReq, &obPWMReq };
+  int nRetVal;
+
+  if (NULL == pnTempMilliDegC || NULL == pnPWMMilliP)
   {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CHeaterCtrl::GetHtrChTempMilliDegC: Function called before Open Call!");
+    return ERR_INVALID_ARGS;
+  }
+
+  nRetVal = TransactBatch(apobTxn, sizeof (apobTxn) / sizeof (apobTxn[0]));
+  if (ERR_SUCCESS == nRetVal)
+  {
+    *pnTempMilliDegC = obTempReq.Resp().stData.htrsolDataUnion.TempmDegC;
+
+    *pnPWMMilliP = obPWMReq.Resp().stData.htrsolDataUnion.PWMmPct;
   }
 
   return nRetVal;
@@ -1071,620 +360,135 @@ int CHeaterCtrl::GetRTDStatus (int* pnStatus)
 // Get the on-board temp in Milli Degree C.
 int CHeaterCtrl::GetOnBoardTemp (int* pnTempMilliDegC)
 {
-  int nRetVal = ERR_SUCCESS;
-
-  CmdAckUnion stCmd = {0};
-  CAN_CMD_HTR_STRUCT stResp = {0};
+  CHtrGetRequest obReq(CMD_HTR_FN_GET_ON_BD_TEMP);
+  int nRetVal;
 
   if (NULL == pnTempMilliDegC)
   {
     return ERR_INVALID_ARGS;
   }
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        //stCmd.Command = CMD_HTR_FN_GET_ON_BD_TEMP;  // Command 
-        SetCmdAckCommand(&stCmd.byCmdAck, CMD_HTR_FN_GET_ON_BD_TEMP);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd, // Command
-                                                     sizeof (stCmd),        // Size of command
-                                                     (unsigned char *) &stResp, // Response from remote board
-                                                     sizeof (stResp));      // Size of expected response
-
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          // Check if the device ACK'd or NACK'd
-          //if (stResp.stCmd.Err == 1)
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.htrsolDataUnion.ErrorType);
-            DEBUG2("CHeaterCtrl::GetOnBoardTemp: Device sent a NACK! Dev error code = %d!", nRetVal);
-
-          }
-          else
-          {
-            FixEndian(stResp.stData.htrsolDataUnion.OnBdTempmDegC);
-            *pnTempMilliDegC = stResp.stData.htrsolDataUnion.OnBdTempmDegC;
-            nRetVal = ERR_SUCCESS;
-          }
-        }
-        else if (nRetVal == sizeof (CmdAckUnion))
-        {
-          // Device did not understand our command and sent us a NACK
-          // Check if the device ACK'd or NACK'd
-          //if (stResp.stCmd.Err == 1)
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.htrsolDataUnion.ErrorType);
-            DEBUG2("CHeaterCtrl::GetOnBoardTemp: Device sent a NACK! Dev error code = %d!", nRetVal);
-
-          }
-          else
-          {
-            DEBUG2("CHeaterCtrl::GetOnBoardTemp: Device sent a ACK, but response packet size is invalid!: %d", nRetVal);
-            nRetVal = ERR_PROTOCOL;
-          }
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CHeaterCtrl::GetOnBoardTemp(): Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CHeaterCtrl::GetOnBoardTemp(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CHeaterCtrl::GetOnBoardTemp(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CHeaterCtrl::GetOnBoardTemp(): Invalid switch case!");
-      break;
-    }
-  }
-  else
+
+  nRetVal = Transact(obReq);
+  if (ERR_SUCCESS == nRetVal)
   {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CHeaterCtrl::GetHtrChTempMilliDegC: Function called before Open Call!");
+    *pnTempMilliDegC = obReq.Resp().stData.htrsolDataUnion.OnBdTempmDegC;
   }
 
   return nRetVal;
-
 }
 
+// Get the proportional gain (milli)
 int CHeaterCtrl::GetChPropGain(unsigned long *pulPropGainMilli)
 {
-  int nRetVal = ERR_SUCCESS;
-
-  CmdAckUnion stCmd = {0};
-  CAN_CMD_HTR_STRUCT stResp = {0};
+  CHtrGetRequest obReq(CMD_HTR_FN_GET_PROP_GAIN);
+  int nRetVal;
 
   if (NULL == pulPropGainMilli)
   {
     return ERR_INVALID_ARGS;
   }
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        SetCmdAckCommand(&stCmd.byCmdAck, CMD_HTR_FN_GET_PROP_GAIN);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd, // Command
-                                                     sizeof (stCmd),        // Size of command
-                                                     (unsigned char *) &stResp, // Response from remote board
-                                                     sizeof (stResp));      // Size of expected response
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          // Check if the device ACK'd or NACK'd
-          //if (stResp.stCmd.Err == 1)
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.htrsolDataUnion.ErrorType);
-            DEBUG2("CHeaterCtrl::GetChPropGain(): Device sent a NACK! Dev error code = %d!", nRetVal);
-
-          }
-          else
-          {
-            FixEndian(stResp.stData.htrsolDataUnion.PropGain);
-            *pulPropGainMilli = stResp.stData.htrsolDataUnion.PropGain;
-            nRetVal = ERR_SUCCESS;
-          }
-        }
-        else if (nRetVal == sizeof (CmdAckUnion))
-        {
-          // Device did not understand our command and sent us a NACK
-          // Check if the device ACK'd or NACK'd
-          //if (stResp.stCmd.Err == 1)
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.htrsolDataUnion.ErrorType);
-            DEBUG2("CHeaterCtrl::GetChPropGain(): Device sent a NACK! Dev error code = %d!", nRetVal);
-
-          }
-          else
-          {
-            DEBUG2("CHeaterCtrl::GetChPropGain(): Device sent a ACK, but response packet size is invalid!: %d", nRetVal);
-            nRetVal = ERR_PROTOCOL;
-          }
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CHeaterCtrl::GetChPropGain(): Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CHeaterCtrl::GetChPropGain(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CHeaterCtrl::GetChPropGain(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CHeaterCtrl::GetChPropGain(): Invalid switch case!");
-      break;
-    }
-  }
-  else
+
+  nRetVal = Transact(obReq);
+  if (ERR_SUCCESS == nRetVal)
   {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CHeaterCtrl::GetChPropGain(): Function called before Open Call!");
+    *pulPropGainMilli = obReq.Resp().stData.htrsolDataUnion.PropGain;
   }
 
   return nRetVal;
-
 }
 
-// Set the integral gain (milli)
+// Get the integral gain (milli)
 int CHeaterCtrl::GetChIntGain(unsigned long *pulIntGainMilli)
-{ 
-  int nRetVal = ERR_SUCCESS;
-
-  CmdAckUnion stCmd = {0};
-  CAN_CMD_HTR_STRUCT stResp = {0};
+{
+  CHtrGetRequest obReq(CMD_HTR_FN_GET_INT_GAIN);
+  int nRetVal;
 
   if (NULL == pulIntGainMilli)
   {
     return ERR_INVALID_ARGS;
   }
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        SetCmdAckCommand(&stCmd.byCmdAck, CMD_HTR_FN_GET_INT_GAIN);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd, // Command
-                                                     sizeof (stCmd),        // Size of command
-                                                     (unsigned char *) &stResp,         // Response from remote board
-                                                     sizeof (stResp));      // Size of expected response
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          // Check if the device ACK'd or NACK'd
-          //if (stResp.stCmd.Err == 1)
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.htrsolDataUnion.ErrorType);
-            DEBUG2("CHeaterCtrl::GetChPropGain(): Device sent a NACK! Dev error code = %d!", nRetVal);
-
-          }
-          else
-          {
-            FixEndian(stResp.stData.htrsolDataUnion.IntGain);
-            *pulIntGainMilli = stResp.stData.htrsolDataUnion.IntGain;
-            nRetVal = ERR_SUCCESS;
-          }
-        }
-        else if (nRetVal == sizeof (CmdAckUnion))
-        {
-          // Device did not understand our command and sent us a NACK
-          // Check if the device ACK'd or NACK'd
-          //if (stResp.stCmd.Err == 1)
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.htrsolDataUnion.ErrorType);
-            DEBUG2("CHeaterCtrl::GetChPropGain(): Device sent a NACK! Dev error code = %d!", nRetVal);
-
-          }
-          else
-          {
-            DEBUG2("CHeaterCtrl::GetChPropGain(): Device sent a ACK, but response packet size is invalid!: %d", nRetVal);
-            nRetVal = ERR_PROTOCOL;
-          }
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CHeaterCtrl::GetChPropGain(): Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CHeaterCtrl::GetChPropGain(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CHeaterCtrl::GetChPropGain(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CHeaterCtrl::GetChPropGain(): Invalid switch case!");
-      break;
-    }
-  }
-  else
+
+  nRetVal = Transact(obReq);
+  if (ERR_SUCCESS == nRetVal)
   {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CHeaterCtrl::GetChPropGain(): Function called before Open Call!");
+    *pulIntGainMilli = obReq.Resp().stData.htrsolDataUnion.IntGain;
   }
 
   return nRetVal;
-
 }
 
-// Set the differential gain (direct value)
+// Get the differential gain (direct value)
 int CHeaterCtrl::GetChDiffGain(unsigned long *pulDiffGain)
-{ 
-  int nRetVal = ERR_SUCCESS;
-
-  CmdAckUnion stCmd = {0};
-  CAN_CMD_HTR_STRUCT stResp = {0};
+{
+  CHtrGetRequest obReq(CMD_HTR_FN_GET_DIFF_GAIN);
+  int nRetVal;
 
   if (NULL == pulDiffGain)
   {
     return ERR_INVALID_ARGS;
   }
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        SetCmdAckCommand(&stCmd.byCmdAck, CMD_HTR_FN_GET_DIFF_GAIN);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd, // Command
-                                                     sizeof (stCmd),        // Size of command
-                                                     (unsigned char *) &stResp, // Response from remote board
-                                                     sizeof (stResp));      // Size of expected response
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          // Check if the device ACK'd or NACK'd
-          //if (stResp.stCmd.Err == 1)
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.htrsolDataUnion.ErrorType);
-            DEBUG2("CHeaterCtrl::GetChPropGain(): Device sent a NACK! Dev error code = %d!", nRetVal);
-
-          }
-          else
-          {
-            FixEndian(stResp.stData.htrsolDataUnion.DiffGain);
-            *pulDiffGain = stResp.stData.htrsolDataUnion.DiffGain;
-            nRetVal = ERR_SUCCESS;
-          }
-        }
-        else if (nRetVal == sizeof (CmdAckUnion))
-        {
-          // Device did not understand our command and sent us a NACK
-          // Check if the device ACK'd or NACK'd
-          //if (stResp.stCmd.Err == 1)
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.htrsolDataUnion.ErrorType);
-            DEBUG2("CHeaterCtrl::GetChPropGain(): Device sent a NACK! Dev error code = %d!", nRetVal);
-
-          }
-          else
-          {
-            DEBUG2("CHeaterCtrl::GetChPropGain(): Device sent a ACK, but response packet size is invalid!: %d", nRetVal);
-            nRetVal = ERR_PROTOCOL;
-          }
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CHeaterCtrl::GetChPropGain(): Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CHeaterCtrl::GetChPropGain(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CHeaterCtrl::GetChPropGain(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CHeaterCtrl::GetChPropGain(): Invalid switch case!");
-      break;
-    }
-  }
-  else
+
+  nRetVal = Transact(obReq);
+  if (ERR_SUCCESS == nRetVal)
   {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CHeaterCtrl::GetChPropGain(): Function called before Open Call!");
+    *pulDiffGain = obReq.Resp().stData.htrsolDataUnion.DiffGain;
   }
 
   return nRetVal;
 }
 
-// Set Heater type - AC or DC
-int CHeaterCtrl::SetHeaterType( HEATER_TYPE eHtrType )
-{ 
-  int nRetVal = ERR_SUCCESS;
+// Get all three PID gains in one round trip
+int CHeaterCtrl::GetChPIDGains(unsigned long *pulPropGainMilli, unsigned long *pulIntGainMilli, unsigned long *pulDiffGain)
+{
+  CHtrGetRequest obPropReq(CMD_HTR_FN_GET_PROP_GAIN);
+  CHtrGetRequest obIntReq(CMD_HTR_FN_GET_INT_GAIN);
+  CHtrGetRequest obDiffReq(CMD_HTR_FN_GET_DIFF_GAIN);
+  CDevTxn *apobTxn[] = { &obPropReq, &obIntReq, &obDiffReq };
+  int nRetVal;
 
-  CAN_CMD_HTR_STRUCT stCmd = {0};
-  CAN_CMD_HTR_STATUS_STRUCT stResp = {0};
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
+  if (NULL == pulPropGainMilli || NULL == pulIntGainMilli || NULL == pulDiffGain)
   {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        SetCmdAckCommand(&stCmd.stCmd.byCmdAck, CMD_HTR_FN_SET_HTR_TYPE);
-        
-        stCmd.stData.htrsolDataUnion.HtrType = eHtrType;
-
-        FixEndian(stCmd.stData.htrsolDataUnion.HtrType);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd,  // Command
-                                                     sizeof (stCmd),          // Size of command
-                                                     (unsigned char *) &stResp,     // Response from remote board
-                                                     sizeof (stResp));        // Size of expected response
-
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          // Check if the device ACK'd or NACK'd
-          //if (stResp.stCmd.Err == 1)
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.StatusDataUnion.ErrorType);
-            DEBUG2("CHeaterCtrl::SetHeaterType(): Device sent a NACK! Dev error code = %d!", nRetVal);
-
-          }
-          else
-          {
-            nRetVal = ERR_SUCCESS;
-          }
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CHeaterCtrl::SetHeaterType(): Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CHeaterCtrl::SetHeaterType(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CHeaterCtrl::SetHeaterType(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CHeaterCtrl::SetHeaterType(): Invalid switch case!");
-      break;
-    }
+    return ERR_INVALID_ARGS;
   }
-  else
+
+  nRetVal = TransactBatch(apobTxn, sizeof (apobTxn) / sizeof (apobTxn[0]));
+  if (ERR_SUCCESS == nRetVal)
   {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CHeaterCtrl::SetHeaterType(): Function called before Open Call!");
+    *pulPropGainMilli = obPropReq.Resp().stData.htrsolDataUnion.PropGain;
+
+    *pulIntGainMilli = obIntReq.Resp().stData.htrsolDataUnion.IntGain;
+
+    *pulDiffGain = obDiffReq.Resp().stData.htrsolDataUnion.DiffGain;
   }
 
   return nRetVal;
+}
+
+// Set Heater type - AC or DC
+int CHeaterCtrl::SetHeaterType( HEATER_TYPE eHtrType )
+{ 
+  CHtrSetRequest obReq(CMD_HTR_FN_SET_HTR_TYPE);
+
+  obReq.Cmd().stData.htrsolDataUnion.HtrType = eHtrType;
 
+  return Transact(obReq);
 }
 
 // Get Heater type - AC or DC
 int CHeaterCtrl::GetHeaterType( HEATER_TYPE * p_eHtrType )
 { 
-  int nRetVal = ERR_SUCCESS;
-
-  CmdAckUnion stCmd = {0};
-  CAN_CMD_HTR_STRUCT stResp = {0};
+  CHtrGetRequest obReq(CMD_HTR_FN_GET_HTR_TYPE);
+  int nRetVal;
 
   if (NULL == p_eHtrType)
   {
     return ERR_INVALID_ARGS;
   }
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        SetCmdAckCommand(&stCmd.byCmdAck, CMD_HTR_FN_GET_HTR_TYPE);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd,  // Command
-                                                     sizeof (stCmd),          // Size of command
-                                                     (unsigned char *) &stResp,     // Response from remote board
-                                                     sizeof (stResp));        // Size of expected response
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          // Check if the device ACK'd or NACK'd
-          //if (stResp.stCmd.Err == 1)
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.htrsolDataUnion.ErrorType);
-            DEBUG2("CHeaterCtrl::GetHeaterType(): Device sent a NACK! Dev error code = %d!", nRetVal);
-
-          }
-          else
-          {
-            FixEndian(stResp.stData.htrsolDataUnion.HtrType);
-            * p_eHtrType = (HEATER_TYPE) stResp.stData.htrsolDataUnion.HtrType;
-            nRetVal = ERR_SUCCESS;
-          }
-        }
-        else if (nRetVal == sizeof (CmdAckUnion))
-        {
-          // Device did not understand our command and sent us a NACK
-          // Check if the device ACK'd or NACK'd
-          //if (stResp.stCmd.Err == 1)
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.htrsolDataUnion.ErrorType);
-            DEBUG2("CHeaterCtrl::GetHeaterType(): Device sent a NACK! Dev error code = %d!", nRetVal);
-
-          }
-          else
-          {
-            DEBUG2("CHeaterCtrl::GetHeaterType(): Device sent a ACK, but response packet size is invalid!: %d", nRetVal);
-            nRetVal = ERR_PROTOCOL;
-          }
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CHeaterCtrl::GetHeaterType(): Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CHeaterCtrl::GetHeaterType(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CHeaterCtrl::GetHeaterType(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CHeaterCtrl::GetHeaterType(): Invalid switch case!");
-      break;
-    }
-  }
-  else
+
+  nRetVal = Transact(obReq);
+  if (ERR_SUCCESS == nRetVal)
   {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CHeaterCtrl::GetHeaterType(): Function called before Open Call!");
+    * p_eHtrType = (HEATER_TYPE) obReq.Resp().stData.htrsolDataUnion.HtrType;
   }
 
   return nRetVal;
@@ -1694,549 +498,127 @@ int CHeaterCtrl::GetHeaterType( HEATER_TYPE * p_eHtrType )
 // Set Compensation Base Temperature.
 int CHeaterCtrl::SetCompBaseTemp( int nCompBaseTempMilliDegC )
 { 
-  int nRetVal = ERR_SUCCESS;
+  CHtrSetRequest obReq(CMD_HTR_FN_SET_COMP_BASE_TEMP);
 
-  CAN_CMD_HTR_STRUCT stCmd = {0};
-  CAN_CMD_HTR_STATUS_STRUCT stResp = {0};
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        SetCmdAckCommand(&stCmd.stCmd.byCmdAck, CMD_HTR_FN_SET_COMP_BASE_TEMP);
-        
-        stCmd.stData.htrsolDataUnion.CompBaseTemp = nCompBaseTempMilliDegC;
-
-        FixEndian(stCmd.stData.htrsolDataUnion.CompBaseTemp);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd,  // Command
-                                                     sizeof (stCmd),          // Size of command
-                                                     (unsigned char *) &stResp,     // Response from remote board
-                                                     sizeof (stResp));        // Size of expected response
-
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          // Check if the device ACK'd or NACK'd
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.StatusDataUnion.ErrorType);
-            DEBUG2("CHeaterCtrl::SetCompBaseTemp(): Device sent a NACK! Dev error code = %d!", nRetVal);
-
-          }
-          else
-          {
-            nRetVal = ERR_SUCCESS;
-          }
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CHeaterCtrl::SetCompBaseTemp(): Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CHeaterCtrl::SetCompBaseTemp(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CHeaterCtrl::SetCompBaseTemp(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CHeaterCtrl::SetCompBaseTemp(): Invalid switch case!");
-      break;
-    }
-  }
-  else
-  {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CHeaterCtrl::SetCompBaseTemp(): Function called before Open Call!");
-  }
-
-  return nRetVal;
+  obReq.Cmd().stData.htrsolDataUnion.CompBaseTemp = nCompBaseTempMilliDegC;
 
+  return Transact(obReq);
 }
 
-// Get Compensation Base Temperature
+// Get Compensation Base Temperature.
 int CHeaterCtrl::GetCompBaseTemp( int * p_nCompBaseTempMilliDegC )
 { 
-  int nRetVal = ERR_SUCCESS;
-
-  CmdAckUnion stCmd = {0};
-  CAN_CMD_HTR_STRUCT stResp = {0};
+  CHtrGetRequest obReq(CMD_HTR_FN_GET_COMP_BASE_TEMP);
+  int nRetVal;
 
   if (NULL == p_nCompBaseTempMilliDegC)
   {
     return ERR_INVALID_ARGS;
   }
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        SetCmdAckCommand(&stCmd.byCmdAck, CMD_HTR_FN_GET_COMP_BASE_TEMP);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd,  // Command
-                                                     sizeof (stCmd),          // Size of command
-                                                     (unsigned char *) &stResp,     // Response from remote board
-                                                     sizeof (stResp));        // Size of expected response
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          // Check if the device ACK'd or NACK'd
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.htrsolDataUnion.ErrorType);
-            DEBUG2("CHeaterCtrl::GetCompBaseTemp(): Device sent a NACK! Dev error code = %d!", nRetVal);
-
-          }
-          else
-          {
-            FixEndian(stResp.stData.htrsolDataUnion.CompBaseTemp);
-            * p_nCompBaseTempMilliDegC = stResp.stData.htrsolDataUnion.CompBaseTemp;
-            nRetVal = ERR_SUCCESS;
-          }
-        }
-        else if (nRetVal == sizeof (CmdAckUnion))
-        {
-          // Device did not understand our command and sent us a NACK
-          // Check if the device ACK'd or NACK'd
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.htrsolDataUnion.ErrorType);
-            DEBUG2("CHeaterCtrl::GetCompBaseTemp(): Device sent a NACK! Dev error code = %d!", nRetVal);
-
-          }
-          else
-          {
-            DEBUG2("CHeaterCtrl::GetCompBaseTemp(): Device sent a ACK, but response packet size is invalid!: %d", nRetVal);
-            nRetVal = ERR_PROTOCOL;
-          }
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CHeaterCtrl::GetCompBaseTemp(): Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CHeaterCtrl::GetCompBaseTemp(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CHeaterCtrl::GetCompBaseTemp(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CHeaterCtrl::GetCompBaseTemp(): Invalid switch case!");
-      break;
-    }
-  }
-  else
+
+  nRetVal = Transact(obReq);
+  if (ERR_SUCCESS == nRetVal)
   {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CHeaterCtrl::GetCompBaseTemp(): Function called before Open Call!");
+    * p_nCompBaseTempMilliDegC = obReq.Resp().stData.htrsolDataUnion.CompBaseTemp;
   }
 
   return nRetVal;
 }
 
-
 // Mark Compensation Base Temperature.
 int CHeaterCtrl::MarkCompBaseTemp()
 { 
-  int nRetVal = ERR_SUCCESS;
-
-  CAN_CMD_HTR_STRUCT stCmd = {0};
-  CAN_CMD_HTR_STATUS_STRUCT stResp = {0};
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        SetCmdAckCommand(&stCmd.stCmd.byCmdAck, CMD_HTR_FN_MARK_COMP_BASE_TEMP);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd,  // Command
-                                                     sizeof (stCmd),          // Size of command
-                                                     (unsigned char *) &stResp,     // Response from remote board
-                                                     sizeof (stResp));        // Size of expected response
-
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          // Check if the device ACK'd or NACK'd
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.StatusDataUnion.ErrorType);
-            DEBUG2("CHeaterCtrl::MarkCompBaseTemp(): Device sent a NACK! Dev error code = %d!", nRetVal);
-
-          }
-          else
-          {
-            nRetVal = ERR_SUCCESS;
-          }
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CHeaterCtrl::MarkCompBaseTemp(): Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CHeaterCtrl::MarkCompBaseTemp(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CHeaterCtrl::MarkCompBaseTemp(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CHeaterCtrl::MarkCompBaseTemp(): Invalid switch case!");
-      break;
-    }
-  }
-  else
-  {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CHeaterCtrl::MarkCompBaseTemp(): Function called before Open Call!");
-  }
-
-  return nRetVal;
+  // The command carries an (unused) data field
+  CHtrSetRequest obReq(CMD_HTR_FN_MARK_COMP_BASE_TEMP);
 
+  return Transact(obReq);
 }
 
 // Set Compensation Temperature Slope.
 int CHeaterCtrl::SetCompTempSlope( float fCompTempSlope )
 { 
-  int nRetVal = ERR_SUCCESS;
-
-  CAN_CMD_HTR_STRUCT stCmd = {0};
-  CAN_CMD_HTR_STATUS_STRUCT stResp = {0};
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        SetCmdAckCommand(&stCmd.stCmd.byCmdAck, CMD_HTR_FN_SET_COMP_TEMP_SLOPE);
-        
-        stCmd.stData.htrsolDataUnion.CompTempSlope = fCompTempSlope;
-
-        FixEndian(stCmd.stData.htrsolDataUnion.CompTempSlope);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd,  // Command
-                                                     sizeof (stCmd),          // Size of command
-                                                     (unsigned char *) &stResp,     // Response from remote board
-                                                     sizeof (stResp));        // Size of expected response
-
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          // Check if the device ACK'd or NACK'd
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.StatusDataUnion.ErrorType);
-            DEBUG2("CHeaterCtrl::SetCompTempSlope(): Device sent a NACK! Dev error code = %d!", nRetVal);
-
-          }
-          else
-          {
-            nRetVal = ERR_SUCCESS;
-          }
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CHeaterCtrl::SetCompTempSlope(): Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CHeaterCtrl::SetCompTempSlope(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CHeaterCtrl::SetCompTempSlope(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CHeaterCtrl::SetCompTempSlope(): Invalid switch case!");
-      break;
-    }
-  }
-  else
-  {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CHeaterCtrl::SetCompTempSlope(): Function called before Open Call!");
-  }
+  CHtrSetRequest obReq(CMD_HTR_FN_SET_COMP_TEMP_SLOPE);
 
-  return nRetVal;
+  obReq.Cmd().stData.htrsolDataUnion.CompTempSlope = fCompTempSlope;
 
+  return Transact(obReq);
 }
 
 
 // Get Compensation Temperature Slope
 int CHeaterCtrl::GetCompTempSlope( float * p_fCompTempSlope )
 { 
-  int nRetVal = ERR_SUCCESS;
-
-  CmdAckUnion stCmd = {0};
-  CAN_CMD_HTR_STRUCT stResp = {0};
+  CHtrGetRequest obReq(CMD_HTR_FN_GET_COMP_TEMP_SLOPE);
+  int nRetVal;
 
   if (NULL == p_fCompTempSlope)
   {
     return ERR_INVALID_ARGS;
   }
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        SetCmdAckCommand(&stCmd.byCmdAck, CMD_HTR_FN_GET_COMP_TEMP_SLOPE);
-
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd,  // Command
-                                                     sizeof (stCmd),          // Size of command
-                                                     (unsigned char *) &stResp,     // Response from remote board
-                                                     sizeof (stResp));        // Size of expected response
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
-        {
-          // Check if the device ACK'd or NACK'd
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.htrsolDataUnion.ErrorType);
-            DEBUG2("CHeaterCtrl::GetCompTempSlope(): Device sent a NACK! Dev error code = %d!", nRetVal);
-
-          }
-          else
-          {
-            FixEndian(stResp.stData.htrsolDataUnion.CompTempSlope);
-            * p_fCompTempSlope = stResp.stData.htrsolDataUnion.CompTempSlope;
-            nRetVal = ERR_SUCCESS;
-          }
-        }
-        else if (nRetVal == sizeof (CmdAckUnion))
-        {
-          // Device did not understand our command and sent us a NACK
-          // Check if the device ACK'd or NACK'd
-          if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-          {
-            nRetVal = TransDevError (stResp.stData.htrsolDataUnion.ErrorType);
-            DEBUG2("CHeaterCtrl::GetCompTempSlope(): Device sent a NACK! Dev error code = %d!", nRetVal);
-
-          }
-          else
-          {
-            DEBUG2("CHeaterCtrl::GetCompTempSlope(): Device sent a ACK, but response packet size is invalid!: %d", nRetVal);
-            nRetVal = ERR_PROTOCOL;
-          }
-        }
-        //Not the expected packet size
-        else if (nRetVal >= 0)
-        {
-          DEBUG2("CHeaterCtrl::GetCompTempSlope(): Unexpected packet size: %d", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
-        else // if (nRetVal < 0)
-        {
-          DEBUG2("CHeaterCtrl::GetCompTempSlope(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CHeaterCtrl::GetCompTempSlope(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CHeaterCtrl::GetCompTempSlope(): Invalid switch case!");
-      break;
-    }
-  }
-  else
+
+  nRetVal = Transact(obReq);
+  if (ERR_SUCCESS == nRetVal)
   {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CHeaterCtrl::GetCompTempSlope(): Function called before Open Call!");
+    * p_fCompTempSlope = obReq.Resp().stData.htrsolDataUnion.CompTempSlope;
   }
 
   return nRetVal;
 }
 
-typedef struct
-{
-  CAN_CMD_HTR_STRUCT s;
-  unsigned char ucRTDndx;
-} 
-#ifndef WIN32
-  __attribute (( packed )) 
-#endif 
-  CAN_CMD_HTR_RTD_LEAD_STRUCT;
-
 // Set RTD lead resistor value
 int CHeaterCtrl::SetRTDleadR(unsigned char rtdNdx, float fValue)
 {
-  int nRetVal = ERR_SUCCESS;
-  CAN_CMD_HTR_RTD_LEAD_STRUCT stCmd;
-  CAN_CMD_HTR_STATUS_STRUCT stResp = {0};
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
+  CDevRequest<CAN_CMD_HTR_RTD_LEAD_STRUCT, CAN_CMD_HTR_STATUS_STRUCT> obReq(CMD_HTR_FN_SET_RTD_LEAD_RESIST);
+
+  obReq.Cmd().s.stData.htrsolDataUnion.LeadResistance = fValue;
+  obReq.Cmd().ucRTDndx = rtdNdx;
+
+  return Transact(obReq);
+}
+
+// Have the board push the temperature and PWM every PeriodMs (0 - stop)
+int CHeaterCtrl::SetStreamPeriod (unsigned int PeriodMs)
+{
+  CHtrSetRequest obReq(CMD_HTR_FN_SET_STREAM_PERIOD);
+  int nRetVal;
+
+  if (m_bIsDevOpen && !m_bIsStreaming)
   {
-    switch (m_eCommType)
-    {
-      case CAN_COMM:
-        if (m_pobCAN)
-        {
-          SetCmdAckCommand(&stCmd.s.stCmd.byCmdAck, CMD_HTR_FN_SET_RTD_LEAD_RESIST);
-          stCmd.s.stData.htrsolDataUnion.CompTempSlope = fValue;
-          FixEndian(stCmd.s.stData.htrsolDataUnion.LeadResistance);
-          stCmd.ucRTDndx = rtdNdx;
-
-          // Send a command and wait for ackowledgement from remote device
-          nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *)&stCmd, sizeof(stCmd), (unsigned char *)&stResp, sizeof(stResp));
-
-          // Check if we got the correct response packet
-          if (nRetVal == sizeof(stResp))
-          {
-            // Check if the device ACK'd or NACK'd
-            if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-            {
-              nRetVal = TransDevError(stResp.stData.StatusDataUnion.ErrorType);
-              DEBUG2("CHeaterCtrl::SetRTDleadR(): Device sent a NACK! Dev error code = %d!", nRetVal);
-            }
-            else
-              nRetVal = ERR_SUCCESS;
-          }
-          else if (nRetVal >= 0)
-          {
-            DEBUG2("CHeaterCtrl::SetRTDleadR(): Unexpected packet size: %d", nRetVal);
-            nRetVal = ERR_PROTOCOL;
-          }
-          else
-          {
-            DEBUG2("CHeaterCtrl::SetRTDleadR(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-          }
-        }
-        else
-        {
-          nRetVal = ERR_INTERNAL_ERR;
-          DEBUG2("CHeaterCtrl::SetRTDleadR(): Unexpected invalid pointer!");
-        }
-        break;
-
-      case SPI_COMM:
-        // TODO: To be implemented?
-      case SERIAL_COMM:
-        // TODO:  To be implemented?
-      case COMM_NONE:
-      default:
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CHeaterCtrl::SetRTDleadR(): Invalid switch case!");
-        break;
-    }
+    DEBUG2("CHeaterCtrl::SetStreamPeriod(): %s - Device not opened for streaming!", m_szDevName);
+    return ERR_INVALID_SEQ;
   }
-  else
+
+  obReq.Cmd().stData.htrsolDataUnion.StreamPeriodMs = PeriodMs;
+
+  nRetVal = Transact(obReq);
+  if (ERR_SUCCESS == nRetVal)
   {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CHeaterCtrl::SetCompTempSlope(): Function called before Open Call!");
+    SetPushPeriod (PeriodMs);
   }
 
   return nRetVal;
 }
+
+// Read the next pushed value
+int CHeaterCtrl::ReadStreamData (DevStreamValueStruct* Value, unsigned int Timeout)
+{
+  return ReadPushedValue (Value, Timeout, "ReadStreamData");
+}
+
+// Counters of the pushed values
+int CHeaterCtrl::GetStreamStats (DevStreamStatsStruct* Stats)
+{
+  return GetPushStats (Stats);
+}
+
+// Return Receive Pipe File Descriptor
+int CHeaterCtrl::GetRxStreamingFd ()
+{
+  if (NULL == m_pobCAN)
+  {
+    DEBUG2("CHeaterCtrl::GetRxStreamingFd(): Unexpected invalid pointer!");
+    return ERR_INTERNAL_ERR;
+  }
+
+  return m_pobCAN->CANGetRxStrmFd();
+}
@@ -127,13 +127,28 @@
 #include "debug.h"
 #include "IMBProtocol.h"
 #include "IMBComm.h"
+#include "WireLayouts.h"  // For the byte order of the flash image requests
+#include "crc16.h"
 
 
 #define IMB_REQUEST_TIME_OUT  900
+
+// Requests of the windowed flash image transfers
+typedef CDevRequest<CAN_CMD_IMB_WRITE_DATA_STRUCT, CAN_IMB_STATUS_STRUCT> IMBWriteRequest;
+typedef CDevRequest<CAN_CMD_IMB_READ_DATA_REQUEST_STRUCT, CAN_CMD_IMB_READ_DATA_STRUCT> IMBReadRequest;
+
 CIMBComm::CIMBComm()  // Default Constructor
 {
   // IMB firmware API version
   //m_nAPIVer = 1;
+
+  m_unWindow = IMB_DFLT_TRANSFER_WINDOW;
+  m_pfnProgress = NULL;
+  m_pvProgressArg = NULL;
+  m_ullTransferStartUs = 0;
+  m_unProgressDone = 0;
+  m_unProgressTotal = 0;
+  memset(&m_stTransferStats, 0, sizeof (m_stTransferStats));
 }
 
 CIMBComm::~CIMBComm() // Destructor
@@ -3531,30 +3546,47 @@ int CIMBComm::GetGlobalDataModuleSerialNum2( unsigned char * pchData )
 
 // Set the the flash image (write data to IMB)
 // THIS VERSION DOES NOT HAVE THE LENTH CONSTRAINT !!!!
+// Only a windowed write (see SetTransferWindow()) is read back and verified - one
+// chunk at a time relies on the acknowledgement of each chunk, as it always has.
 int CIMBComm::SetFlashImage2( unsigned char * pchFlashImage, const unsigned char bySection, const unsigned int unOffset, const unsigned int unLength)
 {
   //the while loop
   unsigned int count = 0;
   int ret = 0;
+
+  // Keep other threads' commands out of the middle of the image
+  CHALLock obCmdLock(GetCmdLock());
+
+  StartTransfer(unLength);
+
+  if (m_unWindow > 1)
+  {
+    ret = SetFlashImageWindowed(pchFlashImage, bySection, unOffset, unLength);
+    EndTransfer(pchFlashImage, (ret < 0) ? 0 : unLength);
+    return ret;
+  }
+
   do
   {
-    // is this last batch?
-    bool bLastBatch = ((count+1) * FLASH_IMAGE_DATA_LENGTH) < unLength;
     // the data length to be sent in this batch
-    unsigned int unDataSent = 
-      bLastBatch ? FLASH_IMAGE_DATA_LENGTH : (unLength % FLASH_IMAGE_DATA_LENGTH);
+    unsigned int unDataSent = ChunkLen(count, unLength);
     // the offst to be used in this batch
     unsigned int unOffsetSent = unOffset + count * FLASH_IMAGE_DATA_LENGTH;
     // the data pointer for this batcch
     unsigned char * pData = (unsigned char *) pchFlashImage + count * FLASH_IMAGE_DATA_LENGTH;
 
     ret = SetFlashImage( pData, bySection, unOffsetSent, unDataSent );
+    m_stTransferStats.unChunksSent++;
     if(ret < 0)
-      return ret;
+      break;
+
+    ReportProgress(unDataSent);
 
     count++;
   } while ( (count * FLASH_IMAGE_DATA_LENGTH) < unLength);
 
+  EndTransfer(pchFlashImage, (ret < 0) ? 0 : unLength);
+
   return ret;
 }
 
@@ -3659,25 +3691,40 @@ int CIMBComm::GetFlashImage2( unsigned char * pchFlashImage, const unsigned char
   //the while loop
   unsigned int count = 0;
   int ret = 0;
+
+  // Keep other threads' commands out of the middle of the image
+  CHALLock obCmdLock(GetCmdLock());
+
+  StartTransfer(length);
+
+  if (m_unWindow > 1)
+  {
+    ret = GetFlashImageWindowed(pchFlashImage, bySection, offset, length, &refActualLen);
+    EndTransfer(pchFlashImage, (ret < 0) ? 0 : length);
+    return ret;
+  }
+
   do
   {
-    // is this last batch?
-    bool bLastBatch = ((count+1) * FLASH_IMAGE_DATA_LENGTH) < length;
     // the data length to be sent in this batch
-    unsigned int unDataSent = 
-      bLastBatch ? FLASH_IMAGE_DATA_LENGTH : (length % FLASH_IMAGE_DATA_LENGTH);
+    unsigned int unDataSent = ChunkLen(count, length);
     // the offset to be used in this batch
     unsigned int unOffsetSent = offset + count * FLASH_IMAGE_DATA_LENGTH;
     // the data pointer for this batcch
     unsigned char * pData = (unsigned char *) pchFlashImage + count * FLASH_IMAGE_DATA_LENGTH;
 
     ret = GetFlashImage( pData, bySection, unOffsetSent, unDataSent, refActualLen );
+    m_stTransferStats.unChunksSent++;
     if(ret < 0)
-      return ret;
+      break;
+
+    ReportProgress(unDataSent);
 
     count++;
   } while ( (count * FLASH_IMAGE_DATA_LENGTH) < length);
 
+  EndTransfer(pchFlashImage, (ret < 0) ? 0 : length);
+
   return ret;
 }
 
@@ -3793,6 +3840,418 @@ int CIMBComm::GetFlashImage( unsigned char * pchFlashImage, const unsigned char
   return nRetVal;
 }
 
+// Chunks of SetFlashImage2() / GetFlashImage2() in flight
+int CIMBComm::SetTransferWindow( unsigned int unWindow )
+{
+  if (unWindow < 1 || unWindow > IMB_MAX_TRANSFER_WINDOW)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  CHALLock obCmdLock(GetCmdLock());
+  m_unWindow = unWindow;
+
+  return ERR_SUCCESS;
+}
+
+// Called with the bytes transferred after every window
+void CIMBComm::SetTransferProgress( IMBProgressFn pfnProgress, void * pvArg )
+{
+  CHALLock obCmdLock(GetCmdLock());
+  m_pfnProgress = pfnProgress;
+  m_pvProgressArg = pvArg;
+}
+
+// Statistics of the last SetFlashImage2() / GetFlashImage2()
+int CIMBComm::GetTransferStats( IMBTransferStatsStruct * pstStats )
+{
+  if (NULL == pstStats)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  CHALLock obCmdLock(GetCmdLock());
+  *pstStats = m_stTransferStats;
+
+  return ERR_SUCCESS;
+}
+
+// Length of chunk unChunk of an image of unLength bytes
+unsigned int CIMBComm::ChunkLen(unsigned int unChunk, unsigned int unLength)
+{
+  unsigned int unStart = unChunk * FLASH_IMAGE_DATA_LENGTH;
+
+  if (unStart >= unLength)
+  {
+    return 0;
+  }
+
+  return (unLength - unStart < FLASH_IMAGE_DATA_LENGTH) ? unLength - unStart : FLASH_IMAGE_DATA_LENGTH;
+}
+
+void CIMBComm::StartTransfer(unsigned int unLength)
+{
+  memset(&m_stTransferStats, 0, sizeof (m_stTransferStats));
+  m_stTransferStats.unBytes = unLength;
+  m_stTransferStats.unChunks = (unLength + FLASH_IMAGE_DATA_LENGTH - 1) / FLASH_IMAGE_DATA_LENGTH;
+  m_stTransferStats.unWindow = m_unWindow;
+  m_ullTransferStartUs = CReliability::GetMonotonicTimeUs();
+  m_unProgressDone = 0;
+  m_unProgressTotal = unLength;
+}
+
+// Time the transfer took and the CRC of the first unCRCLen bytes of the image
+// (0 - the transfer failed)
+void CIMBComm::EndTransfer(const unsigned char *pbyImage, unsigned int unCRCLen)
+{
+  m_stTransferStats.ullElapsedUs = CReliability::GetMonotonicTimeUs() - m_ullTransferStartUs;
+  if (m_stTransferStats.ullElapsedUs > 0)
+  {
+    m_stTransferStats.dBytesPerSec = m_stTransferStats.unBytes * 1000000.0 / m_stTransferStats.ullElapsedUs;
+  }
+  if (unCRCLen > 0)
+  {
+    m_stTransferStats.usImageCRC = crc16((unsigned char *) pbyImage, unCRCLen);
+  }
+}
+
+void CIMBComm::ReportProgress(unsigned int unBytes)
+{
+  m_unProgressDone += unBytes;
+  if (m_unProgressDone > m_unProgressTotal)
+  {
+    m_unProgressDone = m_unProgressTotal;
+  }
+
+  if (m_pfnProgress)
+  {
+    m_pfnProgress(m_pvProgressArg, m_unProgressDone, m_unProgressTotal);
+  }
+}
+
+// Failures that sending the chunk again may cure
+static BOOL IsRetryableError(int nError)
+{
+  return (ERR_TIMEOUT == nError || ERR_PROTOCOL == nError || ERR_WRONG_CRC == nError);
+}
+
+// Write the chunks not done yet, a window at a time
+int CIMBComm::WriteChunks(const unsigned char *pbyImage, unsigned char bySection, unsigned int unOffset,
+                          unsigned int unLength, BOOL *pbDone, BOOL bRetransmit)
+{
+  IMBWriteRequest *apobReq[IMB_MAX_TRANSFER_WINDOW];
+  CDevTxn *apobTxn[IMB_MAX_TRANSFER_WINDOW];
+  unsigned int aunChunk[IMB_MAX_TRANSFER_WINDOW];
+  unsigned int unChunk = 0;
+  int nRetVal = ERR_SUCCESS;
+
+  while (unChunk < m_stTransferStats.unChunks)
+  {
+    int nNumReq = 0;
+    unsigned int unBytesDone = 0;
+
+    for (; unChunk < m_stTransferStats.unChunks && nNumReq < (int) m_unWindow; unChunk++)
+    {
+      if (pbDone[unChunk])
+      {
+        continue;
+      }
+
+      unsigned int unLen = ChunkLen(unChunk, unLength);
+      IMBWriteRequest *pobReq = new IMBWriteRequest(CMD_IMB_FN_WRITE_IMB_DATA);
+
+      memcpy(pobReq->Cmd().inflashData, pbyImage + unChunk * FLASH_IMAGE_DATA_LENGTH, unLen);
+      pobReq->Cmd().bySectionType = bySection;
+      pobReq->Cmd().uinFlashOffset = unOffset + unChunk * FLASH_IMAGE_DATA_LENGTH;
+      pobReq->Cmd().uinFlashLen = unLen;
+
+      aunChunk[nNumReq] = unChunk;
+      apobTxn[nNumReq] = pobReq;
+      apobReq[nNumReq++] = pobReq;
+    }
+
+    if (0 == nNumReq)
+    {
+      break;
+    }
+
+    TransactBatch(apobTxn, nNumReq, IMB_REQUEST_TIME_OUT, TRUE);
+
+    for (int nReq = 0; nReq < nNumReq; nReq++)
+    {
+      int nResult = apobReq[nReq]->GetResult();
+
+      m_stTransferStats.unChunksSent++;
+      if (bRetransmit)
+      {
+        m_stTransferStats.unRetransmits++;
+      }
+
+      if (ERR_SUCCESS == nResult)
+      {
+        pbDone[aunChunk[nReq]] = TRUE;
+        unBytesDone += ChunkLen(aunChunk[nReq], unLength);
+      }
+      else if (ERR_SUCCESS == nRetVal || !IsRetryableError(nResult))
+      {
+        DEBUG2("CIMBComm::SetFlashImage2(): Chunk at offset %u failed with error code %d!",
+               unOffset + aunChunk[nReq] * FLASH_IMAGE_DATA_LENGTH, nResult);
+        nRetVal = nResult;
+      }
+
+      delete apobReq[nReq];
+    }
+
+    ReportProgress(unBytesDone);
+
+    if (nRetVal < 0 && !IsRetryableError(nRetVal))
+    {
+      break;
+    }
+  }
+
+  return nRetVal;
+}
+
+// Read the chunks not done yet, a window at a time
+int CIMBComm::ReadChunks(unsigned char *pbyImage, unsigned char bySection, unsigned int unOffset,
+                         unsigned int unLength, BOOL *pbDone, BOOL bRetransmit, unsigned int *punActualLen)
+{
+  IMBReadRequest *apobReq[IMB_MAX_TRANSFER_WINDOW];
+  CDevTxn *apobTxn[IMB_MAX_TRANSFER_WINDOW];
+  unsigned int aunChunk[IMB_MAX_TRANSFER_WINDOW];
+  unsigned int unChunk = 0;
+  int nRetVal = ERR_SUCCESS;
+
+  while (unChunk < m_stTransferStats.unChunks)
+  {
+    int nNumReq = 0;
+    unsigned int unBytesDone = 0;
+
+    for (; unChunk < m_stTransferStats.unChunks && nNumReq < (int) m_unWindow; unChunk++)
+    {
+      if (pbDone[unChunk])
+      {
+        continue;
+      }
+
+      IMBReadRequest *pobReq = new IMBReadRequest(CMD_IMB_FN_READ_IMB_DATA);
+
+      pobReq->Cmd().bySectionType = bySection;
+      pobReq->Cmd().nFlashOffset = unOffset + unChunk * FLASH_IMAGE_DATA_LENGTH;
+      pobReq->Cmd().nFlashLen = ChunkLen(unChunk, unLength);
+
+      aunChunk[nNumReq] = unChunk;
+      apobTxn[nNumReq] = pobReq;
+      apobReq[nNumReq++] = pobReq;
+    }
+
+    if (0 == nNumReq)
+    {
+      break;
+    }
+
+    TransactBatch(apobTxn, nNumReq, IMB_REQUEST_TIME_OUT, TRUE);
+
+    for (int nReq = 0; nReq < nNumReq; nReq++)
+    {
+      int nResult = apobReq[nReq]->GetResult();
+
+      m_stTransferStats.unChunksSent++;
+      if (bRetransmit)
+      {
+        m_stTransferStats.unRetransmits++;
+      }
+
+      if (nResult < 0)
+      {
+        if (ERR_SUCCESS == nRetVal || !IsRetryableError(nResult))
+        {
+          DEBUG2("CIMBComm::GetFlashImage2(): Chunk at offset %u failed with error code %d!",
+                 unOffset + aunChunk[nReq] * FLASH_IMAGE_DATA_LENGTH, nResult);
+          nRetVal = nResult;
+        }
+        continue;
+      }
+
+      // All the responses carry the same command. The offset they echo puts each
+      // with its own chunk.
+      const CAN_CMD_IMB_READ_DATA_STRUCT &stResp = apobReq[nReq]->Resp();
+      int nMatch = 0;
+      while (nMatch < nNumReq &&
+             (pbDone[aunChunk[nMatch]] ||
+              stResp.nRequestOffset != unOffset + aunChunk[nMatch] * FLASH_IMAGE_DATA_LENGTH))
+      {
+        nMatch++;
+      }
+
+      if (nMatch == nNumReq || stResp.flashDataLen > ChunkLen(aunChunk[nMatch], unLength))
+      {
+        DEBUG2("CIMBComm::GetFlashImage2(): Unexpected response for offset %u, length %u!",
+               stResp.nRequestOffset, stResp.flashDataLen);
+        if (ERR_SUCCESS == nRetVal)
+        {
+          nRetVal = ERR_PROTOCOL;
+        }
+        continue;
+      }
+
+      unsigned int unMatchChunk = aunChunk[nMatch];
+      memcpy(pbyImage + unMatchChunk * FLASH_IMAGE_DATA_LENGTH, stResp.flashData, stResp.flashDataLen);
+      pbDone[unMatchChunk] = TRUE;
+      unBytesDone += ChunkLen(unMatchChunk, unLength);
+
+      // As GetFlashImage2() one chunk at a time - the length read of the last chunk
+      if (unMatchChunk == m_stTransferStats.unChunks - 1)
+      {
+        *punActualLen = stResp.flashDataLen;
+      }
+    }
+
+    for (int nReq = 0; nReq < nNumReq; nReq++)
+    {
+      delete apobReq[nReq];
+    }
+
+    ReportProgress(unBytesDone);
+
+    if (nRetVal < 0 && !IsRetryableError(nRetVal))
+    {
+      break;
+    }
+  }
+
+  return nRetVal;
+}
+
+// Read an image with several chunks in flight. Chunks that failed or whose response
+// went missing are read again, up to IMB_MAX_TRANSFER_ROUNDS passes.
+int CIMBComm::GetFlashImageWindowed(unsigned char *pbyImage, unsigned char bySection, unsigned int unOffset,
+                                    unsigned int unLength, unsigned int *punActualLen)
+{
+  int nRetVal = ERR_SUCCESS;
+  BOOL bAllDone = FALSE;
+
+  if (NULL == pbyImage)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  BOOL *pbDone = new BOOL[m_stTransferStats.unChunks + 1];
+  memset(pbDone, 0, (m_stTransferStats.unChunks + 1) * sizeof (BOOL));
+
+  for (int nRound = 0; nRound < IMB_MAX_TRANSFER_ROUNDS && !bAllDone; nRound++)
+  {
+    m_stTransferStats.unRounds++;
+
+    nRetVal = ReadChunks(pbyImage, bySection, unOffset, unLength, pbDone, nRound > 0, punActualLen);
+    if (nRetVal < 0 && !IsRetryableError(nRetVal))
+    {
+      break;
+    }
+
+    bAllDone = TRUE;
+    for (unsigned int unChunk = 0; unChunk < m_stTransferStats.unChunks; unChunk++)
+    {
+      bAllDone = bAllDone && pbDone[unChunk];
+    }
+  }
+
+  delete [] pbDone;
+
+  return bAllDone ? ERR_SUCCESS : ((nRetVal < 0) ? nRetVal : ERR_TIMEOUT);
+}
+
+// Write an image with several chunks in flight, then read it back and compare
+// its CRC. The acknowledgements carry no offset, so when one is lost the batch
+// can not tell which chunk it belonged to and writes all of the window's chunks
+// again one at a time (see CReliability::GetRemoteRespBatch). The read back checks
+// the image as a whole; chunks found different are written again.
+int CIMBComm::SetFlashImageWindowed(unsigned char *pbyImage, unsigned char bySection, unsigned int unOffset,
+                                    unsigned int unLength)
+{
+  int nRetVal = ERR_SUCCESS;
+  int nRound = 0;
+  unsigned int unActualLen = 0;
+  unsigned int unNumChunks = m_stTransferStats.unChunks;
+
+  if (NULL == pbyImage)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  // The read back is part of the transfer
+  m_unProgressTotal = 2 * unLength;
+
+  BOOL *pbWritten = new BOOL[unNumChunks + 1];
+  memset(pbWritten, 0, (unNumChunks + 1) * sizeof (BOOL));
+  unsigned char *pbyReadBack = new unsigned char[unLength + 1];
+
+  unsigned short usCRC = crc16(pbyImage, unLength);
+
+  for (nRound = 0; nRound < IMB_MAX_TRANSFER_ROUNDS && !m_stTransferStats.bVerified; nRound++)
+  {
+    BOOL bAllWritten = TRUE;
+
+    m_stTransferStats.unRounds++;
+
+    nRetVal = WriteChunks(pbyImage, bySection, unOffset, unLength, pbWritten, nRound > 0);
+    if (nRetVal < 0 && !IsRetryableError(nRetVal))
+    {
+      break;
+    }
+
+    for (unsigned int unChunk = 0; unChunk < unNumChunks; unChunk++)
+    {
+      bAllWritten = bAllWritten && pbWritten[unChunk];
+    }
+    if (!bAllWritten)
+    {
+      continue;
+    }
+
+    // The passes of the read back are not counted as rounds of the write
+    unsigned int unRounds = m_stTransferStats.unRounds;
+    m_unProgressDone = unLength;
+    memset(pbyReadBack, 0, unLength);
+    nRetVal = GetFlashImageWindowed(pbyReadBack, bySection, unOffset, unLength, &unActualLen);
+    m_stTransferStats.unRounds = unRounds;
+    if (nRetVal < 0)
+    {
+      DEBUG2("CIMBComm::SetFlashImage2(): Read back failed with error code %d!", nRetVal);
+      break;
+    }
+
+    if (crc16(pbyReadBack, unLength) == usCRC && 0 == memcmp(pbyReadBack, pbyImage, unLength))
+    {
+      m_stTransferStats.bVerified = TRUE;
+      break;
+    }
+
+    for (unsigned int unChunk = 0; unChunk < unNumChunks; unChunk++)
+    {
+      unsigned int unStart = unChunk * FLASH_IMAGE_DATA_LENGTH;
+      pbWritten[unChunk] = (0 == memcmp(pbyReadBack + unStart, pbyImage + unStart, ChunkLen(unChunk, unLength)));
+    }
+    m_unProgressDone = 0;
+    DEBUG2("CIMBComm::SetFlashImage2(): Image read back differs, writing again.");
+  }
+
+  if (ERR_SUCCESS == nRetVal && !m_stTransferStats.bVerified)
+  {
+    nRetVal = ERR_PROTOCOL;
+  }
+  if (nRetVal < 0)
+  {
+    DEBUG2("CIMBComm::SetFlashImage2(): Image not written after %d rounds, error code %d!", nRound, nRetVal);
+  }
+
+  delete [] pbyReadBack;
+  delete [] pbWritten;
+
+  return nRetVal;
+}
+
 /*----------------------------------------------------------------------------
  * Sets the flash image of FACTORY or MIRROR section
  *--------------------------------------------------------------------------*/
@@ -0,0 +1,145 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                     10241 West Little York, Suite 200
+ * *                            Houston, TX 77040
+ * *
+ * *
+ * *  Filename: NoiseStats.cpp
+ * *
+ * *  Description: Running noise and drift statistics of detector (preamp)
+ * *               data.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+#include <string.h>
+#include <math.h>
+
+#include "NoiseStats.h"
+
+CNoiseStats::CNoiseStats()
+{
+  memset(&m_stConfig, 0, sizeof (m_stConfig));
+  m_stConfig.unNumWindows = 2;
+  m_stConfig.aunWindowSamples[0] = NOISE_STATS_DFLT_WINDOW;
+  m_stConfig.aunWindowSamples[1] = 0;
+  Reset();
+}
+
+// Set the windows
+int CNoiseStats::Configure(const NoiseStatsConfigStruct &Config)
+{
+  if ( (0 == Config.unNumWindows) || (Config.unNumWindows > NOISE_STATS_MAX_WINDOWS) )
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  for (unsigned int unWindow = 0; unWindow < Config.unNumWindows; unWindow++)
+  {
+    // At least 2 samples for a standard deviation and a slope
+    if (1 == Config.aunWindowSamples[unWindow])
+    {
+      return ERR_INVALID_ARGS;
+    }
+  }
+
+  m_stConfig = Config;
+  Reset();
+
+  return ERR_SUCCESS;
+}
+
+// Clear the figures
+void CNoiseStats::Reset()
+{
+  for (unsigned int unWindow = 0; unWindow < NOISE_STATS_MAX_WINDOWS; unWindow++)
+  {
+    Clear(&m_astCurrent[unWindow]);
+    Clear(&m_astLast[unWindow]);
+  }
+}
+
+void CNoiseStats::Clear(AccumStruct *pstAccum)
+{
+  memset(pstAccum, 0, sizeof (*pstAccum));
+}
+
+// Welford's update, for the values and (for the slope) jointly for times and values
+void CNoiseStats::Add(AccumStruct *pstAccum, int nValue, unsigned long long ullTimeStamp)
+{
+  if (0 == pstAccum->ulSamples)
+  {
+    pstAccum->ullStartTime = ullTimeStamp;
+    pstAccum->nMin = nValue;
+    pstAccum->nMax = nValue;
+  }
+  pstAccum->ullEndTime = ullTimeStamp;
+  pstAccum->ulSamples++;
+
+  double dN = (double) pstAccum->ulSamples;
+  double dTime = (double) (ullTimeStamp - pstAccum->ullStartTime) / 1000.0;
+  double dDelta = nValue - pstAccum->dMean;
+  double dTimeDelta = dTime - pstAccum->dTimeMean;
+
+  pstAccum->dMean += dDelta / dN;
+  pstAccum->dTimeMean += dTimeDelta / dN;
+  pstAccum->dM2 += dDelta * (nValue - pstAccum->dMean);
+  pstAccum->dTimeM2 += dTimeDelta * (dTime - pstAccum->dTimeMean);
+  pstAccum->dCoM += dTimeDelta * (nValue - pstAccum->dMean);
+
+  if (nValue < pstAccum->nMin)
+  {
+    pstAccum->nMin = nValue;
+  }
+  else if (nValue > pstAccum->nMax)
+  {
+    pstAccum->nMax = nValue;
+  }
+}
+
+void CNoiseStats::ToStats(const AccumStruct &stAccum, NoiseStatsStruct *pstStats)
+{
+  memset(pstStats, 0, sizeof (*pstStats));
+  if (0 == stAccum.ulSamples)
+  {
+    return;
+  }
+
+  pstStats->ulSamples = stAccum.ulSamples;
+  pstStats->ullStartTime = stAccum.ullStartTime;
+  pstStats->ullEndTime = stAccum.ullEndTime;
+  pstStats->dMean = stAccum.dMean;
+  pstStats->dStdDev = (stAccum.ulSamples > 1) ? sqrt(stAccum.dM2 / (stAccum.ulSamples - 1)) : 0.0;
+  pstStats->nMin = stAccum.nMin;
+  pstStats->nMax = stAccum.nMax;
+  pstStats->nPeakToPeak = stAccum.nMax - stAccum.nMin;
+  pstStats->dDrift = (stAccum.dTimeM2 > 0.0) ? stAccum.dCoM / stAccum.dTimeM2 : 0.0;
+}
+
+// Figures of a window so far and of the last complete window
+int CNoiseStats::GetStats(unsigned int Window, NoiseStatsStruct *Current, NoiseStatsStruct *Last) const
+{
+  if (Window >= m_stConfig.unNumWindows)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  if (Current)
+  {
+    ToStats(m_astCurrent[Window], Current);
+  }
+  if (Last)
+  {
+    ToStats(m_astLast[Window], Last);
+  }
+
+  return ERR_SUCCESS;
+}
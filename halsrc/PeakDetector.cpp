@@ -0,0 +1,266 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                     10241 West Little York, Suite 200
+ * *                            Houston, TX 77040
+ * *
+ * *
+ * *  Filename: PeakDetector.cpp
+ * *
+ * *  Description: Streaming peak detection on detector (preamp) data.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+#include <string.h>
+
+#include "PeakDetector.h"
+
+#define BASELINE_FRAC_BITS    8
+
+CPeakDetector::CPeakDetector()
+{
+  m_stConfig.unSlopeWindow = PEAK_DET_DFLT_WINDOW;
+  m_stConfig.nSlopeThreshold = PEAK_DET_DFLT_SLOPE;
+  m_stConfig.unConfirm = PEAK_DET_DFLT_CONFIRM;
+  m_stConfig.nMinHeight = PEAK_DET_DFLT_MIN_HEIGHT;
+  m_stConfig.unBaselineShift = PEAK_DET_DFLT_BASE_SHIFT;
+  memset(&m_stStats, 0, sizeof (m_stStats));
+  Reset();
+}
+
+// Set the detection parameters
+int CPeakDetector::Configure(const PeakDetectConfigStruct &Config)
+{
+  if ( (Config.unSlopeWindow < 2) || (Config.unSlopeWindow > PEAK_DET_MAX_WINDOW) ||
+       (Config.nSlopeThreshold <= 0) || (0 == Config.unConfirm) || (Config.nMinHeight < 0) ||
+       (Config.unBaselineShift > 16) )
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  m_stConfig = Config;
+  Reset();
+
+  return ERR_SUCCESS;
+}
+
+// Start a new chromatogram
+void CPeakDetector::Reset()
+{
+  m_unWindowPos = 0;
+  m_unWindowCount = 0;
+  m_llWindowSum = 0;
+  m_eState = STATE_BASELINE;
+  m_llBaseline = 0;
+  m_unRun = 0;
+  m_bStarted = FALSE;
+  m_ullStartTime = 0;
+  m_nStartValue = 0;
+  m_nPeakBaseline = 0;
+  m_nExtreme = 0;
+  m_ullExtremeTime = 0;
+  m_llArea = 0;
+  m_unEventHead = 0;
+  m_unEventCount = 0;
+}
+
+void CPeakDetector::AddEvent(PEAK_EVENT_ENUM eEvent, unsigned long long ullTime, int nValue, long long llArea)
+{
+  // Full - drop the oldest
+  if (m_unEventCount == PEAK_DET_EVENT_QUEUE_LEN)
+  {
+    m_unEventHead = (m_unEventHead + 1) % PEAK_DET_EVENT_QUEUE_LEN;
+    m_unEventCount--;
+    m_stStats.ulEventsLost++;
+  }
+
+  PeakEventStruct &stEvent = m_astEvents[(m_unEventHead + m_unEventCount) % PEAK_DET_EVENT_QUEUE_LEN];
+  stEvent.eEvent = eEvent;
+  stEvent.ullTimeStamp = ullTime;
+  stEvent.nValue = nValue;
+  stEvent.nBaseline = m_nPeakBaseline;
+  stEvent.llArea = llArea;
+  m_unEventCount++;
+}
+
+// A rise seen at the current sample - the peak starts at the oldest sample of the
+// slope window
+void CPeakDetector::BeginRise(int nBaseline, int nMean, unsigned long long ullMeanTime)
+{
+  unsigned int unWindowLen = m_stConfig.unSlopeWindow + 1;
+  unsigned int unOldest = (m_unWindowPos + unWindowLen - m_unWindowCount) % unWindowLen;
+
+  m_eState = STATE_RISING;
+  m_bStarted = FALSE;
+  m_unRun = 0;
+  m_nPeakBaseline = nBaseline;
+  m_ullStartTime = m_aullWindowTime[unOldest];
+  m_nStartValue = m_anWindow[unOldest];
+  m_nExtreme = nMean;
+  m_ullExtremeTime = ullMeanTime;
+  m_llArea = m_llWindowSum - (long long) nBaseline * m_unWindowCount;
+}
+
+// Add the next sample
+void CPeakDetector::Push(int Value, unsigned long long TimeStamp)
+{
+  unsigned int unWindowLen = m_stConfig.unSlopeWindow + 1;
+
+  // Slope over the window, against the sample about to be replaced
+  int nSlope = 0;
+  if (m_unWindowCount == unWindowLen)
+  {
+    nSlope = Value - m_anWindow[m_unWindowPos];
+    m_llWindowSum -= m_anWindow[m_unWindowPos];
+  }
+  else
+  {
+    if (0 == m_unWindowCount)
+    {
+      m_llBaseline = (long long) Value << BASELINE_FRAC_BITS;
+    }
+    m_unWindowCount++;
+  }
+  m_anWindow[m_unWindowPos] = Value;
+  m_aullWindowTime[m_unWindowPos] = TimeStamp;
+  m_unWindowPos = (m_unWindowPos + 1) % unWindowLen;
+  m_llWindowSum += Value;
+
+  // Apex and valley are taken on the mean of the window (far less noisy than single
+  // samples on a broad peak), at the time of its middle sample
+  int nMean = (int) (m_llWindowSum / (long long) m_unWindowCount);
+  unsigned long long ullMeanTime =
+    m_aullWindowTime[(m_unWindowPos + unWindowLen - m_unWindowCount + m_unWindowCount / 2) % unWindowLen];
+
+  int nThreshold = m_stConfig.nSlopeThreshold;
+
+  switch (m_eState)
+  {
+  case STATE_BASELINE:
+    m_llBaseline += (((long long) Value << BASELINE_FRAC_BITS) - m_llBaseline) >> m_stConfig.unBaselineShift;
+
+    m_unRun = (nSlope > nThreshold) ? m_unRun + 1 : 0;
+    if (m_unRun >= m_stConfig.unConfirm)
+    {
+      BeginRise((int) (m_llBaseline >> BASELINE_FRAC_BITS), nMean, ullMeanTime);
+    }
+    break;
+
+  case STATE_RISING:
+    m_llArea += Value - m_nPeakBaseline;
+    if (nMean > m_nExtreme)
+    {
+      m_nExtreme = nMean;
+      m_ullExtremeTime = ullMeanTime;
+    }
+
+    if (!m_bStarted && m_nExtreme - m_nPeakBaseline >= m_stConfig.nMinHeight)
+    {
+      m_bStarted = TRUE;
+      m_stStats.ulPeaks++;
+      AddEvent(PEAK_EVENT_START, m_ullStartTime, m_nStartValue, 0);
+    }
+
+    if (nSlope < -nThreshold)
+    {
+      m_unRun++;
+      if (m_unRun >= m_stConfig.unConfirm)
+      {
+        if (m_bStarted)
+        {
+          AddEvent(PEAK_EVENT_APEX, m_ullExtremeTime, m_nExtreme, 0);
+        }
+        m_eState = STATE_FALLING;
+        m_unRun = 0;
+        m_nExtreme = nMean;
+        m_ullExtremeTime = ullMeanTime;
+      }
+    }
+    else if (!m_bStarted && nSlope <= nThreshold)
+    {
+      // Not a peak (yet) - back to the baseline once the rise is over
+      m_unRun++;
+      if (m_unRun >= m_stConfig.unConfirm)
+      {
+        m_eState = STATE_BASELINE;
+        m_unRun = 0;
+      }
+    }
+    else
+    {
+      m_unRun = 0;
+    }
+    break;
+
+  case STATE_FALLING:
+    m_llArea += Value - m_nPeakBaseline;
+    if (nMean < m_nExtreme)
+    {
+      m_nExtreme = nMean;
+      m_ullExtremeTime = ullMeanTime;
+    }
+
+    if (nSlope > nThreshold)
+    {
+      // Rising again before the baseline - the valley ends this peak, the next one
+      // starts there
+      if (++m_unRun >= m_stConfig.unConfirm)
+      {
+        if (m_bStarted)
+        {
+          AddEvent(PEAK_EVENT_END, m_ullExtremeTime, m_nExtreme, m_llArea);
+        }
+        m_eState = STATE_RISING;
+        m_bStarted = FALSE;
+        m_unRun = 0;
+        m_ullStartTime = m_ullExtremeTime;
+        m_nStartValue = m_nExtreme;
+        m_nExtreme = nMean;
+        m_ullExtremeTime = ullMeanTime;
+        m_llArea = 0;
+      }
+    }
+    else if (nSlope >= -nThreshold)
+    {
+      // Flat - back on the baseline, which may have moved
+      if (++m_unRun >= m_stConfig.unConfirm)
+      {
+        if (m_bStarted)
+        {
+          AddEvent(PEAK_EVENT_END, TimeStamp, Value, m_llArea);
+        }
+        m_eState = STATE_BASELINE;
+        m_unRun = 0;
+        m_llBaseline = (long long) Value << BASELINE_FRAC_BITS;
+      }
+    }
+    else
+    {
+      m_unRun = 0;
+    }
+    break;
+  }
+}
+
+// Copy up to MaxEvents events, oldest first
+unsigned int CPeakDetector::ReadEvents(PeakEventStruct *Events, unsigned int MaxEvents)
+{
+  unsigned int unNumEvents = 0;
+
+  while (m_unEventCount > 0 && unNumEvents < MaxEvents)
+  {
+    Events[unNumEvents++] = m_astEvents[m_unEventHead];
+    m_unEventHead = (m_unEventHead + 1) % PEAK_DET_EVENT_QUEUE_LEN;
+    m_unEventCount--;
+  }
+
+  return unNumEvents;
+}
@@ -115,10 +115,99 @@
 #include "debug.h"
 #include "PreampConfig.h"
 #include "BoardSlotInfo.h"
+#include "WireLayouts.h"
+
+// Requests to the preamp configuration function - set commands get a status back,
+// get commands get the data union back.
+typedef CDevRequest<CAN_CMD_PREAMP_DATA_STRUCT, CAN_CMD_PREAMP_STATUS_STRUCT> CPreampSetRequest;
+typedef CDevRequest<CmdAckUnion, CAN_CMD_PREAMP_STATUS_STRUCT>                CPreampCmdRequest;
+typedef CDevRequest<CmdAckUnion, CAN_CMD_PREAMP_DATA_STRUCT>                  CPreampGetRequest;
+
+// Commands of the bridge offsets, by PREAMP_OFFSET_TYPE
+static const unsigned char s_abySetOffsetCmd[MAX_PREAMP_OFFSET_TYPE] = {
+  CMD_PREAMP_CFG_FN_SET_LEFT_COARSE,
+  CMD_PREAMP_CFG_FN_SET_RIGHT_COARSE,
+  CMD_PREAMP_CFG_FN_SET_RIGHT_FINE,
+};
+
+static const unsigned char s_abyGetOffsetCmd[MAX_PREAMP_OFFSET_TYPE] = {
+  CMD_PREAMP_CFG_FN_GET_LEFT_COARSE,
+  CMD_PREAMP_CFG_FN_GET_RIGHT_COARSE,
+  CMD_PREAMP_CFG_FN_GET_RIGHT_FINE,
+};
+
+// Settings the configuration cache may hold. Auto zero and self calibration move
+// the bridge offsets.
+static const DevCacheMapStruct s_astPreampCacheMap[] = {
+  { CMD_PREAMP_CFG_FN_SET_GAIN,           CMD_PREAMP_CFG_FN_GET_GAIN,           TRUE  },
+  { CMD_PREAMP_CFG_FN_SET_SAMPLING_RATE,  CMD_PREAMP_CFG_FN_GET_SAMPLING_RATE,  TRUE  },
+  { CMD_PREAMP_CFG_FN_SET_AC_BRIDGE,      CMD_PREAMP_CFG_FN_GET_AC_BRIDGE,      TRUE  },
+  { CMD_PREAMP_CFG_FN_SET_FILTER,         CMD_PREAMP_CFG_FN_GET_FILTER,         TRUE  },
+  { CMD_PREAMP_CFG_FN_SET_MOV_AVG,        CMD_PREAMP_CFG_FN_GET_MOV_AVG,        TRUE  },
+  { CMD_PREAMP_CFG_FN_SET_LEFT_COARSE,    CMD_PREAMP_CFG_FN_GET_LEFT_COARSE,    TRUE  },
+  { CMD_PREAMP_CFG_FN_SET_RIGHT_COARSE,   CMD_PREAMP_CFG_FN_GET_RIGHT_COARSE,   TRUE  },
+  { CMD_PREAMP_CFG_FN_SET_RIGHT_FINE,     CMD_PREAMP_CFG_FN_GET_RIGHT_FINE,     TRUE  },
+  { CMD_PREAMP_CFG_FN_SET_AUTOZERO,       CMD_PREAMP_CFG_FN_GET_LEFT_COARSE,    FALSE },
+  { CMD_PREAMP_CFG_FN_SET_AUTOZERO,       CMD_PREAMP_CFG_FN_GET_RIGHT_COARSE,   FALSE },
+  { CMD_PREAMP_CFG_FN_SET_AUTOZERO,       CMD_PREAMP_CFG_FN_GET_RIGHT_FINE,     FALSE },
+  { CMD_PREAMP_CFG_FN_SET_CAL_ON,         CMD_PREAMP_CFG_FN_GET_LEFT_COARSE,    FALSE },
+  { CMD_PREAMP_CFG_FN_SET_CAL_ON,         CMD_PREAMP_CFG_FN_GET_RIGHT_COARSE,   FALSE },
+  { CMD_PREAMP_CFG_FN_SET_CAL_ON,         CMD_PREAMP_CFG_FN_GET_RIGHT_FINE,     FALSE },
+};
+
+// The settings of a snapshot, in the order they are sent
+static const unsigned int s_aunCfgSettings[] = {
+  PREAMP_CFG_GAIN,
+  PREAMP_CFG_SAMPLING_RATE,
+  PREAMP_CFG_AC_BRIDGE,
+  PREAMP_CFG_FILTER,
+  PREAMP_CFG_MOV_AVG,
+  PREAMP_CFG_LEFT_COARSE,
+  PREAMP_CFG_RIGHT_COARSE,
+  PREAMP_CFG_RIGHT_FINE,
+};
+
+#define NUM_PREAMP_CFG_SETTINGS   (sizeof (s_aunCfgSettings) / sizeof (s_aunCfgSettings[0]))
+
+// The value of a setting in a snapshot. All of them are enums.
+static int *CfgSettingValue(PreampConfigSnapshotStruct *pstSnapshot, unsigned int unField)
+{
+  switch (unField)
+  {
+  case PREAMP_CFG_GAIN:          return (int *) &pstSnapshot->eGain;
+  case PREAMP_CFG_SAMPLING_RATE: return (int *) &pstSnapshot->eSamplingRate;
+  case PREAMP_CFG_AC_BRIDGE:     return (int *) &pstSnapshot->eACBridge;
+  case PREAMP_CFG_FILTER:        return (int *) &pstSnapshot->eFilter;
+  case PREAMP_CFG_MOV_AVG:       return (int *) &pstSnapshot->eMovAvg;
+  case PREAMP_CFG_LEFT_COARSE:   return (int *) &pstSnapshot->aeOffset[BRIDGE_LEFT_COARSE];
+  case PREAMP_CFG_RIGHT_COARSE:  return (int *) &pstSnapshot->aeOffset[BRIDGE_RIGHT_COARSE];
+  case PREAMP_CFG_RIGHT_FINE:    return (int *) &pstSnapshot->aeOffset[BRIDGE_RIGHT_FINE];
+  default:                       return NULL;
+  }
+}
+
+// Is a value valid for a setting?
+static bool IsCfgSettingValid(unsigned int unField, int nValue)
+{
+  switch (unField)
+  {
+  case PREAMP_CFG_GAIN:
+    return (nValue >= MIN_PREAMP_BRIDGE_GAIN) && (nValue < MAX_PREAMP_BRIDGE_GAIN);
+  case PREAMP_CFG_SAMPLING_RATE:
+    return (nValue >= MIN_PREAMP_SAMPLING_RATE) && (nValue < MAX_PREAMP_SAMPLING_RATE);
+  case PREAMP_CFG_AC_BRIDGE:
+  case PREAMP_CFG_FILTER:
+  case PREAMP_CFG_MOV_AVG:
+    return (nValue >= MIN_PREAMP_STATE) && (nValue < MAX_PREAMP_STATE);
+  default:
+    return (nValue >= BRIDGE_ADJ_0000) && (nValue < NUM_BRIDGE_ADJ_ENUM);
+  }
+}
 
 CPreampConfig::CPreampConfig()  // Default Constructor
 {
   m_iBoardRevision = -1;
+  SetConfigCacheMap(s_astPreampCacheMap, sizeof (s_astPreampCacheMap) / sizeof (s_astPreampCacheMap[0]));
 }
 
 CPreampConfig::~CPreampConfig() // Destructor
@@ -182,6 +271,9 @@ int CPreampConfig::GetBoardInfo (unsigned char* byFirmwareVerMaj,   // Firmware
       // Transmit
       if (m_pobCAN)
       {
+        // GetRemTimeOut() must report our own response
+        CHALLock obCmdLock(GetCmdLock());
+
         while( true )
         {
           SetCmdAckCommand(&stCmd.byCmdAck, BD_GET_SYSTEM_INFO);
@@ -281,542 +373,94 @@ int CPreampConfig::GetBridgeCurrent (int* BridgeCurrentMicroAmps ,
 int CPreampConfig::GetBridgeGain (PREAMP_BRIDGE_GAIN_ENUM *eBridgeGain, 
                                   unsigned int unTimeOut) // Time to wait for response from remote device
 {
-  int nRetVal = ERR_SUCCESS;
-
-  CmdAckUnion stCmd = {0};
-  CAN_CMD_PREAMP_DATA_STRUCT stResp = {0};
+  CPreampGetRequest obReq(CMD_PREAMP_CFG_FN_GET_GAIN);
+  int nRetVal;
 
   if (NULL == eBridgeGain)
   {
     return ERR_INVALID_ARGS;
   }
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        while( true )
-        {
-          SetCmdAckCommand(&stCmd.byCmdAck, CMD_PREAMP_CFG_FN_GET_GAIN);
-
-          // Send a command and wait for ackowledgement from remote device
-          nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd,  // Command
-                                                       sizeof (stCmd),    // Size of command
-                                                       (unsigned char *) &stResp, // Response from remote board
-                                                       sizeof (stResp), // Size of expected response
-                                                       FALSE,    // Streaming data
-                                                       unTimeOut); // Time to wait for response 
-
-          // Check if we got the correct response packet
-          if (nRetVal == sizeof (stResp))  
-          {
-            unsigned char ucRxdRespCmdType = GetCmdAckCommand( &stResp.stCmd.byCmdAck );
-            if( CMD_PREAMP_CFG_FN_GET_GAIN == ucRxdRespCmdType )
-            {
-              FixEndian(stResp.stData.preampData.Gain);
-              *eBridgeGain = stResp.stData.preampData.Gain;
-              nRetVal = ERR_SUCCESS;
-            }
-            else
-            {
-              DEBUG2( "CPreampConfig::GetBridgeGain(): Response of a different Command - %d!", ucRxdRespCmdType );
-              nRetVal = ERR_PROTOCOL;
-
-              //Received response of a previously sent command.
-              //Try sending the command again with remaining timeout interval.
-              unTimeOut = m_pobReliabilityCAN->GetRemTimeOut();
-              if( unTimeOut > 0 )
-              {
-                continue;
-              }
-            }
-          }
-          //Not the expected packet size
-          else if (nRetVal >= 0)
-          {
-            DEBUG2("CPreampConfign:GetBridgeGain(): Unexpected packet size: %d", nRetVal);
-            nRetVal = ERR_PROTOCOL;
-          }
-          else // if (nRetVal < 0)
-          {
-            DEBUG2("CPreampConfig::GetBridgeGain(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-          }
-          
-          break;
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CPreampConfig::GetBridgeGain(): Unexpected invalid pointer!");
-      }
-
-      break;
 
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CPreampConfig::GetBridgeGain(): Invalid switch case!");
-      break;
-    }
-  }
-  else
+  nRetVal = Transact(obReq, unTimeOut);
+  if (ERR_SUCCESS == nRetVal)
   {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CPreampConfig::GetBridgeGain(): Function called before Open Call!");
+    *eBridgeGain = obReq.Resp().stData.preampData.Gain;
   }
 
   return nRetVal;
-
 }
 
 // Sets the Bridge gain adjustment.
 int CPreampConfig::SetBridgeGain (PREAMP_BRIDGE_GAIN_ENUM eBridgeGain, 
                                   unsigned int unTimeOut) // Time to wait for response from remote device
 {
-  int nRetVal = ERR_SUCCESS;
-
-  CAN_CMD_PREAMP_DATA_STRUCT stCmd = {0};
-  CAN_CMD_PREAMP_STATUS_STRUCT stResp = {0};
+  CPreampSetRequest obReq(CMD_PREAMP_CFG_FN_SET_GAIN);
 
   if ( (eBridgeGain < MIN_PREAMP_BRIDGE_GAIN) || 
        (eBridgeGain >= MAX_PREAMP_BRIDGE_GAIN) )
   {
     return ERR_INVALID_ARGS;
   }
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        while( true )
-        {
-          SetCmdAckCommand(&stCmd.stCmd.byCmdAck, CMD_PREAMP_CFG_FN_SET_GAIN);
-
-          stCmd.stData.preampData.Gain = eBridgeGain;   // Data
-
-          FixEndian(stCmd.stData.preampData.Gain);
-
-          // Send a command and wait for ackowledgement from remote device
-          nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd, // Command
-                                                       sizeof (stCmd),        // Size of command
-                                                       (unsigned char *) &stResp, // Response from remote board
-                                                       sizeof (stResp),     // Size of expected response
-                                                       FALSE,       // Streaming data
-                                                       unTimeOut);  // Time to wait for response 
-
-
-          // Check if we got the correct response packet
-          if (nRetVal == sizeof (stResp))  
-          {
-            unsigned char ucRxdRespCmdType = GetCmdAckCommand( &stResp.stCmd.byCmdAck );
-            if( CMD_PREAMP_CFG_FN_SET_GAIN == ucRxdRespCmdType )
-            {
-              // Check if the device ACK'd or NACK'd
-              //if (stResp.stCmd.Err == 1)
-              if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-              {
-                nRetVal = TransDevError (stResp.stData.StatusDataUnion.ErrorType);
-                DEBUG2("CPreampConfig::SetBridgeGain(): Device sent a NACK! Dev error code = %d!", nRetVal);
-
-              }
-              else
-              {
-                nRetVal = ERR_SUCCESS;
-              }
-            }
-            else
-            {
-              DEBUG2( "CPreampConfig::SetBridgeGain(): Response of a different Command - %d!", ucRxdRespCmdType );
-              nRetVal = ERR_PROTOCOL;
-
-              //Received response of a previously sent command.
-              //Try sending the command again with remaining timeout interval.
-              unTimeOut = m_pobReliabilityCAN->GetRemTimeOut();
-              if( unTimeOut > 0 )
-              {
-                continue;
-              }
-            }
-          }
-          //Not the expected packet size
-          else if (nRetVal >= 0)
-          {
-            DEBUG2("CPreampConfig::SetBridgeGain(): Unexpected packet size: %d", nRetVal);
-            nRetVal = ERR_PROTOCOL;
-          }
-          else // if (nRetVal < 0)
-          {
-            DEBUG2("CPreampConfig::SetBridgeGain(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-          }
-          
-          break;
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CPreampConfig::SetBridgeGain(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CPreampConfig::SetBridgeGain(): Invalid switch case!");
-      break;
-    }
-  }
-  else
-  {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CPreampConfig::SetBridgeGain(): Function called before Open Call!");
-  }
 
-  return nRetVal;
+  obReq.Cmd().stData.preampData.Gain = eBridgeGain;
 
+  return Transact(obReq, unTimeOut);
 }
 
-// Sets the Sampling Rate
+// Gets the Sampling Rate
 int CPreampConfig::GetSamplingRate (PREAMP_SAMPLING_RATE_ENUM *eSamplingRate, 
                                     unsigned int unTimeOut) // Time to wait for response from remote device
 { 
-  int nRetVal = ERR_SUCCESS;
-
-  CmdAckUnion stCmd = {0};
-  CAN_CMD_PREAMP_DATA_STRUCT stResp = {0};
+  CPreampGetRequest obReq(CMD_PREAMP_CFG_FN_GET_SAMPLING_RATE);
+  int nRetVal;
 
   if (NULL == eSamplingRate)
   {
     return ERR_INVALID_ARGS;
   }
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        while( true )
-        {
-          SetCmdAckCommand(&stCmd.byCmdAck, CMD_PREAMP_CFG_FN_GET_SAMPLING_RATE);
-
-          // Send a command and wait for ackowledgement from remote device
-          nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd,  // Command
-                                                       sizeof (stCmd),    // Size of command
-                                                       (unsigned char *) &stResp, // Response from remote board
-                                                       sizeof (stResp), // Size of expected response
-                                                       FALSE,   // Streaming data
-                                                       unTimeOut); // Time to wait for response 
-
-          // Check if we got the correct response packet
-          if (nRetVal == sizeof (stResp))  
-          {
-            unsigned char ucRxdRespCmdType = GetCmdAckCommand( &stResp.stCmd.byCmdAck );
-            if( CMD_PREAMP_CFG_FN_GET_SAMPLING_RATE == ucRxdRespCmdType )
-            {
-              FixEndian(stResp.stData.preampData.SamplingRate);
-              *eSamplingRate = stResp.stData.preampData.SamplingRate;
-              nRetVal = ERR_SUCCESS;
-            }
-            else
-            {
-              DEBUG2( "CPreampConfig::GetSamplingRate(): Response of a different Command - %d!", ucRxdRespCmdType );
-              nRetVal = ERR_PROTOCOL;
-
-              //Received response of a previously sent command.
-              //Try sending the command again with remaining timeout interval.
-              unTimeOut = m_pobReliabilityCAN->GetRemTimeOut();
-              if( unTimeOut > 0 )
-              {
-                continue;
-              }
-            }
-          }
-          //Not the expected packet size
-          else if (nRetVal >= 0)
-          {
-            DEBUG2("CPreampConfig::GetSamplingRate(): Unexpected packet size: %d", nRetVal);
-            nRetVal = ERR_PROTOCOL;
-          }
-          else // if (nRetVal < 0)
-          {
-            DEBUG2("CPreampConfig::GetSamplingRate(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-          }
-          
-          break;
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CPreampConfig::GetSamplingRate(): Unexpected invalid pointer!");
-      }
 
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CPreampConfig::GetSamplingRate(): Invalid switch case!");
-      break;
-    }
-  }
-  else
+  nRetVal = Transact(obReq, unTimeOut);
+  if (ERR_SUCCESS == nRetVal)
   {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CPreampConfig::GetSamplingRate(): Function called before Open Call!");
+    *eSamplingRate = obReq.Resp().stData.preampData.SamplingRate;
   }
 
   return nRetVal;
 }
 
-// Gets the Sampling Rate
+// Sets the Sampling Rate
 int CPreampConfig::SetSamplingRate (PREAMP_SAMPLING_RATE_ENUM eSamplingRate, 
                                     unsigned int unTimeOut) // Time to wait for response from remote device
 { 
-  int nRetVal = ERR_SUCCESS;
-
-  CAN_CMD_PREAMP_DATA_STRUCT stCmd = {0};
-  CAN_CMD_PREAMP_STATUS_STRUCT stResp = {0};
+  CPreampSetRequest obReq(CMD_PREAMP_CFG_FN_SET_SAMPLING_RATE);
 
   if ( (eSamplingRate < MIN_PREAMP_SAMPLING_RATE) ||
        (eSamplingRate >= MAX_PREAMP_SAMPLING_RATE) )
   {
     return ERR_INVALID_ARGS;
   }
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        while( true )
-        {
-          SetCmdAckCommand(&stCmd.stCmd.byCmdAck, CMD_PREAMP_CFG_FN_SET_SAMPLING_RATE);
-
-          stCmd.stData.preampData.SamplingRate = eSamplingRate;   // Data
-
-          FixEndian(stCmd.stData.preampData.SamplingRate);
-
-          // Send a command and wait for ackowledgement from remote device
-          nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd,  // Command
-                                                       sizeof (stCmd),      // Size of command
-                                                       (unsigned char *) &stResp, // Response from remote board
-                                                       sizeof (stResp),   // Size of expected response
-                                                       FALSE,  // Streaming data
-                                                       unTimeOut); // Time to wait for response 
-
-          // Check if we got the correct response packet
-          if (nRetVal == sizeof (stResp))  
-          {
-            unsigned char ucRxdRespCmdType = GetCmdAckCommand( &stResp.stCmd.byCmdAck );
-            if( CMD_PREAMP_CFG_FN_SET_SAMPLING_RATE == ucRxdRespCmdType )
-            {
-              // Check if the device ACK'd or NACK'd
-              //if (stResp.stCmd.Err == 1)
-              if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-              {
-                nRetVal = TransDevError (stResp.stData.StatusDataUnion.ErrorType);
-                DEBUG2("CPreampConfig::SetSamplingRate(): Device sent a NACK! Dev error code = %d!", nRetVal);
-              }
-              else
-              {
-                nRetVal = ERR_SUCCESS;
-              }
-            }
-            else
-            {
-              DEBUG2( "CPreampConfig::SetSamplingRate(): Response of a different Command - %d!", ucRxdRespCmdType );
-              nRetVal = ERR_PROTOCOL;
-              
-              //Received response of a previously sent command.
-              //Try sending the command again with remaining timeout interval.
-              unTimeOut = m_pobReliabilityCAN->GetRemTimeOut();
-              if( unTimeOut > 0 )
-              {
-                continue;
-              }
-            }
-          }
-          //Not the expected packet size
-          else if (nRetVal >= 0)
-          {
-            DEBUG2("CPreampConfig:SetSamplingRate(): Unexpected packet size: %d", nRetVal);
-            nRetVal = ERR_PROTOCOL;
-          }
-          else // if (nRetVal < 0)
-          {
-            DEBUG2("CPreampConfig::SetSamplingRate(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-          }
-          
-          break;
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CPreampConfig::SetSamplingRate(): Unexpected invalid pointer!");
-      }
-
-      break;
 
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CPreampConfig::SetSamplingRate(): Invalid switch case!");
-      break;
-    }
-  }
-  else
-  {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CPreampConfig::SetSamplingRate(): Function called before Open Call!");
-  }
+  obReq.Cmd().stData.preampData.SamplingRate = eSamplingRate;
 
-  return nRetVal;
+  return Transact(obReq, unTimeOut);
 }
 
 // Get the current status of the AC bridge setting
 int CPreampConfig::GetACBridgeStatus(PREAMP_STATE_ENUM *eACBridgeStatus,
                                      unsigned int unTimeOut) // Time to wait for response from remote device
 {
-  int nRetVal = ERR_SUCCESS;
-
-  CmdAckUnion stCmd = {0};
-  CAN_CMD_PREAMP_DATA_STRUCT stResp = {0};
+  CPreampGetRequest obReq(CMD_PREAMP_CFG_FN_GET_AC_BRIDGE);
+  int nRetVal;
 
   if (NULL == eACBridgeStatus)
   {
     return ERR_INVALID_ARGS;
   }
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        while( true )
-        {
-          SetCmdAckCommand(&stCmd.byCmdAck, CMD_PREAMP_CFG_FN_GET_AC_BRIDGE);
-
-          // Send a command and wait for ackowledgement from remote device
-          nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd,  // Command
-                                                       sizeof (stCmd),    // Size of command
-                                                       (unsigned char *) &stResp, // Response from remote board
-                                                       sizeof (stResp), // Size of expected response
-                                                       FALSE, // Streaming data
-                                                       unTimeOut); // Time to wait for response 
-
-          // Check if we got the correct response packet
-          if (nRetVal == sizeof (stResp))  
-          {
-            unsigned char ucRxdRespCmdType = GetCmdAckCommand( &stResp.stCmd.byCmdAck );
-            if( CMD_PREAMP_CFG_FN_GET_AC_BRIDGE == ucRxdRespCmdType )
-            {
-              FixEndian(stResp.stData.preampData.ACBridgeStatus);
-              *eACBridgeStatus = stResp.stData.preampData.ACBridgeStatus;
-              nRetVal = ERR_SUCCESS;
-            }
-            else
-            {
-              DEBUG2( "CPreampConfig::GetACBridgeStatus(): Response of a different Command - %d!", ucRxdRespCmdType );
-              nRetVal = ERR_PROTOCOL;
-              
-              //Received response of a previously sent command.
-              //Try sending the command again with remaining timeout interval.
-              unTimeOut = m_pobReliabilityCAN->GetRemTimeOut();
-              if( unTimeOut > 0 )
-              {
-                continue;
-              }
-            }
-          }
-          //Not the expected packet size
-          else if (nRetVal >= 0)
-          {
-            DEBUG2("CPreampConfig::GetACBridgeStatus(): Unexpected packet size: %d", nRetVal);
-            nRetVal = ERR_PROTOCOL;
-          }
-          else // if (nRetVal < 0)
-          {
-            DEBUG2("CPreampConfig::GetACBridgeStatus(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-          }
-          
-          break;
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CPreampConfig::GetACBridgeStatus(): Unexpected invalid pointer!");
-      }
 
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CPreampConfig::GetACBridgeStatus(): Invalid switch case!");
-      break;
-    }
-  }
-  else
+  nRetVal = Transact(obReq, unTimeOut);
+  if (ERR_SUCCESS == nRetVal)
   {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CPreampConfig::GetACBridgeStatus(): Function called before Open Call!");
+    *eACBridgeStatus = obReq.Resp().stData.preampData.ACBridgeStatus;
   }
 
   return nRetVal;
@@ -826,556 +470,93 @@ int CPreampConfig::GetACBridgeStatus(PREAMP_STATE_ENUM *eACBridgeStatus,
 int CPreampConfig::SetACBridgeStatus(PREAMP_STATE_ENUM eACBridgeStatus, 
                                      unsigned int unTimeOut) // Time to wait for response from remote device
 {
-  int nRetVal = ERR_SUCCESS;
-
-  CAN_CMD_PREAMP_DATA_STRUCT stCmd = {0};
-  CAN_CMD_PREAMP_STATUS_STRUCT stResp = {0};
+  CPreampSetRequest obReq(CMD_PREAMP_CFG_FN_SET_AC_BRIDGE);
 
   if ( (eACBridgeStatus < MIN_PREAMP_STATE) || 
        (eACBridgeStatus >= MAX_PREAMP_STATE) )
   {
     return ERR_INVALID_ARGS;
   }
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        while( true )
-        {
-          SetCmdAckCommand(&stCmd.stCmd.byCmdAck, CMD_PREAMP_CFG_FN_SET_AC_BRIDGE);
-
-          stCmd.stData.preampData.ACBridgeStatus = eACBridgeStatus;   // Data
-
-          FixEndian(stCmd.stData.preampData.ACBridgeStatus);
-
-          // Send a command and wait for ackowledgement from remote device
-          nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd,  // Command
-                                                       sizeof (stCmd),    // Size of command
-                                                       (unsigned char *) &stResp, // Response from remote board
-                                                       sizeof (stResp), // Size of expected response
-                                                       FALSE,  // Streaming data
-                                                       unTimeOut); // Time to wait for response 
 
+  obReq.Cmd().stData.preampData.ACBridgeStatus = eACBridgeStatus;
 
-          // Check if we got the correct response packet
-          if (nRetVal == sizeof (stResp))  
-          {
-            unsigned char ucRxdRespCmdType = GetCmdAckCommand( &stResp.stCmd.byCmdAck );
-            if( CMD_PREAMP_CFG_FN_SET_AC_BRIDGE == ucRxdRespCmdType )
-            {
-              // Check if the device ACK'd or NACK'd
-              //if (stResp.stCmd.Err == 1)
-              if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-              {
-                nRetVal = TransDevError (stResp.stData.StatusDataUnion.ErrorType);
-                DEBUG2("CPreampConfig::SetACBridgeStatus(): Device sent a NACK! Dev error code = %d!", nRetVal);
-              }
-              else
-              {
-                nRetVal = ERR_SUCCESS;
-              }
-            }
-            else
-            {
-              DEBUG2( "CPreampConfig::SetACBridgeStatus(): Response of a different Command - %d!", ucRxdRespCmdType );
-              nRetVal = ERR_PROTOCOL;
-              
-              //Received response of a previously sent command.
-              //Try sending the command again with remaining timeout interval.
-              unTimeOut = m_pobReliabilityCAN->GetRemTimeOut();
-              if( unTimeOut > 0 )
-              {
-                continue;
-              }
-            }
-          }
-          //Not the expected packet size
-          else if (nRetVal >= 0)
-          {
-            DEBUG2("CPreampConfig::SetACBridgeStatus(): Unexpected packet size: %d", nRetVal);
-            nRetVal = ERR_PROTOCOL;
-          }
-          else // if (nRetVal < 0)
-          {
-            DEBUG2("CPreampConfig::SetACBridgeStatus(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-          }
-          
-          break;
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CPreampConfig::SetACBridgeStatus(): Unexpected invalid pointer!");
-      }
+  return Transact(obReq, unTimeOut);
+}
 
-      break;
+// Get filter ON/OFF status
+int CPreampConfig::GetFilterStatus(PREAMP_STATE_ENUM *eFilterStatus,
+                                   unsigned int unTimeOut) // Time to wait for response from remote device
+{
+  CPreampGetRequest obReq(CMD_PREAMP_CFG_FN_GET_FILTER);
+  int nRetVal;
 
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CPreampConfign:SetACBridgeStatus(): Invalid switch case!");
-      break;
-    }
+  if (NULL == eFilterStatus)
+  {
+    return ERR_INVALID_ARGS;
   }
-  else
+
+  nRetVal = Transact(obReq, unTimeOut);
+  if (ERR_SUCCESS == nRetVal)
   {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CPreampConfig::SetACBridgeStatus(): Function called before Open Call!");
+    *eFilterStatus = obReq.Resp().stData.preampData.FilterStatus;
   }
 
   return nRetVal;
 }
 
-// Get filter ON/OFF status
-int CPreampConfig::GetFilterStatus(PREAMP_STATE_ENUM *eFilterStatus,
+// Turn ON/OFF filter
+int CPreampConfig::SetFilterStatus(PREAMP_STATE_ENUM eFilterStatus, 
                                    unsigned int unTimeOut) // Time to wait for response from remote device
 {
-  int nRetVal = ERR_SUCCESS;
+  CPreampSetRequest obReq(CMD_PREAMP_CFG_FN_SET_FILTER);
 
-  CmdAckUnion stCmd = {0};
-  CAN_CMD_PREAMP_DATA_STRUCT stResp = {0};
-
-  if (NULL == eFilterStatus)
+  if ( (eFilterStatus < MIN_PREAMP_STATE) || 
+       (eFilterStatus >= MAX_PREAMP_STATE) )
   {
     return ERR_INVALID_ARGS;
   }
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
 
-      // Transmit
-      if (m_pobCAN)
-      {
-        while( true )
-        {
-          SetCmdAckCommand(&stCmd.byCmdAck, CMD_PREAMP_CFG_FN_GET_FILTER);
+  obReq.Cmd().stData.preampData.FilterStatus = eFilterStatus;
 
-          // Send a command and wait for ackowledgement from remote device
-          nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd,  // Command
-                                                       sizeof (stCmd),    // Size of command
-                                                       (unsigned char *) &stResp, // Response from remote board
-                                                       sizeof (stResp), // Size of expected response
-                                                       FALSE,  // Streaming data
-                                                       unTimeOut); // Time to wait for response 
-
-          // Check if we got the correct response packet
-          if (nRetVal == sizeof (stResp))  
-          {
-            unsigned char ucRxdRespCmdType = GetCmdAckCommand( &stResp.stCmd.byCmdAck );
-            if( CMD_PREAMP_CFG_FN_GET_FILTER == ucRxdRespCmdType )
-            {
-              FixEndian(stResp.stData.preampData.FilterStatus);
-              *eFilterStatus = stResp.stData.preampData.FilterStatus;
-              nRetVal = ERR_SUCCESS;
-            }
-            else
-            {
-              DEBUG2( "CPreampConfig::GetFilterStatus(): Response of a different Command - %d!", ucRxdRespCmdType );
-              nRetVal = ERR_PROTOCOL;
-
-              //Received response of a previously sent command.
-              //Try sending the command again with remaining timeout interval.
-              unTimeOut = m_pobReliabilityCAN->GetRemTimeOut();
-              if( unTimeOut > 0 )
-              {
-                continue;
-              }
-            }
-          }
-          //Not the expected packet size
-          else if (nRetVal >= 0)
-          {
-            DEBUG2("CPreampConfig::GetFilterStatus(): Unexpected packet size: %d", nRetVal);
-            nRetVal = ERR_PROTOCOL;
-          }
-          else // if (nRetVal < 0)
-          {
-            DEBUG2("CPreampConfig::GetFilterStatus(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-          }
-          
-          break;
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CPreampConfig::GetFilterStatus(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CPreampConfig::GetFilterStatus(): Invalid switch case!");
-      break;
-    }
-  }
-  else
-  {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CPreampConfig::GetFilterStatus(): Function called before Open Call!");
-  }
-
-  return nRetVal;
-}
-
-// Turn ON/OFF filter
-int CPreampConfig::SetFilterStatus(PREAMP_STATE_ENUM eFilterStatus, 
-                                   unsigned int unTimeOut) // Time to wait for response from remote device
-{
-  int nRetVal = ERR_SUCCESS;
-
-  CAN_CMD_PREAMP_DATA_STRUCT stCmd = {0};
-  CAN_CMD_PREAMP_STATUS_STRUCT stResp = {0};
-
-  if ( (eFilterStatus < MIN_PREAMP_STATE) || 
-       (eFilterStatus >= MAX_PREAMP_STATE) )
-  {
-    return ERR_INVALID_ARGS;
-  }
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        while( true )
-        {
-          SetCmdAckCommand(&stCmd.stCmd.byCmdAck, CMD_PREAMP_CFG_FN_SET_FILTER);
-
-          stCmd.stData.preampData.FilterStatus = eFilterStatus;   // Data
-
-          FixEndian(stCmd.stData.preampData.FilterStatus);
-
-          // Send a command and wait for ackowledgement from remote device
-          nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd,  // Command
-                                                       sizeof (stCmd),    // Size of command
-                                                       (unsigned char *) &stResp, // Response from remote board
-                                                       sizeof (stResp), // Size of expected response
-                                                       FALSE,  // Streaming data
-                                                       unTimeOut); // Time to wait for response 
-
-
-          // Check if we got the correct response packet
-          if (nRetVal == sizeof (stResp))  
-          {
-            unsigned char ucRxdRespCmdType = GetCmdAckCommand( &stResp.stCmd.byCmdAck );
-            if( CMD_PREAMP_CFG_FN_SET_FILTER == ucRxdRespCmdType )
-            {
-              // Check if the device ACK'd or NACK'd
-              //if (stResp.stCmd.Err == 1)
-              if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-              {
-                nRetVal = TransDevError (stResp.stData.StatusDataUnion.ErrorType);
-                DEBUG2("CPreampConfig::SetFilterStatus(): Device sent a NACK! Dev error code = %d!", nRetVal);
-              }
-              else
-              {
-                nRetVal = ERR_SUCCESS;
-              }
-            }
-            else
-            {
-              DEBUG2( "CPreampConfig::SetFilterStatus(): Response of a different Command - %d!", ucRxdRespCmdType );
-              nRetVal = ERR_PROTOCOL;
-
-              //Received response of a previously sent command.
-              //Try sending the command again with remaining timeout interval.
-              unTimeOut = m_pobReliabilityCAN->GetRemTimeOut();
-              if( unTimeOut > 0 )
-              {
-                continue;
-              }
-            }
-          }
-          //Not the expected packet size
-          else if (nRetVal >= 0)
-          {
-            DEBUG2("CPreampConfig::SetFilterStatus(): Unexpected packet size: %d", nRetVal);
-            nRetVal = ERR_PROTOCOL;
-          }
-          else // if (nRetVal < 0)
-          {
-            DEBUG2("CPreampConfig::SetFilterStatus(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-          }
-          
-          break;
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CPreampConfig::SetFilterStatus(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CPreampConfig::SetFilterStatus(): Invalid switch case!");
-      break;
-    }
-  }
-  else
-  {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CPreampConfig::SetFilterStatus(): Function called before Open Call!");
-  }
-
-  return nRetVal;
+  return Transact(obReq, unTimeOut);
 }
 
-// Turn on moving avg.
+// Get moving avg. ON/OFF status
 int CPreampConfig::GetMovingAvgStatus(PREAMP_STATE_ENUM *eMovAvgStatus,
                                       unsigned int unTimeOut) // Time to wait for response from remote device
 {
-  int nRetVal = ERR_SUCCESS;
-
-  CmdAckUnion stCmd = {0};
-  CAN_CMD_PREAMP_DATA_STRUCT stResp = {0};
+  CPreampGetRequest obReq(CMD_PREAMP_CFG_FN_GET_MOV_AVG);
+  int nRetVal;
 
   if (NULL == eMovAvgStatus)
   {
     return ERR_INVALID_ARGS;
   }
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
 
-      // Transmit
-      if (m_pobCAN)
-      {
-        while( true )
-        {
-          SetCmdAckCommand(&stCmd.byCmdAck, CMD_PREAMP_CFG_FN_GET_MOV_AVG);
-
-          // Send a command and wait for ackowledgement from remote device
-          nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd,  // Command
-                                                       sizeof (stCmd),    // Size of command
-                                                       (unsigned char *) &stResp, // Response from remote board
-                                                       sizeof (stResp), // Size of expected response
-                                                       FALSE,    // Streaming data
-                                                       unTimeOut); // Time to wait for response 
-
-          // Check if we got the correct response packet
-          if (nRetVal == sizeof (stResp))  
-          {
-            unsigned char ucRxdRespCmdType = GetCmdAckCommand( &stResp.stCmd.byCmdAck );
-            if( CMD_PREAMP_CFG_FN_GET_MOV_AVG == ucRxdRespCmdType )
-            {
-              FixEndian(stResp.stData.preampData.MovAvgStatus);
-              *eMovAvgStatus = stResp.stData.preampData.MovAvgStatus;
-              nRetVal = ERR_SUCCESS;
-            }
-            else
-            {
-              DEBUG2( "CPreampConfig::GetMovingAvgStatus(): Response of a different Command - %d!", ucRxdRespCmdType );
-              nRetVal = ERR_PROTOCOL;
-
-              //Received response of a previously sent command.
-              //Try sending the command again with remaining timeout interval.
-              unTimeOut = m_pobReliabilityCAN->GetRemTimeOut();
-              if( unTimeOut > 0 )
-              {
-                continue;
-              }
-            }
-          }
-          //Not the expected packet size
-          else if (nRetVal >= 0)
-          {
-            DEBUG2("CPreampConfig::GetMovingAvgStatus(): Unexpected packet size: %d", nRetVal);
-            nRetVal = ERR_PROTOCOL;
-          }
-          else // if (nRetVal < 0)
-          {
-            DEBUG2("CPreampConfig::GetMovingAvgStatus(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-          }
-          
-          break;
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CPreampConfig::GetMovingAvgStatus(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CPreampConfig::GetMovingAvgStatus(): Invalid switch case!");
-      break;
-    }
-  }
-  else
+  nRetVal = Transact(obReq, unTimeOut);
+  if (ERR_SUCCESS == nRetVal)
   {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CPreampConfig::GetMovingAvgStatus(): Function called before Open Call!");
+    *eMovAvgStatus = obReq.Resp().stData.preampData.MovAvgStatus;
   }
 
   return nRetVal;
 }
 
-// Get moving avg. ON/OFF status
+// Turn ON/OFF moving avg.
 int CPreampConfig::SetMovingAvgStatus(PREAMP_STATE_ENUM eMovAvgStatus, 
                                       unsigned int unTimeOut) // Time to wait for response from remote device
 { 
-  int nRetVal = ERR_SUCCESS;
-
-  CAN_CMD_PREAMP_DATA_STRUCT stCmd = {0};
-  CAN_CMD_PREAMP_STATUS_STRUCT stResp = {0};
+  CPreampSetRequest obReq(CMD_PREAMP_CFG_FN_SET_MOV_AVG);
 
   if ( (eMovAvgStatus < MIN_PREAMP_STATE) || 
        (eMovAvgStatus >= MAX_PREAMP_STATE) )
   {
     return ERR_INVALID_ARGS;
   }
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        while( true )
-        {
-          SetCmdAckCommand(&stCmd.stCmd.byCmdAck, CMD_PREAMP_CFG_FN_SET_MOV_AVG);
-
-          stCmd.stData.preampData.MovAvgStatus = eMovAvgStatus;   // Data
 
-          FixEndian(stCmd.stData.preampData.MovAvgStatus);
+  obReq.Cmd().stData.preampData.MovAvgStatus = eMovAvgStatus;
 
-          // Send a command and wait for ackowledgement from remote device
-          nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd,  // Command
-                                                       sizeof (stCmd),    // Size of command
-                                                       (unsigned char *) &stResp, // Response from remote board
-                                                       sizeof (stResp), // Size of expected response
-                                                       FALSE,    // Streaming data
-                                                       unTimeOut); // Time to wait for response 
-
-          // Check if we got the correct response packet
-          if (nRetVal == sizeof (stResp))  
-          {
-            unsigned char ucRxdRespCmdType = GetCmdAckCommand( &stResp.stCmd.byCmdAck );
-            if( CMD_PREAMP_CFG_FN_SET_MOV_AVG == ucRxdRespCmdType )
-            {
-              // Check if the device ACK'd or NACK'd
-              //if (stResp.stCmd.Err == 1)
-              if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-              {
-                nRetVal = TransDevError (stResp.stData.StatusDataUnion.ErrorType);
-                DEBUG2("CPreampConfig::SetMovingAvgStatus(): Device sent a NACK! Dev error code = %d!", nRetVal);
-              }
-              else
-              {
-                nRetVal = ERR_SUCCESS;
-              }
-            }
-            else
-            {
-              DEBUG2( "CPreampConfig::SetMovingAvgStatus(): Response of a different Command - %d!", ucRxdRespCmdType );
-              nRetVal = ERR_PROTOCOL;
-              
-              //Received response of a previously sent command.
-              //Try sending the command again with remaining timeout interval.
-              unTimeOut = m_pobReliabilityCAN->GetRemTimeOut();
-              if( unTimeOut > 0 )
-              {
-                continue;
-              }
-            }
-          }
-          //Not the expected packet size
-          else if (nRetVal >= 0)
-          {
-            DEBUG2("CPreampConfig::SetMovingAvgStatus(): Unexpected packet size: %d", nRetVal);
-            nRetVal = ERR_PROTOCOL;
-          }
-          else // if (nRetVal < 0)
-          {
-            DEBUG2("CPreampConfig::SetMovingAvgStatus(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-          }
-          
-          break;
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CPreampConfig::SetMovingAvgStatus(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CPreampConfig::SetMovingAvgStatus(): Invalid switch case!");
-      break;
-    }
-  }
-  else
-  {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CPreampConfig::SetMovingAvgStatus(): Function called before Open Call!");
-  }
-
-  return nRetVal;
+  return Transact(obReq, unTimeOut);
 }
 
 // Get the bridge offset value for the specified offset type
@@ -1383,9 +564,7 @@ int CPreampConfig::GetBridgeOffset(PREAMP_OFFSET_TYPE eOffsetType,
                                    PREAMP_BRIDGE_ADJ_ENUM *eOffsetValue,
                                    unsigned int unTimeOut) // Time to wait for response from remote device
 {
-  int nRetVal = ERR_SUCCESS;
-  CmdAckUnion stCmd = {0};
-  CAN_CMD_PREAMP_DATA_STRUCT stResp = {0};
+  int nRetVal;
 
   if (NULL == eOffsetValue)
   {
@@ -1397,264 +576,56 @@ int CPreampConfig::GetBridgeOffset(PREAMP_OFFSET_TYPE eOffsetType,
   {
     return ERR_INVALID_ARGS;
   }
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        while( true )
-        {
-          unsigned char ucCmmdType;
-          switch (eOffsetType)
-          {
-          default:
-          case BRIDGE_LEFT_COARSE:
-            SetCmdAckCommand(&stCmd.byCmdAck, CMD_PREAMP_CFG_FN_GET_LEFT_COARSE);
-            ucCmmdType = CMD_PREAMP_CFG_FN_GET_LEFT_COARSE;
-            break;
-
-          case BRIDGE_RIGHT_COARSE:
-            SetCmdAckCommand(&stCmd.byCmdAck, CMD_PREAMP_CFG_FN_GET_RIGHT_COARSE);
-            ucCmmdType = CMD_PREAMP_CFG_FN_GET_RIGHT_COARSE;
-            break;
-
-          case BRIDGE_RIGHT_FINE:
-            SetCmdAckCommand(&stCmd.byCmdAck, CMD_PREAMP_CFG_FN_GET_RIGHT_FINE);
-            ucCmmdType = CMD_PREAMP_CFG_FN_GET_RIGHT_FINE;
-            break;
-          }
-
-          // Send a command and wait for ackowledgement from remote device
-          nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd, // Command
-                                                       sizeof (stCmd),        // Size of command
-                                                       (unsigned char *) &stResp, // Response from remote board
-                                                       sizeof (stResp),     // Size of expected response
-                                                       FALSE,        // Streaming data
-                                                       unTimeOut);  // Time to wait for response 
-
-          // Check if we got the correct response packet
-          if (nRetVal == sizeof (stResp))  
-          {
-            unsigned char ucRxdRespCmdType = GetCmdAckCommand( &stResp.stCmd.byCmdAck );
-            if( ucRxdRespCmdType == ucCmmdType )
-            {
-              FixEndian(stResp.stData.preampData.OffsetValue);
-              *eOffsetValue = stResp.stData.preampData.OffsetValue;
-              nRetVal = ERR_SUCCESS;
-            }
-            else
-            {
-              DEBUG2( "CPreampConfig::GetBridgeOffset(): Response of a different Command - %d!", ucRxdRespCmdType );
-              nRetVal = ERR_PROTOCOL;
-              
-              //Received response of a previously sent command.
-              //Try sending the command again with remaining timeout interval.
-              unTimeOut = m_pobReliabilityCAN->GetRemTimeOut();
-              if( unTimeOut > 0 )
-              {
-                continue;
-              }
-            }
-          }
-          //Not the expected packet size
-          else if (nRetVal >= 0)
-          {
-            DEBUG2("CPreampConfig::GetBridgeOffset(): Unexpected packet size: %d", nRetVal);
-            nRetVal = ERR_PROTOCOL;
-          }
-          else // if (nRetVal < 0)
-          {
-            DEBUG2("CPreampConfig::GetBridgeOffset(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-          }
-          
-          break;
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CPreampConfig::GetBridgeOffset(): Unexpected invalid pointer!");
-      }
 
-      break;
+  CPreampGetRequest obReq(s_abyGetOffsetCmd[eOffsetType]);
 
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CPreampConfig::GetBridgeOffset(): Invalid switch case!");
-      break;
-    }
-  }
-  else
+  nRetVal = Transact(obReq, unTimeOut);
+  if (ERR_SUCCESS == nRetVal)
   {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CPreampConfig::GetBridgeOffset(): Function called before Open Call!");
+    *eOffsetValue = obReq.Resp().stData.preampData.OffsetValue;
   }
 
   return nRetVal;
 }
 
-// Set the bridge offset value for the specified offset type
-int CPreampConfig::SetBridgeOffset(PREAMP_OFFSET_TYPE eOffsetType, 
-                                   PREAMP_BRIDGE_ADJ_ENUM eOffsetValue,
-                                   unsigned int unTimeOut) // Time to wait for response from remote device
-{
-  DEBUG2("SetBridgeOffset() Called by pid (%d)\n", (int)getpid());
-  int nRetVal = ERR_SUCCESS;
-
-  CAN_CMD_PREAMP_DATA_STRUCT stCmd = {0};
-  CAN_CMD_PREAMP_STATUS_STRUCT stResp = {0};
-
-  if ( (eOffsetValue < BRIDGE_ADJ_0000) || 
-       (eOffsetValue >= NUM_BRIDGE_ADJ_ENUM) )
-  {
-    return ERR_INVALID_ARGS;
-  }
-
-  if ( (eOffsetType < MIN_PREAMP_OFFSET_TYPE) || 
-       (eOffsetType >= MAX_PREAMP_OFFSET_TYPE) )
-  {
-    return ERR_INVALID_ARGS;
-  }
-  
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    if( !IsBaseLineAdjustable() )
-    {
-      DEBUG2("Preamp G2 Board. Doesnot Support Base Line Adjustment\n");
-      return ERR_INVALID_ARGS;
-    }
-    else
-    {
-      DEBUG2("Preamp G1 Board. Let's Attempt Base Line Adjustment\n");
-    }
-
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-
-      // Transmit
-      if (m_pobCAN)
-      {
-        while( true )
-        {
-          unsigned char ucCmmdType;
-          switch (eOffsetType)
-          {
-          default:
-          case BRIDGE_LEFT_COARSE:
-            SetCmdAckCommand(&stCmd.stCmd.byCmdAck, CMD_PREAMP_CFG_FN_SET_LEFT_COARSE);
-            ucCmmdType = CMD_PREAMP_CFG_FN_SET_LEFT_COARSE;
-            break;
-
-          case BRIDGE_RIGHT_COARSE:
-            SetCmdAckCommand(&stCmd.stCmd.byCmdAck, CMD_PREAMP_CFG_FN_SET_RIGHT_COARSE);
-            ucCmmdType = CMD_PREAMP_CFG_FN_SET_RIGHT_COARSE;
-            break;
-
-          case BRIDGE_RIGHT_FINE:
-            SetCmdAckCommand(&stCmd.stCmd.byCmdAck, CMD_PREAMP_CFG_FN_SET_RIGHT_FINE);
-            ucCmmdType = CMD_PREAMP_CFG_FN_SET_RIGHT_FINE;
-            break;
-          }
-
-          stCmd.stData.preampData.OffsetValue = eOffsetValue;   // Data
-
-          FixEndian(stCmd.stData.preampData.OffsetValue);
-
-          // Send a command and wait for ackowledgement from remote device
-          nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd,  // Command
-                                                       sizeof (stCmd),    // Size of command
-                                                       (unsigned char *) &stResp, // Response from remote board
-                                                       sizeof (stResp),// Size of expected response
-                                                       FALSE,   // Streaming data
-                                                       unTimeOut); // Time to wait for response 
-
-          // Check if we got the correct response packet
-          if (nRetVal == sizeof (stResp))  
-          {
-            unsigned char ucRxdRespCmdType = GetCmdAckCommand( &stResp.stCmd.byCmdAck );
-            if( ucRxdRespCmdType == ucCmmdType )
-            {
-              // Check if the device ACK'd or NACK'd
-              //if (stResp.stCmd.Err == 1)
-              if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-              {
-                nRetVal = TransDevError (stResp.stData.StatusDataUnion.ErrorType);
-                DEBUG2("CPreamp:Stream:SetSamplingRate(): Device sent a NACK! Dev error code = %d!", nRetVal);
-              }
-              else
-              {
-                nRetVal = ERR_SUCCESS;
-              }
-            }
-            else
-            {
-              DEBUG2( "CPreampConfig::SetSamplingRate(): Response of a different Command - %d!", ucRxdRespCmdType );
-              nRetVal = ERR_PROTOCOL;
-              
-              //Received response of a previously sent command.
-              //Try sending the command again with remaining timeout interval.
-              unTimeOut = m_pobReliabilityCAN->GetRemTimeOut();
-              if( unTimeOut > 0 )
-              {
-                continue;
-              }
-            }
-          }
-          //Not the expected packet size
-          else if (nRetVal >= 0)
-          {
-            DEBUG2("CPreampConfig::SetSamplingRate(): Unexpected packet size: %d", nRetVal);
-            nRetVal = ERR_PROTOCOL;
-          }
-          else // if (nRetVal < 0)
-          {
-            DEBUG2("CPreampConfig::SetSamplingRate(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-          }
-
-          break;
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CPreampConfig::SetSamplingRate(): Unexpected invalid pointer!");
-      }
-
-      break;
+// Set the bridge offset value for the specified offset type
+int CPreampConfig::SetBridgeOffset(PREAMP_OFFSET_TYPE eOffsetType, 
+                                   PREAMP_BRIDGE_ADJ_ENUM eOffsetValue,
+                                   unsigned int unTimeOut) // Time to wait for response from remote device
+{
+  DEBUG2("SetBridgeOffset() Called by pid (%d)\n", (int)getpid());
 
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CPreampConfig::SetSamplingRate(): Invalid switch case!");
-      break;
-    }
+  if ( (eOffsetValue < BRIDGE_ADJ_0000) || 
+       (eOffsetValue >= NUM_BRIDGE_ADJ_ENUM) )
+  {
+    return ERR_INVALID_ARGS;
   }
-  else
+
+  if ( (eOffsetType < MIN_PREAMP_OFFSET_TYPE) || 
+       (eOffsetType >= MAX_PREAMP_OFFSET_TYPE) )
   {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CPreampConfig::SetSamplingRate(): Function called before Open Call!");
+    return ERR_INVALID_ARGS;
   }
 
-  return nRetVal;
+  // Check if the device is open!
+  if (m_bIsDevOpen)
+  {
+    if( !IsBaseLineAdjustable() )
+    {
+      DEBUG2("Preamp G2 Board. Doesnot Support Base Line Adjustment\n");
+      return ERR_INVALID_ARGS;
+    }
+    else
+    {
+      DEBUG2("Preamp G1 Board. Let's Attempt Base Line Adjustment\n");
+    }
+  }
+
+  CPreampSetRequest obReq(s_abySetOffsetCmd[eOffsetType]);
+
+  obReq.Cmd().stData.preampData.OffsetValue = eOffsetValue;
+
+  return Transact(obReq, unTimeOut);
 }
 
 // Gets the on-board temperature in Milli Degree C.
@@ -1681,6 +652,9 @@ int CPreampConfig::GetOnBoardTemp (int* TempMilliDegC,
       // Transmit
       if (m_pobCAN)
       {
+        // GetRemTimeOut() must report our own response
+        CHALLock obCmdLock(GetCmdLock());
+
         while( true )
         {
           SetCmdAckCommand(&stCmd.byCmdAck, CMD_PREAMP_CFG_FN_GET_ON_BD_TEMP);
@@ -1785,6 +759,9 @@ int CPreampConfig::GetPreampValue (long *PreampValue,
       // Transmit
       if (m_pobCAN)
       {
+        // GetRemTimeOut() must report our own response
+        CHALLock obCmdLock(GetCmdLock());
+
         while( true )
         {
           SetCmdAckCommand(&stCmd.byCmdAck, CMD_PREAMP_CFG_FN_GET_PREAMP_VALUE);
@@ -1888,6 +865,9 @@ int CPreampConfig::GetScalingFactor( float * ScalingFactor,
       // Transmit
       if (m_pobCAN)
       {
+        // GetRemTimeOut() must report our own response
+        CHALLock obCmdLock(GetCmdLock());
+
         while( true )
         {
           SetCmdAckCommand(&stCmd.byCmdAck, CMD_PREAMP_CFG_FN_GET_SCALE_FACTOR);
@@ -1970,221 +950,21 @@ int CPreampConfig::GetScalingFactor( float * ScalingFactor,
 // Enable self calibration
 int CPreampConfig::EnableSelfCalibration(unsigned int unTimeOut) 
 {
-  int nRetVal = ERR_SUCCESS;
-    
-  //CMD_ACK_STRUCT stCmd = {0};
-  CmdAckUnion stCmd = {0}; 
-  CAN_CMD_PREAMP_STATUS_STRUCT stResp = {0};
-    
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-        
-      // Transmit
-      if (m_pobCAN)
-      {
-        while( true )
-        {
-          SetCmdAckCommand(&stCmd.byCmdAck, CMD_PREAMP_CFG_FN_SET_CAL_ON);
-
-          // Send a command and wait for ackowledgement from remote device
-          nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd,   // Command
-                                                       sizeof (stCmd),             // Size of command
-                                                       (unsigned char *) &stResp,  // Response from remote board
-                                                       sizeof (stResp),            // Size of expected response
-                                                       FALSE,                      // Streaming data
-                                                       unTimeOut);                 // Time to wait for response 
-
-          // Check if we got the correct response packet
-          if (nRetVal == sizeof (stResp))  
-          {
-            unsigned char ucRxdRespCmdType = GetCmdAckCommand( &stResp.stCmd.byCmdAck );
-            if( CMD_PREAMP_CFG_FN_SET_CAL_ON == ucRxdRespCmdType )
-            {
-              // Check if the device ACK'd or NACK'd
-              if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-              {
-                nRetVal = TransDevError (stResp.stData.StatusDataUnion.ErrorType);
-                DEBUG2("CPreampConfig::EnableSelfCalibration: Device sent a NACK! Dev error code = %d!", nRetVal);
-              }
-              else
-              {
-                nRetVal = ERR_SUCCESS;
-              }
-            }
-            else
-            {
-              DEBUG2( "CPreampConfig::EnableSelfCalibration(): Response of a different Command - %d!", ucRxdRespCmdType );
-              nRetVal = ERR_PROTOCOL;
-
-              //Received response of a previously sent command.
-              //Try sending the command again with remaining timeout interval.
-              unTimeOut = m_pobReliabilityCAN->GetRemTimeOut();
-              if( unTimeOut > 0 )
-              {
-                continue;
-              }
-            }
-          }
-          //Not the expected packet size
-          else if (nRetVal >= 0)
-          {
-            DEBUG2("CPreampConfig::EnableSelfCalibration(): Unexpected packet size: %d", nRetVal);
-            nRetVal = ERR_PROTOCOL;
-          }
-          else // if (nRetVal < 0)
-          {
-            DEBUG2("CPreampConfig::EnableSelfCalibration(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-          }
-      
-          break;
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CPreampConfig::EnableSelfCalibration(): Unexpected invalid pointer!");
-      }
-
-      break;
-
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CPreampConfig::EnableSelfCalibration(): Invalid switch case!");
-      break;
-    }
-  }
-  else
-  {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CPreampConfig::EnableSelfCalibration: Function called before Open Call!");
-  }
+  CPreampCmdRequest obReq(CMD_PREAMP_CFG_FN_SET_CAL_ON);
 
-  return nRetVal;
+  return Transact(obReq, unTimeOut);
 }
 
 // Enable / Disable Auto Zero
 int CPreampConfig::SetAutoZero( bool bEnable, unsigned int unTimeOut) 
 {
   DEBUG2("SetAutoZero() Called by pid (%d)\n", (int)getpid());
-  int nRetVal = ERR_SUCCESS;
-    
-  CAN_CMD_PREAMP_DATA_STRUCT stCmd = {0};
-  CAN_CMD_PREAMP_STATUS_STRUCT stResp = {0};
-    
-  // Check if the device is open!
-  if (m_bIsDevOpen)
-  {
-    switch (m_eCommType)
-    {
-    case CAN_COMM:
-        
-      // Transmit
-      if (m_pobCAN)
-      {
-        while( true )
-        {
-          SetCmdAckCommand(&stCmd.stCmd.byCmdAck, CMD_PREAMP_CFG_FN_SET_AUTOZERO);
-
-          if( bEnable )
-          {
-            stCmd.stData.preampData.AutoZero = PREAMP_STATE_ON;
-          }
-          else
-          {
-            stCmd.stData.preampData.AutoZero = PREAMP_STATE_OFF;
-          }
-          FixEndian(stCmd.stData.preampData.AutoZero);
-
-          // Send a command and wait for ackowledgement from remote device
-          nRetVal = m_pobReliabilityCAN->GetRemoteResp((unsigned char *) &stCmd,   // Command
-                                                       sizeof (stCmd),             // Size of command
-                                                       (unsigned char *) &stResp,  // Response from remote board
-                                                       sizeof (stResp),            // Size of expected response
-                                                       FALSE,                      // Streaming data
-                                                       unTimeOut);                 // Time to wait for response 
-
-          // Check if we got the correct response packet
-          if (nRetVal == sizeof (stResp))  
-          {
-            unsigned char ucRxdRespCmdType = GetCmdAckCommand( &stResp.stCmd.byCmdAck );
-            if( CMD_PREAMP_CFG_FN_SET_AUTOZERO == ucRxdRespCmdType )
-            {
-              // Check if the device ACK'd or NACK'd
-              if (GetCmdAckError(&stResp.stCmd.byCmdAck) == 1)
-              {
-                nRetVal = TransDevError (stResp.stData.StatusDataUnion.ErrorType);
-                DEBUG2("CPreampConfig::EnableAutoZero: Device sent a NACK! Dev error code = %d!", nRetVal);
-              }
-              else
-              {
-                nRetVal = ERR_SUCCESS;
-              }
-            }
-            else
-            {
-              DEBUG2( "CPreampConfig::EnableAutoZero(): Response of a different Command - %d!", ucRxdRespCmdType );
-              nRetVal = ERR_PROTOCOL;
-
-              //Received response of a previously sent command.
-              //Try sending the command again with remaining timeout interval.
-              unTimeOut = m_pobReliabilityCAN->GetRemTimeOut();
-              if( unTimeOut > 0 )
-              {
-                continue;
-              }
-            }
-          }
-          //Not the expected packet size
-          else if (nRetVal >= 0)
-          {
-            DEBUG2("CPreampConfig::EnableAutoZero(): Unexpected packet size: %d", nRetVal);
-            nRetVal = ERR_PROTOCOL;
-          }
-          else // if (nRetVal < 0)
-          {
-            DEBUG2("CPreampConfig::EnableAutoZero(): CCANComm::CANGetRemoteResp failed with error code %d!", nRetVal);
-          }
-      
-          break;
-        }
-      }
-      else
-      {
-        nRetVal = ERR_INTERNAL_ERR;
-        DEBUG2("CPreampConfig::EnableAutoZero(): Unexpected invalid pointer!");
-      }
 
-      break;
+  CPreampSetRequest obReq(CMD_PREAMP_CFG_FN_SET_AUTOZERO);
 
-    case SPI_COMM:
-      //TODO: To be implemented
-    case SERIAL_COMM:
-      //TODO:  To be implemented
-    case COMM_NONE:
-    default:
-      nRetVal = ERR_INTERNAL_ERR;
-      DEBUG2("CPreampConfig::EnableAutoZero(): Invalid switch case!");
-      break;
-    }
-  }
-  else
-  {
-    // Function called before Open Call!
-    nRetVal = ERR_INVALID_SEQ;
-    DEBUG2("CPreampConfig::EnableAutoZero: Function called before Open Call!");
-  }
+  obReq.Cmd().stData.preampData.AutoZero = bEnable ? PREAMP_STATE_ON : PREAMP_STATE_OFF;
 
-  return nRetVal;
+  return Transact(obReq, unTimeOut);
 }
 
 // Read calibration status (Calibration is in progress or not)
@@ -2211,6 +991,9 @@ int CPreampConfig::GetCalOnOffStatus(PREAMP_STATE_ENUM *eCalInProgress,
       // Transmit
       if (m_pobCAN)
       {
+        // GetRemTimeOut() must report our own response
+        CHALLock obCmdLock(GetCmdLock());
+
         while( true )
         {
           SetCmdAckCommand(&stCmd.byCmdAck, CMD_PREAMP_CFG_FN_GET_CAL_STATUS);
@@ -2314,6 +1097,9 @@ int CPreampConfig::GetBRRightDetStatus(PREAMP_STATE_ENUM *eDetStatus,
       // Transmit
       if (m_pobCAN)
       {
+        // GetRemTimeOut() must report our own response
+        CHALLock obCmdLock(GetCmdLock());
+
         while( true )
         {
           SetCmdAckCommand(&stCmd.byCmdAck, CMD_PREAMP_CFG_FN_GET_BR_RIGHT_DET_STATUS);
@@ -2417,6 +1203,9 @@ int CPreampConfig::GetBRLeftDetStatus(PREAMP_STATE_ENUM *eDetStatus,
       // Transmit
       if (m_pobCAN)
       {
+        // GetRemTimeOut() must report our own response
+        CHALLock obCmdLock(GetCmdLock());
+
         while( true )
         {
           SetCmdAckCommand(&stCmd.byCmdAck, CMD_PREAMP_CFG_FN_GET_BR_LEFT_DET_STATUS);
@@ -2528,3 +1317,144 @@ bool CPreampConfig::IsBaseLineAdjustable( void )
 
   return bIsBaseLineAdjustable;
 }
+
+// Settings a snapshot of this board can hold
+unsigned int CPreampConfig::SnapshotFields()
+{
+  return IsBaseLineAdjustable() ? PREAMP_CFG_ALL : (PREAMP_CFG_ALL & ~PREAMP_CFG_OFFSETS);
+}
+
+// Read all the settings in one exchange with the board
+int CPreampConfig::GetConfigSnapshot(PreampConfigSnapshotStruct *Snapshot,
+                                     unsigned int unTimeOut) // Time to wait for each response
+{
+  CPreampGetRequest obGainReq(CMD_PREAMP_CFG_FN_GET_GAIN);
+  CPreampGetRequest obRateReq(CMD_PREAMP_CFG_FN_GET_SAMPLING_RATE);
+  CPreampGetRequest obACBridgeReq(CMD_PREAMP_CFG_FN_GET_AC_BRIDGE);
+  CPreampGetRequest obFilterReq(CMD_PREAMP_CFG_FN_GET_FILTER);
+  CPreampGetRequest obMovAvgReq(CMD_PREAMP_CFG_FN_GET_MOV_AVG);
+  CPreampGetRequest obLeftCoarseReq(CMD_PREAMP_CFG_FN_GET_LEFT_COARSE);
+  CPreampGetRequest obRightCoarseReq(CMD_PREAMP_CFG_FN_GET_RIGHT_COARSE);
+  CPreampGetRequest obRightFineReq(CMD_PREAMP_CFG_FN_GET_RIGHT_FINE);
+  CPreampGetRequest *apobReq[NUM_PREAMP_CFG_SETTINGS] = { &obGainReq, &obRateReq, &obACBridgeReq, &obFilterReq,
+                                                         &obMovAvgReq, &obLeftCoarseReq, &obRightCoarseReq,
+                                                         &obRightFineReq };
+  CDevTxn *apobTxn[NUM_PREAMP_CFG_SETTINGS];
+  int nNumTxn = 0;
+
+  if (NULL == Snapshot)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  memset(Snapshot, 0, sizeof (*Snapshot));
+  Snapshot->unVersion = PREAMP_CFG_SNAPSHOT_VERSION;
+
+  unsigned int unFields = SnapshotFields();
+  for (unsigned int unSetting = 0; unSetting < NUM_PREAMP_CFG_SETTINGS; unSetting++)
+  {
+    if (unFields & s_aunCfgSettings[unSetting])
+    {
+      apobTxn[nNumTxn++] = apobReq[unSetting];
+    }
+  }
+
+  int nRetVal = TransactBatch(apobTxn, nNumTxn, unTimeOut);
+
+  // Keep what was read, also if some of the settings failed
+  for (unsigned int unSetting = 0; unSetting < NUM_PREAMP_CFG_SETTINGS; unSetting++)
+  {
+    unsigned int unField = s_aunCfgSettings[unSetting];
+    if ( (unFields & unField) && (ERR_SUCCESS == apobReq[unSetting]->GetResult()) )
+    {
+      // All the settings are enums, in the same slot of the data union
+      *CfgSettingValue(Snapshot, unField) = apobReq[unSetting]->Resp().stData.preampData.Gain;
+      Snapshot->unFields |= unField;
+    }
+  }
+
+  return nRetVal;
+}
+
+// Write the settings of a snapshot in one exchange with the board
+int CPreampConfig::RestoreConfigSnapshot(const PreampConfigSnapshotStruct &Snapshot,
+                                         unsigned int Fields,
+                                         unsigned int unTimeOut) // Time to wait for each response
+{
+  CPreampSetRequest obGainReq(CMD_PREAMP_CFG_FN_SET_GAIN);
+  CPreampSetRequest obRateReq(CMD_PREAMP_CFG_FN_SET_SAMPLING_RATE);
+  CPreampSetRequest obACBridgeReq(CMD_PREAMP_CFG_FN_SET_AC_BRIDGE);
+  CPreampSetRequest obFilterReq(CMD_PREAMP_CFG_FN_SET_FILTER);
+  CPreampSetRequest obMovAvgReq(CMD_PREAMP_CFG_FN_SET_MOV_AVG);
+  CPreampSetRequest obLeftCoarseReq(CMD_PREAMP_CFG_FN_SET_LEFT_COARSE);
+  CPreampSetRequest obRightCoarseReq(CMD_PREAMP_CFG_FN_SET_RIGHT_COARSE);
+  CPreampSetRequest obRightFineReq(CMD_PREAMP_CFG_FN_SET_RIGHT_FINE);
+  CPreampSetRequest *apobReq[NUM_PREAMP_CFG_SETTINGS] = { &obGainReq, &obRateReq, &obACBridgeReq, &obFilterReq,
+                                                         &obMovAvgReq, &obLeftCoarseReq, &obRightCoarseReq,
+                                                         &obRightFineReq };
+  CDevTxn *apobTxn[NUM_PREAMP_CFG_SETTINGS];
+  int nNumTxn = 0;
+
+  if (Snapshot.unVersion != PREAMP_CFG_SNAPSHOT_VERSION)
+  {
+    DEBUG2("CPreampConfig::RestoreConfigSnapshot(): Snapshot version %u not supported!", Snapshot.unVersion);
+    return ERR_INVALID_ARGS;
+  }
+
+  PreampConfigSnapshotStruct stSnapshot = Snapshot;
+  unsigned int unFields = Snapshot.unFields & Fields;
+  if ( (unFields & PREAMP_CFG_OFFSETS) && !(SnapshotFields() & PREAMP_CFG_OFFSETS) )
+  {
+    DEBUG2("CPreampConfig::RestoreConfigSnapshot(): Preamp G2 Board. Bridge offsets not restored.");
+    unFields &= ~PREAMP_CFG_OFFSETS;
+  }
+
+  // Check the whole snapshot before anything is changed
+  for (unsigned int unSetting = 0; unSetting < NUM_PREAMP_CFG_SETTINGS; unSetting++)
+  {
+    unsigned int unField = s_aunCfgSettings[unSetting];
+    if ( (unFields & unField) && !IsCfgSettingValid(unField, *CfgSettingValue(&stSnapshot, unField)) )
+    {
+      return ERR_INVALID_ARGS;
+    }
+  }
+
+  for (unsigned int unSetting = 0; unSetting < NUM_PREAMP_CFG_SETTINGS; unSetting++)
+  {
+    unsigned int unField = s_aunCfgSettings[unSetting];
+    if (unFields & unField)
+    {
+      // All the settings are enums, in the same slot of the data union
+      apobReq[unSetting]->Cmd().stData.preampData.Gain = (PREAMP_BRIDGE_GAIN_ENUM) *CfgSettingValue(&stSnapshot, unField);
+      apobTxn[nNumTxn++] = apobReq[unSetting];
+    }
+  }
+
+  if (0 == nNumTxn)
+  {
+    return ERR_SUCCESS;
+  }
+
+  return TransactBatch(apobTxn, nNumTxn, unTimeOut);
+}
+
+// Settings that differ between two snapshots
+unsigned int CPreampConfig::DiffConfigSnapshot(const PreampConfigSnapshotStruct &Snapshot1,
+                                               const PreampConfigSnapshotStruct &Snapshot2)
+{
+  PreampConfigSnapshotStruct stSnapshot1 = Snapshot1;
+  PreampConfigSnapshotStruct stSnapshot2 = Snapshot2;
+  unsigned int unDiff = (Snapshot1.unFields ^ Snapshot2.unFields) & PREAMP_CFG_ALL;
+
+  for (unsigned int unSetting = 0; unSetting < NUM_PREAMP_CFG_SETTINGS; unSetting++)
+  {
+    unsigned int unField = s_aunCfgSettings[unSetting];
+    if ( (Snapshot1.unFields & Snapshot2.unFields & unField) &&
+         (*CfgSettingValue(&stSnapshot1, unField) != *CfgSettingValue(&stSnapshot2, unField)) )
+    {
+      unDiff |= unField;
+    }
+  }
+
+  return unDiff;
+}
@@ -0,0 +1,363 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                     10241 West Little York, Suite 200
+ * *                            Houston, TX 77040
+ * *
+ * *
+ * *  Filename: PreampFrameSync.cpp
+ * *
+ * *  Description: Time aligned frames from several detector (preamp)
+ * *               streams.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+#include <string.h>
+#include <poll.h>
+
+#include "debug.h"
+#include "Reliability.h"
+#include "PreampFrameSync.h"
+
+CPreampFrameSync::CPreampFrameSync()  // Default Constructor
+{
+  m_unNumDetectors = 0;
+  m_unToleranceMs = PREAMP_FRAME_DFLT_TOLERANCE_MS;
+  m_unLateMs = PREAMP_FRAME_DFLT_LATE_MS;
+  m_eFill = PREAMP_FRAME_FILL_ZERO;
+  memset(&m_stStats, 0, sizeof (m_stStats));
+}
+
+CPreampFrameSync::~CPreampFrameSync() // Destructor
+{
+}
+
+// Add an open detector. Returns its index in the frames.
+int CPreampFrameSync::AddDetector(CPreampStream *pobStream)
+{
+  if (NULL == pobStream)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  if (m_unNumDetectors >= PREAMP_FRAME_MAX_DETECTORS)
+  {
+    DEBUG2("CPreampFrameSync::AddDetector(): No more than %d detectors!", PREAMP_FRAME_MAX_DETECTORS);
+    return ERR_INVALID_ARGS;
+  }
+
+  DetectorStruct &stDet = m_astDetectors[m_unNumDetectors];
+  stDet.pobStream = pobStream;
+  stDet.unHead = 0;
+  stDet.unCount = 0;
+  stDet.unLastBridgeData = 0;
+
+  return m_unNumDetectors++;
+}
+
+// Remove all detectors
+void CPreampFrameSync::RemoveAll()
+{
+  m_unNumDetectors = 0;
+}
+
+// Matching tolerance, late limit and fill value for missing samples
+int CPreampFrameSync::Configure(unsigned int ToleranceMs, unsigned int LateMs, PREAMP_FRAME_FILL_ENUM Fill)
+{
+  if (Fill != PREAMP_FRAME_FILL_ZERO && Fill != PREAMP_FRAME_FILL_HOLD)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  m_unToleranceMs = ToleranceMs;
+  m_unLateMs = LateMs;
+  m_eFill = Fill;
+
+  return ERR_SUCCESS;
+}
+
+// Start broadcast on all detectors
+int CPreampFrameSync::Start(CCycleClockSync *pobCycleClock)
+{
+  int nRetVal = ERR_SUCCESS;
+
+  if (0 == m_unNumDetectors)
+  {
+    return ERR_INVALID_SEQ;
+  }
+
+  Reset();
+
+  // With a cycle clock the detectors only get ready here, the cycle clock start
+  // message starts them all
+  for (unsigned int unDet = 0; unDet < m_unNumDetectors; unDet++)
+  {
+    nRetVal = m_astDetectors[unDet].pobStream->SetBroadcastMode(TRUE, pobCycleClock != NULL);
+    if (nRetVal < 0)
+    {
+      DEBUG2("CPreampFrameSync::Start(): Detector %u failed to start with error code %d!", unDet, nRetVal);
+      return nRetVal;
+    }
+  }
+
+  if (pobCycleClock)
+  {
+    nRetVal = pobCycleClock->StartCycleClock();
+    if (nRetVal < 0)
+    {
+      DEBUG2("CPreampFrameSync::Start(): Cycle clock start failed with error code %d!", nRetVal);
+    }
+  }
+
+  return nRetVal;
+}
+
+// Stop broadcast on all detectors
+int CPreampFrameSync::Stop(CCycleClockSync *pobCycleClock)
+{
+  int nRetVal = ERR_SUCCESS;
+
+  if (pobCycleClock)
+  {
+    nRetVal = pobCycleClock->StopCycleClock();
+  }
+
+  for (unsigned int unDet = 0; unDet < m_unNumDetectors; unDet++)
+  {
+    int nDetRetVal = m_astDetectors[unDet].pobStream->SetBroadcastMode(FALSE, pobCycleClock != NULL);
+    if (nDetRetVal < 0 && ERR_SUCCESS == nRetVal)
+    {
+      nRetVal = nDetRetVal;
+    }
+  }
+
+  return nRetVal;
+}
+
+// Drop the samples waiting to be put in frames
+void CPreampFrameSync::Reset()
+{
+  for (unsigned int unDet = 0; unDet < m_unNumDetectors; unDet++)
+  {
+    m_astDetectors[unDet].unHead = 0;
+    m_astDetectors[unDet].unCount = 0;
+    m_astDetectors[unDet].unLastBridgeData = 0;
+  }
+}
+
+// Read the samples already received by each detector
+int CPreampFrameSync::PullSamples()
+{
+  unsigned int aunBridgeData[PREAMP_FRAME_QUEUE_LEN];
+  unsigned long long aullTimeStamp[PREAMP_FRAME_QUEUE_LEN];
+  unsigned char abyFlags[PREAMP_FRAME_QUEUE_LEN];
+
+  for (unsigned int unDet = 0; unDet < m_unNumDetectors; unDet++)
+  {
+    DetectorStruct &stDet = m_astDetectors[unDet];
+    unsigned int unRoom = PREAMP_FRAME_QUEUE_LEN - stDet.unCount;
+
+    // A full queue is waiting for the other detectors - leave the rest in the pipe
+    if (0 == unRoom)
+    {
+      continue;
+    }
+
+    int nRetVal = stDet.pobStream->ReadStreamDataBatch(aunBridgeData, aullTimeStamp, abyFlags, unRoom, 0);
+    if (nRetVal < 0)
+    {
+      DEBUG2("CPreampFrameSync::PullSamples(): Detector %u read failed with error code %d!", unDet, nRetVal);
+      return nRetVal;
+    }
+
+    unsigned long long ullNowUs = CReliability::GetMonotonicTimeUs();
+    for (int nSample = 0; nSample < nRetVal; nSample++)
+    {
+      SampleStruct &stSample = stDet.astQueue[(stDet.unHead + stDet.unCount) % PREAMP_FRAME_QUEUE_LEN];
+      stSample.ullTimeStamp = aullTimeStamp[nSample];
+      stSample.ullRxTimeUs = ullNowUs;
+      stSample.unBridgeData = aunBridgeData[nSample];
+      stSample.byFlags = abyFlags[nSample];
+      stDet.unCount++;
+    }
+  }
+
+  return ERR_SUCCESS;
+}
+
+// Make the next frame from the queued samples
+BOOL CPreampFrameSync::AssembleFrame(PreampFrameStruct *pstFrame, unsigned long long *pullWaitUs)
+{
+  DetectorStruct &stRef = m_astDetectors[0];
+
+  *pullWaitUs = 0;
+  if (0 == stRef.unCount)
+  {
+    return FALSE;
+  }
+
+  const SampleStruct stRefSample = stRef.astQueue[stRef.unHead];
+  unsigned long long ullTime = stRefSample.ullTimeStamp;
+  unsigned long long ullDeadlineUs = stRefSample.ullRxTimeUs + m_unLateMs * 1000ULL;
+  unsigned long long ullNowUs = CReliability::GetMonotonicTimeUs();
+
+  // (1) Drop samples too old for this frame, and wait if a detector's sample for it
+  //     may still come
+  for (unsigned int unDet = 1; unDet < m_unNumDetectors; unDet++)
+  {
+    DetectorStruct &stDet = m_astDetectors[unDet];
+
+    while (stDet.unCount > 0 && stDet.astQueue[stDet.unHead].ullTimeStamp + m_unToleranceMs < ullTime)
+    {
+      stDet.unHead = (stDet.unHead + 1) % PREAMP_FRAME_QUEUE_LEN;
+      stDet.unCount--;
+      m_stStats.ulDropped++;
+    }
+
+    if (0 == stDet.unCount && ullNowUs < ullDeadlineUs)
+    {
+      *pullWaitUs = ullDeadlineUs - ullNowUs;
+      return FALSE;
+    }
+  }
+
+  // (2) Fill the frame
+  pstFrame->ullTimeStamp = ullTime;
+  pstFrame->aunBridgeData[0] = stRefSample.unBridgeData;
+  pstFrame->abyFlags[0] = stRefSample.byFlags;
+  stRef.unLastBridgeData = stRefSample.unBridgeData;
+  stRef.unHead = (stRef.unHead + 1) % PREAMP_FRAME_QUEUE_LEN;
+  stRef.unCount--;
+
+  for (unsigned int unDet = 1; unDet < m_unNumDetectors; unDet++)
+  {
+    DetectorStruct &stDet = m_astDetectors[unDet];
+
+    if (stDet.unCount > 0 && stDet.astQueue[stDet.unHead].ullTimeStamp <= ullTime + m_unToleranceMs)
+    {
+      const SampleStruct &stSample = stDet.astQueue[stDet.unHead];
+      pstFrame->aunBridgeData[unDet] = stSample.unBridgeData;
+      pstFrame->abyFlags[unDet] = stSample.byFlags;
+      stDet.unLastBridgeData = stSample.unBridgeData;
+      stDet.unHead = (stDet.unHead + 1) % PREAMP_FRAME_QUEUE_LEN;
+      stDet.unCount--;
+    }
+    else
+    {
+      // Late (given up on) or lost
+      pstFrame->aunBridgeData[unDet] = (PREAMP_FRAME_FILL_HOLD == m_eFill) ? stDet.unLastBridgeData : 0;
+      pstFrame->abyFlags[unDet] = PREAMP_FRAME_SAMPLE_MISSING;
+      m_stStats.ulMissing++;
+    }
+  }
+
+  m_stStats.ulFrames++;
+  return TRUE;
+}
+
+// Wait for stream data on any detector that has room for it
+void CPreampFrameSync::WaitForData(unsigned int unWaitMs)
+{
+  struct pollfd astPollFd[PREAMP_FRAME_MAX_DETECTORS];
+  int nNumFds = 0;
+
+  for (unsigned int unDet = 0; unDet < m_unNumDetectors; unDet++)
+  {
+    // PullSamples leaves the data of a full queue in the pipe, so its fd stays
+    // readable - polling it would return at once and spin until detector 0 catches up
+    if (PREAMP_FRAME_QUEUE_LEN == m_astDetectors[unDet].unCount)
+    {
+      continue;
+    }
+
+    int nFd = m_astDetectors[unDet].pobStream->GetRxStreamingFd();
+    if (nFd >= 0)
+    {
+      astPollFd[nNumFds].fd = nFd;
+      astPollFd[nNumFds].events = POLLIN;
+      astPollFd[nNumFds].revents = 0;
+      nNumFds++;
+    }
+  }
+
+  poll(astPollFd, nNumFds, unWaitMs);
+}
+
+// Read up to MaxFrames frames, waiting up to Timeout ms for the first
+int CPreampFrameSync::ReadFrames(PreampFrameStruct *Frames, unsigned int MaxFrames, unsigned int Timeout)
+{
+  unsigned int unNumFrames = 0;
+  unsigned long long ullEndUs = CReliability::GetMonotonicTimeUs() + Timeout * 1000ULL;
+
+  if ( (NULL == Frames) || (0 == MaxFrames) )
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  if (0 == m_unNumDetectors)
+  {
+    DEBUG2("CPreampFrameSync::ReadFrames(): No detectors added!");
+    return ERR_INVALID_SEQ;
+  }
+
+  while (TRUE)
+  {
+    unsigned long long ullWaitUs = 0;
+
+    int nRetVal = PullSamples();
+    if (nRetVal < 0)
+    {
+      return nRetVal;
+    }
+
+    while (unNumFrames < MaxFrames && AssembleFrame(&Frames[unNumFrames], &ullWaitUs))
+    {
+      unNumFrames++;
+    }
+
+    if (unNumFrames > 0)
+    {
+      break;
+    }
+
+    unsigned long long ullNowUs = CReliability::GetMonotonicTimeUs();
+    if (ullNowUs >= ullEndUs)
+    {
+      break;
+    }
+
+    // Wake up for new data, the end of the timeout or the late limit of the next frame
+    unsigned long long ullSleepUs = ullEndUs - ullNowUs;
+    if (ullWaitUs && ullWaitUs < ullSleepUs)
+    {
+      ullSleepUs = ullWaitUs;
+    }
+    WaitForData((unsigned int) ((ullSleepUs + 999) / 1000));
+  }
+
+  return unNumFrames;
+}
+
+int CPreampFrameSync::GetStats(PreampFrameStatsStruct *Stats)
+{
+  if (NULL == Stats)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  *Stats = m_stStats;
+  return ERR_SUCCESS;
+}
+
+void CPreampFrameSync::ResetStats()
+{
+  memset(&m_stStats, 0, sizeof (m_stStats));
+}
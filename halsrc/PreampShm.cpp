@@ -0,0 +1,289 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                     10241 West Little York, Suite 200
+ * *                            Houston, TX 77040
+ * *
+ * *
+ * *  Filename: PreampShm.cpp
+ * *
+ * *  Description: Detector (preamp) stream samples in shared memory for
+ * *               other processes.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "debug.h"
+#include "PreampShm.h"
+
+// Bytes of a ring of unCapacity slots
+static unsigned int RingSize(unsigned int unCapacity)
+{
+  return sizeof (PreampShmHeaderStruct) + unCapacity * sizeof (PreampShmSlotStruct);
+}
+
+// Header, then the slots aligned for their 64 bit time stamps
+static PreampShmSlotStruct *RingSlots(void *pvMap)
+{
+  return (PreampShmSlotStruct *) ((char *) pvMap + sizeof (PreampShmHeaderStruct));
+}
+
+CPreampShmPublisher::CPreampShmPublisher()  // Default Constructor
+{
+  m_pstHeader = NULL;
+  m_pstSlots = NULL;
+  m_unMapSize = 0;
+}
+
+CPreampShmPublisher::~CPreampShmPublisher() // Destructor
+{
+  Close();
+}
+
+// Create (or take over) the ring of a device
+int CPreampShmPublisher::Open(const char *DevName, unsigned int Capacity)
+{
+  Close();
+
+  if ( (NULL == DevName) || (Capacity < 2) || (Capacity > PREAMP_SHM_MAX_CAPACITY) ||
+       (Capacity & (Capacity - 1)) )
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  m_sShmName = std::string(PREAMP_SHM_NAME_PREFIX) + DevName;
+  m_unMapSize = RingSize(Capacity);
+
+  int nFd = shm_open(m_sShmName.c_str(), O_RDWR | O_CREAT, 0644);
+  if (nFd < 0)
+  {
+    DEBUG2("CPreampShmPublisher::Open(): Cannot open %s. Error: %d, %s.", m_sShmName.c_str(), errno, strerror(errno));
+    return ERR_OPEN_FILE;
+  }
+
+  if (ftruncate(nFd, m_unMapSize) < 0)
+  {
+    DEBUG2("CPreampShmPublisher::Open(): Cannot size %s. Error: %d, %s.", m_sShmName.c_str(), errno, strerror(errno));
+    close(nFd);
+    return ERR_MEMORY_ERR;
+  }
+
+  void *pvMap = mmap(NULL, m_unMapSize, PROT_READ | PROT_WRITE, MAP_SHARED, nFd, 0);
+  close(nFd);
+  if (MAP_FAILED == pvMap)
+  {
+    DEBUG2("CPreampShmPublisher::Open(): Cannot map %s. Error: %d, %s.", m_sShmName.c_str(), errno, strerror(errno));
+    return ERR_MEMORY_ERR;
+  }
+
+  m_pstHeader = (PreampShmHeaderStruct *) pvMap;
+  m_pstSlots = RingSlots(pvMap);
+
+  // Continue a ring of the same size, so that its readers carry on
+  if ( (m_pstHeader->unMagic != PREAMP_SHM_MAGIC) || (m_pstHeader->unVersion != PREAMP_SHM_VERSION) ||
+       (m_pstHeader->unCapacity != Capacity) )
+  {
+    m_pstHeader->unMagic = 0;
+    __sync_synchronize();
+    memset(m_pstSlots, 0, Capacity * sizeof (PreampShmSlotStruct));
+    m_pstHeader->unVersion = PREAMP_SHM_VERSION;
+    m_pstHeader->unCapacity = Capacity;
+    m_pstHeader->unWriteCount = 0;
+    __sync_synchronize();
+    m_pstHeader->unMagic = PREAMP_SHM_MAGIC;
+  }
+
+  return ERR_SUCCESS;
+}
+
+// Unmap the ring
+void CPreampShmPublisher::Close()
+{
+  if (m_pstHeader)
+  {
+    munmap(m_pstHeader, m_unMapSize);
+    m_pstHeader = NULL;
+    m_pstSlots = NULL;
+  }
+}
+
+// Remove the ring of a device
+int CPreampShmPublisher::Remove(const char *DevName)
+{
+  if (NULL == DevName)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  std::string sShmName = std::string(PREAMP_SHM_NAME_PREFIX) + DevName;
+  if (shm_unlink(sShmName.c_str()) < 0 && errno != ENOENT)
+  {
+    return ERR_INTERNAL_ERR;
+  }
+
+  return ERR_SUCCESS;
+}
+
+CPreampShmReader::CPreampShmReader()  // Default Constructor
+{
+  m_pstHeader = NULL;
+  m_pstSlots = NULL;
+  m_unMapSize = 0;
+  m_unNext = 0;
+  memset(&m_stStats, 0, sizeof (m_stStats));
+}
+
+CPreampShmReader::~CPreampShmReader() // Destructor
+{
+  Close();
+}
+
+// Map the ring of a device
+int CPreampShmReader::Open(const char *DevName, BOOL FromOldest)
+{
+  struct stat stStat;
+
+  Close();
+
+  if (NULL == DevName)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  std::string sShmName = std::string(PREAMP_SHM_NAME_PREFIX) + DevName;
+  int nFd = shm_open(sShmName.c_str(), O_RDONLY, 0);
+  if (nFd < 0)
+  {
+    return ERR_OPEN_FILE;
+  }
+
+  if (fstat(nFd, &stStat) < 0 || stStat.st_size < (off_t) RingSize(2))
+  {
+    close(nFd);
+    return ERR_OPEN_FILE;
+  }
+
+  m_unMapSize = (unsigned int) stStat.st_size;
+  void *pvMap = mmap(NULL, m_unMapSize, PROT_READ, MAP_SHARED, nFd, 0);
+  close(nFd);
+  if (MAP_FAILED == pvMap)
+  {
+    return ERR_MEMORY_ERR;
+  }
+
+  m_pstHeader = (const PreampShmHeaderStruct *) pvMap;
+  m_pstSlots = RingSlots(pvMap);
+
+  // Not set up yet, or of another version
+  if ( (m_pstHeader->unMagic != PREAMP_SHM_MAGIC) || (m_pstHeader->unVersion != PREAMP_SHM_VERSION) ||
+       (RingSize(m_pstHeader->unCapacity) > m_unMapSize) )
+  {
+    Close();
+    return ERR_OPEN_FILE;
+  }
+  __sync_synchronize();
+
+  m_unNext = m_pstHeader->unWriteCount;
+  if (FromOldest)
+  {
+    m_unNext -= (m_unNext < m_pstHeader->unCapacity) ? m_unNext : m_pstHeader->unCapacity;
+  }
+  memset(&m_stStats, 0, sizeof (m_stStats));
+
+  return ERR_SUCCESS;
+}
+
+void CPreampShmReader::Close()
+{
+  if (m_pstHeader)
+  {
+    munmap((void *) m_pstHeader, m_unMapSize);
+    m_pstHeader = NULL;
+    m_pstSlots = NULL;
+  }
+}
+
+// Copy up to MaxSamples new samples
+int CPreampShmReader::Read(PreampShmSampleStruct *Samples, unsigned int MaxSamples)
+{
+  unsigned int unNumSamples = 0;
+
+  if ( (NULL == Samples) || (NULL == m_pstHeader) )
+  {
+    return (NULL == m_pstHeader) ? ERR_INVALID_SEQ : ERR_INVALID_ARGS;
+  }
+
+  unsigned int unCapacity = m_pstHeader->unCapacity;
+
+  while (unNumSamples < MaxSamples)
+  {
+    unsigned int unWriteCount = m_pstHeader->unWriteCount;
+    __sync_synchronize();
+
+    if (unWriteCount == m_unNext)
+    {
+      break;
+    }
+
+    // Fallen behind by more than the ring - skip to the oldest sample still there
+    if (unWriteCount - m_unNext > unCapacity)
+    {
+      m_stStats.ulOverrun += unWriteCount - m_unNext - unCapacity;
+      m_unNext = unWriteCount - unCapacity;
+    }
+
+    const PreampShmSlotStruct &stSlot = m_pstSlots[m_unNext & (unCapacity - 1)];
+    unsigned int unSeq = stSlot.unSeq;
+    __sync_synchronize();
+    PreampShmSampleStruct stSample;
+    stSample.unBridgeData = stSlot.unBridgeData;
+    stSample.ullTimeStamp = stSlot.ullTimeStamp;
+    stSample.byFlags = stSlot.byFlags;
+    __sync_synchronize();
+
+    if (unSeq != 2 * m_unNext + 2 || stSlot.unSeq != unSeq)
+    {
+      // Overwritten under us - the publisher has lapped this slot
+      m_stStats.ulOverrun++;
+      m_unNext++;
+      continue;
+    }
+
+    Samples[unNumSamples++] = stSample;
+    m_unNext++;
+  }
+
+  m_stStats.ulRead += unNumSamples;
+  return unNumSamples;
+}
+
+// Samples published and not read yet
+unsigned int CPreampShmReader::GetBacklog() const
+{
+  return m_pstHeader ? m_pstHeader->unWriteCount - m_unNext : 0;
+}
+
+int CPreampShmReader::GetStats(PreampShmReaderStatsStruct *Stats)
+{
+  if (NULL == Stats)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  *Stats = m_stStats;
+  return ERR_SUCCESS;
+}
@@ -0,0 +1,202 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                     10241 West Little York, Suite 200
+ * *                            Houston, TX 77040
+ * *
+ * *
+ * *  Filename: PreampSimFile.cpp
+ * *
+ * *  Description: Binary sample files for the preamp stream simulator.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <vector>
+#include <string>
+
+#include "debug.h"
+#include "PreampSimFile.h"
+
+CPreampSimFile::CPreampSimFile()  // Default Constructor
+{
+  m_nFd = -1;
+  m_pvMap = NULL;
+  m_unMapSize = 0;
+  m_pstHeader = NULL;
+  m_pnSamples = NULL;
+}
+
+CPreampSimFile::~CPreampSimFile() // Destructor
+{
+  Close();
+}
+
+// Map a binary sample file
+int CPreampSimFile::Open(const char *pszFile)
+{
+  struct stat stStat;
+
+  Close();
+
+  if (NULL == pszFile)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  m_nFd = open(pszFile, O_RDONLY);
+  if (m_nFd < 0)
+  {
+    DEBUG2("CPreampSimFile::Open(): Cannot open %s. Error: %d, %s.", pszFile, errno, strerror(errno));
+    return ERR_OPEN_FILE;
+  }
+
+  if (fstat(m_nFd, &stStat) < 0 || stStat.st_size < (off_t) sizeof (PreampSimFileHeaderStruct))
+  {
+    DEBUG2("CPreampSimFile::Open(): %s is too short!", pszFile);
+    Close();
+    return ERR_PROTOCOL;
+  }
+
+  m_unMapSize = (unsigned int) stStat.st_size;
+  m_pvMap = mmap(NULL, m_unMapSize, PROT_READ, MAP_SHARED, m_nFd, 0);
+  if (MAP_FAILED == m_pvMap)
+  {
+    DEBUG2("CPreampSimFile::Open(): Cannot map %s. Error: %d, %s.", pszFile, errno, strerror(errno));
+    m_pvMap = NULL;
+    Close();
+    return ERR_MEMORY_ERR;
+  }
+
+  const PreampSimFileHeaderStruct *pstHeader = (const PreampSimFileHeaderStruct *) m_pvMap;
+  unsigned long long ullDataSize = (unsigned long long) pstHeader->unNumSamples * pstHeader->unNumChannels * sizeof (int);
+
+  if ( (pstHeader->unMagic != PREAMP_SIM_FILE_MAGIC) || (pstHeader->unVersion != PREAMP_SIM_FILE_VERSION) ||
+       (pstHeader->unHeaderSize < sizeof (PreampSimFileHeaderStruct)) || (pstHeader->unHeaderSize % sizeof (int)) ||
+       (0 == pstHeader->unNumChannels) || (pstHeader->unHeaderSize + ullDataSize > m_unMapSize) )
+  {
+    DEBUG2("CPreampSimFile::Open(): %s is not a valid sample file!", pszFile);
+    Close();
+    return ERR_PROTOCOL;
+  }
+
+  m_pstHeader = pstHeader;
+  m_pnSamples = (const int *) ((const char *) m_pvMap + pstHeader->unHeaderSize);
+
+  // Read from start to end
+  madvise(m_pvMap, m_unMapSize, MADV_SEQUENTIAL);
+
+  return ERR_SUCCESS;
+}
+
+// Unmap the file
+void CPreampSimFile::Close()
+{
+  if (m_pvMap)
+  {
+    munmap(m_pvMap, m_unMapSize);
+    m_pvMap = NULL;
+  }
+
+  if (m_nFd >= 0)
+  {
+    close(m_nFd);
+    m_nFd = -1;
+  }
+
+  m_unMapSize = 0;
+  m_pstHeader = NULL;
+  m_pnSamples = NULL;
+}
+
+// Write a one channel binary file with the samples of a simulator text file
+int CPreampSimFile::ConvertTextFile(const char *pszTextFile, const char *pszBinFile)
+{
+  PreampSimFileHeaderStruct stHeader;
+  std::vector<int> vnSamples;
+  char szBuffer[200];
+  int nFirstTs = 0;
+  int nSecondTs = 0;
+
+  if ( (NULL == pszTextFile) || (NULL == pszBinFile) )
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  FILE *pTextFile = fopen(pszTextFile, "r");
+  if (NULL == pTextFile)
+  {
+    DEBUG2("CPreampSimFile::ConvertTextFile(): Cannot open %s. Error: %d, %s.", pszTextFile, errno, strerror(errno));
+    return ERR_OPEN_FILE;
+  }
+
+  while (fgets(szBuffer, sizeof (szBuffer), pTextFile) != NULL)
+  {
+    int nTs = 0, nValue = 0;
+    if (sscanf(szBuffer, "%d %d", &nTs, &nValue) != 2)
+    {
+      continue;
+    }
+
+    if (vnSamples.size() == 0)
+    {
+      nFirstTs = nTs;
+    }
+    else if (vnSamples.size() == 1)
+    {
+      nSecondTs = nTs;
+    }
+    vnSamples.push_back(nValue);
+  }
+  fclose(pTextFile);
+
+  memset(&stHeader, 0, sizeof (stHeader));
+  stHeader.unMagic = PREAMP_SIM_FILE_MAGIC;
+  stHeader.unVersion = PREAMP_SIM_FILE_VERSION;
+  stHeader.unHeaderSize = sizeof (stHeader);
+  stHeader.unPeriodUs = (nSecondTs > nFirstTs) ? (nSecondTs - nFirstTs) * 1000 : PREAMP_SIM_DFLT_PERIOD_MS * 1000;
+  stHeader.unNumChannels = 1;
+  stHeader.unNumSamples = vnSamples.size();
+
+  std::string sTmpFile = std::string(pszBinFile) + ".tmp";
+  FILE *pBinFile = fopen(sTmpFile.c_str(), "wb");
+  if (NULL == pBinFile)
+  {
+    DEBUG2("CPreampSimFile::ConvertTextFile(): Cannot create %s. Error: %d, %s.", sTmpFile.c_str(), errno, strerror(errno));
+    return ERR_OPEN_FILE;
+  }
+
+  BOOL bOk = (fwrite(&stHeader, sizeof (stHeader), 1, pBinFile) == 1);
+  if (bOk && vnSamples.size() > 0)
+  {
+    bOk = (fwrite(&vnSamples[0], sizeof (int), vnSamples.size(), pBinFile) == vnSamples.size());
+  }
+  if (fclose(pBinFile) != 0)
+  {
+    bOk = FALSE;
+  }
+
+  if (!bOk || rename(sTmpFile.c_str(), pszBinFile) != 0)
+  {
+    DEBUG2("CPreampSimFile::ConvertTextFile(): Cannot write %s. Error: %d, %s.", pszBinFile, errno, strerror(errno));
+    unlink(sTmpFile.c_str());
+    return ERR_INTERNAL_ERR;
+  }
+
+  DEBUG1("CPreampSimFile::ConvertTextFile(): %s -> %s, %u samples", pszTextFile, pszBinFile, stHeader.unNumSamples);
+  return ERR_SUCCESS;
+}
@@ -0,0 +1,320 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                     10241 West Little York, Suite 200
+ * *                            Houston, TX 77040
+ * *
+ * *
+ * *  Filename: PreampSimSource.cpp
+ * *
+ * *  Description: Where each simulated detector (preamp) stream gets its
+ * *               samples.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+
+#include "debug.h"
+#include "PreampSimFile.h"    // For PREAMP_SIM_DFLT_PERIOD_MS
+#include "PreampStreamSim.h"  // For CDetNameToRawFileMapping
+#include "PreampSimSource.h"
+
+std::map<std::string, PreampSimSourceStruct> CPreampSimSources::m_mapSources;
+BOOL CPreampSimSources::m_bConfigFileRead = FALSE;
+CHALMutex CPreampSimSources::m_obLock;
+
+// Simulator details files of the six standard detectors
+static CDetNameToRawFileMapping s_obDetMapping;
+
+CPreampSynth::CPreampSynth()
+{
+  m_vnCycle.assign(1, 0);
+  m_unNoise = 0;
+  Reset();
+}
+
+int CPreampSynth::Configure(const PreampSynthStruct &stSynth)
+{
+  if ( (0 == stSynth.unPeriodMs) || (stSynth.unCycleMs < stSynth.unPeriodMs) ||
+       (stSynth.unCycleMs > PREAMP_SYNTH_MAX_CYCLE_MS) || (stSynth.unNumPeaks > PREAMP_SYNTH_MAX_PEAKS) )
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  unsigned int unNumSamples = stSynth.unCycleMs / stSynth.unPeriodMs;
+  std::vector<double> vdCycle(unNumSamples, (double) stSynth.nBaseline);
+
+  for (unsigned int unPeak = 0; unPeak < stSynth.unNumPeaks; unPeak++)
+  {
+    const PreampSynthPeakStruct &stPeak = stSynth.astPeaks[unPeak];
+    if (0 == stPeak.unSigmaMs)
+    {
+      return ERR_INVALID_ARGS;
+    }
+
+    // Out to 5 sigma, where the peak is below 4e-6 of its height
+    double dSigma = stPeak.unSigmaMs;
+    double dFrom = (double) stPeak.unTimeMs - 5 * dSigma;
+    double dTo = (double) stPeak.unTimeMs + 5 * dSigma;
+    unsigned int unFirst = (dFrom > 0) ? (unsigned int) (dFrom / stSynth.unPeriodMs) : 0;
+
+    for (unsigned int unSample = unFirst; unSample < unNumSamples; unSample++)
+    {
+      double dTime = (double) unSample * stSynth.unPeriodMs;
+      if (dTime > dTo)
+      {
+        break;
+      }
+      double dX = (dTime - stPeak.unTimeMs) / dSigma;
+      vdCycle[unSample] += stPeak.nHeight * exp(-0.5 * dX * dX);
+    }
+  }
+
+  m_vnCycle.resize(unNumSamples);
+  for (unsigned int unSample = 0; unSample < unNumSamples; unSample++)
+  {
+    m_vnCycle[unSample] = (int) floor(vdCycle[unSample] + 0.5);
+  }
+  m_unNoise = stSynth.unNoise;
+  Reset();
+
+  return ERR_SUCCESS;
+}
+
+// Back to the start of the cycle, with the same noise
+void CPreampSynth::Reset()
+{
+  m_unPos = 0;
+  m_unRandom = 2463534242U;
+}
+
+// Parse one line of a configuration file. Returns 1 for a source, 0 for a blank or
+// comment line and ERR_PROTOCOL for an error.
+int CPreampSimSources::ParseLine(const char *pszLine, std::string *psDevName, PreampSimSourceStruct *pstSource)
+{
+  char szDevName[100];
+  char szSource[20];
+  char szFile[200];
+  int nUsed = 0;
+
+  if (sscanf(pszLine, " %99s", szDevName) < 1 || '#' == szDevName[0])
+  {
+    return 0;
+  }
+
+  if (sscanf(pszLine, " %99s %19s %n", szDevName, szSource, &nUsed) < 2)
+  {
+    return ERR_PROTOCOL;
+  }
+  const char *pszParams = pszLine + nUsed;
+
+  *psDevName = szDevName;
+  pstSource->sFile.clear();
+  pstSource->unNumFiles = 0;
+  pstSource->unChannel = 0;
+  memset(&pstSource->stSynth, 0, sizeof (pstSource->stSynth));
+
+  if (strcmp(szSource, "hw") == 0)
+  {
+    pstSource->eSource = PREAMP_SIM_NONE;
+  }
+  else if (strcmp(szSource, "files") == 0)
+  {
+    pstSource->eSource = PREAMP_SIM_FILES;
+    if (sscanf(pszParams, "%199s %u", szFile, &pstSource->unNumFiles) != 2)
+    {
+      return ERR_PROTOCOL;
+    }
+    pstSource->sFile = szFile;
+  }
+  else if (strcmp(szSource, "capture") == 0)
+  {
+    pstSource->eSource = PREAMP_SIM_CAPTURE;
+    if (sscanf(pszParams, "%199s %u", szFile, &pstSource->unChannel) < 1)
+    {
+      return ERR_PROTOCOL;
+    }
+    pstSource->sFile = szFile;
+  }
+  else if (strcmp(szSource, "synth") == 0)
+  {
+    PreampSynthStruct &stSynth = pstSource->stSynth;
+    pstSource->eSource = PREAMP_SIM_SYNTHETIC;
+    stSynth.unPeriodMs = PREAMP_SIM_DFLT_PERIOD_MS;
+    if (sscanf(pszParams, "%d %u %u %n", &stSynth.nBaseline, &stSynth.unNoise, &stSynth.unCycleMs, &nUsed) < 3)
+    {
+      return ERR_PROTOCOL;
+    }
+    pszParams += nUsed;
+
+    PreampSynthPeakStruct stPeak;
+    while (sscanf(pszParams, "%u %u %d %n", &stPeak.unTimeMs, &stPeak.unSigmaMs, &stPeak.nHeight, &nUsed) >= 3)
+    {
+      if (stSynth.unNumPeaks >= PREAMP_SYNTH_MAX_PEAKS)
+      {
+        return ERR_PROTOCOL;
+      }
+      stSynth.astPeaks[stSynth.unNumPeaks++] = stPeak;
+      pszParams += nUsed;
+    }
+  }
+  else
+  {
+    return ERR_PROTOCOL;
+  }
+
+  return 1;
+}
+
+// Source of a device
+int CPreampSimSources::SetSource(const char *DevName, const PreampSimSourceStruct &Source)
+{
+  if (NULL == DevName)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  switch (Source.eSource)
+  {
+  case PREAMP_SIM_NONE:
+    break;
+
+  case PREAMP_SIM_FILES:
+    if (Source.sFile.empty() || 0 == Source.unNumFiles)
+    {
+      return ERR_INVALID_ARGS;
+    }
+    break;
+
+  case PREAMP_SIM_CAPTURE:
+    if (Source.sFile.empty())
+    {
+      return ERR_INVALID_ARGS;
+    }
+    break;
+
+  case PREAMP_SIM_SYNTHETIC:
+    {
+      // Check it builds
+      CPreampSynth obSynth;
+      if (obSynth.Configure(Source.stSynth) != ERR_SUCCESS)
+      {
+        return ERR_INVALID_ARGS;
+      }
+    }
+    break;
+
+  default:
+    return ERR_INVALID_ARGS;
+  }
+
+  CHALLock obLock(&m_obLock);
+  m_mapSources[DevName] = Source;
+
+  return ERR_SUCCESS;
+}
+
+// Back to the default source of a device
+void CPreampSimSources::ClearSource(const char *DevName)
+{
+  if (DevName)
+  {
+    CHALLock obLock(&m_obLock);
+    m_mapSources.erase(DevName);
+  }
+}
+
+// Source a device is opened with
+void CPreampSimSources::GetSource(const char *DevName, PreampSimSourceStruct *Source)
+{
+  Source->eSource = PREAMP_SIM_NONE;
+  Source->sFile.clear();
+  Source->unNumFiles = 0;
+  Source->unChannel = 0;
+  if (NULL == DevName)
+  {
+    return;
+  }
+
+  CHALLock obLock(&m_obLock);
+
+  if (!m_bConfigFileRead)
+  {
+    m_bConfigFileRead = TRUE;
+    ReadConfigFile(PREAMP_SIM_CONFIG_FILE);
+  }
+
+  std::map<std::string, PreampSimSourceStruct>::const_iterator it = m_mapSources.find(DevName);
+  if (it != m_mapSources.end())
+  {
+    *Source = it->second;
+    return;
+  }
+
+  // Simulator details file of a standard detector
+  Source->sFile = s_obDetMapping.GetRawFileTemplatePath(DevName);
+  Source->unNumFiles = s_obDetMapping.IsSimulationEnabled(DevName);
+  Source->eSource = (Source->unNumFiles > 0) ? PREAMP_SIM_FILES : PREAMP_SIM_NONE;
+}
+
+// Set the sources listed in a configuration file
+int CPreampSimSources::ReadConfigFile(const char *FileName)
+{
+  char szLine[1024];
+  int nNumSources = 0;
+  int nLine = 0;
+
+  if (NULL == FileName)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  FILE *pFile = fopen(FileName, "r");
+  if (NULL == pFile)
+  {
+    // No configuration file is the usual case
+    return (ENOENT == errno) ? 0 : ERR_OPEN_FILE;
+  }
+
+  while (fgets(szLine, sizeof (szLine), pFile) != NULL)
+  {
+    std::string sDevName;
+    PreampSimSourceStruct stSource;
+
+    nLine++;
+    int nRetVal = ParseLine(szLine, &sDevName, &stSource);
+    if (0 == nRetVal)
+    {
+      continue;
+    }
+
+    if (nRetVal > 0)
+    {
+      nRetVal = SetSource(sDevName.c_str(), stSource);
+    }
+
+    if (nRetVal < 0)
+    {
+      DEBUG2("CPreampSimSources::ReadConfigFile(): %s line %d is not valid, ignored!", FileName, nLine);
+    }
+    else
+    {
+      nNumSources++;
+    }
+  }
+  fclose(pFile);
+
+  return nNumSources;
+}
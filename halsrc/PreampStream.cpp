@@ -104,15 +104,32 @@
 
 #define MAX_DEV_TS_VALUE  65536
 
+// Sampling period of each PREAMP_SAMPLING_RATE_ENUM, in micro-seconds
+static const unsigned int s_aunSamplingPeriodUs[MAX_PREAMP_SAMPLING_RATE] =
+{
+  145455,   // PREAMP_SAMPLING_RATE_6HZ875
+  72727,    // PREAMP_SAMPLING_RATE_13HZ75
+  36364,    // PREAMP_SAMPLING_RATE_27HZ5
+  18182,    // PREAMP_SAMPLING_RATE_55HZ
+};
+
 CPreampStream::CPreampStream()  // Default Constructor
-  :  SPIKE_FILT_SAMPLE_SIZE (3), SPIKE_SLOPE_THRESHOLD (100000)
+  :  m_obSpikeFilter (m_szDevName)
 {
   m_ullTimeStamp = 0;
   m_unBridgeData = 0;
   m_usPrevTimeStamp = 0;
   m_usStartTimeStamp = 0;
   m_bRxFirstTimeStamp = FALSE;
+  m_bRxPrevTimeStamp = FALSE;
   m_bStreamingStarted = FALSE;
+  m_unPeriodUs = 0;
+  m_eGapMode = PREAMP_GAP_FLAG;
+  memset(&m_stStreamStats, 0, sizeof (m_stStreamStats));
+  m_unOutQueueHead = 0;
+  m_unOutQueueCount = 0;
+  m_bPeakDetect = FALSE;
+  m_bNoiseStats = FALSE;
 }
 
 CPreampStream::~CPreampStream() // Destructor
@@ -133,6 +150,7 @@ int CPreampStream::OpenHal (char* pszDevName)
 // Closes the device. Returns 0 on success, negative error code on failure.
 int CPreampStream::CloseHal ()
 {
+  SetShmBroadcast (FALSE);
   return CBaseDev::CloseHal ();
 }
 
@@ -166,6 +184,9 @@ int CPreampStream::SetBroadcastMode (unsigned char Start, bool doInitOnly)
           }
           else
           {
+            // The stream state must not change under a reader
+            CHALLock obStrmLock(GetStrmLock());
+
             //Flush existing data
             Flush();
             m_bStreamingStarted = TRUE;
@@ -174,7 +195,12 @@ int CPreampStream::SetBroadcastMode (unsigned char Start, bool doInitOnly)
             m_usStartTimeStamp = 0;
             m_unBridgeData = 0;
             m_bRxFirstTimeStamp = TRUE;
-            m_vstSpikeFiltData.clear();
+            m_bRxPrevTimeStamp = FALSE;
+            m_obSpikeFilter.Reset();
+            m_unOutQueueHead = 0;
+            m_unOutQueueCount = 0;
+            m_obPeakDetector.Reset();
+            ResetNoiseStats();
             SetCmdAckCommand(&stCmd.byCmdAck, CMD_PREAMP_STR_FN_EN_BROADCAST);
           }
         }
@@ -253,12 +279,15 @@ int CPreampStream::ReadStreamData (unsigned int *BridgeData, unsigned long long
 {
   int nRetVal = ERR_SUCCESS;
   PREAMP_STREAM_STRUCT stResp;
-  SampleDataStruct stCurrentSample;
+  unsigned int unNumSamples = 0;
 
   if ( (NULL == BridgeData) || (NULL == TimeStamp) )
   {
     return ERR_INVALID_ARGS;
   }
+
+  // Spike filter and time stamp state is shared by the stream reads
+  CHALLock obStrmLock(GetStrmLock());
     
   // Check if the device is open!
   if (m_bIsDevOpen)
@@ -270,7 +299,10 @@ int CPreampStream::ReadStreamData (unsigned int *BridgeData, unsigned long long
       // Transmit
       if (m_pobCAN)
       {
-        do 
+        // A sample left over from a filled gap is returned first
+        DrainOutQueue (BridgeData, TimeStamp, NULL, &unNumSamples, 1);
+
+        while (ERR_SUCCESS == nRetVal && 0 == unNumSamples)
         {
           // Send a command and wait for ackowledgement from remote device
           nRetVal = m_pobCAN->CANRxStrmTimeout((unsigned char *) &stResp,  // Response from remote board
@@ -282,14 +314,7 @@ int CPreampStream::ReadStreamData (unsigned int *BridgeData, unsigned long long
             FixEndian(stResp.unBridgeData);
             FixEndian(stResp.usTimeStamp);
     
-            UpdateTime(stResp.usTimeStamp);
-    
-            //*BridgeData = stResp.unBridgeData;
-            //*TimeStamp = (m_ullTimeStamp - m_usStartTimeStamp);
-
-            stCurrentSample.nBridgeVal = stResp.unBridgeData;
-            stCurrentSample.ullTimestamp = m_ullTimeStamp - m_usStartTimeStamp;
-            m_vstSpikeFiltData.push_back (stCurrentSample);
+            ProcessSample (stResp, BridgeData, TimeStamp, NULL, &unNumSamples, 1);
     
             nRetVal = ERR_SUCCESS;
           }
@@ -302,11 +327,6 @@ int CPreampStream::ReadStreamData (unsigned int *BridgeData, unsigned long long
             DEBUG2("CPreampStream::ReadStreamData(): CCANComm::CANRxStrmTimeout - received unexpected number of bytes: %d !", nRetVal);
             nRetVal = ERR_PROTOCOL;
           }
-        } while (ERR_SUCCESS == nRetVal && SPIKE_FILT_SAMPLE_SIZE > m_vstSpikeFiltData.size());
-
-        if (ERR_SUCCESS == nRetVal)
-        {
-          nRetVal = GetFilteredData (BridgeData, TimeStamp);
         }
       }
       else
@@ -337,6 +357,116 @@ int CPreampStream::ReadStreamData (unsigned int *BridgeData, unsigned long long
   return nRetVal;
 }
 
+// Read all samples that arrive within Timeout milli-seconds, up to MaxSamples
+int CPreampStream::ReadStreamDataBatch (unsigned int *BridgeData, unsigned long long *TimeStamp, unsigned char *Flags,
+                                        unsigned int MaxSamples, unsigned int Timeout)
+{
+  int nRetVal = ERR_SUCCESS;
+  PREAMP_STREAM_STRUCT astRaw[PREAMP_STREAM_BATCH_CHUNK];
+  unsigned int unNumSamples = 0;
+  unsigned int unRemTimeout = Timeout;
+  BOOL bTimedOut = FALSE;
+
+  if ( (NULL == BridgeData) || (NULL == TimeStamp) || (0 == MaxSamples) )
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  // Spike filter and time stamp state is shared by the stream reads
+  CHALLock obStrmLock(GetStrmLock());
+
+  if (!m_bIsDevOpen)
+  {
+    // Function called before Open Call!
+    DEBUG2("CPreampStream::ReadStreamDataBatch: Function called before Open Call!");
+    return ERR_INVALID_SEQ;
+  }
+
+  if (CAN_COMM != m_eCommType || NULL == m_pobCAN)
+  {
+    DEBUG2("CPreampStream::ReadStreamDataBatch(): Unexpected invalid pointer / comm type!");
+    return ERR_INTERNAL_ERR;
+  }
+
+  // Samples left over from a filled gap are returned first
+  DrainOutQueue (BridgeData, TimeStamp, Flags, &unNumSamples, MaxSamples);
+
+  // Samples that can come out of one received sample (the filter only ever holds
+  // samples back, a filled gap adds samples)
+  unsigned int unOutPerRaw = 1;
+  if (m_unPeriodUs && PREAMP_GAP_INTERPOLATE == m_eGapMode)
+  {
+    unOutPerRaw += PREAMP_STREAM_MAX_GAP_FILL;
+  }
+
+  while (unNumSamples < MaxSamples && !bTimedOut && ERR_SUCCESS == nRetVal)
+  {
+    // Read no more raw samples than there is room for. What does not fit (at most
+    // one received sample's worth) is queued for the next read.
+    unsigned int unChunk = (MaxSamples - unNumSamples) / unOutPerRaw;
+    unsigned int unNumRaw = 0;
+    if (unChunk == 0)
+    {
+      unChunk = 1;
+    }
+    else if (unChunk > PREAMP_STREAM_BATCH_CHUNK)
+    {
+      unChunk = PREAMP_STREAM_BATCH_CHUNK;
+    }
+
+    // (1) Collect raw samples until the chunk is full or the time is up
+    while (unNumRaw < unChunk)
+    {
+      nRetVal = m_pobCAN->CANRxStrmTimeout((unsigned char *) &astRaw[unNumRaw],  // Response from remote board
+                                           sizeof (astRaw[0]), unRemTimeout,    // Size of expected response
+                                           &unRemTimeout);
+      if (nRetVal == sizeof (astRaw[0]))
+      {
+        unNumRaw++;
+        nRetVal = ERR_SUCCESS;
+      }
+      else if (ERR_TIMEOUT == nRetVal)
+      {
+        bTimedOut = TRUE;
+        nRetVal = ERR_SUCCESS;
+        break;
+      }
+      else if (nRetVal < 0)
+      {
+        DEBUG2("CPreampStream::ReadStreamDataBatch(): CCANComm::CANRxStrmTimeout failed with error code %d!", nRetVal);
+        break;
+      }
+      else
+      {
+        DEBUG2("CPreampStream::ReadStreamDataBatch(): CCANComm::CANRxStrmTimeout - received unexpected number of bytes: %d !", nRetVal);
+        nRetVal = ERR_PROTOCOL;
+        break;
+      }
+    }
+
+    // (2) Byte order over the chunk
+    for (unsigned int unRaw = 0; unRaw < unNumRaw; unRaw++)
+    {
+      FixEndian(astRaw[unRaw].unBridgeData);
+      FixEndian(astRaw[unRaw].usTimeStamp);
+    }
+
+    // (3) Time stamp unwrapping, continuity check and spike filter over the chunk
+    for (unsigned int unRaw = 0; unRaw < unNumRaw; unRaw++)
+    {
+      ProcessSample (astRaw[unRaw], BridgeData, TimeStamp, Flags, &unNumSamples, MaxSamples);
+    }
+  }
+
+  // Samples already taken out of the filter are returned even if the read failed
+  if (ERR_SUCCESS == nRetVal || unNumSamples > 0)
+  {
+    nRetVal = unNumSamples;
+  }
+
+  return nRetVal;
+}
+
 // Read stream data, block on read
 int CPreampStream::ReadStreamDataBlocking (unsigned int *BridgeData, unsigned long long *TimeStamp)
 {
@@ -347,6 +477,9 @@ int CPreampStream::ReadStreamDataBlocking (unsigned int *BridgeData, unsigned lo
   {
     return ERR_INVALID_ARGS;
   }
+
+  // Spike filter and time stamp state is shared by the stream reads
+  CHALLock obStrmLock(GetStrmLock());
     
   // Check if the device is open!
   if (m_bIsDevOpen)
@@ -358,32 +491,40 @@ int CPreampStream::ReadStreamDataBlocking (unsigned int *BridgeData, unsigned lo
       // Transmit
       if (m_pobCAN)
       {
-        // Send a command and wait for ackowledgement from remote device
-        nRetVal = m_pobCAN->CANRxStrmBlocking((unsigned char *) &stResp,  // Response from remote board
-                                              sizeof (stResp));         // Size of expected response
-
-        // Check if we got the correct response packet
-        if (nRetVal == sizeof (stResp))  
+        BOOL bReordered = FALSE;
+        do
         {
-          FixEndian(stResp.unBridgeData);
-          FixEndian(stResp.usTimeStamp);
+          // Send a command and wait for ackowledgement from remote device
+          nRetVal = m_pobCAN->CANRxStrmBlocking((unsigned char *) &stResp,  // Response from remote board
+                                                sizeof (stResp));         // Size of expected response
 
-          UpdateTime(stResp.usTimeStamp);
+          // Check if we got the correct response packet
+          if (nRetVal == sizeof (stResp))  
+          {
+            unsigned int unMissing = 0;
+
+            FixEndian(stResp.unBridgeData);
+            FixEndian(stResp.usTimeStamp);
+
+            // An out of order sample is dropped - wait for the next one
+            bReordered = (UpdateTime(stResp.usTimeStamp, &unMissing) & PREAMP_SAMPLE_REORDERED) ? TRUE : FALSE;
           
-          *BridgeData = stResp.unBridgeData;
-          *TimeStamp = (m_ullTimeStamp - m_usStartTimeStamp);
+            *BridgeData = stResp.unBridgeData;
+            *TimeStamp = (m_ullTimeStamp - m_usStartTimeStamp);
+            m_unBridgeData = stResp.unBridgeData;
 
-          nRetVal = ERR_SUCCESS;
-        }
-        else if (nRetVal < 0)// if (nRetVal <= 0)
-        {
-          DEBUG2("CPreampStream::ReadStreamDataBlocking(): CCANComm::CANRxStrmBlocking failed with error code %d!", nRetVal);
-        }
-        else // if(nRetVal != sizeof (stResp))
-        {
-          DEBUG2("CPreampStream::ReadStreamDataBlocking(): CCANComm::CANRxStrmBlocking - received unexpected number of bytes: %d !", nRetVal);
-          nRetVal = ERR_PROTOCOL;
-        }
+            nRetVal = ERR_SUCCESS;
+          }
+          else if (nRetVal < 0)// if (nRetVal <= 0)
+          {
+            DEBUG2("CPreampStream::ReadStreamDataBlocking(): CCANComm::CANRxStrmBlocking failed with error code %d!", nRetVal);
+          }
+          else // if(nRetVal != sizeof (stResp))
+          {
+            DEBUG2("CPreampStream::ReadStreamDataBlocking(): CCANComm::CANRxStrmBlocking - received unexpected number of bytes: %d !", nRetVal);
+            nRetVal = ERR_PROTOCOL;
+          }
+        } while (ERR_SUCCESS == nRetVal && bReordered);
       }
       else
       {
@@ -574,8 +715,13 @@ int CPreampStream::GetCalOnOffStatus(PREAMP_STATE_ENUM *eCalInProgress)
 }
 
 // Update the local time stamp counter (also takes care of roll-over condition)
-void CPreampStream::UpdateTime(unsigned short usCurrentTimeStamp)
+unsigned char CPreampStream::UpdateTime(unsigned short usCurrentTimeStamp, unsigned int *punMissing)
 {
+  unsigned char byFlags = 0;
+  unsigned short usDelta = 0;
+
+  *punMissing = 0;
+
   //Update the total time stamp counter, taking roll-over into consideration.
   //  The time stamp from the board is 2 bytes long and hence rolls over 
   //  every MAX_DEV_TS_VALUE. But the time stamp counter maintained here
@@ -588,26 +734,217 @@ void CPreampStream::UpdateTime(unsigned short usCurrentTimeStamp)
     m_usStartTimeStamp = usCurrentTimeStamp;
   }
 
-  if (m_usPrevTimeStamp < usCurrentTimeStamp)
-  {
-    m_ullTimeStamp += (usCurrentTimeStamp - m_usPrevTimeStamp);
-  }
-  else if (m_usPrevTimeStamp > usCurrentTimeStamp)
+  m_stStreamStats.ulSamples++;
+
+  // Time since the previous sample, roll-over included
+  usDelta = (unsigned short)(usCurrentTimeStamp - m_usPrevTimeStamp);
+
+  if (FALSE == m_bRxPrevTimeStamp)
   {
-    m_ullTimeStamp += (MAX_DEV_TS_VALUE - (m_usPrevTimeStamp - usCurrentTimeStamp));
+    // Nothing to check the first sample against
+    m_bRxPrevTimeStamp = TRUE;
+    m_ullTimeStamp += usDelta;
+    m_usPrevTimeStamp = usCurrentTimeStamp;
+    m_stStreamStats.ulInOrder++;
+    return byFlags;
   }
-  // else if (m_usPrevTimeStamp == usCurrentTimeStamp) - READ BELOW
+
   //If both are equal, it is considered a duplicate and not added
   //  to the total time. This is based on the assumption that 
   //  it will never take more than MAX_DEV_TS_VALUE to be able to
   //  receive the next packet.
+  if (0 == usDelta)
+  {
+    m_stStreamStats.ulDuplicates++;
+    return PREAMP_SAMPLE_DUP_TIMESTAMP;
+  }
 
+  // A small step back is a sample that arrived out of order, not a roll-over
+  if (MAX_DEV_TS_VALUE - usDelta <= PREAMP_STREAM_REORDER_WINDOW_MS)
+  {
+    m_stStreamStats.ulReordered++;
+    DEBUG2("CPreampStream::UpdateTime: %s - sample %d ms older than the previous one dropped",
+           m_szDevName, MAX_DEV_TS_VALUE - usDelta);
+    return PREAMP_SAMPLE_REORDERED;
+  }
+
+  m_ullTimeStamp += usDelta;
   m_usPrevTimeStamp = usCurrentTimeStamp;
+
+  // Number of sampling periods since the previous sample, rounded
+  if (m_unPeriodUs)
+  {
+    unsigned int unPeriods = (usDelta * 1000U + m_unPeriodUs / 2) / m_unPeriodUs;
+    if (unPeriods > 1)
+    {
+      *punMissing = unPeriods - 1;
+      byFlags |= PREAMP_SAMPLE_GAP;
+      m_stStreamStats.ulGaps++;
+      m_stStreamStats.ulMissing += *punMissing;
+      return byFlags;
+    }
+  }
+
+  m_stStreamStats.ulInOrder++;
+  return byFlags;
+}
+
+// Classify a received sample, fill the gap before it if asked to and run the spike filter
+void CPreampStream::ProcessSample (const PREAMP_STREAM_STRUCT &stRaw, unsigned int *BridgeData, unsigned long long *TimeStamp,
+                                   unsigned char *Flags, unsigned int *NumSamples, unsigned int MaxSamples)
+{
+  SpikeFiltSampleStruct stSample, stFiltered;
+  unsigned long long ullPrevTime = m_ullTimeStamp - m_usStartTimeStamp;
+  unsigned int unMissing = 0;
+
+  unsigned char byFlags = UpdateTime (stRaw.usTimeStamp, &unMissing);
+  if (byFlags & PREAMP_SAMPLE_REORDERED)
+  {
+    return;
+  }
+
+  stSample.nBridgeVal = stRaw.unBridgeData;
+  stSample.ullTimestamp = m_ullTimeStamp - m_usStartTimeStamp;
+  stSample.byFlags = byFlags;
+
+  // Fill the gap with samples on a straight line between the samples around it
+  if ( (byFlags & PREAMP_SAMPLE_GAP) && PREAMP_GAP_INTERPOLATE == m_eGapMode &&
+       unMissing <= PREAMP_STREAM_MAX_GAP_FILL )
+  {
+    long long llValStep = (long long) stSample.nBridgeVal - (int) m_unBridgeData;
+    unsigned long long ullTimeStep = stSample.ullTimestamp - ullPrevTime;
+
+    for (unsigned int unFill = 1; unFill <= unMissing; unFill++)
+    {
+      SpikeFiltSampleStruct stFill;
+      stFill.nBridgeVal = (int) m_unBridgeData + (int) (llValStep * unFill / (unMissing + 1));
+      stFill.ullTimestamp = ullPrevTime + ullTimeStep * unFill / (unMissing + 1);
+      stFill.byFlags = PREAMP_SAMPLE_INTERPOLATED;
+      m_stStreamStats.ulInterpolated++;
+
+      if (m_obSpikeFilter.Push (stFill, &stFiltered))
+      {
+        OutputSample (stFiltered, BridgeData, TimeStamp, Flags, NumSamples, MaxSamples);
+      }
+    }
+  }
+  m_unBridgeData = stRaw.unBridgeData;
+
+  if (m_obSpikeFilter.Push (stSample, &stFiltered))
+  {
+    OutputSample (stFiltered, BridgeData, TimeStamp, Flags, NumSamples, MaxSamples);
+  }
+}
+
+// Return a filtered sample to the caller, or queue it if there is no room
+void CPreampStream::OutputSample (const SpikeFiltSampleStruct &stSample, unsigned int *BridgeData, unsigned long long *TimeStamp,
+                                  unsigned char *Flags, unsigned int *NumSamples, unsigned int MaxSamples)
+{
+  if (m_obShmPublisher.IsOpen())
+  {
+    m_obShmPublisher.Publish (stSample.nBridgeVal, stSample.ullTimestamp, stSample.byFlags);
+  }
+
+  if (m_bPeakDetect)
+  {
+    m_obPeakDetector.Push (stSample.nBridgeVal, stSample.ullTimestamp);
+  }
+
+  {
+    // The flag is set by SetNoiseStats() under the same lock
+    CHALLock obNoiseLock(&m_obNoiseLock);
+    if (m_bNoiseStats)
+    {
+      m_obNoiseStats.Push (stSample.nBridgeVal, stSample.ullTimestamp);
+    }
+  }
+
+  if (*NumSamples < MaxSamples && 0 == m_unOutQueueCount)
+  {
+    BridgeData[*NumSamples] = stSample.nBridgeVal;
+    TimeStamp[*NumSamples] = stSample.ullTimestamp;
+    if (Flags)
+    {
+      Flags[*NumSamples] = stSample.byFlags;
+    }
+    (*NumSamples)++;
+  }
+  else if (m_unOutQueueCount < sizeof (m_astOutQueue) / sizeof (m_astOutQueue[0]))
+  {
+    unsigned int unTail = (m_unOutQueueHead + m_unOutQueueCount) % (sizeof (m_astOutQueue) / sizeof (m_astOutQueue[0]));
+    m_astOutQueue[unTail] = stSample;
+    m_unOutQueueCount++;
+  }
+  else
+  {
+    // Unexpected! The reads never process more samples than there is room for
+    DEBUG2("CPreampStream::OutputSample: %s - output queue full, sample dropped!", m_szDevName);
+  }
+}
+
+// Move queued samples to the caller's arrays
+void CPreampStream::DrainOutQueue (unsigned int *BridgeData, unsigned long long *TimeStamp,
+                                   unsigned char *Flags, unsigned int *NumSamples, unsigned int MaxSamples)
+{
+  while (m_unOutQueueCount > 0 && *NumSamples < MaxSamples)
+  {
+    const SpikeFiltSampleStruct &stSample = m_astOutQueue[m_unOutQueueHead];
+    BridgeData[*NumSamples] = stSample.nBridgeVal;
+    TimeStamp[*NumSamples] = stSample.ullTimestamp;
+    if (Flags)
+    {
+      Flags[*NumSamples] = stSample.byFlags;
+    }
+    (*NumSamples)++;
+
+    m_unOutQueueHead = (m_unOutQueueHead + 1) % (sizeof (m_astOutQueue) / sizeof (m_astOutQueue[0]));
+    m_unOutQueueCount--;
+  }
+}
+
+// Check the stream for missing samples against the sampling period of SamplingRate
+int CPreampStream::SetStreamCheck (PREAMP_SAMPLING_RATE_ENUM SamplingRate, PREAMP_GAP_MODE_ENUM GapMode)
+{
+  if ( (SamplingRate < MIN_PREAMP_SAMPLING_RATE || SamplingRate > MAX_PREAMP_SAMPLING_RATE) ||
+       (GapMode != PREAMP_GAP_FLAG && GapMode != PREAMP_GAP_INTERPOLATE) )
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  // Continuity state is shared by the stream reads
+  CHALLock obStrmLock(GetStrmLock());
+
+  m_unPeriodUs = (MAX_PREAMP_SAMPLING_RATE == SamplingRate) ? 0 : s_aunSamplingPeriodUs[SamplingRate];
+  m_eGapMode = GapMode;
+
+  return ERR_SUCCESS;
+}
+
+// Stream continuity counters
+int CPreampStream::GetStreamStats (PreampStreamStatsStruct *Stats)
+{
+  if (NULL == Stats)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  CHALLock obStrmLock(GetStrmLock());
+  *Stats = m_stStreamStats;
+
+  return ERR_SUCCESS;
+}
+
+void CPreampStream::ResetStreamStats ()
+{
+  CHALLock obStrmLock(GetStrmLock());
+  memset(&m_stStreamStats, 0, sizeof (m_stStreamStats));
 }
 
 //Flushes the contents of the Named Pipe that is used for streaming data for this device.
 int CPreampStream::Flush()
 {
+  CHALLock obStrmLock(GetStrmLock());
+
   if (m_pobCAN)
   {
     return m_pobCAN->CANFlushStreamPipe ();
@@ -618,6 +955,23 @@ int CPreampStream::Flush()
   }
 }
 
+// Returns the file descriptor that becomes readable when streaming data arrives
+// for this device (for select() / CHALReactor)
+int CPreampStream::GetRxStreamingFd()
+{
+  int nRetVal = ERR_SUCCESS;
+  if (m_pobCAN)
+  {
+    nRetVal = m_pobCAN->CANGetRxStrmFd();
+  }
+  else
+  {
+    nRetVal = ERR_INTERNAL_ERR;
+    DEBUG2("CPreampStream::GetRxStreamingFd(): Unexpected invalid pointer!");
+  }
+  return nRetVal;
+}
+
 // Starts / Stops broadcast for all channels in a preamp. Added this API to prevent 
 // the start time of the two channels from being affected by communication jitters. This API
 // should be used in Mode 1 (1 Stream, 2 Detectors, 1 Method) to prevent a lag between 
@@ -655,6 +1009,9 @@ int CPreampStream::SetAllChBroadcastMode(unsigned char Start, bool doInitOnly /*
           }
           else
           {
+            // The stream state must not change under a reader
+            CHALLock obStrmLock(GetStrmLock());
+
             //Flush existing data
             Flush();
             m_bStreamingStarted = TRUE;
@@ -663,7 +1020,12 @@ int CPreampStream::SetAllChBroadcastMode(unsigned char Start, bool doInitOnly /*
             m_usStartTimeStamp = 0;
             m_unBridgeData = 0;
             m_bRxFirstTimeStamp = TRUE;
-            m_vstSpikeFiltData.clear();
+            m_bRxPrevTimeStamp = FALSE;
+            m_obSpikeFilter.Reset();
+            m_unOutQueueHead = 0;
+            m_unOutQueueCount = 0;
+            m_obPeakDetector.Reset();
+            ResetNoiseStats();
             SetCmdAckCommand(&stCmd.byCmdAck, CMD_PREAMP_STR_FN_EN_BROADCAST_ALL);
           }
         }
@@ -738,58 +1100,117 @@ int CPreampStream::SetAllChBroadcastMode(unsigned char Start, bool doInitOnly /*
 }
 
 
-/*Spike Trap
-  Search and remove random spike found in chromatograms. 
-  This works on the following idea proposed by Skip Watkins based on several bad chromatograms
-  seen from several GCs - All spikes ever detected consists of a sinle bad point (provided averaging and filtering is turned 
-  off in the dual-TCD preamp board). This single bad point will have a large offset from the rest of the chromatogram (be it a 
-  peak or the baseline). If we were to see the slope of the chromatogram, you would typically see a large slope associated with 
-  spikes. It is not sufficient to check slope of successive points to detect and fix spikes; this is because valve upsets
-  and backflush (the backflush process onto Det2 and not the backflush valve upset alone) can cause large swings in preamp ADC counts. 
-  Hence, we need a smart way to detect and fix spikes. And here's how - 
-  Detect Spikes - Rate of change of slope at a spike should be significant and the slope before the spike and the slope after the 
-  spike would be of opposite sign.
-  Fix - Identify the data point and replace with an average of the previous and next points. 
-*/
-int CPreampStream::GetFilteredData (unsigned int *BridgeData, unsigned long long *TimeStamp)
+// Select the spike filter applied to the stream data
+int CPreampStream::SetSpikeFilter (SPIKE_FILT_TYPE_ENUM Type, unsigned int WindowSize, int Threshold)
 {
-  int nRetVal = ERR_SUCCESS, nSlope1 = 0, nSlope2 = 0;
+  // Spike filter state is shared by the stream reads
+  CHALLock obStrmLock(GetStrmLock());
 
-  if (SPIKE_FILT_SAMPLE_SIZE == m_vstSpikeFiltData.size())
+  int nRetVal = m_obSpikeFilter.Configure (Type, WindowSize, Threshold);
+  if (nRetVal < 0)
   {
-    // Compute slope with the three points
-    nSlope1 = m_vstSpikeFiltData[1].nBridgeVal - m_vstSpikeFiltData[0].nBridgeVal;
-    nSlope2 = m_vstSpikeFiltData[2].nBridgeVal - m_vstSpikeFiltData[1].nBridgeVal;
-    
-    // Check if there is a sike 
-    if ( ( abs (nSlope1) >= SPIKE_SLOPE_THRESHOLD && abs (nSlope2) >= SPIKE_SLOPE_THRESHOLD) &&
-         ( (nSlope1 < 0 && nSlope2 > 0) || (nSlope1 > 0 && nSlope2 < 0) ) )
+    DEBUG2("CPreampStream::SetSpikeFilter: Invalid filter %d, window %u, threshold %d!", Type, WindowSize, Threshold);
+  }
+
+  return nRetVal;
+}
+
+// Publish the returned samples to shared memory
+int CPreampStream::SetShmBroadcast (BOOL Enable, unsigned int Capacity)
+{
+  // The publisher is used by the stream reads
+  CHALLock obStrmLock(GetStrmLock());
+
+  if (!Enable)
+  {
+    m_obShmPublisher.Close ();
+    return ERR_SUCCESS;
+  }
+
+  if (!m_bIsDevOpen)
+  {
+    DEBUG2("CPreampStream::SetShmBroadcast: Function called before Open Call!");
+    return ERR_INVALID_SEQ;
+  }
+
+  int nRetVal = m_obShmPublisher.Open (m_szDevName, Capacity);
+  if (nRetVal < 0)
+  {
+    DEBUG2("CPreampStream::SetShmBroadcast: %s - shared memory failed with error code %d!", m_szDevName, nRetVal);
+  }
+
+  return nRetVal;
+}
+
+// Run peak detection on the returned samples
+int CPreampStream::SetPeakDetect (BOOL Enable, const PeakDetectConfigStruct *Config)
+{
+  // The detector is used by the stream reads
+  CHALLock obStrmLock(GetStrmLock());
+
+  if (Enable && Config)
+  {
+    int nRetVal = m_obPeakDetector.Configure (*Config);
+    if (nRetVal < 0)
     {
-      // We trapped a spike! Fix it! 
-      
-      DEBUG1 ("SPIKE! %s, %d, %d, %d", 
-              m_szDevName, 
-              m_vstSpikeFiltData[0].nBridgeVal, 
-              m_vstSpikeFiltData[1].nBridgeVal, 
-              m_vstSpikeFiltData[2].nBridgeVal);
-
-      // New value is the average of the points around the spike
-      m_vstSpikeFiltData[1].nBridgeVal = (m_vstSpikeFiltData[0].nBridgeVal + m_vstSpikeFiltData[2].nBridgeVal) / 2;
-      DEBUG1 ("SPIKE_FIX! Replacing with %d",  m_vstSpikeFiltData[1].nBridgeVal);
+      DEBUG2("CPreampStream::SetPeakDetect: Invalid configuration!");
+      return nRetVal;
     }
+  }
+  else
+  {
+    m_obPeakDetector.Reset ();
+  }
+
+  m_bPeakDetect = Enable;
+  return ERR_SUCCESS;
+}
+
+// Peak events found so far
+int CPreampStream::ReadPeakEvents (PeakEventStruct *Events, unsigned int MaxEvents)
+{
+  if (NULL == Events)
+  {
+    return ERR_INVALID_ARGS;
+  }
 
-    // Return data from the top of this vector and remove that element from our filter queue
-    *BridgeData = m_vstSpikeFiltData[0].nBridgeVal;
-    *TimeStamp = m_vstSpikeFiltData[0].ullTimestamp;
+  CHALLock obStrmLock(GetStrmLock());
+  return m_obPeakDetector.ReadEvents (Events, MaxEvents);
+}
+
+// Keep noise and drift figures of the returned samples
+int CPreampStream::SetNoiseStats (BOOL Enable, const NoiseStatsConfigStruct *Config)
+{
+  CHALLock obNoiseLock(&m_obNoiseLock);
 
-    m_vstSpikeFiltData.erase (m_vstSpikeFiltData.begin());
+  if (Enable && Config)
+  {
+    int nRetVal = m_obNoiseStats.Configure (*Config);
+    if (nRetVal < 0)
+    {
+      DEBUG2("CPreampStream::SetNoiseStats: Invalid configuration!");
+      return nRetVal;
+    }
   }
   else
   {
-    // Unexpected! This function should never be called without enough pionts to filter!
-    nRetVal = ERR_INTERNAL_ERR;
+    m_obNoiseStats.Reset ();
   }
-  return nRetVal;
+
+  m_bNoiseStats = Enable;
+  return ERR_SUCCESS;
+}
+
+int CPreampStream::GetNoiseStats (unsigned int Window, NoiseStatsStruct *Current, NoiseStatsStruct *Last)
+{
+  CHALLock obNoiseLock(&m_obNoiseLock);
+  return m_obNoiseStats.GetStats (Window, Current, Last);
+}
+
+void CPreampStream::ResetNoiseStats ()
+{
+  CHALLock obNoiseLock(&m_obNoiseLock);
+  m_obNoiseStats.Reset ();
 }
 
 // Set Cycle Clock associated with this detector.
@@ -22,26 +22,28 @@
 
 #include <string.h>
 #include <errno.h>
-#include <sys/time.h>
+#include <sys/stat.h>
 #include "debug.h"
 #include "PreampStreamSim.h"
 
-CDetNameToRawFileMapping CPreampStreamSim::m_oDetMapping;
-bool CPreampStreamSim::m_bDelayAssigned = false; 
-
-double dTotalElapsedTime = 0.0;
-int nTotalNumSamples = 0; 
-
 CPreampStreamSim::CPreampStreamSim()  // Default Constructor
 {
   m_bIsDevOpen = false;
   m_bStreamingStarted = false; 
   m_pRawDataFileFd = NULL; 
+  m_unSimFileSample = 0;
+  m_unPeriodMs = PREAMP_SIM_DFLT_PERIOD_MS;
   m_nBridgeData = 0;
   m_ullTimeStamp = 0; 
   m_nNumDetSimulationFiles = 0;
   m_nDetFileInUse = 0;
-  m_bOkToSleep = false; 
+  m_stSource.eSource = PREAMP_SIM_NONE;
+  m_stSource.unNumFiles = 0;
+  m_stSource.unChannel = 0;
+  m_pobClock = CSimClock::GetDefault();
+  m_ullStartDevUs = 0;
+  m_bPeakDetect = false;
+  m_bNoiseStats = false;
 }
 
 CPreampStreamSim::~CPreampStreamSim() // Destructor
@@ -79,6 +81,8 @@ int CPreampStreamSim::CloseHal ()
     SetBroadcastMode(false); 
   }
   
+  m_obShmPublisher.Close();
+
   // Get ready for next "Open" call
   m_sDevName.clear();
   m_bIsDevOpen = false; 
@@ -89,6 +93,8 @@ int CPreampStreamSim::CloseHal ()
 int CPreampStreamSim::SetBroadcastMode (unsigned char Start)
 {
   int nRetVal = ERR_SUCCESS;
+
+  CHALLock obLock(&m_obLock);
     
   // Check if the device is open!
   if (m_bIsDevOpen)
@@ -102,33 +108,24 @@ int CPreampStreamSim::SetBroadcastMode (unsigned char Start)
       }
       else
       {
-        dTotalElapsedTime = 0; 
-        nTotalNumSamples = 0; 
-        
         nRetVal = OpenRawDataFile ();
         if (nRetVal == ERR_SUCCESS)
         {
           m_bStreamingStarted = TRUE;
-          m_ullTimeStamp = 0;
           m_nBridgeData = 0; 
         }
-        
-        if (!m_bDelayAssigned) 
-        {
-          m_bDelayAssigned = true; // Turn ON for the 1st instance ONLY
-          m_bOkToSleep = true;
-        }
 
+        // Time stamps count from here, also for a stream read without its data file
+        m_ullTimeStamp = 0;
+        m_obPeakDetector.Reset ();
+        ResetNoiseStats ();
+        m_ullStartDevUs = m_pobClock->GetTimeUs ();
       }
     }
     else // (0 == Start) Stop Broadcast
     {
       CloseRawDataFile ();
       m_bStreamingStarted = FALSE;
-      m_bDelayAssigned = false;
-      m_bOkToSleep = false; 
-
-      //printf ("Avg Elapsed Time = %g\n", dTotalElapsedTime/nTotalNumSamples);
     }
   }
   else
@@ -143,12 +140,57 @@ int CPreampStreamSim::SetBroadcastMode (unsigned char Start)
 
 int CPreampStreamSim::ReadStreamData (unsigned int *BridgeData, unsigned long long *TimeStamp)
 {
-  return ReadRawDataFile ( (int*)BridgeData, TimeStamp);
+  int nRetVal;
+  unsigned long long ullDueUs;
+  CSimClock *pobClock;
+
+  {
+    CHALLock obLock(&m_obLock);
+    nRetVal = ReadRawDataFile ( (int*)BridgeData, TimeStamp);
+    ullDueUs = m_ullStartDevUs + m_ullTimeStamp * 1000;
+    pobClock = m_pobClock;
+  }
+
+  // Return the sample at its device time. Waiting without the lock lets the other
+  // calls go on during the sample period.
+  pobClock->WaitUntilUs (ullDueUs);
+
+  return nRetVal;
 }
 
 int CPreampStreamSim::OpenRawDataFile ()
 {
+  m_unSimFileSample = 0;
+  m_unPeriodMs = PREAMP_SIM_DFLT_PERIOD_MS;
+
+  if (PREAMP_SIM_SYNTHETIC == m_stSource.eSource)
+  {
+    m_obSynth.Reset ();
+    m_unPeriodMs = m_stSource.stSynth.unPeriodMs;
+    return ERR_SUCCESS;
+  }
+
+  if (PREAMP_SIM_CAPTURE == m_stSource.eSource)
+  {
+    int nRetVal = m_obSimFile.Open (m_stSource.sFile.c_str());
+    if (nRetVal == ERR_SUCCESS && m_stSource.unChannel >= m_obSimFile.GetHeader()->unNumChannels)
+    {
+      DEBUG1 ("%s has no channel %u.", m_stSource.sFile.c_str(), m_stSource.unChannel);
+      m_obSimFile.Close ();
+      nRetVal = ERR_INVALID_ARGS;
+    }
+    if (nRetVal == ERR_SUCCESS && m_obSimFile.GetHeader()->unPeriodUs >= 1000)
+    {
+      m_unPeriodMs = m_obSimFile.GetHeader()->unPeriodUs / 1000;
+    }
+    return nRetVal;
+  }
+
   std::string sFilePath = GetNextFile ();
+  if (OpenSimFile (sFilePath) == ERR_SUCCESS)
+  {
+    return ERR_SUCCESS;
+  }
   
   m_pRawDataFileFd = fopen (sFilePath.c_str(), "r");
   if (m_pRawDataFileFd != NULL)
@@ -162,8 +204,44 @@ int CPreampStreamSim::OpenRawDataFile ()
   }
 }
 
+// Map the binary copy of a raw data file, making it first if it is missing or older
+// than the raw data file
+int CPreampStreamSim::OpenSimFile (const std::string &sRawFilePath)
+{
+  struct stat stRaw, stBin;
+  std::string sBinFilePath = sRawFilePath;
+
+  std::string::size_type nExt = sBinFilePath.rfind (".raw");
+  if (nExt != std::string::npos && nExt + 4 == sBinFilePath.size())
+  {
+    sBinFilePath.erase (nExt);
+  }
+  sBinFilePath += ".bin";
+
+  if (stat (sBinFilePath.c_str(), &stBin) != 0 ||
+      (stat (sRawFilePath.c_str(), &stRaw) == 0 && stRaw.st_mtime > stBin.st_mtime))
+  {
+    int nRetVal = CPreampSimFile::ConvertTextFile (sRawFilePath.c_str(), sBinFilePath.c_str());
+    if (nRetVal != ERR_SUCCESS)
+    {
+      return nRetVal;
+    }
+  }
+
+  int nRetVal = m_obSimFile.Open (sBinFilePath.c_str());
+  if (nRetVal == ERR_SUCCESS)
+  {
+    unsigned int unPeriodMs = m_obSimFile.GetHeader()->unPeriodUs / 1000;
+    m_unPeriodMs = (unPeriodMs > 0) ? unPeriodMs : PREAMP_SIM_DFLT_PERIOD_MS;
+  }
+
+  return nRetVal;
+}
+
 int CPreampStreamSim::CloseRawDataFile ()
 {
+  m_obSimFile.Close ();
+
   if (m_pRawDataFileFd != NULL) 
   {
     fclose (m_pRawDataFileFd);
@@ -176,17 +254,27 @@ int CPreampStreamSim::CloseRawDataFile ()
 int CPreampStreamSim::ReadRawDataFile (int *Data, unsigned long long *TimeStamp)
 {
   char szBuffer [200];
-  timeval start, end, diff; 
-  gettimeofday (&start, NULL);
 
   // Increment Timestamp, upper layer expects the timestamp to increment by 20ms for each sample
-  m_ullTimeStamp += 20; 
+  m_ullTimeStamp += m_unPeriodMs; 
   *TimeStamp = m_ullTimeStamp;
 
   // Initialize return value just in case we can't open Det Data File or if Anly Time > the data the file contains
   *Data = m_nBridgeData;
   
-  if (m_pRawDataFileFd != NULL)
+  if (PREAMP_SIM_SYNTHETIC == m_stSource.eSource)
+  {
+    *Data = m_obSynth.Next ();
+  }
+  else if (m_obSimFile.IsOpen ())
+  {
+    if (m_unSimFileSample < m_obSimFile.GetNumSamples ())
+    {
+      *Data = m_obSimFile.GetSample (m_unSimFileSample++, m_stSource.unChannel);
+      m_nBridgeData = *Data;
+    }
+  }
+  else if (m_pRawDataFileFd != NULL)
   {
     char* szTemp = fgets (szBuffer, 200, m_pRawDataFileFd);
     if (szTemp != NULL)
@@ -200,23 +288,132 @@ int CPreampStreamSim::ReadRawDataFile (int *Data, unsigned long long *TimeStamp)
     }
   }
 
-  gettimeofday (&end, NULL);
-  DiffTime (start, end, &diff);
-  int nElapsedTime_us = diff.tv_sec * 1000000 + diff.tv_usec;
-  if (nElapsedTime_us < 18000 && m_bOkToSleep) usleep (18000 - nElapsedTime_us);
+  if (m_obShmPublisher.IsOpen ())
+  {
+    m_obShmPublisher.Publish (*Data, *TimeStamp, 0);
+  }
 
-  dTotalElapsedTime += nElapsedTime_us;
-  ++nTotalNumSamples;
+  if (m_bPeakDetect)
+  {
+    m_obPeakDetector.Push (*Data, *TimeStamp);
+  }
+
+  {
+    // The flag is set by SetNoiseStats() under the same lock
+    CHALLock obNoiseLock(&m_obNoiseLock);
+    if (m_bNoiseStats)
+    {
+      m_obNoiseStats.Push (*Data, *TimeStamp);
+    }
+  }
 
   return ERR_SUCCESS;
 }
 
 bool CPreampStreamSim::IsSimulationEnabled (std::string sDetName)
 {
+  CPreampSimSources::GetSource (sDetName.c_str(), &m_stSource);
+
+  if (PREAMP_SIM_SYNTHETIC == m_stSource.eSource &&
+      m_obSynth.Configure (m_stSource.stSynth) != ERR_SUCCESS)
+  {
+    DEBUG1 ("Invalid synthetic source for %s, using the detector.", sDetName.c_str());
+    m_stSource.eSource = PREAMP_SIM_NONE;
+  }
+
   // How many Raw Data Files should we cycle through? 
-  m_nNumDetSimulationFiles = m_oDetMapping.IsSimulationEnabled(sDetName);
+  m_nNumDetSimulationFiles = m_stSource.unNumFiles;
+
+  return (m_stSource.eSource != PREAMP_SIM_NONE);
+}
+
+int CPreampStreamSim::SetShmBroadcast (bool Enable, unsigned int Capacity)
+{
+  CHALLock obLock(&m_obLock);
+
+  if (!Enable)
+  {
+    m_obShmPublisher.Close ();
+    return ERR_SUCCESS;
+  }
+
+  if (!m_bIsDevOpen)
+  {
+    return ERR_INVALID_SEQ;
+  }
+
+  return m_obShmPublisher.Open (m_sDevName.c_str(), Capacity);
+}
+
+int CPreampStreamSim::SetPeakDetect (bool Enable, const PeakDetectConfigStruct *Config)
+{
+  CHALLock obLock(&m_obLock);
+
+  if (Enable && Config)
+  {
+    int nRetVal = m_obPeakDetector.Configure (*Config);
+    if (nRetVal < 0)
+    {
+      return nRetVal;
+    }
+  }
+  else
+  {
+    m_obPeakDetector.Reset ();
+  }
 
-  return (m_nNumDetSimulationFiles > 0);
+  m_bPeakDetect = Enable;
+  return ERR_SUCCESS;
+}
+
+int CPreampStreamSim::ReadPeakEvents (PeakEventStruct *Events, unsigned int MaxEvents)
+{
+  if (NULL == Events)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  CHALLock obLock(&m_obLock);
+  return m_obPeakDetector.ReadEvents (Events, MaxEvents);
+}
+
+int CPreampStreamSim::SetNoiseStats (bool Enable, const NoiseStatsConfigStruct *Config)
+{
+  CHALLock obNoiseLock(&m_obNoiseLock);
+
+  if (Enable && Config)
+  {
+    int nRetVal = m_obNoiseStats.Configure (*Config);
+    if (nRetVal < 0)
+    {
+      return nRetVal;
+    }
+  }
+  else
+  {
+    m_obNoiseStats.Reset ();
+  }
+
+  m_bNoiseStats = Enable;
+  return ERR_SUCCESS;
+}
+
+int CPreampStreamSim::GetNoiseStats (unsigned int Window, NoiseStatsStruct *Current, NoiseStatsStruct *Last)
+{
+  CHALLock obNoiseLock(&m_obNoiseLock);
+  return m_obNoiseStats.GetStats (Window, Current, Last);
+}
+
+void CPreampStreamSim::ResetNoiseStats ()
+{
+  CHALLock obNoiseLock(&m_obNoiseLock);
+  m_obNoiseStats.Reset ();
+}
+
+void CPreampStreamSim::SetClock (CSimClock *pobClock)
+{
+  CHALLock obLock(&m_obLock);
+  m_pobClock = pobClock ? pobClock : CSimClock::GetDefault();
 }
 
 std::string CPreampStreamSim::GetNextFile ()
@@ -226,7 +423,7 @@ std::string CPreampStreamSim::GetNextFile ()
   if (++m_nDetFileInUse > m_nNumDetSimulationFiles) 
     m_nDetFileInUse = 1;
 
-  std::string sRawDataTemplatePath = m_oDetMapping.GetRawFileTemplatePath(m_sDevName);
+  std::string sRawDataTemplatePath = m_stSource.sFile;
 
   sprintf (szDetFilePath, sRawDataTemplatePath.c_str(), m_nDetFileInUse);
   DEBUG1 ("Next File to use: %d, %s\n", m_nDetFileInUse, szDetFilePath);
@@ -20,6 +20,7 @@
  * *
  * *************************************************************************/
 
+#include <string.h>
 #include "PreampStreamWrapper.h"
 
 CPreampStreamWrapper::CPreampStreamWrapper()  // Default Constructor
@@ -70,6 +71,27 @@ int CPreampStreamWrapper::ReadStreamData (unsigned int *BridgeData, unsigned lon
     return m_oPreampStrmHW.ReadStreamData (BridgeData, TimeStamp, Timeout);
 }
 
+// Read up to MaxSamples samples into the caller's arrays
+int CPreampStreamWrapper::ReadStreamDataBatch (unsigned int *BridgeData, unsigned long long *TimeStamp, unsigned char *Flags,
+                                               unsigned int MaxSamples, unsigned int Timeout)
+{
+  if (m_bSimulate)
+  {
+    if ( (NULL == BridgeData) || (NULL == TimeStamp) || (0 == MaxSamples) )
+      return ERR_INVALID_ARGS;
+
+    int nRetVal = m_oPreampStrmSim.ReadStreamData (BridgeData, TimeStamp);
+    if (nRetVal < 0)
+      return nRetVal;
+
+    if (Flags)
+      Flags[0] = 0;
+    return 1;
+  }
+  else
+    return m_oPreampStrmHW.ReadStreamDataBatch (BridgeData, TimeStamp, Flags, MaxSamples, Timeout);
+}
+
 // Read stream data, block on read
 int CPreampStreamWrapper::ReadStreamDataBlocking (unsigned int *BridgeData, unsigned long long *TimeStamp)
 {
@@ -118,6 +140,89 @@ int CPreampStreamWrapper::SetAllChBroadcastMode(unsigned char Start, bool doInit
     return m_oPreampStrmHW.SetAllChBroadcastMode(Start, doInitOnly);
 }
 
+// Select the spike filter
+int CPreampStreamWrapper::SetSpikeFilter (SPIKE_FILT_TYPE_ENUM Type, unsigned int WindowSize, int Threshold)
+{
+  if (m_bSimulate)
+    return ERR_SUCCESS;
+  else
+    return m_oPreampStrmHW.SetSpikeFilter(Type, WindowSize, Threshold);
+}
+
+// Check the stream for missing, duplicate and out of order samples
+int CPreampStreamWrapper::SetStreamCheck (PREAMP_SAMPLING_RATE_ENUM SamplingRate, PREAMP_GAP_MODE_ENUM GapMode)
+{
+  if (m_bSimulate)
+    return ERR_SUCCESS;
+  else
+    return m_oPreampStrmHW.SetStreamCheck(SamplingRate, GapMode);
+}
+
+// Stream continuity counters
+int CPreampStreamWrapper::GetStreamStats (PreampStreamStatsStruct *Stats)
+{
+  if (m_bSimulate)
+  {
+    if (NULL == Stats)
+      return ERR_INVALID_ARGS;
+    memset(Stats, 0, sizeof (*Stats));
+    return ERR_SUCCESS;
+  }
+  else
+    return m_oPreampStrmHW.GetStreamStats(Stats);
+}
+
+// Publish the returned samples to shared memory
+int CPreampStreamWrapper::SetShmBroadcast (BOOL Enable, unsigned int Capacity)
+{
+  if (m_bSimulate)
+    return m_oPreampStrmSim.SetShmBroadcast(Enable, Capacity);
+  else
+    return m_oPreampStrmHW.SetShmBroadcast(Enable, Capacity);
+}
+
+// Peak detection on the returned samples
+int CPreampStreamWrapper::SetPeakDetect (BOOL Enable, const PeakDetectConfigStruct *Config)
+{
+  if (m_bSimulate)
+    return m_oPreampStrmSim.SetPeakDetect(Enable, Config);
+  else
+    return m_oPreampStrmHW.SetPeakDetect(Enable, Config);
+}
+
+// Peak events found so far
+int CPreampStreamWrapper::ReadPeakEvents (PeakEventStruct *Events, unsigned int MaxEvents)
+{
+  if (m_bSimulate)
+    return m_oPreampStrmSim.ReadPeakEvents(Events, MaxEvents);
+  else
+    return m_oPreampStrmHW.ReadPeakEvents(Events, MaxEvents);
+}
+
+// Noise and drift figures of the returned samples
+int CPreampStreamWrapper::SetNoiseStats (BOOL Enable, const NoiseStatsConfigStruct *Config)
+{
+  if (m_bSimulate)
+    return m_oPreampStrmSim.SetNoiseStats(Enable, Config);
+  else
+    return m_oPreampStrmHW.SetNoiseStats(Enable, Config);
+}
+
+// Figures of a window so far and of its last complete window
+int CPreampStreamWrapper::GetNoiseStats (unsigned int Window, NoiseStatsStruct *Current, NoiseStatsStruct *Last)
+{
+  if (m_bSimulate)
+    return m_oPreampStrmSim.GetNoiseStats(Window, Current, Last);
+  else
+    return m_oPreampStrmHW.GetNoiseStats(Window, Current, Last);
+}
+
+// Clock pacing the simulator
+void CPreampStreamWrapper::SetSimClock (CSimClock *pobClock)
+{
+  m_oPreampStrmSim.SetClock(pobClock);
+}
+
 // Set Cycle Clock associated with this detector.
 int CPreampStreamWrapper::SetCycleClock (unsigned int cycleClock)
 {
@@ -86,21 +86,35 @@
  * *
  * *************************************************************************/
 
+#include <string.h>
 #include "Definitions.h"
   
 #include "debug.h"
 #include "Reliability.h"
+#include "SlotHealth.h"
+#include "HALTrace.h"
+
+CReliability::SlotRttStruct CReliability::m_astSlotRtt[RELIABILITY_NUM_SLOT_ADDR];
+pthread_mutex_t CReliability::m_SlotRttMutex = PTHREAD_MUTEX_INITIALIZER;
 
 CReliability::CReliability(CCANComm *pobCANComm) // Default Constructor
 {
   m_pobCANComm = pobCANComm;
   m_nRetryCount = MAX_NO_RETRIES;
+  m_bAdaptiveTimeOut = TRUE;
+  m_bProbeChannelRegistered = FALSE;
 
   m_nRetryAttempts = 0;
+
+  ResetStats();
 }
 
 CReliability::~CReliability() // Default Destructor
 {
+  if (m_bProbeChannelRegistered)
+  {
+    CSlotHealth::UnregisterChannel(m_pobCANComm);
+  }
 }
 
 
@@ -122,44 +136,472 @@ int CReliability::GetRemoteResp (unsigned char* pbyCmd, // Data to form command
                                  unsigned char *pbyRespData,    // Pointer to write device response to
                                  unsigned int unNumBytesResp, // Number of bytes expected from remote device
                                  BOOL bStreamingTx,   // Indicates if we are transmitting streaming data
-                                 unsigned int unTimeOut)         // Time to wait for response from remote device
+                                 unsigned int unTimeOut,         // Time to wait for response from remote device
+                                 const struct timespec *pstDeadline) // Deadline for the whole transaction
 {
   int nRetries = m_nRetryCount;
   int nRetVal = 0;
+  int nAttempt = 0;
+  int nAttemptsMade = 0;
+  unsigned long long ullDeadlineUs = 0;
+  unsigned long long ullStartUs = 0;
+  BOOL bDeadlineLimited = FALSE;
+  unsigned char bySlotID;
 
   if (NULL == m_pobCANComm)
   {
     return ERR_MEMORY_ERR;
   }
 
+  // No other thread's command may go out (or take our response) until we are done
+  CHALLock obCmdLock(m_pobCANComm->GetCmdLock());
+
+  bySlotID = m_pobCANComm->GetSlotID();
+
+  // Let the slot health probe use this channel while the slot is offline
+  if (!m_bProbeChannelRegistered)
+  {
+    CSlotHealth::RegisterChannel(m_pobCANComm);
+    m_bProbeChannelRegistered = TRUE;
+  }
+
+  // Fail right away if the board has stopped responding
+  if (!CSlotHealth::IsRequestAllowed(bySlotID))
+  {
+    m_stStats.ulSlotOffline++;
+    m_nRetryAttempts = 0;
+    return ERR_SLOT_OFFLINE;
+  }
+
+  if (pstDeadline)
+  {
+    ullDeadlineUs = (unsigned long long)pstDeadline->tv_sec * 1000000ULL + pstDeadline->tv_nsec / 1000;
+  }
+
+  m_stStats.ulTransactions++;
+
   do
   {
+    unsigned int unAttemptTimeOut = unTimeOut;
+    if (m_bAdaptiveTimeOut && unTimeOut <= HAL_DFLT_TIMEOUT)
+    {
+      unAttemptTimeOut = GetAttemptTimeOut(nAttempt, unTimeOut);
+    }
+
+    ullStartUs = GetMonotonicTimeUs();
+
+    // Do not wait past the caller's deadline. Less than 1 ms left would be a 0 ms
+    // wait, which still sends the command and counts as a failed attempt.
+    if (pstDeadline)
+    {
+      if (ullStartUs + 1000 > ullDeadlineUs)
+      {
+        DEBUG2("CReliability::GetRemoteResp() - deadline expired.");
+        m_stStats.ulDeadlineExpired++;
+        nRetVal = ERR_TIMEOUT;
+        break;
+      }
+      if ((ullDeadlineUs - ullStartUs) / 1000 < unAttemptTimeOut)
+      {
+        unAttemptTimeOut = (ullDeadlineUs - ullStartUs) / 1000;
+        bDeadlineLimited = TRUE;
+      }
+    }
 
     // Send a command and wait for ackowledgement from remote device
+    nAttemptsMade++;
+    m_stStats.ulRoundTrips++;
     nRetVal = m_pobCANComm->CANGetRemoteResp(pbyCmd,             // Command
                                              unNumBytesCmd,      // Size of command
                                              pbyRespData,        // Response from remote board
                                              unNumBytesResp,     // Size of expected response
                                              bStreamingTx,       // Streaming TX or not
-                                             unTimeOut);         // Time to wait for response
+                                             unAttemptTimeOut);  // Time to wait for response
+
+    if (CHALTrace::IsEnabled())
+    {
+      CHALTrace::Record(HAL_TRACE_ATTEMPT, NULL, bySlotID, GetCmdAckCommand(pbyCmd), 0, ullStartUs, nAttemptsMade, nRetVal);
+    }
 
     if (nRetVal >= 0)
     {
+      // Only first attempts give an unambiguous round trip time - a response to a
+      // retry may just as well be the late response to an earlier attempt.
+      if (0 == nAttempt && unTimeOut <= HAL_DFLT_TIMEOUT)
+      {
+        UpdateRtt((unsigned int)(GetMonotonicTimeUs() - ullStartUs));
+      }
       break;
     }
     if (nRetries > 0)
     {
-      DEBUG2("CReliability::GetRemoteResp() - timed out.");
+      DEBUG2("CReliability::GetRemoteResp() - timed out after %u ms.", unAttemptTimeOut);
     }
     nRetries--;
+    nAttempt++;
   } while (nRetries > 0);
 
 
   m_nRetryAttempts = m_nRetryCount - nRetries;
 
+  if (nAttemptsMade > 1)
+  {
+    m_stStats.ulRetries += nAttemptsMade - 1;
+  }
+  if (nRetVal < 0)
+  {
+    m_stStats.ulFailures++;
+  }
+
+  // Tell the slot health state whether the board answered. Attempts cut short by
+  // the caller's deadline are no evidence of a dead board.
+  if (nRetVal >= 0 || ERR_PROTOCOL == nRetVal || ERR_WRONG_CRC == nRetVal)
+  {
+    CSlotHealth::ReportResult(bySlotID, TRUE);
+  }
+  else if (ERR_TIMEOUT == nRetVal && nAttemptsMade > 0 && !bDeadlineLimited)
+  {
+    CSlotHealth::ReportResult(bySlotID, FALSE);
+  }
+
   return nRetVal;
 }
 
+// Send a batch of commands back to back and collect their responses
+int CReliability::GetRemoteRespBatch (CDevTxn **apobTxn,  // Commands to send, responses written back
+                                      int nNumTxn,         // Number of commands
+                                      unsigned int unTimeOut, // Time to wait for each response
+                                      BOOL bStreamingTx)   // Indicates if we are transmitting streaming data
+{
+  int nRetVal = ERR_SUCCESS;
+  int nNext = 0;
+  int nSent = 0;
+  int nAnswered = 0;
+  unsigned long long ullStartUs = 0;
+  unsigned char bySlotID;
+
+  if (NULL == m_pobCANComm)
+  {
+    return ERR_MEMORY_ERR;
+  }
+
+  // The whole batch is one exchange
+  CHALLock obCmdLock(m_pobCANComm->GetCmdLock());
+
+  if (NULL == apobTxn || nNumTxn <= 0 || nNumTxn > MAX_DEV_TXN_BATCH)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  for (int nTxn = 0; nTxn < nNumTxn; nTxn++)
+  {
+    if (NULL == apobTxn[nTxn])
+    {
+      return ERR_INVALID_ARGS;
+    }
+    apobTxn[nTxn]->SetRespBytes(ERR_TIMEOUT);
+  }
+
+  // Nothing to pipeline
+  if (1 == nNumTxn)
+  {
+    apobTxn[0]->SetRespBytes(GetRemoteResp(apobTxn[0]->GetCmdBuf(), apobTxn[0]->GetCmdLen(),
+                                           apobTxn[0]->GetRespBuf(), apobTxn[0]->GetRespLen(),
+                                           bStreamingTx, unTimeOut));
+    return ERR_SUCCESS;
+  }
+
+  bySlotID = m_pobCANComm->GetSlotID();
+
+  if (!m_bProbeChannelRegistered)
+  {
+    CSlotHealth::RegisterChannel(m_pobCANComm);
+    m_bProbeChannelRegistered = TRUE;
+  }
+
+  if (!CSlotHealth::IsRequestAllowed(bySlotID))
+  {
+    m_stStats.ulSlotOffline += nNumTxn;
+    for (int nTxn = 0; nTxn < nNumTxn; nTxn++)
+    {
+      apobTxn[nTxn]->SetRespBytes(ERR_SLOT_OFFLINE);
+    }
+    return ERR_SUCCESS;
+  }
+
+  m_stStats.ulTransactions += nNumTxn;
+  m_stStats.ulRoundTrips++;
+
+  // Stale responses to earlier (timed out) commands must not be taken for ours
+  m_pobCANComm->CANFlushCmdRespPipe();
+
+  ullStartUs = GetMonotonicTimeUs();
+
+  // Send all the commands without waiting in between
+  for (nSent = 0; nSent < nNumTxn; nSent++)
+  {
+    nRetVal = m_pobCANComm->CANTxCmd(apobTxn[nSent]->GetCmdBuf(), apobTxn[nSent]->GetCmdLen(), bStreamingTx);
+    if (nRetVal < 0)
+    {
+      DEBUG2("CReliability::GetRemoteRespBatch() - CANTxCmd failed with error code %d!", nRetVal);
+      break;
+    }
+  }
+
+  // Collect the responses. Each is read into the buffer of the next command still 
+  // waiting - if it turns out to be the response to a later command, the commands
+  // skipped over have lost their response and it is moved to where it belongs.
+  while (nNext < nSent)
+  {
+    unsigned int unAttemptTimeOut = unTimeOut;
+    if (m_bAdaptiveTimeOut && unTimeOut <= HAL_DFLT_TIMEOUT)
+    {
+      unAttemptTimeOut = GetAttemptTimeOut(0, unTimeOut);
+    }
+
+    CDevTxn *pobTxn = apobTxn[nNext];
+    nRetVal = m_pobCANComm->CANRxCmdRespTimeout(pobTxn->GetRespBuf(), pobTxn->GetRespLen(), unAttemptTimeOut);
+    if (ERR_TIMEOUT == nRetVal)
+    {
+      // Everything still outstanding is lost
+      break;
+    }
+    if (nRetVal < 0)
+    {
+      // Garbled - can't tell whose it was, retry this one on its own
+      pobTxn->SetRespBytes(nRetVal);
+      nNext++;
+      continue;
+    }
+
+    if (0 == nAnswered++)
+    {
+      UpdateRtt((unsigned int)(GetMonotonicTimeUs() - ullStartUs));
+    }
+
+    unsigned char byCommand = GetCmdAckCommand(pobTxn->GetRespBuf());
+    if (byCommand == pobTxn->GetCommand())
+    {
+      pobTxn->SetRespBytes(nRetVal);
+      nNext++;
+      continue;
+    }
+
+    int nMatch = nNext + 1;
+    while (nMatch < nSent && apobTxn[nMatch]->GetCommand() != byCommand)
+    {
+      nMatch++;
+    }
+
+    if (nMatch < nSent && (unsigned int)nRetVal <= apobTxn[nMatch]->GetRespLen())
+    {
+      memcpy(apobTxn[nMatch]->GetRespBuf(), pobTxn->GetRespBuf(), nRetVal);
+      apobTxn[nMatch]->SetRespBytes(nRetVal);
+      nNext = nMatch + 1;
+    }
+    else
+    {
+      // Late response to a command from before this batch - drop it
+      DEBUG2("CReliability::GetRemoteRespBatch() - dropped response to command %d.", byCommand);
+    }
+  }
+
+  if (nAnswered > 0)
+  {
+    CSlotHealth::ReportResult(bySlotID, TRUE);
+  }
+
+  // A response is given to the next request waiting with its command. If a command
+  // repeats and one of its responses went missing, the ones received may sit with
+  // the wrong request - none of them can be trusted.
+  for (int nTxn = 0; nTxn < nSent; nTxn++)
+  {
+    if (apobTxn[nTxn]->GetRespBytes() >= 0)
+    {
+      continue;
+    }
+    for (int nDup = 0; nDup < nSent; nDup++)
+    {
+      if (apobTxn[nDup]->GetCommand() == apobTxn[nTxn]->GetCommand() && apobTxn[nDup]->GetRespBytes() >= 0)
+      {
+        apobTxn[nDup]->SetRespBytes(ERR_TIMEOUT);
+        m_stStats.ulBatchAmbiguous++;
+      }
+    }
+  }
+
+  // Anything without a valid response gets the usual retry sequence on its own
+  for (int nTxn = 0; nTxn < nNumTxn; nTxn++)
+  {
+    if (apobTxn[nTxn]->GetRespBytes() < 0)
+    {
+      // Counted again by GetRemoteResp
+      m_stStats.ulTransactions--;
+      apobTxn[nTxn]->SetRespBytes(GetRemoteResp(apobTxn[nTxn]->GetCmdBuf(), apobTxn[nTxn]->GetCmdLen(),
+                                                apobTxn[nTxn]->GetRespBuf(), apobTxn[nTxn]->GetRespLen(),
+                                                bStreamingTx, unTimeOut));
+      if (ERR_SLOT_OFFLINE == apobTxn[nTxn]->GetRespBytes())
+      {
+        // Slot just went offline - don't try the rest
+        for (nTxn++; nTxn < nNumTxn; nTxn++)
+        {
+          if (apobTxn[nTxn]->GetRespBytes() < 0)
+          {
+            apobTxn[nTxn]->SetRespBytes(ERR_SLOT_OFFLINE);
+          }
+        }
+      }
+    }
+  }
+
+  return ERR_SUCCESS;
+}
+
+// Feed a round trip time measurement into the slot's estimator
+void CReliability::UpdateRtt(unsigned int unRttUs)
+{
+  unsigned char bySlotID = m_pobCANComm->GetSlotID();
+
+  m_stStats.unLastRttUs = unRttUs;
+  m_stStats.ullTotalRttUs += unRttUs;
+  if (0 == m_stStats.ulRttSamples++ || unRttUs < m_stStats.unMinRttUs)
+  {
+    m_stStats.unMinRttUs = unRttUs;
+  }
+  if (unRttUs > m_stStats.unMaxRttUs)
+  {
+    m_stStats.unMaxRttUs = unRttUs;
+  }
+
+  if (bySlotID >= RELIABILITY_NUM_SLOT_ADDR)
+  {
+    return;
+  }
+
+  // The estimate is shared with the other devices on the slot
+  CHALLock obRttLock(&m_SlotRttMutex);
+
+  SlotRttStruct *pstRtt = &m_astSlotRtt[bySlotID];
+  if (!pstRtt->bValid)
+  {
+    pstRtt->unSRttUs = unRttUs;
+    pstRtt->unRttVarUs = unRttUs / 2;
+    pstRtt->bValid = TRUE;
+  }
+  else
+  {
+    unsigned int unErr = (pstRtt->unSRttUs > unRttUs) ? pstRtt->unSRttUs - unRttUs : unRttUs - pstRtt->unSRttUs;
+    // RTTVAR = 3/4 RTTVAR + 1/4 |SRTT - R|, SRTT = 7/8 SRTT + 1/8 R
+    pstRtt->unRttVarUs = pstRtt->unRttVarUs - (pstRtt->unRttVarUs >> 2) + (unErr >> 2);
+    pstRtt->unSRttUs = pstRtt->unSRttUs - (pstRtt->unSRttUs >> 3) + (unRttUs >> 3);
+  }
+}
+
+// Retry timeout for the given attempt (0 based), capped at unMaxTimeOut. 
+// RTO = SRTT + 4 * RTTVAR, doubled on every retry.
+unsigned int CReliability::GetAttemptTimeOut(int nAttempt, unsigned int unMaxTimeOut)
+{
+  unsigned char bySlotID = m_pobCANComm->GetSlotID();
+  unsigned int unRtoMs = unMaxTimeOut;
+
+  CHALLock obRttLock(&m_SlotRttMutex);
+
+  // No estimate yet - use the caller's time-out
+  if (bySlotID >= RELIABILITY_NUM_SLOT_ADDR || !m_astSlotRtt[bySlotID].bValid)
+  {
+    return unMaxTimeOut;
+  }
+
+  unRtoMs = (m_astSlotRtt[bySlotID].unSRttUs + 4 * m_astSlotRtt[bySlotID].unRttVarUs + 999) / 1000;
+  if (unRtoMs < HAL_MIN_RTO_MS)
+  {
+    unRtoMs = HAL_MIN_RTO_MS;
+  }
+
+  for (int nCount = 0; nCount < nAttempt && unRtoMs < unMaxTimeOut; nCount++)
+  {
+    unRtoMs <<= 1;
+  }
+
+  return (unRtoMs < unMaxTimeOut) ? unRtoMs : unMaxTimeOut;
+}
+
+// Enable / disable round trip time based retry timeouts
+void CReliability::SetAdaptiveTimeOut(BOOL bEnable)
+{
+  m_bAdaptiveTimeOut = bEnable;
+}
+
+// Get the retry and latency statistics of this device
+int CReliability::GetStats(ReliabilityStatsStruct *pstStats)
+{
+  if (NULL == pstStats)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  CHALLock obCmdLock(m_pobCANComm ? m_pobCANComm->GetCmdLock() : NULL);
+
+  *pstStats = m_stStats;
+
+  if (m_pobCANComm)
+  {
+    unsigned char bySlotID = m_pobCANComm->GetSlotID();
+    BOOL bValid = FALSE;
+    if (bySlotID < RELIABILITY_NUM_SLOT_ADDR)
+    {
+      CHALLock obRttLock(&m_SlotRttMutex);
+      bValid = m_astSlotRtt[bySlotID].bValid;
+      if (bValid)
+      {
+        pstStats->unSRttUs = m_astSlotRtt[bySlotID].unSRttUs;
+        pstStats->unRttVarUs = m_astSlotRtt[bySlotID].unRttVarUs;
+      }
+    }
+    if (bValid)
+    {
+      pstStats->unRtoMs = GetAttemptTimeOut(0, HAL_DFLT_TIMEOUT);
+    }
+    else
+    {
+      pstStats->unRtoMs = HAL_DFLT_TIMEOUT;
+    }
+  }
+
+  return ERR_SUCCESS;
+}
+
+// Clear the statistics of this device
+void CReliability::ResetStats()
+{
+  CHALLock obCmdLock(m_pobCANComm ? m_pobCANComm->GetCmdLock() : NULL);
+  memset(&m_stStats, 0, sizeof(m_stStats));
+}
+
+// Fill pstDeadline with the absolute time unMilliSec from now
+void CReliability::MakeDeadline(unsigned int unMilliSec, struct timespec *pstDeadline)
+{
+  if (pstDeadline)
+  {
+    clock_gettime(CLOCK_MONOTONIC, pstDeadline);
+    pstDeadline->tv_sec += unMilliSec / 1000;
+    pstDeadline->tv_nsec += (unMilliSec % 1000) * 1000000L;
+    if (pstDeadline->tv_nsec >= 1000000000L)
+    {
+      pstDeadline->tv_sec++;
+      pstDeadline->tv_nsec -= 1000000000L;
+    }
+  }
+}
+
+// Monotonic time in micro-seconds
+unsigned long long CReliability::GetMonotonicTimeUs()
+{
+  struct timespec stNow;
+  clock_gettime(CLOCK_MONOTONIC, &stNow);
+  return (unsigned long long)stNow.tv_sec * 1000000ULL + stNow.tv_nsec / 1000;
+}
+
 
 //Returns part of the timeout interval that was not used.
 int CReliability::GetRemTimeOut()
@@ -167,6 +609,7 @@ int CReliability::GetRemTimeOut()
   DB_INT32 nRemTimeOut = 0;
   if( m_pobCANComm )
   {
+    CHALLock obCmdLock(m_pobCANComm->GetCmdLock());
     nRemTimeOut = m_pobCANComm->GetRemTimeOut();
   }
 
@@ -180,6 +623,7 @@ int CReliability::TxCmd (unsigned char* pbyCmd,         // Data to form command
 {
   if( m_pobCANComm )
   {
+    CHALLock obCmdLock(m_pobCANComm->GetCmdLock());
     return m_pobCANComm->CANTxCmd(pbyCmd, unNumBytesCmd, bStreamingTx);
   }
   else
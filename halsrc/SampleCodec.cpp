@@ -0,0 +1,160 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                     10241 West Little York, Suite 200
+ * *                            Houston, TX 77040
+ * *
+ * *
+ * *  Filename: SampleCodec.cpp
+ * *
+ * *  Description: Lossless compression of detector sample sequences.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+#include "SampleCodec.h"
+
+// Prediction of the next sample. Unsigned arithmetic, so that any residual wraps
+// around the same way in the encoder and the decoder.
+static inline unsigned int Predict(SAMPLE_CODEC_PREDICTOR_ENUM ePredictor, unsigned int unHistory,
+                                   unsigned int unPrev1, unsigned int unPrev2)
+{
+  if (SAMPLE_CODEC_DELTA2 == ePredictor && unHistory >= 2)
+  {
+    return 2 * unPrev1 - unPrev2;
+  }
+  return unPrev1;   // 0 for the first sample
+}
+
+CSampleEncoder::CSampleEncoder(SAMPLE_CODEC_PREDICTOR_ENUM ePredictor)
+{
+  m_ePredictor = ePredictor;
+  Reset();
+}
+
+// Start a new sequence
+void CSampleEncoder::Reset()
+{
+  m_unPrev1 = 0;
+  m_unPrev2 = 0;
+  m_unHistory = 0;
+}
+
+// Encode samples into Buf
+int CSampleEncoder::Encode(const int *Samples, unsigned int NumSamples, unsigned char *Buf, unsigned int BufSize)
+{
+  unsigned char *pbyOut = Buf;
+
+  if ( (NULL == Samples && NumSamples > 0) || (NULL == Buf) ||
+       (BufSize < SAMPLE_CODEC_MAX_ENCODED_SIZE(NumSamples)) )
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  for (unsigned int unSample = 0; unSample < NumSamples; unSample++)
+  {
+    unsigned int unVal = (unsigned int) Samples[unSample];
+    unsigned int unResidual = unVal - Predict(m_ePredictor, m_unHistory, m_unPrev1, m_unPrev2);
+
+    // Zigzag - small negative and positive residuals both become small numbers
+    unsigned int unZigzag = (unResidual << 1) ^ (0U - (unResidual >> 31));
+
+    // Varint
+    while (unZigzag >= 0x80)
+    {
+      *pbyOut++ = (unsigned char) (unZigzag | 0x80);
+      unZigzag >>= 7;
+    }
+    *pbyOut++ = (unsigned char) unZigzag;
+
+    m_unPrev2 = m_unPrev1;
+    m_unPrev1 = unVal;
+    if (m_unHistory < 2)
+    {
+      m_unHistory++;
+    }
+  }
+
+  return (int) (pbyOut - Buf);
+}
+
+CSampleDecoder::CSampleDecoder(SAMPLE_CODEC_PREDICTOR_ENUM ePredictor)
+{
+  m_ePredictor = ePredictor;
+  Reset();
+}
+
+// Start a new sequence
+void CSampleDecoder::Reset()
+{
+  m_unPrev1 = 0;
+  m_unPrev2 = 0;
+  m_unHistory = 0;
+}
+
+// Decode samples from Buf
+int CSampleDecoder::Decode(const unsigned char *Buf, unsigned int BufSize, int *Samples, unsigned int MaxSamples,
+                           unsigned int *BytesUsed)
+{
+  unsigned int unPos = 0;
+  unsigned int unNumSamples = 0;
+
+  if ( (NULL == Buf && BufSize > 0) || (NULL == Samples) || (NULL == BytesUsed) )
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  while (unNumSamples < MaxSamples && unPos < BufSize)
+  {
+    unsigned int unZigzag = 0;
+    unsigned int unShift = 0;
+    unsigned int unEnd = unPos;
+    BOOL bComplete = FALSE;
+
+    // Varint
+    while (unEnd < BufSize)
+    {
+      unsigned char byVal = Buf[unEnd++];
+      if (unShift >= 7 * SAMPLE_CODEC_MAX_BYTES)
+      {
+        *BytesUsed = unPos;
+        return ERR_PROTOCOL;
+      }
+      unZigzag |= (unsigned int) (byVal & 0x7F) << unShift;
+      unShift += 7;
+      if (0 == (byVal & 0x80))
+      {
+        bComplete = TRUE;
+        break;
+      }
+    }
+
+    // Cut off at the end of the buffer - left for the next call
+    if (!bComplete)
+    {
+      break;
+    }
+    unPos = unEnd;
+
+    unsigned int unResidual = (unZigzag >> 1) ^ (0U - (unZigzag & 1));
+    unsigned int unVal = Predict(m_ePredictor, m_unHistory, m_unPrev1, m_unPrev2) + unResidual;
+    Samples[unNumSamples++] = (int) unVal;
+
+    m_unPrev2 = m_unPrev1;
+    m_unPrev1 = unVal;
+    if (m_unHistory < 2)
+    {
+      m_unHistory++;
+    }
+  }
+
+  *BytesUsed = unPos;
+  return (int) unNumSamples;
+}
@@ -714,6 +714,8 @@ int CSerial::GetOnBoardTemp(int* TempMilliDegC)
 // Flushes the contents of the Named Pipe that is used for streaming data for this device.
 int CSerial::Flush() 
 {
+  CHALLock obStrmLock(GetStrmLock());
+
   if (m_pobCAN)
   {
     return m_pobCAN->CANFlushStreamPipe ();
@@ -724,6 +726,23 @@ int CSerial::Flush()
   }
 }
 
+// Returns the file descriptor that becomes readable when streaming data arrives
+// for this device (for select() / CHALReactor)
+int CSerial::GetRxStreamingFd()
+{
+  int nRetVal = ERR_SUCCESS;
+  if (m_pobCAN)
+  {
+    nRetVal = m_pobCAN->CANGetRxStrmFd();
+  }
+  else
+  {
+    nRetVal = ERR_INTERNAL_ERR;
+    DEBUG2("CSerial::GetRxStreamingFd(): Unexpected invalid pointer!");
+  }
+  return nRetVal;
+}
+
 
 //Common logic for both blocking and non blocking reads
 int CSerial::ReadCommon(unsigned char *Data, unsigned int NumBytes,  unsigned int *Timeout)
@@ -754,6 +773,9 @@ int CSerial::ReadCommon(unsigned char *Data, unsigned int NumBytes,  unsigned in
     unRemTimeout = 1;
   }
 
+  // The receive FIFO is shared by the stream reads
+  CHALLock obStrmLock(GetStrmLock());
+
   // Check if the device is open!
   if (m_bIsDevOpen)
   {
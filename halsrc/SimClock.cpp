@@ -0,0 +1,123 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                     10241 West Little York, Suite 200
+ * *                            Houston, TX 77040
+ * *
+ * *
+ * *  Filename: SimClock.cpp
+ * *
+ * *  Description: Virtual clock pacing the device simulators.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "debug.h"
+#include "Reliability.h"  // For GetMonotonicTimeUs
+#include "SimClock.h"
+
+// Speed of the default clock from PREAMP_SIM_SPEED, real time if not set
+static unsigned int GetDefaultSpeed()
+{
+  const char *pszSpeed = getenv("PREAMP_SIM_SPEED");
+  if (NULL == pszSpeed || '\0' == *pszSpeed)
+  {
+    return SIM_CLOCK_REAL_TIME;
+  }
+
+  return (unsigned int) strtoul(pszSpeed, NULL, 10);
+}
+
+static CSimClock s_obDefaultClock(GetDefaultSpeed());
+
+CSimClock::CSimClock(unsigned int Speed)
+{
+  m_unSpeed = Speed;
+  m_ullBaseDevUs = 0;
+  m_ullBaseWallUs = CReliability::GetMonotonicTimeUs();
+}
+
+CSimClock *CSimClock::GetDefault()
+{
+  return &s_obDefaultClock;
+}
+
+// Device time, with m_obLock held
+unsigned long long CSimClock::DevTimeAt(unsigned long long ullWallUs) const
+{
+  if (SIM_CLOCK_FREE_RUN == m_unSpeed)
+  {
+    return m_ullBaseDevUs;
+  }
+
+  return m_ullBaseDevUs + (ullWallUs - m_ullBaseWallUs) * m_unSpeed;
+}
+
+void CSimClock::SetSpeed(unsigned int Speed)
+{
+  CHALLock obLock(&m_obLock);
+
+  // Continue from the current device time
+  unsigned long long ullWallUs = CReliability::GetMonotonicTimeUs();
+  m_ullBaseDevUs = DevTimeAt(ullWallUs);
+  m_ullBaseWallUs = ullWallUs;
+  m_unSpeed = Speed;
+
+  DEBUG2("CSimClock::SetSpeed(): Speed %u at device time %llu us", Speed, m_ullBaseDevUs);
+}
+
+unsigned int CSimClock::GetSpeed()
+{
+  CHALLock obLock(&m_obLock);
+  return m_unSpeed;
+}
+
+unsigned long long CSimClock::GetTimeUs()
+{
+  CHALLock obLock(&m_obLock);
+  return DevTimeAt(CReliability::GetMonotonicTimeUs());
+}
+
+// Wait until device time DevTimeUs
+void CSimClock::WaitUntilUs(unsigned long long DevTimeUs)
+{
+  while (TRUE)
+  {
+    unsigned long long ullSleepUs = 0;
+    {
+      CHALLock obLock(&m_obLock);
+
+      if (SIM_CLOCK_FREE_RUN == m_unSpeed)
+      {
+        if (DevTimeUs > m_ullBaseDevUs)
+        {
+          m_ullBaseDevUs = DevTimeUs;
+        }
+        return;
+      }
+
+      unsigned long long ullNowUs = DevTimeAt(CReliability::GetMonotonicTimeUs());
+      if (ullNowUs >= DevTimeUs)
+      {
+        return;
+      }
+      ullSleepUs = (DevTimeUs - ullNowUs + m_unSpeed - 1) / m_unSpeed;
+    }
+
+    if (ullSleepUs > SIM_CLOCK_MAX_SLEEP_US)
+    {
+      ullSleepUs = SIM_CLOCK_MAX_SLEEP_US;
+    }
+    usleep((useconds_t) ullSleepUs);
+  }
+}
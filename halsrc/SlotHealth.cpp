@@ -0,0 +1,373 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                     10241 West Little York, Suite 200
+ * *                            Houston, TX 77040
+ * *
+ * *
+ * *  Filename: SlotHealth.cpp
+ * *
+ * *  Description: Process wide health state (circuit breaker) for each
+ * *               board slot on the CAN bus.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+#include <unistd.h>
+#include "FixEndian.h"
+
+#include "debug.h"
+#include "Reliability.h"
+#include "SlotHealth.h"
+
+// How often the probe thread wakes up to check for due probes (ms)
+#define SLOT_HEALTH_POLL_INTERVAL  100
+
+CSlotHealth::SlotStateStruct CSlotHealth::m_astSlots[SLOT_HEALTH_NUM_SLOT_ADDR];
+pthread_mutex_t CSlotHealth::m_Mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t CSlotHealth::m_Cond = PTHREAD_COND_INITIALIZER;
+pthread_t CSlotHealth::m_ProbeThread;
+BOOL CSlotHealth::m_bProbeThreadRunning = FALSE;
+BOOL CSlotHealth::m_bEnabled = TRUE;
+int CSlotHealth::m_nFailThreshold = SLOT_HEALTH_DFLT_FAIL_THRESHOLD;
+unsigned int CSlotHealth::m_unProbeIntervalMs = SLOT_HEALTH_DFLT_PROBE_INTERVAL;
+SlotHealthEventCallback CSlotHealth::m_pfnCallback = NULL;
+void *CSlotHealth::m_pvCallbackArg = NULL;
+
+// Enable / disable the circuit breaker for the whole process
+void CSlotHealth::Enable(BOOL bEnable)
+{
+  pthread_mutex_lock(&m_Mutex);
+  m_bEnabled = bEnable;
+  if (!bEnable)
+  {
+    for (int nSlot = 0; nSlot < SLOT_HEALTH_NUM_SLOT_ADDR; nSlot++)
+    {
+      m_astSlots[nSlot].eState = SLOT_ONLINE;
+      m_astSlots[nSlot].nConsecutiveFailures = 0;
+    }
+  }
+  pthread_mutex_unlock(&m_Mutex);
+}
+
+// Number of consecutive timed-out transactions that take a slot offline
+int CSlotHealth::SetFailThreshold(int nFailures)
+{
+  if (nFailures <= 0)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  pthread_mutex_lock(&m_Mutex);
+  m_nFailThreshold = nFailures;
+  pthread_mutex_unlock(&m_Mutex);
+
+  return ERR_SUCCESS;
+}
+
+// Interval (ms) between probes of an offline slot
+int CSlotHealth::SetProbeInterval(unsigned int unProbeIntervalMs)
+{
+  if (0 == unProbeIntervalMs)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  pthread_mutex_lock(&m_Mutex);
+  m_unProbeIntervalMs = unProbeIntervalMs;
+  pthread_mutex_unlock(&m_Mutex);
+
+  return ERR_SUCCESS;
+}
+
+// Register a function to be told about slots going offline / online
+void CSlotHealth::SetEventCallback(SlotHealthEventCallback pfnCallback, void *pvArg)
+{
+  pthread_mutex_lock(&m_Mutex);
+  m_pfnCallback = pfnCallback;
+  m_pvCallbackArg = pvArg;
+  pthread_mutex_unlock(&m_Mutex);
+}
+
+// Current state of a slot
+SLOT_HEALTH_STATE CSlotHealth::GetState(unsigned char bySlotID)
+{
+  SLOT_HEALTH_STATE eState = SLOT_ONLINE;
+
+  if (bySlotID < SLOT_HEALTH_NUM_SLOT_ADDR)
+  {
+    pthread_mutex_lock(&m_Mutex);
+    eState = m_astSlots[bySlotID].eState;
+    pthread_mutex_unlock(&m_Mutex);
+  }
+
+  return eState;
+}
+
+// Number of times a slot went offline and number of requests rejected while offline
+int CSlotHealth::GetSlotStats(unsigned char bySlotID, unsigned long *pulOfflineCount, unsigned long *pulRejectedRequests)
+{
+  if (bySlotID >= SLOT_HEALTH_NUM_SLOT_ADDR || NULL == pulOfflineCount || NULL == pulRejectedRequests)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  pthread_mutex_lock(&m_Mutex);
+  *pulOfflineCount = m_astSlots[bySlotID].ulOfflineCount;
+  *pulRejectedRequests = m_astSlots[bySlotID].ulRejectedRequests;
+  pthread_mutex_unlock(&m_Mutex);
+
+  return ERR_SUCCESS;
+}
+
+// Register a CAN channel that the probe thread may use for a slot
+void CSlotHealth::RegisterChannel(CCANComm *pobCANComm)
+{
+  unsigned char bySlotID = pobCANComm ? pobCANComm->GetSlotID() : SLOT_HEALTH_NUM_SLOT_ADDR;
+
+  if (bySlotID >= SLOT_HEALTH_NUM_SLOT_ADDR)
+  {
+    return;
+  }
+
+  pthread_mutex_lock(&m_Mutex);
+  SlotStateStruct *pstSlot = &m_astSlots[bySlotID];
+  int nFree = -1;
+  for (int nCount = 0; nCount < SLOT_HEALTH_MAX_CHANNELS; nCount++)
+  {
+    if (pstSlot->apobChannels[nCount] == pobCANComm)
+    {
+      nFree = -1;
+      break;
+    }
+    if (NULL == pstSlot->apobChannels[nCount] && nFree < 0)
+    {
+      nFree = nCount;
+    }
+  }
+  if (nFree >= 0)
+  {
+    pstSlot->apobChannels[nFree] = pobCANComm;
+  }
+  pthread_mutex_unlock(&m_Mutex);
+}
+
+// Unregister a CAN channel. Waits for a probe in progress on the slot to complete.
+void CSlotHealth::UnregisterChannel(CCANComm *pobCANComm)
+{
+  unsigned char bySlotID = pobCANComm ? pobCANComm->GetSlotID() : SLOT_HEALTH_NUM_SLOT_ADDR;
+
+  if (bySlotID >= SLOT_HEALTH_NUM_SLOT_ADDR)
+  {
+    return;
+  }
+
+  pthread_mutex_lock(&m_Mutex);
+  SlotStateStruct *pstSlot = &m_astSlots[bySlotID];
+  while (pstSlot->bProbeInProgress)
+  {
+    pthread_cond_wait(&m_Cond, &m_Mutex);
+  }
+  for (int nCount = 0; nCount < SLOT_HEALTH_MAX_CHANNELS; nCount++)
+  {
+    if (pstSlot->apobChannels[nCount] == pobCANComm)
+    {
+      pstSlot->apobChannels[nCount] = NULL;
+    }
+  }
+  pthread_mutex_unlock(&m_Mutex);
+}
+
+// Returns FALSE if requests to the slot should fail immediately
+BOOL CSlotHealth::IsRequestAllowed(unsigned char bySlotID)
+{
+  BOOL bAllowed = TRUE;
+
+  if (bySlotID >= SLOT_HEALTH_NUM_SLOT_ADDR)
+  {
+    return TRUE;
+  }
+
+  pthread_mutex_lock(&m_Mutex);
+  if (m_bEnabled && SLOT_OFFLINE == m_astSlots[bySlotID].eState)
+  {
+    m_astSlots[bySlotID].ulRejectedRequests++;
+    bAllowed = FALSE;
+  }
+  pthread_mutex_unlock(&m_Mutex);
+
+  return bAllowed;
+}
+
+// Outcome of a transaction - bResponded is TRUE if the board answered at all
+void CSlotHealth::ReportResult(unsigned char bySlotID, BOOL bResponded)
+{
+  BOOL bNotify = FALSE;
+  SLOT_HEALTH_STATE eNewState = SLOT_ONLINE;
+
+  if (bySlotID >= SLOT_HEALTH_NUM_SLOT_ADDR)
+  {
+    return;
+  }
+
+  pthread_mutex_lock(&m_Mutex);
+  SlotStateStruct *pstSlot = &m_astSlots[bySlotID];
+  if (bResponded)
+  {
+    pstSlot->nConsecutiveFailures = 0;
+    if (SLOT_OFFLINE == pstSlot->eState)
+    {
+      pstSlot->eState = SLOT_ONLINE;
+      bNotify = TRUE;
+    }
+  }
+  else if (m_bEnabled && SLOT_ONLINE == pstSlot->eState &&
+           ++pstSlot->nConsecutiveFailures >= m_nFailThreshold)
+  {
+    pstSlot->eState = SLOT_OFFLINE;
+    pstSlot->ulOfflineCount++;
+    pstSlot->ullNextProbeUs = CReliability::GetMonotonicTimeUs() + m_unProbeIntervalMs * 1000ULL;
+    eNewState = SLOT_OFFLINE;
+    bNotify = TRUE;
+
+    // Start probing in the background
+    if (!m_bProbeThreadRunning)
+    {
+      pthread_attr_t stAttr;
+      pthread_attr_init(&stAttr);
+      pthread_attr_setdetachstate(&stAttr, PTHREAD_CREATE_DETACHED);
+      if (0 == pthread_create(&m_ProbeThread, &stAttr, ProbeThread, NULL))
+      {
+        m_bProbeThreadRunning = TRUE;
+      }
+      else
+      {
+        DEBUG1("CSlotHealth::ReportResult: Unable to start probe thread!");
+      }
+      pthread_attr_destroy(&stAttr);
+    }
+  }
+  pthread_mutex_unlock(&m_Mutex);
+
+  if (bNotify)
+  {
+    NotifyEvent(bySlotID, eNewState);
+  }
+}
+
+// Probe all offline slots that are due. Exits when no slot is offline.
+void *CSlotHealth::ProbeThread(void *pvArg)
+{
+  pthread_mutex_lock(&m_Mutex);
+  while (TRUE)
+  {
+    BOOL bAnyOffline = FALSE;
+    unsigned long long ullNowUs = CReliability::GetMonotonicTimeUs();
+
+    for (int nSlot = 0; nSlot < SLOT_HEALTH_NUM_SLOT_ADDR; nSlot++)
+    {
+      SlotStateStruct *pstSlot = &m_astSlots[nSlot];
+      if (SLOT_OFFLINE != pstSlot->eState)
+      {
+        continue;
+      }
+      bAnyOffline = TRUE;
+
+      if (ullNowUs < pstSlot->ullNextProbeUs)
+      {
+        continue;
+      }
+
+      CCANComm *pobChannel = NULL;
+      for (int nCount = 0; nCount < SLOT_HEALTH_MAX_CHANNELS && NULL == pobChannel; nCount++)
+      {
+        pobChannel = pstSlot->apobChannels[nCount];
+      }
+      if (NULL == pobChannel)
+      {
+        // Nothing to probe with - check again later
+        pstSlot->ullNextProbeUs = ullNowUs + m_unProbeIntervalMs * 1000ULL;
+        continue;
+      }
+
+      // Probe without holding the lock. Requests to this slot keep failing fast
+      // (it is still offline), so nobody else is using the channel.
+      pstSlot->bProbeInProgress = TRUE;
+      pthread_mutex_unlock(&m_Mutex);
+
+      CmdAckUnion stCmd = {0};
+      unsigned char byResp[sizeof(CmdAckUnion) + sizeof(DEVICE_SYSTEM_INFO_STRUCT)];
+      SetCmdAckCommand(&stCmd.byCmdAck, BD_GET_SYSTEM_INFO);
+      int nRetVal = pobChannel->CANGetRemoteResp((unsigned char *)&stCmd, sizeof(stCmd),
+                                                 byResp, sizeof(byResp), FALSE, HAL_DFLT_TIMEOUT);
+
+      pthread_mutex_lock(&m_Mutex);
+      pstSlot->bProbeInProgress = FALSE;
+      pthread_cond_broadcast(&m_Cond);
+
+      // Anything but silence means the board is back
+      if (ERR_TIMEOUT != nRetVal && ERR_NO_RESP != nRetVal && ERR_INTERNAL_ERR != nRetVal)
+      {
+        if (SLOT_OFFLINE == pstSlot->eState)
+        {
+          pstSlot->eState = SLOT_ONLINE;
+          pstSlot->nConsecutiveFailures = 0;
+          pthread_mutex_unlock(&m_Mutex);
+          NotifyEvent((unsigned char)nSlot, SLOT_ONLINE);
+          pthread_mutex_lock(&m_Mutex);
+        }
+      }
+      else
+      {
+        pstSlot->ullNextProbeUs = CReliability::GetMonotonicTimeUs() + m_unProbeIntervalMs * 1000ULL;
+      }
+      ullNowUs = CReliability::GetMonotonicTimeUs();
+    }
+
+    if (!bAnyOffline)
+    {
+      m_bProbeThreadRunning = FALSE;
+      break;
+    }
+
+    pthread_mutex_unlock(&m_Mutex);
+    usleep(SLOT_HEALTH_POLL_INTERVAL * 1000);
+    pthread_mutex_lock(&m_Mutex);
+  }
+  pthread_mutex_unlock(&m_Mutex);
+
+  return NULL;
+}
+
+// Log and report a slot state change
+void CSlotHealth::NotifyEvent(unsigned char bySlotID, SLOT_HEALTH_STATE eState)
+{
+  SlotHealthEventCallback pfnCallback;
+  void *pvArg;
+
+  if (SLOT_OFFLINE == eState)
+  {
+    DEBUG1("CSlotHealth: Slot %d is not responding - failing requests until it answers a probe.", (int)bySlotID);
+  }
+  else
+  {
+    DEBUG1("CSlotHealth: Slot %d is responding again.", (int)bySlotID);
+  }
+
+  pthread_mutex_lock(&m_Mutex);
+  pfnCallback = m_pfnCallback;
+  pvArg = m_pvCallbackArg;
+  pthread_mutex_unlock(&m_Mutex);
+
+  if (pfnCallback)
+  {
+    pfnCallback(bySlotID, eState, pvArg);
+  }
+}
@@ -0,0 +1,446 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                     10241 West Little York, Suite 200
+ * *                            Houston, TX 77040
+ * *
+ * *
+ * *  Filename: SolenoidSchedule.cpp
+ * *
+ * *  Description: Timed valve events of an analysis cycle, switched from a
+ * *               high priority thread.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+
+#include "debug.h"
+#include "SolenoidSchedule.h"
+#include "Reliability.h"    // For GetMonotonicTimeUs()
+#include "SolenoidCtrl.h"
+#include "CycleClockSync.h"
+#include "HALTrace.h"
+
+CSolenoidSchedule::CSolenoidSchedule()  // Default Constructor
+{
+  pthread_condattr_t stAttr;
+
+  memset(m_astEvents, 0, sizeof (m_astEvents));
+  memset(m_astResults, 0, sizeof (m_astResults));
+  memset(m_anOrder, 0, sizeof (m_anOrder));
+  m_nNumEvents = 0;
+  m_nPriority = SOL_SCHED_DFLT_PRIORITY;
+  m_unSpinUs = SOL_SCHED_DFLT_SPIN_US;
+  m_bCompensate = TRUE;
+  m_ullTotalRoundTripUs = 0;
+  m_ulRoundTrips = 0;
+  m_bThreadStarted = FALSE;
+  m_bDone = FALSE;
+  m_bStop = FALSE;
+  m_bRealTime = FALSE;
+  m_ullCycleStartUs = 0;
+  m_unLeadUs = 0;
+
+  pthread_mutex_init(&m_Mutex, NULL);
+  pthread_condattr_init(&stAttr);
+  pthread_condattr_setclock(&stAttr, CLOCK_MONOTONIC);
+  pthread_cond_init(&m_Cond, &stAttr);
+  pthread_condattr_destroy(&stAttr);
+}
+
+CSolenoidSchedule::~CSolenoidSchedule() // Destructor
+{
+  Stop();
+  pthread_cond_destroy(&m_Cond);
+  pthread_mutex_destroy(&m_Mutex);
+}
+
+// Load the events of a cycle
+int CSolenoidSchedule::Load(const SolEventStruct *Events, int NumEvents)
+{
+  if ( (NULL == Events) || (NumEvents <= 0) || (NumEvents > SOL_SCHED_MAX_EVENTS) )
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  for (int nEvent = 0; nEvent < NumEvents; nEvent++)
+  {
+    if (NULL == Events[nEvent].pobValve && NULL == Events[nEvent].pfnActuate)
+    {
+      return ERR_INVALID_ARGS;
+    }
+  }
+
+  if (IsRunning())
+  {
+    return ERR_INVALID_SEQ;
+  }
+
+  // The thread of the last cycle has finished
+  Wait();
+
+  memcpy(m_astEvents, Events, NumEvents * sizeof (Events[0]));
+  m_nNumEvents = NumEvents;
+
+  // Time order, events at the same time in the order given
+  for (int nEvent = 0; nEvent < NumEvents; nEvent++)
+  {
+    int nPos = nEvent;
+    while (nPos > 0 && m_astEvents[m_anOrder[nPos - 1]].unTimeMs > m_astEvents[nEvent].unTimeMs)
+    {
+      m_anOrder[nPos] = m_anOrder[nPos - 1];
+      nPos--;
+    }
+    m_anOrder[nPos] = nEvent;
+  }
+
+  for (int nEvent = 0; nEvent < NumEvents; nEvent++)
+  {
+    memset(&m_astResults[nEvent], 0, sizeof (m_astResults[nEvent]));
+    m_astResults[nEvent].ullScheduledUs = m_astEvents[nEvent].unTimeMs * 1000ULL;
+    m_astResults[nEvent].nResult = ERR_DATA_PENDING;
+  }
+
+  m_ullTotalRoundTripUs = 0;
+  m_ulRoundTrips = 0;
+
+  return ERR_SUCCESS;
+}
+
+// Thread priority, clock polling time and compensation
+int CSolenoidSchedule::Configure(int Priority, unsigned int SpinUs, BOOL Compensate)
+{
+  if ( (Priority < 0) || (Priority > sched_get_priority_max(SCHED_FIFO)) )
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  if (IsRunning())
+  {
+    return ERR_INVALID_SEQ;
+  }
+
+  m_nPriority = Priority;
+  m_unSpinUs = SpinUs;
+  m_bCompensate = Compensate;
+
+  return ERR_SUCCESS;
+}
+
+// Run the events of one cycle
+int CSolenoidSchedule::Start(unsigned long long CycleStartUs /*= 0*/)
+{
+  pthread_attr_t stAttr;
+  struct sched_param stParam;
+  int nRetVal;
+
+  if (0 == m_nNumEvents)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  if (IsRunning())
+  {
+    return ERR_INVALID_SEQ;
+  }
+
+  Wait();
+
+  for (int nEvent = 0; nEvent < m_nNumEvents; nEvent++)
+  {
+    m_astResults[nEvent].ullSentUs = 0;
+    m_astResults[nEvent].ullDoneUs = 0;
+    m_astResults[nEvent].lErrorUs = 0;
+    m_astResults[nEvent].nResult = ERR_DATA_PENDING;
+  }
+
+  // Half the average round trip of the cycles before
+  m_unLeadUs = (m_bCompensate && m_ulRoundTrips) ? (unsigned int) (m_ullTotalRoundTripUs / m_ulRoundTrips / 2) : 0;
+
+  m_ullCycleStartUs = CycleStartUs ? CycleStartUs : CReliability::GetMonotonicTimeUs();
+  m_bStop = FALSE;
+  m_bDone = FALSE;
+  m_bRealTime = FALSE;
+
+  nRetVal = -1;
+  if (m_nPriority > 0)
+  {
+    pthread_attr_init(&stAttr);
+    pthread_attr_setinheritsched(&stAttr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&stAttr, SCHED_FIFO);
+    memset(&stParam, 0, sizeof (stParam));
+    stParam.sched_priority = m_nPriority;
+    pthread_attr_setschedparam(&stAttr, &stParam);
+
+    nRetVal = pthread_create(&m_Thread, &stAttr, ScheduleThread, this);
+    pthread_attr_destroy(&stAttr);
+
+    if (0 == nRetVal)
+    {
+      m_bRealTime = TRUE;
+    }
+    else
+    {
+      // Typically EPERM - no real time priority for this process
+      DEBUG2("CSolenoidSchedule::Start(): No real time priority (error %d), running at normal priority!", nRetVal);
+    }
+  }
+
+  if (0 != nRetVal && 0 != pthread_create(&m_Thread, NULL, ScheduleThread, this))
+  {
+    DEBUG1("CSolenoidSchedule::Start(): Unable to start the schedule thread!");
+    return ERR_INTERNAL_ERR;
+  }
+
+  pthread_mutex_lock(&m_Mutex);
+  m_bThreadStarted = TRUE;
+  pthread_mutex_unlock(&m_Mutex);
+
+  return ERR_SUCCESS;
+}
+
+// Start the cycle clock and the events together
+int CSolenoidSchedule::StartCycle(CCycleClockSync *CycleClock)
+{
+  if (NULL == CycleClock)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  if (IsRunning())
+  {
+    return ERR_INVALID_SEQ;
+  }
+
+  unsigned long long ullSentUs = CReliability::GetMonotonicTimeUs();
+  int nRetVal = CycleClock->StartCycleClock();
+  unsigned long long ullDoneUs = CReliability::GetMonotonicTimeUs();
+
+  if (nRetVal < 0)
+  {
+    return nRetVal;
+  }
+
+  // The boards started their cycle clocks while the command was on its way
+  return Start(ullSentUs + (ullDoneUs - ullSentUs) / 2);
+}
+
+// Skip the remaining events
+int CSolenoidSchedule::Stop()
+{
+  pthread_mutex_lock(&m_Mutex);
+  m_bStop = TRUE;
+  pthread_cond_broadcast(&m_Cond);
+  pthread_mutex_unlock(&m_Mutex);
+
+  return Wait();
+}
+
+// Wait for the last event
+int CSolenoidSchedule::Wait()
+{
+  pthread_mutex_lock(&m_Mutex);
+  BOOL bThreadStarted = m_bThreadStarted;
+  pthread_mutex_unlock(&m_Mutex);
+
+  if (bThreadStarted)
+  {
+    pthread_join(m_Thread, NULL);
+
+    pthread_mutex_lock(&m_Mutex);
+    m_bThreadStarted = FALSE;
+    pthread_mutex_unlock(&m_Mutex);
+  }
+
+  return ERR_SUCCESS;
+}
+
+BOOL CSolenoidSchedule::IsRunning()
+{
+  pthread_mutex_lock(&m_Mutex);
+  BOOL bRunning = m_bThreadStarted && !m_bDone;
+  pthread_mutex_unlock(&m_Mutex);
+
+  return bRunning;
+}
+
+// Sleep until shortly before ullDueUs, then poll the clock
+BOOL CSolenoidSchedule::WaitUntil(unsigned long long ullDueUs)
+{
+  unsigned long long ullNowUs = CReliability::GetMonotonicTimeUs();
+
+  pthread_mutex_lock(&m_Mutex);
+  while (!m_bStop && ullNowUs + m_unSpinUs < ullDueUs)
+  {
+    unsigned long long ullWakeUs = ullDueUs - m_unSpinUs;
+    struct timespec stWake;
+    stWake.tv_sec = ullWakeUs / 1000000ULL;
+    stWake.tv_nsec = (ullWakeUs % 1000000ULL) * 1000;
+    pthread_cond_timedwait(&m_Cond, &m_Mutex, &stWake);
+
+    ullNowUs = CReliability::GetMonotonicTimeUs();
+  }
+  BOOL bStop = m_bStop;
+  pthread_mutex_unlock(&m_Mutex);
+
+  // Spin the last m_unSpinUs, still reading m_bStop under the lock (uncontended
+  // unless Stop() is called, so it costs little next to the clock read)
+  while (!bStop && ullNowUs < ullDueUs)
+  {
+    ullNowUs = CReliability::GetMonotonicTimeUs();
+
+    pthread_mutex_lock(&m_Mutex);
+    bStop = m_bStop;
+    pthread_mutex_unlock(&m_Mutex);
+  }
+
+  return !bStop;
+}
+
+// Switch the valve of an event
+int CSolenoidSchedule::Actuate(const SolEventStruct &stEvent)
+{
+  if (stEvent.pobValve)
+  {
+    return stEvent.bOn ? stEvent.pobValve->TurnONSolValve() : stEvent.pobValve->TurnOFFSolValve();
+  }
+
+  return stEvent.pfnActuate(stEvent.pvArg, stEvent.bOn);
+}
+
+void CSolenoidSchedule::Run()
+{
+  for (int nPos = 0; nPos < m_nNumEvents; nPos++)
+  {
+    int nEvent = m_anOrder[nPos];
+    SolEventResultStruct &stResult = m_astResults[nEvent];
+
+    // Not before the cycle starts, even with the lead
+    unsigned long long ullDueUs = m_ullCycleStartUs + stResult.ullScheduledUs;
+    ullDueUs = (stResult.ullScheduledUs > m_unLeadUs) ? ullDueUs - m_unLeadUs : m_ullCycleStartUs;
+
+    if (!WaitUntil(ullDueUs))
+    {
+      break;
+    }
+
+    unsigned long long ullSentUs = CReliability::GetMonotonicTimeUs();
+    int nResult = Actuate(m_astEvents[nEvent]);
+    unsigned long long ullDoneUs = CReliability::GetMonotonicTimeUs();
+
+    pthread_mutex_lock(&m_Mutex);
+    stResult.ullSentUs = ullSentUs - m_ullCycleStartUs;
+    stResult.ullDoneUs = ullDoneUs - m_ullCycleStartUs;
+    stResult.lErrorUs = (long) ((stResult.ullSentUs + stResult.ullDoneUs) / 2) - (long) stResult.ullScheduledUs;
+    stResult.nResult = nResult;
+    if (ERR_SUCCESS == nResult)
+    {
+      m_ullTotalRoundTripUs += ullDoneUs - ullSentUs;
+      m_ulRoundTrips++;
+    }
+    else
+    {
+      DEBUG2("CSolenoidSchedule::Run(): Event %d at %u ms failed with error code %d!", nEvent, m_astEvents[nEvent].unTimeMs, nResult);
+    }
+    pthread_mutex_unlock(&m_Mutex);
+  }
+
+  pthread_mutex_lock(&m_Mutex);
+  m_bDone = TRUE;
+  pthread_mutex_unlock(&m_Mutex);
+}
+
+void *CSolenoidSchedule::ScheduleThread(void *pvArg)
+{
+  CHALTrace::SetThreadName("Solenoid schedule");
+  ((CSolenoidSchedule *) pvArg)->Run();
+  return NULL;
+}
+
+// Results of the events in the order they were loaded
+int CSolenoidSchedule::GetResults(SolEventResultStruct *Results, int MaxResults)
+{
+  if ( (NULL == Results) || (MaxResults < 0) )
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  pthread_mutex_lock(&m_Mutex);
+  int nCount = (MaxResults < m_nNumEvents) ? MaxResults : m_nNumEvents;
+  memcpy(Results, m_astResults, nCount * sizeof (Results[0]));
+  pthread_mutex_unlock(&m_Mutex);
+
+  return nCount;
+}
+
+// Timing of the events of the last cycle
+int CSolenoidSchedule::GetStats(SolScheduleStatsStruct *Stats)
+{
+  double dTotalAbsErrorUs = 0.0;
+
+  if (NULL == Stats)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  memset(Stats, 0, sizeof (*Stats));
+
+  pthread_mutex_lock(&m_Mutex);
+  for (int nEvent = 0; nEvent < m_nNumEvents; nEvent++)
+  {
+    const SolEventResultStruct &stResult = m_astResults[nEvent];
+
+    if (ERR_DATA_PENDING == stResult.nResult)
+    {
+      continue;
+    }
+
+    if (ERR_SUCCESS != stResult.nResult)
+    {
+      Stats->ulFailed++;
+    }
+
+    if (0 == Stats->ulExecuted || stResult.lErrorUs < Stats->lMinErrorUs)
+    {
+      Stats->lMinErrorUs = stResult.lErrorUs;
+    }
+    if (0 == Stats->ulExecuted || stResult.lErrorUs > Stats->lMaxErrorUs)
+    {
+      Stats->lMaxErrorUs = stResult.lErrorUs;
+    }
+    Stats->ulExecuted++;
+    dTotalAbsErrorUs += (stResult.lErrorUs < 0) ? -stResult.lErrorUs : stResult.lErrorUs;
+
+    long long llLateUs = (long long) stResult.ullSentUs - ((long long) stResult.ullScheduledUs - m_unLeadUs);
+    if (llLateUs > (long long) Stats->unMaxLateUs)
+    {
+      Stats->unMaxLateUs = (unsigned int) llLateUs;
+    }
+
+    unsigned int unRoundTripUs = (unsigned int) (stResult.ullDoneUs - stResult.ullSentUs);
+    if (unRoundTripUs > Stats->unMaxRoundTripUs)
+    {
+      Stats->unMaxRoundTripUs = unRoundTripUs;
+    }
+  }
+
+  if (Stats->ulExecuted)
+  {
+    Stats->dMeanAbsErrorUs = dTotalAbsErrorUs / Stats->ulExecuted;
+  }
+  Stats->unLeadUs = m_unLeadUs;
+  Stats->bRealTime = m_bRealTime;
+  pthread_mutex_unlock(&m_Mutex);
+
+  return ERR_SUCCESS;
+}
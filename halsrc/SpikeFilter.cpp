@@ -0,0 +1,222 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                     10241 West Little York, Suite 200
+ * *                            Houston, TX 77040
+ * *
+ * *
+ * *  Filename: SpikeFilter.cpp
+ * *
+ * *  Description: Spike filter for detector (preamp) stream data.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+#include <stdlib.h>
+
+#include "debug.h"
+#include "PreampStream.h"   // For PREAMP_SAMPLE_ flags
+#include "SpikeFilter.h"
+
+// Sort a few values in place (insertion sort - the window is small)
+static void SortValues(long long *pllVals, unsigned int unNum)
+{
+  for (unsigned int unI = 1; unI < unNum; unI++)
+  {
+    long long llVal = pllVals[unI];
+    unsigned int unJ = unI;
+    while (unJ > 0 && pllVals[unJ - 1] > llVal)
+    {
+      pllVals[unJ] = pllVals[unJ - 1];
+      unJ--;
+    }
+    pllVals[unJ] = llVal;
+  }
+}
+
+CSpikeFilter::CSpikeFilter(const char *pszName)  // Default Constructor
+{
+  m_pszName = pszName ? pszName : "";
+  m_eType = SPIKE_FILT_SLOPE;
+  m_unWindowSize = SPIKE_FILT_DFLT_WINDOW;
+  m_nThreshold = SPIKE_FILT_DFLT_SLOPE_THRESHOLD;
+  Reset();
+}
+
+// Select the filter. Samples held in the window are dropped.
+int CSpikeFilter::Configure(SPIKE_FILT_TYPE_ENUM eType, unsigned int unWindowSize, int nThreshold)
+{
+  switch (eType)
+  {
+  case SPIKE_FILT_SLOPE:
+    if (unWindowSize != 3)
+    {
+      return ERR_INVALID_ARGS;
+    }
+    break;
+
+  case SPIKE_FILT_MEDIAN:
+  case SPIKE_FILT_HAMPEL:
+    // Odd, so that there is a centre sample
+    if (unWindowSize < 3 || unWindowSize > SPIKE_FILT_MAX_WINDOW || (unWindowSize % 2) == 0)
+    {
+      return ERR_INVALID_ARGS;
+    }
+    break;
+
+  default:
+    return ERR_INVALID_ARGS;
+  }
+
+  if (nThreshold < 0)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  m_eType = eType;
+  m_unWindowSize = unWindowSize;
+  m_nThreshold = nThreshold;
+  Reset();
+
+  return ERR_SUCCESS;
+}
+
+// Drop the samples held in the window
+void CSpikeFilter::Reset()
+{
+  m_unOldest = 0;
+  m_unCount = 0;
+}
+
+// Add a sample, and release the oldest one once the window is full
+BOOL CSpikeFilter::Push(const SpikeFiltSampleStruct &stIn, SpikeFiltSampleStruct *pstOut)
+{
+  WindowEntryStruct &stNew = Entry(m_unCount);
+  stNew.stSample = stIn;
+  stNew.nRawVal = stIn.nBridgeVal;
+  m_unCount++;
+
+  if (m_unCount < m_unWindowSize)
+  {
+    return FALSE;
+  }
+
+  switch (m_eType)
+  {
+  case SPIKE_FILT_MEDIAN:
+    CheckMedian(FALSE);
+    break;
+
+  case SPIKE_FILT_HAMPEL:
+    CheckMedian(TRUE);
+    break;
+
+  case SPIKE_FILT_SLOPE:
+  default:
+    CheckSlope();
+    break;
+  }
+
+  // Release the oldest sample
+  *pstOut = Entry(0).stSample;
+  m_unOldest++;
+  if (m_unOldest >= m_unWindowSize)
+  {
+    m_unOldest = 0;
+  }
+  m_unCount--;
+
+  return TRUE;
+}
+
+/*Spike Trap
+  Search and remove random spike found in chromatograms.
+  This works on the following idea proposed by Skip Watkins based on several bad chromatograms
+  seen from several GCs - All spikes ever detected consists of a sinle bad point (provided averaging and filtering is turned
+  off in the dual-TCD preamp board). This single bad point will have a large offset from the rest of the chromatogram (be it a
+  peak or the baseline). If we were to see the slope of the chromatogram, you would typically see a large slope associated with
+  spikes. It is not sufficient to check slope of successive points to detect and fix spikes; this is because valve upsets
+  and backflush (the backflush process onto Det2 and not the backflush valve upset alone) can cause large swings in preamp ADC counts.
+  Hence, we need a smart way to detect and fix spikes. And here's how -
+  Detect Spikes - Rate of change of slope at a spike should be significant and the slope before the spike and the slope after the
+  spike would be of opposite sign.
+  Fix - Identify the data point and replace with an average of the previous and next points.
+  The fixed point is used when checking the next point, as it always has been.
+*/
+void CSpikeFilter::CheckSlope()
+{
+  SpikeFiltSampleStruct &stPrev = Entry(0).stSample;
+  SpikeFiltSampleStruct &stCurr = Entry(1).stSample;
+  SpikeFiltSampleStruct &stNext = Entry(2).stSample;
+
+  // Compute slope with the three points
+  int nSlope1 = stCurr.nBridgeVal - stPrev.nBridgeVal;
+  int nSlope2 = stNext.nBridgeVal - stCurr.nBridgeVal;
+
+  // Check if there is a sike
+  if ( ( abs (nSlope1) >= m_nThreshold && abs (nSlope2) >= m_nThreshold) &&
+       ( (nSlope1 < 0 && nSlope2 > 0) || (nSlope1 > 0 && nSlope2 < 0) ) )
+  {
+    // We trapped a spike! Fix it!
+    DEBUG1 ("SPIKE! %s, %d, %d, %d", m_pszName, stPrev.nBridgeVal, stCurr.nBridgeVal, stNext.nBridgeVal);
+
+    // New value is the average of the points around the spike
+    stCurr.nBridgeVal = (stPrev.nBridgeVal + stNext.nBridgeVal) / 2;
+    stCurr.byFlags |= PREAMP_SAMPLE_SPIKE_FIXED;
+    DEBUG1 ("SPIKE_FIX! Replacing with %d", stCurr.nBridgeVal);
+  }
+}
+
+// Median and Hampel filters. Both work on the samples as received, so a fixed sample
+// does not change the result for the samples after it.
+void CSpikeFilter::CheckMedian(BOOL bHampel)
+{
+  long long allVals[SPIKE_FILT_MAX_WINDOW];
+  unsigned int unCentre = m_unWindowSize / 2;
+
+  for (unsigned int unAge = 0; unAge < m_unWindowSize; unAge++)
+  {
+    allVals[unAge] = Entry(unAge).nRawVal;
+  }
+  SortValues(allVals, m_unWindowSize);
+  long long llMedian = allVals[unCentre];
+
+  SpikeFiltSampleStruct &stCurr = Entry(unCentre).stSample;
+  long long llDev = Entry(unCentre).nRawVal - llMedian;
+  if (llDev < 0)
+  {
+    llDev = -llDev;
+  }
+
+  if (bHampel)
+  {
+    // Median absolute deviation
+    for (unsigned int unAge = 0; unAge < m_unWindowSize; unAge++)
+    {
+      long long llAbsDev = Entry(unAge).nRawVal - llMedian;
+      allVals[unAge] = (llAbsDev < 0) ? -llAbsDev : llAbsDev;
+    }
+    SortValues(allVals, m_unWindowSize);
+    long long llMAD = allVals[unCentre];
+
+    // Outlier if llDev > (Threshold / 1000) * 1.4826 * MAD
+    if (llDev * 10000000LL <= (long long) m_nThreshold * 14826 * llMAD)
+    {
+      return;
+    }
+    DEBUG1 ("SPIKE! %s, %d, median %lld, MAD %lld", m_pszName, stCurr.nBridgeVal, llMedian, llMAD);
+  }
+
+  if (stCurr.nBridgeVal != (int) llMedian)
+  {
+    stCurr.nBridgeVal = (int) llMedian;
+    stCurr.byFlags |= PREAMP_SAMPLE_SPIKE_FIXED;
+  }
+}
@@ -0,0 +1,591 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                     10241 West Little York, Suite 200
+ * *                            Houston, TX 77040
+ * *
+ * *
+ * *  Filename: TelemetryPoller.cpp
+ * *
+ * *  Description: Background polling of heater, EPC, RTD and pressure
+ * *               readings.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+#include <string.h>
+#include <time.h>
+
+#include "debug.h"
+#include "TelemetryPoller.h"
+#include "Reliability.h"  // For GetMonotonicTimeUs()
+#include "HALTrace.h"
+#include "HeaterCtrl.h"
+#include "EPC.h"
+#include "RTD.h"
+#include "Pressure.h"
+
+CTelemetryPoller::CTelemetryPoller()  // Default Constructor
+{
+  pthread_condattr_t stAttr;
+
+  memset(m_astItems, 0, sizeof (m_astItems));
+  m_nNumItems = 0;
+  m_unNumWorkers = TELEMETRY_DFLT_WORKERS;
+  m_unMinGapUs = TELEMETRY_DFLT_MIN_GAP_US;
+  m_unWorkersRunning = 0;
+  m_bStop = FALSE;
+  m_ullStartUs = 0;
+  m_ullStopUs = 0;
+  m_ullNextStartUs = 0;
+  m_unInFlight = 0;
+  memset(&m_stStats, 0, sizeof (m_stStats));
+
+  pthread_mutex_init(&m_Mutex, NULL);
+  pthread_condattr_init(&stAttr);
+  pthread_condattr_setclock(&stAttr, CLOCK_MONOTONIC);
+  pthread_cond_init(&m_Cond, &stAttr);
+  pthread_condattr_destroy(&stAttr);
+}
+
+CTelemetryPoller::~CTelemetryPoller() // Destructor
+{
+  Stop();
+  pthread_cond_destroy(&m_Cond);
+  pthread_mutex_destroy(&m_Mutex);
+}
+
+int CTelemetryPoller::AddItem(TELEMETRY_VALUE_ENUM eValue, void *pvDev, TelemetryReadFn pfnRead, unsigned int unPeriodMs)
+{
+  int nRetVal;
+
+  if ( (NULL == pvDev && NULL == pfnRead) || (0 == unPeriodMs) )
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  pthread_mutex_lock(&m_Mutex);
+  if (m_unWorkersRunning > 0)
+  {
+    nRetVal = ERR_INVALID_SEQ;
+  }
+  else if (m_nNumItems >= TELEMETRY_MAX_ITEMS)
+  {
+    nRetVal = ERR_MEMORY_ERR;
+  }
+  else
+  {
+    ItemStruct *pstItem = &m_astItems[m_nNumItems];
+    memset(pstItem, 0, sizeof (*pstItem));
+    pstItem->eValue = eValue;
+    pstItem->pvDev = pvDev;
+    pstItem->pfnRead = pfnRead;
+    pstItem->unPeriodMs = unPeriodMs;
+    pstItem->stValue.eValue = eValue;
+    pstItem->stValue.unPeriodMs = unPeriodMs;
+    pstItem->stValue.nLastResult = ERR_DATA_PENDING;
+    nRetVal = m_nNumItems++;
+  }
+  pthread_mutex_unlock(&m_Mutex);
+
+  return nRetVal;
+}
+
+int CTelemetryPoller::AddHeater(CHeaterCtrl *Heater, TELEMETRY_VALUE_ENUM Value, unsigned int PeriodMs)
+{
+  if ( (NULL == Heater) || (Value < TELEMETRY_HTR_TEMP) || (Value > TELEMETRY_HTR_CURRENT) )
+  {
+    return ERR_INVALID_ARGS;
+  }
+  return AddItem(Value, Heater, NULL, PeriodMs);
+}
+
+int CTelemetryPoller::AddEPC(CEPC *EPC, TELEMETRY_VALUE_ENUM Value, unsigned int PeriodMs)
+{
+  if ( (NULL == EPC) || (Value < TELEMETRY_EPC_PRESSURE) || (Value > TELEMETRY_EPC_TEMP) )
+  {
+    return ERR_INVALID_ARGS;
+  }
+  return AddItem(Value, EPC, NULL, PeriodMs);
+}
+
+int CTelemetryPoller::AddRTD(CRTD *RTD, TELEMETRY_VALUE_ENUM Value, unsigned int PeriodMs)
+{
+  if ( (NULL == RTD) || (Value < TELEMETRY_RTD_TEMP) || (Value > TELEMETRY_RTD_PWM) )
+  {
+    return ERR_INVALID_ARGS;
+  }
+  return AddItem(Value, RTD, NULL, PeriodMs);
+}
+
+int CTelemetryPoller::AddPressure(CPressure *Pressure, unsigned int PeriodMs)
+{
+  if (NULL == Pressure)
+  {
+    return ERR_INVALID_ARGS;
+  }
+  return AddItem(TELEMETRY_PRESSURE, Pressure, NULL, PeriodMs);
+}
+
+int CTelemetryPoller::AddCustom(TelemetryReadFn Read, void *Arg, unsigned int PeriodMs)
+{
+  if (NULL == Read)
+  {
+    return ERR_INVALID_ARGS;
+  }
+  return AddItem(TELEMETRY_CUSTOM, Arg, Read, PeriodMs);
+}
+
+// Remove all the readings
+int CTelemetryPoller::Clear()
+{
+  int nRetVal = ERR_SUCCESS;
+
+  pthread_mutex_lock(&m_Mutex);
+  if (m_unWorkersRunning > 0)
+  {
+    nRetVal = ERR_INVALID_SEQ;
+  }
+  else
+  {
+    m_nNumItems = 0;
+  }
+  pthread_mutex_unlock(&m_Mutex);
+
+  return nRetVal;
+}
+
+// Number of worker threads and the least time between the starts of two reads
+int CTelemetryPoller::Configure(unsigned int NumWorkers, unsigned int MinGapUs)
+{
+  int nRetVal = ERR_SUCCESS;
+
+  if ( (0 == NumWorkers) || (NumWorkers > TELEMETRY_MAX_WORKERS) )
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  pthread_mutex_lock(&m_Mutex);
+  if (m_unWorkersRunning > 0)
+  {
+    nRetVal = ERR_INVALID_SEQ;
+  }
+  else
+  {
+    m_unNumWorkers = NumWorkers;
+    m_unMinGapUs = MinGapUs;
+  }
+  pthread_mutex_unlock(&m_Mutex);
+
+  return nRetVal;
+}
+
+// Spread the first reads over their periods - the n-th of N readings starts n/N
+// into its period, so readings of the same period are evenly apart and readings of
+// periods that are multiples of each other do not line up either
+void CTelemetryPoller::Schedule(unsigned long long ullNowUs)
+{
+  for (int nItem = 0; nItem < m_nNumItems; nItem++)
+  {
+    ItemStruct &stItem = m_astItems[nItem];
+
+    stItem.ullDueUs = ullNowUs + (unsigned long long) stItem.unPeriodMs * 1000ULL * nItem / m_nNumItems;
+    stItem.bBusy = FALSE;
+  }
+}
+
+// Start polling
+int CTelemetryPoller::Start()
+{
+  int nRetVal = ERR_SUCCESS;
+
+  pthread_mutex_lock(&m_Mutex);
+  if (m_unWorkersRunning > 0)
+  {
+    pthread_mutex_unlock(&m_Mutex);
+    return ERR_INVALID_SEQ;
+  }
+  if (0 == m_nNumItems)
+  {
+    pthread_mutex_unlock(&m_Mutex);
+    return ERR_INVALID_ARGS;
+  }
+
+  // Figures since the start
+  for (int nItem = 0; nItem < m_nNumItems; nItem++)
+  {
+    TelemetryValueStruct &stValue = m_astItems[nItem].stValue;
+    TELEMETRY_VALUE_ENUM eValue = stValue.eValue;
+    unsigned int unPeriodMs = stValue.unPeriodMs;
+    memset(&stValue, 0, sizeof (stValue));
+    stValue.eValue = eValue;
+    stValue.unPeriodMs = unPeriodMs;
+    stValue.nLastResult = ERR_DATA_PENDING;
+  }
+  memset(&m_stStats, 0, sizeof (m_stStats));
+  m_unInFlight = 0;
+
+  m_ullStartUs = CReliability::GetMonotonicTimeUs();
+  m_ullStopUs = 0;
+  m_ullNextStartUs = m_ullStartUs;
+  Schedule(m_ullStartUs);
+  m_bStop = FALSE;
+
+  for (unsigned int unWorker = 0; unWorker < m_unNumWorkers; unWorker++)
+  {
+    if (0 != pthread_create(&m_aWorkers[unWorker], NULL, WorkerThread, this))
+    {
+      DEBUG1("CTelemetryPoller::Start(): Unable to start worker thread %u!", unWorker);
+      nRetVal = ERR_INTERNAL_ERR;
+      break;
+    }
+    m_unWorkersRunning++;
+  }
+  pthread_mutex_unlock(&m_Mutex);
+
+  if (nRetVal < 0)
+  {
+    Stop();
+  }
+
+  return nRetVal;
+}
+
+// Stop polling, after the reads in progress
+int CTelemetryPoller::Stop()
+{
+  pthread_mutex_lock(&m_Mutex);
+  unsigned int unWorkers = m_unWorkersRunning;
+  m_bStop = TRUE;
+  pthread_cond_broadcast(&m_Cond);
+  pthread_mutex_unlock(&m_Mutex);
+
+  for (unsigned int unWorker = 0; unWorker < unWorkers; unWorker++)
+  {
+    pthread_join(m_aWorkers[unWorker], NULL);
+  }
+
+  pthread_mutex_lock(&m_Mutex);
+  if (unWorkers > 0)
+  {
+    m_ullStopUs = CReliability::GetMonotonicTimeUs();
+  }
+  m_unWorkersRunning = 0;
+  pthread_mutex_unlock(&m_Mutex);
+
+  return ERR_SUCCESS;
+}
+
+BOOL CTelemetryPoller::IsRunning()
+{
+  pthread_mutex_lock(&m_Mutex);
+  BOOL bRunning = (m_unWorkersRunning > 0) && !m_bStop;
+  pthread_mutex_unlock(&m_Mutex);
+
+  return bRunning;
+}
+
+// Item to read next
+CTelemetryPoller::ItemStruct *CTelemetryPoller::NextItem(unsigned long long ullNowUs, unsigned long long *pullWakeUs)
+{
+  ItemStruct *pstNext = NULL;
+  unsigned long long ullWakeUs = 0;
+
+  for (int nItem = 0; nItem < m_nNumItems; nItem++)
+  {
+    ItemStruct &stItem = m_astItems[nItem];
+    unsigned long long ullPeriodUs = stItem.unPeriodMs * 1000ULL;
+
+    if (stItem.bBusy)
+    {
+      continue;
+    }
+
+    // Polls missed while the previous read was in progress are skipped, not made up
+    if (ullNowUs >= stItem.ullDueUs + ullPeriodUs)
+    {
+      unsigned long long ullMissed = (ullNowUs - stItem.ullDueUs) / ullPeriodUs;
+      stItem.ullDueUs += ullMissed * ullPeriodUs;
+      stItem.stValue.ulSkipped += ullMissed;
+      m_stStats.ulSkipped += ullMissed;
+    }
+
+    // One read of a device at a time
+    BOOL bDevBusy = FALSE;
+    for (int nOther = 0; nOther < m_nNumItems; nOther++)
+    {
+      if (m_astItems[nOther].bBusy && m_astItems[nOther].pvDev == stItem.pvDev)
+      {
+        bDevBusy = TRUE;
+        break;
+      }
+    }
+    if (bDevBusy)
+    {
+      continue;
+    }
+
+    if (NULL == pstNext || stItem.ullDueUs < pstNext->ullDueUs)
+    {
+      pstNext = &stItem;
+    }
+  }
+
+  if (pstNext)
+  {
+    ullWakeUs = (pstNext->ullDueUs > m_ullNextStartUs) ? pstNext->ullDueUs : m_ullNextStartUs;
+    if (ullWakeUs > ullNowUs)
+    {
+      pstNext = NULL;
+    }
+  }
+
+  *pullWakeUs = ullWakeUs;
+  return pstNext;
+}
+
+// Make one read
+int CTelemetryPoller::Read(const ItemStruct &stItem, long long *pllValue)
+{
+  int nRetVal = ERR_INVALID_ARGS;
+
+  switch (stItem.eValue)
+  {
+  case TELEMETRY_HTR_TEMP:
+    {
+      int nTemp = 0;
+      nRetVal = ((CHeaterCtrl *) stItem.pvDev)->GetHtrChTempMilliDegC(&nTemp);
+      *pllValue = nTemp;
+    }
+    break;
+
+  case TELEMETRY_HTR_PWM:
+    {
+      unsigned int unPWM = 0;
+      nRetVal = ((CHeaterCtrl *) stItem.pvDev)->GetHtrChPWMMilliP(&unPWM);
+      *pllValue = unPWM;
+    }
+    break;
+
+  case TELEMETRY_HTR_CURRENT:
+    {
+      int nCurrent = 0;
+      nRetVal = ((CHeaterCtrl *) stItem.pvDev)->GetHtrCurrent(&nCurrent);
+      *pllValue = nCurrent;
+    }
+    break;
+
+  case TELEMETRY_EPC_PRESSURE:
+    {
+      unsigned long ulPressure = 0;
+      nRetVal = ((CEPC *) stItem.pvDev)->GetPressure(&ulPressure);
+      *pllValue = ulPressure;
+    }
+    break;
+
+  case TELEMETRY_EPC_TEMP:
+    {
+      int nTemp = 0;
+      nRetVal = ((CEPC *) stItem.pvDev)->GetOnBoardTemp(&nTemp);
+      *pllValue = nTemp;
+    }
+    break;
+
+  case TELEMETRY_RTD_TEMP:
+    {
+      long lTemp = 0;
+      nRetVal = ((CRTD *) stItem.pvDev)->GetTempInMilliDegC(&lTemp);
+      *pllValue = lTemp;
+    }
+    break;
+
+  case TELEMETRY_RTD_PWM:
+    {
+      long lPWM = 0;
+      nRetVal = ((CRTD *) stItem.pvDev)->GetPWMInMilliPercent(&lPWM);
+      *pllValue = lPWM;
+    }
+    break;
+
+  case TELEMETRY_PRESSURE:
+    {
+      unsigned long ulPressure = 0;
+      nRetVal = ((CPressure *) stItem.pvDev)->GetPressure(&ulPressure);
+      *pllValue = ulPressure;
+    }
+    break;
+
+  case TELEMETRY_CUSTOM:
+    nRetVal = stItem.pfnRead(stItem.pvDev, pllValue);
+    break;
+  }
+
+  return nRetVal;
+}
+
+// Worker loop - take the next due item, read it without the lock, store the result
+void CTelemetryPoller::Work()
+{
+  pthread_mutex_lock(&m_Mutex);
+
+  while (!m_bStop)
+  {
+    unsigned long long ullNowUs = CReliability::GetMonotonicTimeUs();
+    unsigned long long ullWakeUs = 0;
+    ItemStruct *pstItem = NextItem(ullNowUs, &ullWakeUs);
+
+    if (NULL == pstItem)
+    {
+      if (0 == ullWakeUs)
+      {
+        // Everything is being read - wait for a read to complete
+        pthread_cond_wait(&m_Cond, &m_Mutex);
+      }
+      else
+      {
+        struct timespec stWake;
+        stWake.tv_sec = ullWakeUs / 1000000ULL;
+        stWake.tv_nsec = (ullWakeUs % 1000000ULL) * 1000;
+        pthread_cond_timedwait(&m_Cond, &m_Mutex, &stWake);
+      }
+      continue;
+    }
+
+    unsigned int unJitterUs = (unsigned int) (ullNowUs - pstItem->ullDueUs);
+    pstItem->bBusy = TRUE;
+    pstItem->ullDueUs += pstItem->unPeriodMs * 1000ULL;
+    m_ullNextStartUs = ullNowUs + m_unMinGapUs;
+    if (++m_unInFlight > m_stStats.unMaxInFlight)
+    {
+      m_stStats.unMaxInFlight = m_unInFlight;
+    }
+    ItemStruct stItem = *pstItem;
+    pthread_mutex_unlock(&m_Mutex);
+
+    long long llValue = 0;
+    int nResult = Read(stItem, &llValue);
+    unsigned long long ullEndUs = CReliability::GetMonotonicTimeUs();
+    unsigned int unReadUs = (unsigned int) (ullEndUs - ullNowUs);
+
+    pthread_mutex_lock(&m_Mutex);
+    TelemetryValueStruct &stValue = pstItem->stValue;
+    stValue.nLastResult = nResult;
+    stValue.ulReads++;
+    if (nResult < 0)
+    {
+      stValue.ulErrors++;
+      m_stStats.ulErrors++;
+    }
+    else
+    {
+      stValue.llValue = llValue;
+      stValue.ullTimeUs = ullEndUs;
+    }
+    stValue.unLastJitterUs = unJitterUs;
+    stValue.ullTotalJitterUs += unJitterUs;
+    if (unJitterUs > stValue.unMaxJitterUs)
+    {
+      stValue.unMaxJitterUs = unJitterUs;
+    }
+    if (unJitterUs > m_stStats.unMaxJitterUs)
+    {
+      m_stStats.unMaxJitterUs = unJitterUs;
+    }
+    stValue.unLastReadUs = unReadUs;
+    if (unReadUs > stValue.unMaxReadUs)
+    {
+      stValue.unMaxReadUs = unReadUs;
+    }
+    m_stStats.ulReads++;
+    m_stStats.ullBusyUs += unReadUs;
+
+    pstItem->bBusy = FALSE;
+    m_unInFlight--;
+    pthread_cond_broadcast(&m_Cond);
+  }
+
+  pthread_mutex_unlock(&m_Mutex);
+}
+
+void *CTelemetryPoller::WorkerThread(void *pvArg)
+{
+  CHALTrace::SetThreadName("Telemetry worker");
+  ((CTelemetryPoller *) pvArg)->Work();
+  return NULL;
+}
+
+// Latest reading of an item
+int CTelemetryPoller::GetValue(int ItemId, TelemetryValueStruct *Value)
+{
+  int nRetVal = ERR_SUCCESS;
+
+  if (NULL == Value)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  pthread_mutex_lock(&m_Mutex);
+  if ( (ItemId < 0) || (ItemId >= m_nNumItems) )
+  {
+    nRetVal = ERR_INVALID_ARGS;
+  }
+  else
+  {
+    *Value = m_astItems[ItemId].stValue;
+  }
+  pthread_mutex_unlock(&m_Mutex);
+
+  return nRetVal;
+}
+
+// Latest readings of all items
+int CTelemetryPoller::GetTable(TelemetryValueStruct *Values, int MaxValues)
+{
+  int nNumValues = 0;
+
+  if ( (NULL == Values) || (MaxValues < 0) )
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  pthread_mutex_lock(&m_Mutex);
+  while ( (nNumValues < m_nNumItems) && (nNumValues < MaxValues) )
+  {
+    Values[nNumValues] = m_astItems[nNumValues].stValue;
+    nNumValues++;
+  }
+  pthread_mutex_unlock(&m_Mutex);
+
+  return nNumValues;
+}
+
+int CTelemetryPoller::GetStats(TelemetryStatsStruct *Stats)
+{
+  if (NULL == Stats)
+  {
+    return ERR_INVALID_ARGS;
+  }
+
+  pthread_mutex_lock(&m_Mutex);
+  *Stats = m_stStats;
+  if (m_ullStartUs > 0)
+  {
+    Stats->ullRunUs = (m_ullStopUs ? m_ullStopUs : CReliability::GetMonotonicTimeUs()) - m_ullStartUs;
+  }
+  pthread_mutex_unlock(&m_Mutex);
+
+  if (Stats->ullRunUs > 0)
+  {
+    Stats->dReadsPerSec = Stats->ulReads * 1000000.0 / Stats->ullRunUs;
+    Stats->dBusyRatio = (double) Stats->ullBusyUs / Stats->ullRunUs;
+  }
+
+  return ERR_SUCCESS;
+}
@@ -85,8 +85,25 @@
 #include "ResolveDevName.h" // For CResolveDevName
 #include "CANComm.h"        // For CCANComm object
 #include "Reliability.h"    // For the CReliability object
+#include "DevTransaction.h" // For CDevTxn / CDevRequest
+#include "DevConfigCache.h" // For CDevConfigCache
+#include "HALLock.h"        // For CHALLock
 #include "UDPClient.h"
 
+// A process value pushed by the device on its stream channel (see
+// CHeaterCtrl::SetStreamPeriod(), CEPC::SetStreamPeriod())
+struct DevStreamValueStruct {
+  STREAM_VALUE_ENUM eValue;       // What the value is
+  int nValue;
+  unsigned long long ullTimeUs;   // When it was read off the stream pipe (monotonic clock)
+};
+
+// Counters of the pushed process values
+struct DevStreamStatsStruct {
+  unsigned long ulReceived;       // Values received
+  unsigned long ulMissed;         // Values lost on the way (sequence number gaps)
+};
+
 // Base class 
 class CBaseDev
 {
@@ -106,6 +123,10 @@ protected:
   // the backplane SPI bus)
   int m_nExpSlotSPIfd;
 
+  // Guards the exchanges with the ROC expansion cards and the per card state the 
+  // device classes keep for them (shared by all the objects in the process)
+  static pthread_mutex_t m_ExpSlotSPIMutex;
+
   // Pointer to UDP communication class object
   CUDPClient * m_pobUDP;
 
@@ -126,6 +147,15 @@ protected:
   // Does the device support streaming?
   BOOL m_bIsStreaming;
 
+  // Last known configuration settings of the device (off unless enabled)
+  CDevConfigCache m_obCfgCache;
+
+  // Process values pushed by the device (guarded by the stream lock)
+  unsigned int m_unPushPeriodMs;      // Period the device was set to push at, 0 if not pushing
+  BOOL m_bPushSeqValid;               // A value was received to check the next one against
+  unsigned char m_byPushNextSeq;      // Sequence number the next value should have
+  DevStreamStatsStruct m_stPushStats;
+
   // OpenHal the device. Returns 0 on success, negative error code on failure
   int OpenHal(char* pszDevNamed,       // Name of the device to open
               BOOL bStream = FALSE);   // Is the device a streaming device?
@@ -133,9 +163,52 @@ protected:
   // Closes the device. Returns 0 on success, negative error code on failure
   int CloseHal();
 
+  // Locks serializing the use of this object by several threads, NULL if the 
+  // device is not open on CAN (see HALLock.h)
+  CHALMutex *GetCmdLock();
+  CHALMutex *GetStrmLock();
+
   // Translate device error into HAL error code
   int TransDevError(int nDevError);
 
+  // Send the request's command to the device and wait for its response. 
+  // Returns ERR_SUCCESS if the device ACK'd with a response of the expected size,
+  // the translated device error if it NACK'd, negative error code otherwise.
+  int Transact(CDevTxn &obTxn,                            // Request to send
+               unsigned int unTimeOut = HAL_DFLT_TIMEOUT); // Time to wait for the response
+
+  // Send several requests to the device back to back and collect all responses,
+  // costing about one round trip instead of one per request. The result of each
+  // request is in its GetResult(). Returns the first failing result, or ERR_SUCCESS.
+  int TransactBatch(CDevTxn **apobTxn,                         // Requests to send
+                    int nNumTxn,                               // Number of requests (up to MAX_DEV_TXN_BATCH)
+                    unsigned int unTimeOut = HAL_DFLT_TIMEOUT,  // Time to wait for each response
+                    BOOL bStreamingTx = FALSE);                 // Indicates if we are transmitting streaming data
+
+  // Settings of the device class that the configuration cache may hold (see
+  // DevConfigCache.h). Called from the constructor of the device class.
+  void SetConfigCacheMap(const DevCacheMapStruct *pstMap, int nMapLen);
+
+  // Note the period the device now pushes its process values at (0 - stopped).
+  // Starting clears the counters, stopping drops the values still in the stream pipe.
+  void SetPushPeriod(unsigned int unPeriodMs);
+
+  // Read the next process value pushed by the device, waiting up to unTimeOut
+  // milli-seconds. Returns ERR_TIMEOUT if none arrived.
+  int ReadPushedValue(DevStreamValueStruct *pstValue,   // Value read
+                      unsigned int unTimeOut,           // Time to wait for it
+                      const char *pszCaller);           // For the log messages
+
+  // Counters of the pushed process values
+  int GetPushStats(DevStreamStatsStruct *pstStats);
+
+private:
+  // Check that the device can be talked to over CAN
+  int CheckTxnChannel(const char *pszCaller);
+
+  // Evaluate the response of a completed request and set its result
+  int CompleteTxn(CDevTxn &obTxn);
+
 public:
   CBaseDev(); // Default Constructor
   
@@ -143,5 +216,22 @@ public:
 
   // Function will resolve error message from error code
   CHAR *GetErrorMsg(ERR_CODE iErrorCode);
+
+  // Get retry and latency statistics of the communication with this device
+  int GetCommStats(ReliabilityStatsStruct *pstStats);
+
+  // Clear the communication statistics of this device
+  int ResetCommStats();
+
+  // Keep the configuration settings written to / read from the device, so that
+  // reading them back does not go to the device. Off by default. Returns
+  // ERR_NOT_IMPLEMENTED if the device has no settings that can be kept.
+  int EnableConfigCache(BOOL bEnable);
+
+  // Forget the kept settings - call after the board has been reset
+  void InvalidateConfigCache();
+
+  // Get the configuration cache counters (hits are bus transactions avoided)
+  int GetConfigCacheStats(DevCacheStatsStruct *pstStats);
 };
 #endif // #ifndef _BASE_DEV_H
@@ -207,6 +207,7 @@ typedef struct {
     float           CompFactor;             // Compensation factor (base temp/correction factor)
 #endif //#ifdef MODEL_370XA
     BASEIO_ANLOUT_PWR_ENUM AnlOutPower;   // Analog output power source
+    unsigned long StreamPeriodMs;         // Period of the pushed process values
   } __attribute (( packed )) BaseIOData;
 } __attribute (( packed )) BASEIO_DATA_STRUCT ;
 
@@ -317,6 +318,7 @@ typedef enum {
   CMD_EPC_FN_SET_TEMP_COMP_BASE   = 7,    // Base temperature at which we don't do any pressure compensation
   CMD_EPC_FN_SET_TEMP_COMP_CORR   = 8,    // Correction factor for pressure sensor reading
 #endif //MODEL_370XA
+  CMD_EPC_FN_SET_STREAM_PERIOD    = 9,    // Push pressure, on-board temp (and PWM) every StreamPeriodMs on the stream channel (0 - stop)
 
   //Get commands
   CMD_EPC_FN_GET_PRESSURE   = 41, // Get pressure (in millivolts)
@@ -93,6 +93,8 @@
 #include "Definitions.h"  // For common definitions and structures.
 #include "ipc.h"          // For Named Pipe Comm.
 #include "DataFragment.h"
+#include "CANMux.h"       // For the multiplexed connection to CAND
+#include "HALLock.h"      // For CHALMutex
 
 
 // Class for Sending / Receiving CAN Data
@@ -111,6 +113,13 @@ private:
   // the last object destroyed
   static int m_nInstances; 
 
+  // Guards the Command TX Pipe and m_nInstances - shared by all the objects in the process
+  static pthread_mutex_t m_TxMutex;
+
+  // Serialize the use of this object by several threads (see HALLock.h)
+  CHALMutex m_obCmdLock;    // Command / response exchanges
+  CHALMutex m_obStrmLock;   // Stream reads
+
   // Is the CmdRespRx pipe open?
   BOOL m_bIsCmdRespPipeOpen;
 
@@ -122,6 +131,10 @@ private:
   unsigned char m_byFnType;   // Device Function Type (Analog In / Analog Out etc...)
   unsigned char m_byFnEnum;   // Device Function Enumeration
 
+  // Device queues on the process wide multiplexed connection - NULL if this device
+  // has its own pipes (see CCANMux)
+  CANMuxChannelStruct *m_pstMuxChannel;
+
   CDataFragment m_obCmdRespFrag;    // Fragment object for storing Command Response fragments
   CDataFragment m_obStrmRespFrag;   // Fragment object for storing Stream Response fragments
 
@@ -130,6 +143,9 @@ private:
   // Private Helper Functions
   int CloseRxPipes(); // Close all the open pipes.
 
+  // Write a packet to the Command TX Pipe. Returns the number of bytes written.
+  static int SendToCAND (void *pvData, int nCount);
+
   // Read from CAND
   int RxData (unsigned char* pbyData,    // Pointer to write data to
               unsigned int unDataLen,    // Number of bytes to read
@@ -224,6 +240,15 @@ public:
 
   //Returns part of the timeout interval that was not used.
   int GetRemTimeOut();
+
+  // Slot address of the remote device this channel was opened for
+  unsigned char GetSlotID();
+
+  // Locks serializing the use of this device by several threads (see HALLock.h).
+  // Hold the command lock across calls that must not be interleaved with commands
+  // from other threads, e.g. GetRemTimeOut() after a response.
+  CHALMutex *GetCmdLock();
+  CHALMutex *GetStrmLock();
 };
 
 #endif // #ifndef _CANCOMM_H
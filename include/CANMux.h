@@ -0,0 +1,132 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                    10241 West Little York, Suite 200
+ * *                           Houston, TX 77040
+ * *
+ * *
+ * *  Filename: CANMux.h
+ * *
+ * *  Description: One multiplexed connection from CAND per process, with
+ * *               received CAN packets demultiplexed to the devices.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+// CANMux.h - header file for CCANMux
+//
+// By default every CCANComm opens its own Command Response pipe (and Stream pipe
+// for streaming devices) and CAND opens its own end of each. A process with many
+// HAL objects ends up with two pipes per device, each created at start up and each
+// read with one system call per CAN packet.
+//
+// After CCANMux::Enable(TRUE), devices are instead registered with CAND on two
+// pipes shared by the whole process (one for command responses, one for stream
+// data). A demultiplexer thread reads from the
+// shared pipes, many packets per read, and queues each packet for the device it is
+// addressed to (Slot ID : Fn Type : Fn Count from the CAN header). CCANComm reads
+// the device's queue instead of a pipe. CAND keeps one pipe end per shared pipe.
+//
+// The gain is in fds and in streaming, where one read picks up many packets. A
+// single command / response costs more than with a pipe of its own: the response
+// is handed over by the demultiplexer thread (about 10 system calls instead of 4,
+// most of them futex wake ups).
+//
+// Nothing changes for the device classes - the CCANComm interface is the same in
+// both modes. CCANComm::CANGetRxStrmFd() returns a per-device notification fd in
+// multiplexed mode, readable while stream data is queued for the device.
+//
+// All members are static - there is one multiplexed connection per process.
+
+#ifndef _CAN_MUX_H
+#define _CAN_MUX_H
+
+#include <pthread.h>
+#include "Definitions.h"  // For common definitions and structures.
+#include "ipc.h"          // For Named Pipe Comm.
+
+// Task ID of the shared pipes is CAN_MUX_PIPE_TASK_ID_BASE + process id. Device
+// pipe Task IDs are 32768 + (14 bit device address), so these never collide.
+#define CAN_MUX_PIPE_TASK_ID_BASE   (32768 + 16384)
+
+// Maximum number of devices open on the multiplexed connection in a process
+#define CAN_MUX_MAX_CHANNELS        64
+
+// Packets queued per device before the oldest is dropped
+#define CAN_MUX_RESP_QUEUE_LEN      64    // Command responses (fragmented responses included)
+#define CAN_MUX_STRM_QUEUE_LEN      256   // Stream data
+
+// Number of packets read from a shared pipe with one system call
+#define CAN_MUX_READ_BATCH          32
+
+// Counters for the multiplexed connection
+struct CANMuxStatsStruct {
+  unsigned long ulPipeReads;      // Read system calls on the shared pipes
+  unsigned long ulPktsRxd;        // CAN packets read from the shared pipes
+  unsigned long ulPktsUnknown;    // Packets for a device not open in this process
+  unsigned long ulPktsDropped;    // Packets dropped because a device queue was full
+  int nOpenChannels;              // Devices currently open on the connection
+};
+
+// Per device state, opaque outside CANMux.cpp
+struct CANMuxChannelStruct;
+
+class CCANMux {
+private:
+  static BOOL m_bEnabled;
+  static pthread_mutex_t m_Mutex;
+  static pthread_t m_DemuxThread;
+  static BOOL m_bDemuxThreadRunning;
+  static BOOL m_bPipesOpen;
+  static int m_nPipeTaskId;
+  static CIPC m_obIPCCmdRespRx;   // Shared Command Response pipe
+  static CIPC m_obIPCStreamRx;    // Shared Stream pipe
+  static CANMuxChannelStruct *m_apstChannels[CAN_MUX_MAX_CHANNELS];
+  static int m_nChannels;
+  static CANMuxStatsStruct m_stStats;
+
+  static int OpenPipes();
+  static void ClosePipes();
+  static void *DemuxThread(void *pvArg);
+  static void ReadPipe(int nFd, CANDRespStruct *pstBuf, int *pnBufBytes);
+  static void Dispatch(const CANDRespStruct *pstPkts, int nNumPkts);
+
+public:
+  // Use the multiplexed connection (or not) for devices opened from now on.
+  // Devices already open keep the connection they were opened with.
+  static void Enable(BOOL bEnable);
+  static BOOL IsEnabled();
+
+  // Counters for the multiplexed connection
+  static void GetStats(CANMuxStatsStruct *pstStats);
+
+  // Used by CCANComm -
+  // Attach a device to the shared pipes. Returns the IPC id to register with CAND
+  // (for both the command response and the stream pipe) in *pnPipeTaskId.
+  static int Attach(unsigned char bySlotId, unsigned char byFnType, unsigned char byFnEnum,
+                    BOOL bIsStreaming, CANMuxChannelStruct **ppstChannel, int *pnPipeTaskId);
+
+  // Detach a device. Packets still queued for it are dropped.
+  static void Detach(CANMuxChannelStruct *pstChannel);
+
+  // Get the next packet queued for a device. pnTimeout == NULL -> block until one
+  // arrives, else wait up to *pnTimeout ms and update it with the time left.
+  // Returns sizeof (CANDRespStruct) on success, ERR_TIMEOUT on timeout.
+  static int Receive(CANMuxChannelStruct *pstChannel, BOOL bStrmPipe,
+                     CANDRespStruct *pstResp, INT32 *pnTimeout);
+
+  // Drop all packets queued for a device
+  static void Flush(CANMuxChannelStruct *pstChannel, BOOL bStrmPipe);
+
+  // Fd readable while stream data is queued for the device (for select())
+  static int GetStreamFd(CANMuxChannelStruct *pstChannel);
+};
+
+#endif // #ifndef _CAN_MUX_H
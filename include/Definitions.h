@@ -149,6 +149,7 @@ struct PipeMailBoxStruct {
 // Error codes
 enum ERR_CODE {
   ERR_NOT_IMPLEMENTED = -100, // Not implemented yet. Need to take this out eventually. 
+  ERR_SLOT_OFFLINE = -17, // Board in this slot stopped responding, request not sent (see CSlotHealth)
   ERR_OPEN_FILE = -16, // Can't open file
   ERR_CMD_FAILED = -15, // The device indicated that the command was NOT successfully executed
   ERR_DATA_PENDING = -14, // Data pending - if trying to read a fragmented packet before it's fully received
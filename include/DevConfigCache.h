@@ -0,0 +1,122 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                    10241 West Little York, Suite 200
+ * *                           Houston, TX 77040
+ * *
+ * *
+ * *  Filename: DevConfigCache.h
+ * *
+ * *  Description: Write-through cache of the configuration settings of a
+ * *               device function.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+// DevConfigCache.h - header file for CDevConfigCache
+//
+// Keeps the last value written to or read from each configuration setting of a
+// device function (PID gains, preamp gain ...), so that reading a setting back does
+// not cost a bus transaction. CBaseDev::Transact() consults the cache of the device
+// before sending a get command and updates it from every completed request.
+//
+// The settings are described by a table of the device class - the set command that
+// changes a setting and the get command that reads it back. When the set command
+// carries the value in the same layout the get command returns it (bWriteThrough),
+// an ACK'd set makes the value known without reading it; otherwise (e.g. a command
+// that makes the board pick the value itself) the set command only makes the
+// cached value unknown. Measurements are never in the table.
+//
+// Values are kept in wire byte order, as they are on the bus. The cache is off
+// until enabled. It only knows what this object sent - enable it only for settings
+// no one else changes - and it forgets everything when a request fails (NACK,
+// timeout, slot off line), since the board may have been reset. After a known
+// board reset call Invalidate().
+//
+// Not thread safe - CBaseDev holds the command lock of the device around its use.
+
+#ifndef _DEV_CONFIG_CACHE_H
+#define _DEV_CONFIG_CACHE_H
+
+#include "Definitions.h"      // For common definitions and structures.
+#include "DevTransaction.h"   // For CDevTxn
+
+// Limits of the settings of one device function
+#define DEV_CACHE_MAX_ENTRIES   16
+#define DEV_CACHE_MAX_DATA      16    // Bytes following the CmdAckUnion
+
+// One setting of a device function
+struct DevCacheMapStruct {
+  unsigned char bySetCmd;   // Command that changes the setting
+  unsigned char byGetCmd;   // Command that reads it back
+  BOOL bWriteThrough;       // Set command carries the value as the get command returns it
+};
+
+struct DevCacheStatsStruct {
+  unsigned long ulHits;           // Reads answered from the cache - bus transactions avoided
+  unsigned long ulMisses;         // Reads of a setting not in the cache (sent to the device)
+  unsigned long ulWrites;         // Values taken from ACK'd set commands
+  unsigned long ulInvalidations;  // Times the whole cache was dropped
+};
+
+class CDevConfigCache {
+private:
+  struct EntryStruct {
+    BOOL bValid;
+    unsigned int unLen;
+    unsigned char abyData[DEV_CACHE_MAX_DATA];
+  };
+
+  const DevCacheMapStruct *m_pstMap;
+  int m_nMapLen;
+  BOOL m_bEnabled;
+
+  // One per map row, used by the first row of each get command
+  EntryStruct m_astEntry[DEV_CACHE_MAX_ENTRIES];
+  DevCacheStatsStruct m_stStats;
+
+  // Entry of a get command, NULL if it is not a cached setting
+  EntryStruct *FindGetEntry(unsigned char byCommand);
+
+  void Store(EntryStruct *pstEntry, const unsigned char *pbyData, unsigned int unLen);
+
+public:
+  CDevConfigCache();
+
+  // Settings of the device class (a static table, up to DEV_CACHE_MAX_ENTRIES rows)
+  void SetMap(const DevCacheMapStruct *pstMap, int nMapLen);
+
+  BOOL HasMap() const { return m_nMapLen > 0; }
+
+  // Turn the cache on / off. Either way it starts empty.
+  void Enable(BOOL bEnable);
+
+  BOOL IsEnabled() const { return m_bEnabled; }
+
+  // Forget all values
+  void Invalidate();
+
+  // Does a request change a cached setting?
+  BOOL IsSetCommand(unsigned char byCommand) const;
+
+  // Answer a get request from the cache - fills in its response (host order) and
+  // result. Returns FALSE if the request has to be sent to the device.
+  BOOL Lookup(CDevTxn &obTxn);
+
+  // Take in an ACK'd request, before its response is converted to host order
+  void Update(CDevTxn &obTxn);
+
+  void GetStats(DevCacheStatsStruct *pstStats) const
+  {
+    *pstStats = m_stStats;
+  }
+};
+
+#endif // #ifndef _DEV_CONFIG_CACHE_H
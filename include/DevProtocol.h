@@ -140,6 +140,22 @@ typedef struct {
   unsigned char Revision;
 }__attribute(( packed ))DEVICE_SYSTEM_INFO_STRUCT;
 
+// Process values a function pushes on its stream channel once its stream period is
+// set (CMD_HTR_FN_SET_STREAM_PERIOD, CMD_EPC_FN_SET_STREAM_PERIOD)
+typedef enum {
+  STREAM_VAL_TEMP_MDEGC = 0,        // Temperature in milli DegC
+  STREAM_VAL_PWM_MPCT = 1,          // PWM in milli %
+  STREAM_VAL_PRESSURE_MV = 2,       // Pressure in milli volts
+  STREAM_VAL_ON_BD_TEMP_MDEGC = 3,  // On-board temperature in milli DegC
+} STREAM_VALUE_ENUM;
+
+// One pushed process value - fits a single CAN packet
+typedef struct {
+  unsigned char ValueType;  // STREAM_VALUE_ENUM
+  unsigned char SeqNum;     // Incremented with every value the function pushes
+  int Value;
+}__attribute(( packed ))PROCESS_VALUE_STREAM_STRUCT;
+
 // ACK / NACK sent from Device to Host in response to commands. 
 // If the device understands the command and the parameters (if any) passed 
 // along with command are valid and the device is able to successfully perform 
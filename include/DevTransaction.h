@@ -0,0 +1,150 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                    10241 West Little York, Suite 200
+ * *                           Houston, TX 77040
+ * *
+ * *
+ * *  Filename: DevTransaction.h
+ * *
+ * *  Description: Typed command / response transactions with a device
+ * *               function.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+// DevTransaction.h - header file for CDevTxn and CDevRequest
+//
+// Every command sent to a device function has the same shape - a packed command
+// structure that starts with a CmdAckUnion, and a packed response structure that
+// also starts with a CmdAckUnion. A NACK'd command comes back with the error type
+// in the byte following the CmdAckUnion.
+//
+// CDevRequest<TCmd, TResp> describes one such exchange. The device class fills in
+// Cmd(), hands the request to CBaseDev::Transact() (or several of them to
+// CBaseDev::TransactBatch()) and reads Resp() on success. Size checks, NACK
+// translation and error logging are done once, in CBaseDev, for every command.
+//
+// Cmd() and Resp() are in host byte order - the command is converted to wire 
+// order when it is sent and the response back to host order when it has been 
+// ACK'd, using the descriptors of TCmd and TResp (see WireLayouts.h).
+//
+// Example -
+//   CDevRequest<CAN_CMD_HTR_STRUCT, CAN_CMD_HTR_STATUS_STRUCT> obReq(CMD_HTR_FN_SET_PROP_GAIN);
+//   obReq.Cmd().stData.htrsolDataUnion.PropGain = ulPropGainMilli;
+//   nRetVal = Transact(obReq);
+
+#ifndef _DEV_TRANSACTION_H
+#define _DEV_TRANSACTION_H
+
+#include <string.h>
+#include "Definitions.h"  // For common definitions and structures.
+#include "FixEndian.h"    // For SetCmdAckCommand()
+#include "WireFormat.h"   // For HostToWire() / WireToHost()
+
+// Maximum number of requests that can be sent to a device in one batch
+#define MAX_DEV_TXN_BATCH   16
+
+// One command / response exchange with a device function
+class CDevTxn {
+private:
+  unsigned char m_byCommand;
+  unsigned char *m_pbyCmd;
+  unsigned int m_unCmdLen;
+  unsigned char *m_pbyResp;
+  unsigned int m_unRespLen;
+
+  // Raw result from the reliability layer - bytes received or negative error code
+  int m_nRespBytes;
+
+  // Result of the transaction as returned by CBaseDev::Transact()
+  int m_nResult;
+
+  // Has the command been converted to wire byte order?
+  BOOL m_bCmdOnWire;
+
+  // Not copyable - the buffer pointers refer to the derived object
+  CDevTxn(const CDevTxn &);
+  CDevTxn &operator=(const CDevTxn &);
+
+protected:
+  CDevTxn(unsigned char byCommand,
+          unsigned char *pbyCmd, unsigned int unCmdLen,
+          unsigned char *pbyResp, unsigned int unRespLen)
+    : m_byCommand(byCommand),
+      m_pbyCmd(pbyCmd), m_unCmdLen(unCmdLen),
+      m_pbyResp(pbyResp), m_unRespLen(unRespLen),
+      m_nRespBytes(ERR_INVALID_SEQ), m_nResult(ERR_INVALID_SEQ),
+      m_bCmdOnWire(FALSE)
+  {
+  }
+
+  // Byte order conversion of the command / response structures
+  virtual void CmdToWire() = 0;
+  virtual void RespToHost() = 0;
+
+public:
+  virtual ~CDevTxn() {}
+
+  unsigned char GetCommand() const { return m_byCommand; }
+
+  unsigned char *GetCmdBuf() const { return m_pbyCmd; }
+  unsigned int GetCmdLen() const { return m_unCmdLen; }
+
+  unsigned char *GetRespBuf() const { return m_pbyResp; }
+  unsigned int GetRespLen() const { return m_unRespLen; }
+
+  int GetRespBytes() const { return m_nRespBytes; }
+  void SetRespBytes(int nRespBytes) { m_nRespBytes = nRespBytes; }
+
+  int GetResult() const { return m_nResult; }
+  void SetResult(int nResult) { m_nResult = nResult; }
+
+  // Convert the command to wire byte order before it is first sent
+  void PrepareCmd()
+  {
+    if (!m_bCmdOnWire)
+    {
+      CmdToWire();
+      m_bCmdOnWire = TRUE;
+    }
+  }
+
+  // Convert an ACK'd response to host byte order
+  void FinishResp() { RespToHost(); }
+};
+
+// Command / response exchange described by its packed command and response structures
+template <typename TCmd, typename TResp>
+class CDevRequest : public CDevTxn {
+private:
+  TCmd m_stCmd;
+  TResp m_stResp;
+
+protected:
+  void CmdToWire() { HostToWire(m_stCmd); }
+  void RespToHost() { WireToHost(m_stResp); }
+
+public:
+  explicit CDevRequest(unsigned char byCommand)
+    : CDevTxn(byCommand,
+              (unsigned char *) &m_stCmd, sizeof (TCmd),
+              (unsigned char *) &m_stResp, sizeof (TResp))
+  {
+    memset(&m_stCmd, 0, sizeof (m_stCmd));
+    memset(&m_stResp, 0, sizeof (m_stResp));
+    SetCmdAckCommand((unsigned char *) &m_stCmd, byCommand);
+  }
+
+  TCmd &Cmd() { return m_stCmd; }
+  TResp &Resp() { return m_stResp; }
+};
+
+#endif // #ifndef _DEV_TRANSACTION_H
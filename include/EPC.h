@@ -82,9 +82,11 @@ public:
   ~CEPC();  // Destructor
 
   // OpenHal the device. Returns 0 on success, negative error code on failure.
-  int OpenHal (char* pszDevName);
+  // Open with Stream = TRUE to receive the values pushed after SetStreamPeriod().
+  int OpenHal (char* pszDevName, BOOL Stream = FALSE);
 
-  // Closes the device. Returns 0 on success, negative error code on failure.
+  // Closes the device (stopping the pushed values). Returns 0 on success, negative
+  // error code on failure.
   int CloseHal ();
 
   // Get Device Status
@@ -104,6 +106,24 @@ public:
   // Gets the on-board temperature in Milli Degree C.
   int GetOnBoardTemp(int* TempMilliDegC);
 
+  // Gets the Pressure in Milli Volts and the on-board temperature in Milli Degree C in one round trip
+  int GetPressureAndTemp(unsigned long* PressureMilliVolt, int* TempMilliDegC);
+
+  // Have the board push the pressure, the on-board temperature and (370XA) the PWM
+  // every PeriodMs on the stream channel, instead of polling them (0 stops it).
+  // Boards whose firmware does not push values NACK the command (ERR_PROTOCOL).
+  int SetStreamPeriod (unsigned int PeriodMs);
+
+  // Read the next pushed value, waiting up to Timeout milli-seconds. Returns
+  // ERR_TIMEOUT if none arrived.
+  int ReadStreamData (DevStreamValueStruct* Value, unsigned int Timeout);
+
+  // Counters of the pushed values since the last SetStreamPeriod() start
+  int GetStreamStats (DevStreamStatsStruct* Stats);
+
+  // Return Receive Pipe File Descriptor - pushed values (see HALReactor.h)
+  int GetRxStreamingFd ();
+
 #ifdef MODEL_370XA
   int SetPWMMilliP (int nTempMilliP);
   int TurnEPCOff ();
@@ -114,6 +134,10 @@ public:
   int GetPropGain(unsigned long *pulPropGainMilli);
   int GetIntGain(unsigned long *pulIntGainMilli);
   int GetDiffGain(unsigned long *pulDiffGainMilli);
+
+  // Set / get the proportional, integral and differential gains in one round trip
+  int SetPIDGains(unsigned long ulPropGainMilli, unsigned long ulIntGainMilli, unsigned long ulDiffGainMilli);
+  int GetPIDGains(unsigned long *pulPropGainMilli, unsigned long *pulIntGainMilli, unsigned long *pulDiffGainMilli);
   
   // Setup correction factors for Pressure Sensor temperature compensation (Pressure sensor on 
   // the 370XA is outside the oven and affected by ambient temperature changes).
@@ -47,6 +47,8 @@
  *
  *************************************************************************/
 
+#include <pthread.h>
+
 class CDAC_AD5570ARSZ
 {
 private:
@@ -58,6 +60,9 @@ private:
 protected:
   CDAC_AD5570ARSZ(const char *pszDevPath);
 
+  // Guards the last set counts, shared by the objects of a DAC in the process
+  static pthread_mutex_t m_DACMutex;
+
 public:
   ~CDAC_AD5570ARSZ();
 
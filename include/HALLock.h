@@ -0,0 +1,135 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                    10241 West Little York, Suite 200
+ * *                           Houston, TX 77040
+ * *
+ * *
+ * *  Filename: HALLock.h
+ * *
+ * *  Description: Locks used to make HAL objects safe to use from
+ * *               several threads.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+// HALLock.h - header file for CHALMutex and CHALLock
+//
+// Concurrency model of the HAL -
+//
+// (1) Calls on different HAL objects may be made from different threads at the
+//     same time. State shared by all objects of a process (the Command TX pipe to
+//     CAND, the per slot round trip time estimates, the ROC expansion card caches,
+//     the FID DAC counts, the simulator clock) is guarded internally.
+//
+// (2) Calls on the same HAL object from different threads are serialized. Every
+//     object talking over CAN has two locks, owned by its CCANComm -
+//       Command lock: held for each command / response exchange with the device,
+//                     including the retries made by CReliability, and for the
+//                     whole of calls that make several exchanges. It also guards
+//                     the configuration cache of the device (DevConfigCache.h).
+//       Stream lock:  held while reading streaming data (and the state kept
+//                     between stream reads, e.g. the preamp spike filter).
+//     A thread blocked in a stream read therefore does not hold up commands sent
+//     to the same device from another thread. (The preamp noise figures have a lock
+//     of their own, for the same reason.)
+//
+// (3) OpenHal() / CloseHal() are not serialized with other calls on the same
+//     object - open the object before sharing it and close it after the other
+//     threads are done with it.
+//
+// Both locks are recursive, so a call holding a lock may call other functions that
+// take it. When both are needed the stream lock is taken first.
+
+#ifndef _HAL_LOCK_H
+#define _HAL_LOCK_H
+
+#include <stddef.h>   // For NULL
+#include <pthread.h>
+
+// Recursive mutex for per object state
+class CHALMutex {
+private:
+  pthread_mutex_t m_Mutex;
+
+  // Not copyable
+  CHALMutex(const CHALMutex &);
+  CHALMutex &operator=(const CHALMutex &);
+
+public:
+  CHALMutex()
+  {
+    pthread_mutexattr_t stAttr;
+    pthread_mutexattr_init(&stAttr);
+    pthread_mutexattr_settype(&stAttr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&m_Mutex, &stAttr);
+    pthread_mutexattr_destroy(&stAttr);
+  }
+
+  ~CHALMutex()
+  {
+    pthread_mutex_destroy(&m_Mutex);
+  }
+
+  void Lock()
+  {
+    pthread_mutex_lock(&m_Mutex);
+  }
+
+  void Unlock()
+  {
+    pthread_mutex_unlock(&m_Mutex);
+  }
+};
+
+// Holds a lock for the life time of the object (released on every return path).
+// Process wide state is guarded with a plain pthread_mutex_t initialized with
+// PTHREAD_MUTEX_INITIALIZER, so it is usable before any constructor has run. A
+// NULL lock is allowed and ignored (e.g. the locks of a device that is not open).
+class CHALLock {
+private:
+  CHALMutex *m_pobMutex;
+  pthread_mutex_t *m_pMutex;
+
+  // Not copyable
+  CHALLock(const CHALLock &);
+  CHALLock &operator=(const CHALLock &);
+
+public:
+  explicit CHALLock(CHALMutex *pobMutex) : m_pobMutex(pobMutex), m_pMutex(NULL)
+  {
+    if (m_pobMutex)
+    {
+      m_pobMutex->Lock();
+    }
+  }
+
+  explicit CHALLock(pthread_mutex_t *pMutex) : m_pobMutex(NULL), m_pMutex(pMutex)
+  {
+    if (m_pMutex)
+    {
+      pthread_mutex_lock(m_pMutex);
+    }
+  }
+
+  ~CHALLock()
+  {
+    if (m_pobMutex)
+    {
+      m_pobMutex->Unlock();
+    }
+    if (m_pMutex)
+    {
+      pthread_mutex_unlock(m_pMutex);
+    }
+  }
+};
+
+#endif // #ifndef _HAL_LOCK_H
@@ -0,0 +1,147 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                    10241 West Little York, Suite 200
+ * *                           Houston, TX 77040
+ * *
+ * *
+ * *  Filename: HALReactor.h
+ * *
+ * *  Description: Event loop for servicing many HAL objects from one
+ * *               thread.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+// HALReactor.h - header file for CHALReactor
+//
+// Without a reactor, an application reading several streaming devices calls
+// ReadStreamData() / ReadCh() / RxStreamingByte() on each in turn with a timeout,
+// or runs a thread per device. CHALReactor waits (epoll) on the streaming fds of
+// any number of HAL objects and on timers, and calls back when one is ready -
+//
+//   obReactor.Open();
+//   obReactor.AddDevice(&obPreamp1, OnPreampData, &obPreamp1);
+//   obReactor.AddDevice(&obSerial, OnSerialData, &obSerial);
+//   obReactor.AddTimer(1000, TRUE, OnPollTemps, NULL);
+//   obReactor.Run();
+//
+// AddDevice() works with every HAL class that has GetRxStreamingFd() (CPreampStream,
+// CSerial, CLtLoi, CFFBCmmd, and CHeaterCtrl / CEPC pushing their process values).
+// Readiness is level triggered: the callback should read with a zero timeout until
+// the read returns ERR_TIMEOUT. A ready fd only means a CAN packet arrived - a read
+// may still time out while a fragmented message is incomplete (the fragment is kept
+// and completed by a later read), and CSerial may hold bytes in its receive FIFO
+// that no longer show on the fd.
+//
+// A reactor is run from one thread. All calls except Stop() are to be made from that
+// thread (callbacks included). Callbacks may add and remove devices and timers.
+
+#ifndef _HAL_REACTOR_H
+#define _HAL_REACTOR_H
+
+#include "Definitions.h"  // For common definitions and structures.
+
+// Maximum number of fds / timers on one reactor
+#define HAL_REACTOR_MAX_SOURCES   64
+#define HAL_REACTOR_MAX_TIMERS    32
+
+// Called when a source is ready or a timer expires, with the id returned by
+// AddFd() / AddDevice() / AddTimer()
+typedef void (*HALReactorCallback)(int nId, void *pvArg);
+
+class CHALReactor {
+private:
+  struct SourceStruct {
+    int nFd;
+    HALReactorCallback pfnCallback;
+    void *pvArg;
+    BOOL bInUse;
+  };
+
+  struct TimerStruct {
+    unsigned int unIntervalMs;
+    unsigned long long ullDueUs;
+    BOOL bPeriodic;
+    HALReactorCallback pfnCallback;
+    void *pvArg;
+    BOOL bInUse;
+  };
+
+  int m_nEpollFd;
+  int m_anWakeFd[2];    // Written by Stop() to interrupt a wait
+  BOOL m_bStop;         // Set by the reactor's thread when it reads the wake up pipe
+
+  SourceStruct m_astSources[HAL_REACTOR_MAX_SOURCES];
+  TimerStruct m_astTimers[HAL_REACTOR_MAX_TIMERS];
+
+  // Time (ms) until the next timer is due, -1 if none
+  int GetTimerWait(unsigned long long ullNowUs);
+
+  // Call back the timers that are due. Returns the number called.
+  int RunTimers();
+
+  // Not copyable - owns fds
+  CHALReactor(const CHALReactor &);
+  CHALReactor &operator=(const CHALReactor &);
+
+public:
+  CHALReactor();  // Default Constructor
+  ~CHALReactor(); // Destructor
+
+  // Create / release the reactor's epoll and wake up fds
+  int Open();
+  int Close();
+
+  // Watch a file descriptor for readability. Returns the source id (>= 0) or a
+  // negative error code.
+  int AddFd(int nFd, HALReactorCallback pfnCallback, void *pvArg);
+
+  // Watch the streaming data of an open HAL object. Returns the source id (>= 0)
+  // or a negative error code.
+  template <typename TDev>
+  int AddDevice(TDev *pobDev, HALReactorCallback pfnCallback, void *pvArg)
+  {
+    if (pobDev == NULL)
+    {
+      return ERR_INVALID_ARGS;
+    }
+    // Negative if the device is not open for streaming
+    int nFd = pobDev->GetRxStreamingFd();
+    if (nFd < 0)
+    {
+      return nFd;
+    }
+    return AddFd(nFd, pfnCallback, pvArg);
+  }
+
+  // Stop watching a source added with AddFd() / AddDevice()
+  int Remove(int nId);
+
+  // Call back after unIntervalMs, and every unIntervalMs after that if bPeriodic.
+  // Returns the timer id (>= 0) or a negative error code.
+  int AddTimer(unsigned int unIntervalMs, BOOL bPeriodic, HALReactorCallback pfnCallback, void *pvArg);
+
+  // Cancel a timer
+  int RemoveTimer(int nId);
+
+  // Wait up to nTimeoutMs (-1 -> until something is ready) and call back the ready
+  // sources and due timers. Returns the number of callbacks made, or a negative
+  // error code.
+  int RunOnce(int nTimeoutMs);
+
+  // Call RunOnce() until Stop() is called
+  int Run();
+
+  // Make Run() return. May be called from any thread or from a callback.
+  void Stop();
+};
+
+#endif // #ifndef _HAL_REACTOR_H
@@ -0,0 +1,152 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                    10241 West Little York, Suite 200
+ * *                           Houston, TX 77040
+ * *
+ * *
+ * *  Filename: HALTrace.h
+ * *
+ * *  Description: Recording of HAL transactions for a timeline view.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+// HALTrace.h - header file for CHALTrace
+//
+// The DEBUG macros tell what failed, not where the time of a cycle went. With the
+// trace on, every HAL transaction is recorded with the device, command, start and
+// end time, number of attempts and result -
+//
+//   CHALTrace::Enable(TRUE);
+//   ...                                         // Run the cycle
+//   CHALTrace::Enable(FALSE);
+//   CHALTrace::ExportChrome("/tmp/hal.json");   // Open in chrome://tracing or Perfetto
+//
+// Recorded are the requests of CBaseDev::Transact() / TransactBatch() (and the ones
+// answered from the configuration cache), each attempt of CReliability::GetRemoteResp()
+// nested under its request, and the reads of the streaming pipe in CCANComm, which
+// show how long a reader was blocked waiting for data.
+//
+// Each thread records into a ring of its own, so recording takes no lock: the
+// thread fills in the event and then publishes it by advancing its count. When a
+// ring is full the oldest events are overwritten. With the trace off the cost of a
+// recording point is a test of one flag. Times are in micro-seconds of the
+// monotonic clock (see CReliability::GetMonotonicTimeUs()).
+
+#ifndef _HAL_TRACE_H
+#define _HAL_TRACE_H
+
+#include <pthread.h>
+#include "Definitions.h"  // For common definitions and structures.
+
+#define HAL_TRACE_MAX_THREADS     64
+#define HAL_TRACE_THREAD_EVENTS   2048  // Ring size of each thread
+#define HAL_TRACE_NAME_LEN        40    // Device names are truncated to this
+
+typedef enum
+{
+  HAL_TRACE_TRANSACT = 0,   // CBaseDev::Transact()
+  HAL_TRACE_CACHED,         // Request answered from the configuration cache
+  HAL_TRACE_BATCH,          // CBaseDev::TransactBatch()
+  HAL_TRACE_ATTEMPT,        // One round trip of CReliability::GetRemoteResp()
+  HAL_TRACE_STREAM_READ,    // Read of the streaming pipe
+} HAL_TRACE_EVENT_ENUM;
+
+// One recorded call
+struct HALTraceEventStruct {
+  unsigned long long ullStartUs;
+  unsigned long long ullEndUs;
+  int nResult;                      // Return value of the call
+  unsigned short usCount;           // Retries of a request / attempt number / requests in a batch /
+                                    // bytes asked of a stream read
+  unsigned char byType;             // HAL_TRACE_EVENT_ENUM
+  unsigned char bySlot;
+  unsigned char byCommand;          // Stream reads - function type
+  unsigned char byFnEnum;
+  char szName[HAL_TRACE_NAME_LEN];  // Device name ("" if not known at the recording point)
+};
+
+struct HALTraceStatsStruct {
+  unsigned int unThreads;           // Threads that have recorded
+  unsigned long ulRecorded;
+  unsigned long ulOverwritten;      // Lost to full (or reused) rings
+  unsigned long ulUntraced;         // Not recorded - no ring left for the thread
+};
+
+class CHALTrace {
+private:
+  // Ring of one thread. Only that thread writes it.
+  struct ThreadBufStruct {
+    long lTid;
+    char szThreadName[HAL_TRACE_NAME_LEN];
+    BOOL bExited;                   // Ring kept for the export, may be given to a new thread
+    volatile unsigned long ulCount; // Events recorded. Event n is at n % HAL_TRACE_THREAD_EVENTS.
+    HALTraceEventStruct astEvents[HAL_TRACE_THREAD_EVENTS];
+  };
+
+  static volatile BOOL m_bEnabled;
+
+  // Registration of the rings. Taken only when a thread records its first event and
+  // by the export.
+  static pthread_mutex_t m_Mutex;
+  static ThreadBufStruct *m_apstBufs[HAL_TRACE_MAX_THREADS];
+  static int m_nNumBufs;
+  static unsigned long m_ulUntraced;
+  static unsigned long m_ulDiscarded;   // Events recorded by exited threads whose ring was reused
+
+  // Ring of the calling thread, NULL if it can't have one
+  static ThreadBufStruct *GetThreadBuf();
+  static ThreadBufStruct *AddThreadBuf();
+  static void ThreadExited(void *pvBuf);
+  static void CreateKey();
+
+  // Copy out the events of a ring that are not being overwritten. Returns the number copied.
+  static int Snapshot(ThreadBufStruct *pstBuf, HALTraceEventStruct *pstEvents);
+
+  CHALTrace();  // Static only
+
+public:
+  // Turn recording on / off. Recorded events are kept until Clear().
+  static void Enable(BOOL Enable);
+
+  static inline BOOL IsEnabled()
+  {
+    return m_bEnabled;
+  }
+
+  // Start time of a recording point - 0 if the trace is off, then nothing is recorded
+  static inline unsigned long long Begin()
+  {
+    return m_bEnabled ? Now() : 0;
+  }
+
+  // Record a call that started at StartUs (from Begin()) and ends now
+  static void Record(HAL_TRACE_EVENT_ENUM Type, const char *Name, unsigned char Slot,
+                     unsigned char Command, unsigned char FnEnum, unsigned long long StartUs,
+                     int Count, int Result);
+
+  // Name the calling thread in the export. The thread gets its ring here (if the
+  // trace is on), instead of with its first event.
+  static void SetThreadName(const char *Name);
+
+  // Drop the recorded events. Only while the trace is off.
+  static int Clear();
+
+  // Write the recorded events as Chrome trace event JSON (complete events, one
+  // track per thread)
+  static int ExportChrome(const char *FileName);
+
+  static int GetStats(HALTraceStatsStruct *Stats);
+
+  static unsigned long long Now();
+};
+
+#endif // #ifndef _HAL_TRACE_H
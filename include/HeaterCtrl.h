@@ -84,9 +84,11 @@ public:
   ~CHeaterCtrl(); // Destructor
 
   // OpenHal the device. Returns 0 on success, negative error code on failure.
-  int OpenHal (char* pszDevName);
+  // Open with Stream = TRUE to receive the values pushed after SetStreamPeriod().
+  int OpenHal (char* pszDevName, BOOL Stream = FALSE);
 
-  // Closes the device. Returns 0 on success, negative error code on failure.
+  // Closes the device (stopping the pushed values). Returns 0 on success, negative
+  // error code on failure.
   int CloseHal ();
 
   // Get Device Status
@@ -113,6 +115,9 @@ public:
 
   // Set the differential gain (direct value)
   int SetChDiffGain(unsigned long ulDiffGain);
+
+  // Set the proportional (milli), integral (milli) and differential gains in one round trip
+  int SetChPIDGains(unsigned long ulPropGainMilli, unsigned long ulIntGainMilli, unsigned long ulDiffGain);
   
   // Get Heater PWM in milli %
   int GetHtrChPWMMilliP (unsigned int* pnPWMMilliP);
@@ -123,6 +128,9 @@ public:
   // Get Temp in milli degree C
   int GetHtrChTempMilliDegC (int* pnTempMilliDegC); 
 
+  // Get Temp in milli degree C and PWM in milli % in one round trip
+  int GetHtrChTempAndPWM (int* pnTempMilliDegC, unsigned int* pnPWMMilliP);
+
   // Get Sensor Status (OK, ERR)
   int GetRTDStatus (int* pnStatus);
 
@@ -138,6 +146,9 @@ public:
   // Set the differential gain (direct value)
   int GetChDiffGain(unsigned long *pulDiffGain);
 
+  // Get the proportional (milli), integral (milli) and differential gains in one round trip
+  int GetChPIDGains(unsigned long *pulPropGainMilli, unsigned long *pulIntGainMilli, unsigned long *pulDiffGain);
+
   // Set Heater type - AC or DC
   int SetHeaterType( HEATER_TYPE eHtrType );
 
@@ -161,6 +172,21 @@ public:
 
   // Set RTD lead resistor value
   int SetRTDleadR(unsigned char rtdNdx, float fValue);
+
+  // Have the board push the temperature and PWM every PeriodMs on the stream
+  // channel, instead of polling them (0 stops it). Boards whose firmware does not
+  // push values NACK the command (ERR_PROTOCOL) - keep polling those.
+  int SetStreamPeriod (unsigned int PeriodMs);
+
+  // Read the next pushed value, waiting up to Timeout milli-seconds. Returns
+  // ERR_TIMEOUT if none arrived.
+  int ReadStreamData (DevStreamValueStruct* Value, unsigned int Timeout);
+
+  // Counters of the pushed values since the last SetStreamPeriod() start
+  int GetStreamStats (DevStreamStatsStruct* Stats);
+
+  // Return Receive Pipe File Descriptor - pushed values (see HALReactor.h)
+  int GetRxStreamingFd ();
 };
 
 #endif // #ifndef _HEATER_CTRL_H
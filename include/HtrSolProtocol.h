@@ -89,6 +89,7 @@ typedef struct
     unsigned long CompBaseTemp; // Compensation base temperature.
     float   CompTempSlope;      // Compensation temperature slope.
     float   LeadResistance;     // RTD circuit lead resistor value (RTDs 1-5, first slot, 1500XA R2 only)
+    unsigned long StreamPeriodMs; // Period of the pushed process values
   } __attribute (( packed )) htrsolDataUnion;
 }
 #ifndef WIN32
@@ -123,6 +124,7 @@ typedef enum
   CMD_HTR_FN_MARK_COMP_BASE_TEMP  = 8,  // Mark current board temperature as temperature compensation base value.
   CMD_HTR_FN_SET_COMP_TEMP_SLOPE  = 9,  // Set temperature compensation slope.
   CMD_HTR_FN_SET_RTD_LEAD_RESIST  = 10,
+  CMD_HTR_FN_SET_STREAM_PERIOD  = 11, // Push temperature and PWM every StreamPeriodMs on the stream channel (0 - stop)
 
   //Get commands
   CMD_HTR_FN_GET_TEMP_ERR_STATUS  = 40, // Return the ok/err status of the requested RTD channel
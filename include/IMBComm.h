@@ -118,6 +118,28 @@
 
 const size_t INVALID_OFFSET2 = 0xFFFF;
 
+// Windowed flash image transfers (see SetTransferWindow())
+#define IMB_MAX_TRANSFER_WINDOW     MAX_DEV_TXN_BATCH
+#define IMB_DFLT_TRANSFER_WINDOW    1     // Stop and wait, one chunk at a time
+#define IMB_MAX_TRANSFER_ROUNDS     4     // Passes over the chunks still missing / different
+
+// Progress of a flash image transfer - called after every window of chunks
+typedef void (*IMBProgressFn)(void *pvArg, unsigned int unBytesDone, unsigned int unBytesTotal);
+
+// Last SetFlashImage2() / GetFlashImage2()
+struct IMBTransferStatsStruct {
+  unsigned int unBytes;             // Image length
+  unsigned int unChunks;            // FLASH_IMAGE_DATA_LENGTH chunks in the image
+  unsigned int unWindow;            // Chunks in flight
+  unsigned int unChunksSent;        // Including retransmits and the read back of a write
+  unsigned int unRetransmits;       // Chunks sent again
+  unsigned int unRounds;
+  unsigned short usImageCRC;        // CRC16 of the image read / written, for the caller to compare
+  BOOL bVerified;                   // Written image read back and found the same (window > 1 only)
+  unsigned long long ullElapsedUs;
+  double dBytesPerSec;
+};
+
 // Digital Input Device
 class CIMBComm : public CBaseDev {
 
@@ -128,6 +150,33 @@ private:
   // private functions
   DB_INT32 setFactoryMirrorFlashImage2(const IMB_FLASH_SECTION_ENUM _eIMBSection, const size_t factoryOffset, const size_t mirrorOffset, unsigned int datalen, unsigned char * pstSwTEVTable);
   DB_INT32 getFactoryMirrorFlashImage2(const IMB_FLASH_SECTION_ENUM _eIMBSection, const size_t factoryOffset, const size_t mirrorOffset, unsigned int datalen, unsigned char * pstSwTEVTable);
+
+  // Windowed flash image transfers
+  unsigned int m_unWindow;
+  IMBProgressFn m_pfnProgress;
+  void *m_pvProgressArg;
+  IMBTransferStatsStruct m_stTransferStats;
+  unsigned long long m_ullTransferStartUs;
+  unsigned int m_unProgressDone;
+  unsigned int m_unProgressTotal;
+
+  // Length of chunk unChunk of an image of unLength bytes
+  static unsigned int ChunkLen(unsigned int unChunk, unsigned int unLength);
+
+  void StartTransfer(unsigned int unLength);
+  void EndTransfer(const unsigned char *pbyImage, unsigned int unCRCLen);
+  void ReportProgress(unsigned int unBytes);
+
+  // Send the write / read requests of the chunks whose pbDone is FALSE, a window at a
+  // time, and set pbDone of the chunks the IMB completed
+  int WriteChunks(const unsigned char *pbyImage, unsigned char bySection, unsigned int unOffset,
+                  unsigned int unLength, BOOL *pbDone, BOOL bRetransmit);
+  int ReadChunks(unsigned char *pbyImage, unsigned char bySection, unsigned int unOffset,
+                 unsigned int unLength, BOOL *pbDone, BOOL bRetransmit, unsigned int *punActualLen);
+
+  int SetFlashImageWindowed(unsigned char *pbyImage, unsigned char bySection, unsigned int unOffset, unsigned int unLength);
+  int GetFlashImageWindowed(unsigned char *pbyImage, unsigned char bySection, unsigned int unOffset, unsigned int unLength,
+                            unsigned int *punActualLen);
   
 public:
   CIMBComm(); // Default Constructor
@@ -208,6 +257,21 @@ public:
   int SetFlashImage2( unsigned char * pchFlashImage, const unsigned char bySection, const unsigned int unOffset, const unsigned int unLength);
   int GetFlashImage2( unsigned char * pchFlashImage, const unsigned char bySection, const unsigned int unOffset, const unsigned int unLength, unsigned int& refActualLen );
 
+  // Chunks of SetFlashImage2() / GetFlashImage2() in flight (1 .. IMB_MAX_TRANSFER_WINDOW).
+  // With more than one, the chunks of a window are sent back to back, the ones that
+  // failed are sent again, and a written image is read back and its CRC compared,
+  // chunks found different being written again. With 1 (the default) the transfer is
+  // stop and wait as before: each chunk is acknowledged, nothing is read back and
+  // IMBTransferStatsStruct::bVerified stays FALSE. A window only pays off when the
+  // turnaround of each chunk, not the bus, limits the transfer; a windowed write also
+  // costs the read back, and a lost response costs the window a time out.
+  int SetTransferWindow( unsigned int Window );
+
+  // Called with the bytes transferred after every window (NULL - none)
+  void SetTransferProgress( IMBProgressFn Progress, void * Arg );
+
+  int GetTransferStats( IMBTransferStatsStruct * Stats );
+
 
   int UpdateFlash();
 
@@ -0,0 +1,123 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                    10241 West Little York, Suite 200
+ * *                           Houston, TX 77040
+ * *
+ * *
+ * *  Filename: NoiseStats.h
+ * *
+ * *  Description: Running noise and drift statistics of detector (preamp)
+ * *               data.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+// NoiseStats.h - header file for CNoiseStats
+//
+// Keeps baseline noise and drift figures of a sample stream as the samples arrive,
+// so that they can be checked without collecting the samples - mean and standard
+// deviation (Welford), min / max / peak-to-peak and the drift (least squares slope
+// against the time stamps, in ADC counts per second).
+//
+// The figures are kept over up to NOISE_STATS_MAX_WINDOWS windows of a configured
+// number of samples each (e.g. a few seconds for the noise, minutes for the drift).
+// Windows are back to back - when a window is full its figures are kept as the last
+// complete window and a new one starts. A window of 0 samples never ends, i.e. covers
+// everything since Reset(). Every sample costs a few operations per window; nothing
+// is buffered.
+
+#ifndef _NOISE_STATS_H
+#define _NOISE_STATS_H
+
+#include "Definitions.h"  // For common definitions and structures.
+
+#define NOISE_STATS_MAX_WINDOWS     3
+
+// Defaults - about a minute at 50 Hz, and since the start
+#define NOISE_STATS_DFLT_WINDOW     3000
+
+struct NoiseStatsConfigStruct {
+  unsigned int unNumWindows;                              // 1 .. NOISE_STATS_MAX_WINDOWS
+  unsigned int aunWindowSamples[NOISE_STATS_MAX_WINDOWS]; // 0: since Reset()
+};
+
+// Figures of one window
+struct NoiseStatsStruct {
+  unsigned long ulSamples;          // 0 if there are no figures (yet)
+  unsigned long long ullStartTime;  // Time stamps of the first and last samples
+  unsigned long long ullEndTime;
+  double dMean;                     // ADC counts
+  double dStdDev;                   // ADC counts (sample standard deviation)
+  int nMin;
+  int nMax;
+  int nPeakToPeak;
+  double dDrift;                    // ADC counts per second
+};
+
+class CNoiseStats {
+private:
+  // Running sums of a window
+  struct AccumStruct {
+    unsigned long ulSamples;
+    unsigned long long ullStartTime;
+    unsigned long long ullEndTime;
+    double dMean;                   // Of the values
+    double dM2;                     // Sum of squared differences from the mean
+    double dTimeMean;               // Of the times (s since the window start)
+    double dTimeM2;
+    double dCoM;                    // Co-moment of times and values
+    int nMin;
+    int nMax;
+  };
+
+  NoiseStatsConfigStruct m_stConfig;
+  AccumStruct m_astCurrent[NOISE_STATS_MAX_WINDOWS];
+  AccumStruct m_astLast[NOISE_STATS_MAX_WINDOWS];
+
+  static void Clear(AccumStruct *pstAccum);
+  static void Add(AccumStruct *pstAccum, int nValue, unsigned long long ullTimeStamp);
+  static void ToStats(const AccumStruct &stAccum, NoiseStatsStruct *pstStats);
+
+public:
+  CNoiseStats();
+
+  // Set the windows. Clears the figures.
+  int Configure(const NoiseStatsConfigStruct &Config);
+
+  void GetConfig(NoiseStatsConfigStruct *Config) const
+  {
+    *Config = m_stConfig;
+  }
+
+  // Clear the figures
+  void Reset();
+
+  // Add the next sample (TimeStamp in ms)
+  void Push(int Value, unsigned long long TimeStamp)
+  {
+    for (unsigned int unWindow = 0; unWindow < m_stConfig.unNumWindows; unWindow++)
+    {
+      AccumStruct &stCurrent = m_astCurrent[unWindow];
+      Add(&stCurrent, Value, TimeStamp);
+      if (stCurrent.ulSamples == m_stConfig.aunWindowSamples[unWindow])
+      {
+        m_astLast[unWindow] = stCurrent;
+        Clear(&stCurrent);
+      }
+    }
+  }
+
+  // Figures of a window so far (Current) and of the last complete window (Last). Either
+  // may be NULL.
+  int GetStats(unsigned int Window, NoiseStatsStruct *Current, NoiseStatsStruct *Last) const;
+};
+
+#endif // #ifndef _NOISE_STATS_H
@@ -0,0 +1,153 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                    10241 West Little York, Suite 200
+ * *                           Houston, TX 77040
+ * *
+ * *
+ * *  Filename: PeakDetector.h
+ * *
+ * *  Description: Streaming peak detection on detector (preamp) data.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+// PeakDetector.h - header file for CPeakDetector
+//
+// Finds peaks in a chromatogram one sample at a time, reporting events as the
+// samples arrive instead of after the cycle -
+//   PEAK_EVENT_START: the signal started rising (time of the first sample of the
+//                     rise, reported once the peak is nMinHeight above the baseline)
+//   PEAK_EVENT_APEX:  top of the peak (reported once the signal falls), taken on the
+//                     mean of the slope window
+//   PEAK_EVENT_END:   the signal is back on a flat baseline, or at the valley
+//                     before the next peak of a fused pair
+//
+// The slope is the change over the last unSlopeWindow samples. A peak starts when
+// the slope stays above nSlopeThreshold for unConfirm samples, falls when it stays
+// below -nSlopeThreshold and ends when it stays within +/- nSlopeThreshold. Between
+// peaks the baseline follows the signal (exponential average, 1 / 2^unBaselineShift
+// per sample), and a peak ends at a new baseline level, so a drifting baseline is
+// followed. Rises that never reach nMinHeight are not reported. Only positive peaks
+// are detected.
+//
+// Every sample costs the same few operations (the window sum when a rise is first
+// seen is at most PEAK_DET_MAX_WINDOW additions).
+
+#ifndef _PEAK_DETECTOR_H
+#define _PEAK_DETECTOR_H
+
+#include "Definitions.h"  // For common definitions and structures.
+
+#define PEAK_DET_MAX_WINDOW         32
+#define PEAK_DET_EVENT_QUEUE_LEN    64
+
+// Defaults
+#define PEAK_DET_DFLT_WINDOW        5
+#define PEAK_DET_DFLT_SLOPE         2000
+#define PEAK_DET_DFLT_CONFIRM       3
+#define PEAK_DET_DFLT_MIN_HEIGHT    5000
+#define PEAK_DET_DFLT_BASE_SHIFT    4
+
+typedef enum
+{
+  PEAK_EVENT_START = 0,
+  PEAK_EVENT_APEX,
+  PEAK_EVENT_END,
+} PEAK_EVENT_ENUM;
+
+struct PeakEventStruct {
+  PEAK_EVENT_ENUM eEvent;
+  unsigned long long ullTimeStamp;  // Time of the sample the event is at
+  int nValue;                       // ADC counts (APEX and fused END: window mean)
+  int nBaseline;                    // Baseline under the peak
+  long long llArea;                 // PEAK_EVENT_END: sum of (sample - baseline) over the peak
+};
+
+struct PeakDetectConfigStruct {
+  unsigned int unSlopeWindow;       // Samples the slope is taken over (2 .. PEAK_DET_MAX_WINDOW)
+  int nSlopeThreshold;              // ADC counts per window
+  unsigned int unConfirm;           // Samples a slope change must last
+  int nMinHeight;                   // ADC counts above the baseline
+  unsigned int unBaselineShift;     // Baseline averaging (0 .. 16)
+};
+
+struct PeakDetectStatsStruct {
+  unsigned long ulPeaks;            // Peaks started
+  unsigned long ulEventsLost;       // Events dropped because the queue was full
+};
+
+class CPeakDetector {
+private:
+  typedef enum
+  {
+    STATE_BASELINE = 0,
+    STATE_RISING,
+    STATE_FALLING,
+  } STATE_ENUM;
+
+  PeakDetectConfigStruct m_stConfig;
+
+  // Last unSlopeWindow + 1 samples
+  int m_anWindow[PEAK_DET_MAX_WINDOW + 1];
+  unsigned long long m_aullWindowTime[PEAK_DET_MAX_WINDOW + 1];
+  unsigned int m_unWindowPos;
+  unsigned int m_unWindowCount;
+  long long m_llWindowSum;
+
+  STATE_ENUM m_eState;
+  long long m_llBaseline;           // Fixed point, 8 fraction bits
+  unsigned int m_unRun;             // Samples the current slope condition has lasted
+  BOOL m_bStarted;                  // PEAK_EVENT_START reported for the current peak
+  unsigned long long m_ullStartTime;
+  int m_nStartValue;
+  int m_nPeakBaseline;
+  int m_nExtreme;                   // Top while rising, valley while falling (window mean)
+  unsigned long long m_ullExtremeTime;
+  long long m_llArea;
+
+  PeakEventStruct m_astEvents[PEAK_DET_EVENT_QUEUE_LEN];
+  unsigned int m_unEventHead;
+  unsigned int m_unEventCount;
+  PeakDetectStatsStruct m_stStats;
+
+  void AddEvent(PEAK_EVENT_ENUM eEvent, unsigned long long ullTime, int nValue, long long llArea);
+
+  // A rise seen at the current sample - a peak may be starting at the oldest sample
+  // of the slope window
+  void BeginRise(int nBaseline, int nMean, unsigned long long ullMeanTime);
+
+public:
+  CPeakDetector();
+
+  // Set the detection parameters. The detector is reset.
+  int Configure(const PeakDetectConfigStruct &Config);
+
+  void GetConfig(PeakDetectConfigStruct *Config) const
+  {
+    *Config = m_stConfig;
+  }
+
+  // Start a new chromatogram. Events not read are dropped.
+  void Reset();
+
+  // Add the next sample
+  void Push(int Value, unsigned long long TimeStamp);
+
+  // Copy up to MaxEvents events, oldest first. Returns the number of events.
+  unsigned int ReadEvents(PeakEventStruct *Events, unsigned int MaxEvents);
+
+  void GetStats(PeakDetectStatsStruct *Stats) const
+  {
+    *Stats = m_stStats;
+  }
+};
+
+#endif // #ifndef _PEAK_DETECTOR_H
@@ -88,11 +88,42 @@
 #include "BaseDev.h"
 #include "PreampProtocol.h"
 
+// Layout version of PreampConfigSnapshotStruct. A snapshot is kept (persisted) as is,
+// so bump this when the structure changes.
+#define PREAMP_CFG_SNAPSHOT_VERSION   1
+
+// Settings held in a snapshot (PreampConfigSnapshotStruct::unFields)
+#define PREAMP_CFG_GAIN               0x0001
+#define PREAMP_CFG_SAMPLING_RATE      0x0002
+#define PREAMP_CFG_AC_BRIDGE          0x0004
+#define PREAMP_CFG_FILTER             0x0008
+#define PREAMP_CFG_MOV_AVG            0x0010
+#define PREAMP_CFG_LEFT_COARSE        0x0020
+#define PREAMP_CFG_RIGHT_COARSE       0x0040
+#define PREAMP_CFG_RIGHT_FINE         0x0080
+#define PREAMP_CFG_OFFSETS            (PREAMP_CFG_LEFT_COARSE | PREAMP_CFG_RIGHT_COARSE | PREAMP_CFG_RIGHT_FINE)
+#define PREAMP_CFG_ALL                0x00FF
+
+// The settings of a preamp channel
+struct PreampConfigSnapshotStruct {
+  unsigned int unVersion;                         // PREAMP_CFG_SNAPSHOT_VERSION
+  unsigned int unFields;                          // Settings held (PREAMP_CFG_ flags)
+  PREAMP_BRIDGE_GAIN_ENUM eGain;
+  PREAMP_SAMPLING_RATE_ENUM eSamplingRate;
+  PREAMP_STATE_ENUM eACBridge;
+  PREAMP_STATE_ENUM eFilter;
+  PREAMP_STATE_ENUM eMovAvg;
+  PREAMP_BRIDGE_ADJ_ENUM aeOffset[MAX_PREAMP_OFFSET_TYPE]; // By PREAMP_OFFSET_TYPE (G1 boards)
+};
+
 // Bridge Preamplifier
 class CPreampConfig : public CBaseDev {
 
 private:
   int m_iBoardRevision;
+
+  // Settings (PREAMP_CFG_ flags) a snapshot of this board can hold
+  unsigned int SnapshotFields();
 public:
   CPreampConfig();  // Default Constructor
   
@@ -203,6 +234,23 @@ public:
 
   // Returns FALSE if G2 Preamp Board else TRUE. Device to be opened before this call.
   bool IsBaseLineAdjustable( void );
+
+  // Read all the settings in one exchange with the board (the commands are sent back
+  // to back). The bridge offsets are read from G1 boards only. On an error
+  // Snapshot->unFields has the settings that were read.
+  int GetConfigSnapshot(PreampConfigSnapshotStruct *Snapshot,
+                        unsigned int unTimeOut = HAL_DFLT_TIMEOUT); // Time to wait for each response
+
+  // Write the settings of a snapshot that are also in Fields (PREAMP_CFG_ flags) in one
+  // exchange with the board. The bridge offsets are skipped on a G2 board.
+  int RestoreConfigSnapshot(const PreampConfigSnapshotStruct &Snapshot,
+                            unsigned int Fields = PREAMP_CFG_ALL,
+                            unsigned int unTimeOut = HAL_DFLT_TIMEOUT); // Time to wait for each response
+
+  // Settings (PREAMP_CFG_ flags) that differ between two snapshots, or are held in
+  // only one of them
+  static unsigned int DiffConfigSnapshot(const PreampConfigSnapshotStruct &Snapshot1,
+                                         const PreampConfigSnapshotStruct &Snapshot2);
     
 };
 
@@ -0,0 +1,172 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                    10241 West Little York, Suite 200
+ * *                           Houston, TX 77040
+ * *
+ * *
+ * *  Filename: PreampFrameSync.h
+ * *
+ * *  Description: Time aligned frames from several detector (preamp)
+ * *               streams.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+// PreampFrameSync.h - header file for CPreampFrameSync
+//
+// Reads several CPreampStream objects (e.g. the TCD and FID detectors of one cycle
+// clock) and returns frames holding one sample per detector for the same time -
+//
+//   obFrames.AddDetector(&obTCD1);     // Detector 0 sets the frame times
+//   obFrames.AddDetector(&obFID1);
+//   obFrames.Start(&obCycleClockSync); // All detectors start at the same instant
+//   nFrames = obFrames.ReadFrames(astFrames, 64, 1000);
+//
+// Sample times are the unwrapped device time stamps (ms since the stream started).
+// Streams started by one cycle clock start message (Start() with a CCycleClockSync)
+// share time zero, so samples from different boards can be matched on time. Each
+// frame is made at the time of a detector 0 sample; each other detector contributes
+// its sample within +/- the tolerance of that time.
+//
+// When a detector has no sample for a frame yet, the frame waits for it up to the
+// late limit (measured from when the detector 0 sample was read), then goes out with
+// that detector marked PREAMP_FRAME_SAMPLE_MISSING - either with a value of 0 or with
+// the detector's previous value (PREAMP_FRAME_FILL_HOLD). A sample that arrives
+// after its frame went out is dropped.
+//
+// A CPreampFrameSync is used from one thread. The detectors must stay open while
+// they are added to it.
+
+#ifndef _PREAMP_FRAME_SYNC_H
+#define _PREAMP_FRAME_SYNC_H
+
+#include "PreampStream.h"
+#include "CycleClockSync.h"
+
+// Maximum number of detectors in a frame
+#define PREAMP_FRAME_MAX_DETECTORS        8
+
+// Samples buffered per detector while waiting for the other detectors
+#define PREAMP_FRAME_QUEUE_LEN            128
+
+// Defaults
+#define PREAMP_FRAME_DFLT_TOLERANCE_MS    10
+#define PREAMP_FRAME_DFLT_LATE_MS         500
+
+// Flags of a detector's sample in a frame, in addition to the PREAMP_SAMPLE_ flags
+#define PREAMP_FRAME_SAMPLE_MISSING       0x80  // No sample for this time (late or lost)
+
+// Value used for a missing sample
+typedef enum
+{
+  PREAMP_FRAME_FILL_ZERO = 0,   // 0
+  PREAMP_FRAME_FILL_HOLD,       // The detector's previous value
+} PREAMP_FRAME_FILL_ENUM;
+
+// One time step, all detectors
+struct PreampFrameStruct {
+  unsigned long long ullTimeStamp;                        // Time of the detector 0 sample (ms)
+  unsigned int aunBridgeData[PREAMP_FRAME_MAX_DETECTORS]; // Detector ADC counts, by detector index
+  unsigned char abyFlags[PREAMP_FRAME_MAX_DETECTORS];     // PREAMP_SAMPLE_ / PREAMP_FRAME_SAMPLE_ flags
+};
+
+// Counters
+struct PreampFrameStatsStruct {
+  unsigned long ulFrames;           // Frames returned
+  unsigned long ulMissing;          // Detector samples marked missing in the frames
+  unsigned long ulDropped;          // Samples that matched no frame (arrived late or outside the tolerance)
+};
+
+class CPreampFrameSync {
+private:
+  struct SampleStruct {
+    unsigned long long ullTimeStamp;
+    unsigned long long ullRxTimeUs; // When it was read (CReliability::GetMonotonicTimeUs)
+    unsigned int unBridgeData;
+    unsigned char byFlags;
+  };
+
+  struct DetectorStruct {
+    CPreampStream *pobStream;
+    SampleStruct astQueue[PREAMP_FRAME_QUEUE_LEN];
+    unsigned int unHead;
+    unsigned int unCount;
+    unsigned int unLastBridgeData;  // For PREAMP_FRAME_FILL_HOLD
+  };
+
+  DetectorStruct m_astDetectors[PREAMP_FRAME_MAX_DETECTORS];
+  unsigned int m_unNumDetectors;
+  unsigned int m_unToleranceMs;
+  unsigned int m_unLateMs;
+  PREAMP_FRAME_FILL_ENUM m_eFill;
+  PreampFrameStatsStruct m_stStats;
+
+  // Read the samples already received by each detector. Returns a negative error code
+  // if a read fails.
+  int PullSamples();
+
+  // Make the next frame from the queued samples. Returns TRUE if a frame was made,
+  // FALSE if it has to wait for a late detector. *pullWaitUs is set to how long it may
+  // still wait.
+  BOOL AssembleFrame(PreampFrameStruct *pstFrame, unsigned long long *pullWaitUs);
+
+  // Wait for stream data on any detector for up to unWaitMs
+  void WaitForData(unsigned int unWaitMs);
+
+  // Not copyable - holds detector queues
+  CPreampFrameSync(const CPreampFrameSync &);
+  CPreampFrameSync &operator=(const CPreampFrameSync &);
+
+public:
+  CPreampFrameSync();  // Default Constructor
+  ~CPreampFrameSync(); // Destructor
+
+  // Add an open detector. The first one added sets the frame times - add the detector
+  // with the highest sampling rate first. Returns the detector's index in the frames
+  // (>= 0) or a negative error code.
+  int AddDetector(CPreampStream *pobStream);
+
+  // Remove all detectors
+  void RemoveAll();
+
+  // Time tolerance for matching samples to a frame, how long a frame waits for a late
+  // detector, and the value used for a missing sample
+  int Configure(unsigned int ToleranceMs, unsigned int LateMs, PREAMP_FRAME_FILL_ENUM Fill);
+
+  // Start broadcast on all detectors. With a cycle clock, the detectors are made ready
+  // (SetBroadcastMode with doInitOnly) and started together by one cycle clock start
+  // message - the detectors must be set to that cycle clock (SetCycleClock). Without
+  // one, each detector is started in turn and their times are only as close as the
+  // start commands.
+  int Start(CCycleClockSync *pobCycleClock);
+
+  // Stop broadcast on all detectors
+  int Stop(CCycleClockSync *pobCycleClock);
+
+  // Drop the samples waiting to be put in frames
+  void Reset();
+
+  // Read up to MaxFrames frames. Waits up to Timeout ms for the first frame, returns
+  // the frames ready at that point. Returns the number of frames (0 on timeout) or a
+  // negative error code.
+  int ReadFrames(PreampFrameStruct *Frames, unsigned int MaxFrames, unsigned int Timeout);
+
+  // Number of detectors in the frames
+  unsigned int GetNumDetectors() const
+  {
+    return m_unNumDetectors;
+  }
+
+  int GetStats(PreampFrameStatsStruct *Stats);
+  void ResetStats();
+};
+
+#endif // #ifndef _PREAMP_FRAME_SYNC_H
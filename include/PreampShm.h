@@ -0,0 +1,170 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                    10241 West Little York, Suite 200
+ * *                           Houston, TX 77040
+ * *
+ * *
+ * *  Filename: PreampShm.h
+ * *
+ * *  Description: Detector (preamp) stream samples in shared memory for
+ * *               other processes.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+// PreampShm.h - header file for CPreampShmPublisher and CPreampShmReader
+//
+// The process reading a detector (CPreampStream::SetShmBroadcast) publishes each
+// sample it returns - time stamp unwrapped, spike filtered, with its PREAMP_SAMPLE_
+// flags - into a ring of slots in POSIX shared memory named after the device
+// (PREAMP_SHM_NAME_PREFIX + device name). Any number of processes on the board can
+// follow the ring with a CPreampShmReader; the publisher never waits for them and
+// neither side makes a system call per sample.
+//
+// Each slot carries a sequence number (seqlock) - odd while the publisher writes
+// the slot, 2 * (sample number + 1) once written. A reader copies a slot and checks
+// the sequence number before and after, so it never returns a half written sample.
+// A reader that falls more than the ring size behind loses the oldest samples and
+// counts them as overrun.
+//
+// The ring is left in place when the publisher stops; a new publisher with the same
+// ring size continues the sample numbers, so readers carry on. A publisher opened
+// with a different Capacity resizes the shared memory object under the readers
+// that still have it mapped - they get SIGBUS on the slots past the new end. Close
+// the readers before changing the ring size.
+
+#ifndef _PREAMP_SHM_H
+#define _PREAMP_SHM_H
+
+#include <string>
+#include "Definitions.h"  // For common definitions and structures.
+
+#define PREAMP_SHM_NAME_PREFIX    "/gc700xp_"
+#define PREAMP_SHM_MAGIC          0x4D485350  // 'PSHM'
+#define PREAMP_SHM_VERSION        1
+
+// Default ring size, in samples (power of 2) - 74 seconds at 55 Hz
+#define PREAMP_SHM_DFLT_CAPACITY  4096
+#define PREAMP_SHM_MAX_CAPACITY   (1 << 20)
+
+struct PreampShmHeaderStruct {
+  volatile unsigned int unMagic;        // PREAMP_SHM_MAGIC once the ring is set up
+  unsigned int unVersion;
+  unsigned int unCapacity;              // Slots
+  volatile unsigned int unWriteCount;   // Samples published (wraps)
+};
+
+struct PreampShmSlotStruct {
+  volatile unsigned int unSeq;          // 2 * (sample number + 1), odd while written
+  unsigned int unBridgeData;
+  unsigned long long ullTimeStamp;
+  unsigned char byFlags;
+};
+
+// A sample read from the ring
+struct PreampShmSampleStruct {
+  unsigned int unBridgeData;
+  unsigned long long ullTimeStamp;
+  unsigned char byFlags;
+};
+
+class CPreampShmPublisher {
+private:
+  std::string m_sShmName;
+  PreampShmHeaderStruct *m_pstHeader;
+  PreampShmSlotStruct *m_pstSlots;
+  unsigned int m_unMapSize;
+
+  // Not copyable - owns the mapping
+  CPreampShmPublisher(const CPreampShmPublisher &);
+  CPreampShmPublisher &operator=(const CPreampShmPublisher &);
+
+public:
+  CPreampShmPublisher();  // Default Constructor
+  ~CPreampShmPublisher(); // Destructor
+
+  // Create (or take over) the ring of a device. Capacity must be a power of 2.
+  int Open(const char *DevName, unsigned int Capacity = PREAMP_SHM_DFLT_CAPACITY);
+
+  // Unmap the ring. It stays in place for the readers.
+  void Close();
+
+  BOOL IsOpen() const
+  {
+    return m_pstHeader != NULL;
+  }
+
+  // Add a sample to the ring
+  void Publish(unsigned int BridgeData, unsigned long long TimeStamp, unsigned char Flags)
+  {
+    unsigned int unCount = m_pstHeader->unWriteCount;
+    PreampShmSlotStruct &stSlot = m_pstSlots[unCount & (m_pstHeader->unCapacity - 1)];
+
+    stSlot.unSeq = 2 * unCount + 1;
+    __sync_synchronize();
+    stSlot.unBridgeData = BridgeData;
+    stSlot.ullTimeStamp = TimeStamp;
+    stSlot.byFlags = Flags;
+    __sync_synchronize();
+    stSlot.unSeq = 2 * unCount + 2;
+    // A reader that sees the new count must see the slot's final sequence number
+    __sync_synchronize();
+    m_pstHeader->unWriteCount = unCount + 1;
+  }
+
+  // Remove the ring of a device
+  static int Remove(const char *DevName);
+};
+
+// Counters of a reader
+struct PreampShmReaderStatsStruct {
+  unsigned long ulRead;       // Samples returned
+  unsigned long ulOverrun;    // Samples overwritten before they were read
+};
+
+class CPreampShmReader {
+private:
+  const PreampShmHeaderStruct *m_pstHeader;
+  const PreampShmSlotStruct *m_pstSlots;
+  unsigned int m_unMapSize;
+  unsigned int m_unNext;      // Next sample number to read
+  PreampShmReaderStatsStruct m_stStats;
+
+  // Not copyable - owns the mapping
+  CPreampShmReader(const CPreampShmReader &);
+  CPreampShmReader &operator=(const CPreampShmReader &);
+
+public:
+  CPreampShmReader();  // Default Constructor
+  ~CPreampShmReader(); // Destructor
+
+  // Map the ring of a device. The first Read() returns the samples published after
+  // this, or all the samples still in the ring with FromOldest. Returns ERR_OPEN_FILE
+  // if no process publishes the device (yet).
+  int Open(const char *DevName, BOOL FromOldest = FALSE);
+
+  void Close();
+
+  BOOL IsOpen() const
+  {
+    return m_pstHeader != NULL;
+  }
+
+  // Copy up to MaxSamples new samples. Never blocks. Returns the number of samples.
+  int Read(PreampShmSampleStruct *Samples, unsigned int MaxSamples);
+
+  // Samples published and not read yet
+  unsigned int GetBacklog() const;
+
+  int GetStats(PreampShmReaderStatsStruct *Stats);
+};
+
+#endif // #ifndef _PREAMP_SHM_H
@@ -0,0 +1,106 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                    10241 West Little York, Suite 200
+ * *                           Houston, TX 77040
+ * *
+ * *
+ * *  Filename: PreampSimFile.h
+ * *
+ * *  Description: Binary sample files for the preamp stream simulator.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+// PreampSimFile.h - header file for CPreampSimFile
+//
+// A binary sample file is a PreampSimFileHeaderStruct followed by unNumSamples
+// sample points of unNumChannels 32 bit ADC counts each (channel 0 of the first
+// point, channel 1 of the first point, ...), in the byte order of the machine that
+// wrote it. The file is mapped into memory and the samples are read in place, so
+// reading a sample is an array access and any sample can be reached directly.
+//
+// ConvertTextFile() makes a binary file from a simulator text file (one
+// "<time ms> <ADC counts>" line per sample, e.g. /nvdata/simulate/1_det1.raw).
+// CPreampStreamSim does this once for each text file, the first time it is used.
+
+#ifndef _PREAMP_SIM_FILE_H
+#define _PREAMP_SIM_FILE_H
+
+#include "Definitions.h"  // For common definitions and structures.
+
+// 'PSIM' - also tells a file written with the other byte order
+#define PREAMP_SIM_FILE_MAGIC       0x4D495350
+#define PREAMP_SIM_FILE_VERSION     1
+
+// Sample period used when a text file does not give one
+#define PREAMP_SIM_DFLT_PERIOD_MS   20
+
+struct PreampSimFileHeaderStruct {
+  unsigned int unMagic;           // PREAMP_SIM_FILE_MAGIC
+  unsigned int unVersion;         // PREAMP_SIM_FILE_VERSION
+  unsigned int unHeaderSize;      // Bytes before the first sample
+  unsigned int unPeriodUs;        // Time between sample points
+  unsigned int unNumChannels;     // Samples per point
+  unsigned int unNumSamples;      // Sample points
+};
+
+class CPreampSimFile {
+private:
+  int m_nFd;
+  void *m_pvMap;
+  unsigned int m_unMapSize;
+  const PreampSimFileHeaderStruct *m_pstHeader;
+  const int *m_pnSamples;
+
+  // Not copyable - owns the mapping
+  CPreampSimFile(const CPreampSimFile &);
+  CPreampSimFile &operator=(const CPreampSimFile &);
+
+public:
+  CPreampSimFile();  // Default Constructor
+  ~CPreampSimFile(); // Destructor
+
+  // Map a binary sample file. Returns ERR_OPEN_FILE if it cannot be opened, or
+  // ERR_PROTOCOL if it is not a valid sample file.
+  int Open(const char *pszFile);
+
+  // Unmap the file
+  void Close();
+
+  BOOL IsOpen() const
+  {
+    return m_pstHeader != NULL;
+  }
+
+  // Header of an open file
+  const PreampSimFileHeaderStruct *GetHeader() const
+  {
+    return m_pstHeader;
+  }
+
+  unsigned int GetNumSamples() const
+  {
+    return m_pstHeader ? m_pstHeader->unNumSamples : 0;
+  }
+
+  // Channel Channel of sample point Sample (both must be in range)
+  int GetSample(unsigned int Sample, unsigned int Channel) const
+  {
+    return m_pnSamples[Sample * m_pstHeader->unNumChannels + Channel];
+  }
+
+  // Write a one channel binary file with the samples of a simulator text file. The
+  // sample period is taken from the time stamps of the first two lines. The file is
+  // written under a temporary name and renamed, so a reader never sees part of it.
+  static int ConvertTextFile(const char *pszTextFile, const char *pszBinFile);
+};
+
+#endif // #ifndef _PREAMP_SIM_FILE_H
@@ -0,0 +1,167 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                    10241 West Little York, Suite 200
+ * *                           Houston, TX 77040
+ * *
+ * *
+ * *  Filename: PreampSimSource.h
+ * *
+ * *  Description: Where each simulated detector (preamp) stream gets its
+ * *               samples.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+// PreampSimSource.h - header file for CPreampSimSources and CPreampSynth
+//
+// CPreampSimSources holds, for each preamp stream device name (detector and
+// channel), where CPreampStreamWrapper gets its samples when the device is opened -
+//   PREAMP_SIM_NONE:      the real detector
+//   PREAMP_SIM_FILES:     simulator text files, used in turn on each start of
+//                         broadcast (sFile is a template with %d for 1..unNumFiles)
+//   PREAMP_SIM_CAPTURE:   one channel (unChannel) of a recorded binary sample file
+//                         (see PreampSimFile.h)
+//   PREAMP_SIM_SYNTHETIC: a generated chromatogram (CPreampSynth) - baseline,
+//                         Gaussian peaks and noise, repeated every unCycleMs
+// Sources are set at run time with SetSource(), or read from a configuration file
+// (PREAMP_SIM_CONFIG_FILE is read on first use) with one line per device -
+//
+//   # <device name> <source> <parameters>
+//   PREAMP_STR:SLOT_1:PREAMP_STR_1 hw
+//   PREAMP_STR:SLOT_1:PREAMP_STR_2 files /nvdata/simulate/%d_det2.raw 3
+//   PREAMP_STR:SLOT_3:PREAMP_STR_1 capture /nvdata/simulate/run1.bin 0
+//   PREAMP_STR:SLOT_3:PREAMP_STR_2 synth <baseline> <noise> <cycle ms> [<time ms> <sigma ms> <height>] ...
+//
+// A device with no source set falls back to the simulator details files of the six
+// standard detectors (CDetNameToRawFileMapping). Simulated and real detectors can
+// be used together in one process. A new source takes effect when the device is
+// next opened.
+
+#ifndef _PREAMP_SIM_SOURCE_H
+#define _PREAMP_SIM_SOURCE_H
+
+#include <string>
+#include <map>
+#include <vector>
+#include "Definitions.h"  // For common definitions and structures.
+#include "HALLock.h"      // For CHALMutex
+
+#ifdef COMPILE_FOR_PC
+#define PREAMP_SIM_CONFIG_FILE      "/home/Daniel/preamp_sim.cfg"
+#else
+#define PREAMP_SIM_CONFIG_FILE      "/nvdata/simulate/preamp_sim.cfg"
+#endif
+
+#define PREAMP_SYNTH_MAX_PEAKS      32
+#define PREAMP_SYNTH_MAX_CYCLE_MS   3600000   // 1 hour
+
+typedef enum
+{
+  PREAMP_SIM_NONE = 0,    // Real detector
+  PREAMP_SIM_FILES,       // Simulator text files
+  PREAMP_SIM_CAPTURE,     // Recorded binary sample file
+  PREAMP_SIM_SYNTHETIC,   // Generated chromatogram
+} PREAMP_SIM_SOURCE_ENUM;
+
+struct PreampSynthPeakStruct {
+  unsigned int unTimeMs;    // Time of the peak top in the cycle
+  unsigned int unSigmaMs;   // Width (standard deviation)
+  int nHeight;              // ADC counts above the baseline (negative for a dip)
+};
+
+struct PreampSynthStruct {
+  int nBaseline;            // ADC counts
+  unsigned int unNoise;     // Noise standard deviation, ADC counts
+  unsigned int unCycleMs;   // Chromatogram length, repeated
+  unsigned int unPeriodMs;  // Time between samples
+  unsigned int unNumPeaks;
+  PreampSynthPeakStruct astPeaks[PREAMP_SYNTH_MAX_PEAKS];
+};
+
+struct PreampSimSourceStruct {
+  PREAMP_SIM_SOURCE_ENUM eSource;
+  std::string sFile;        // PREAMP_SIM_FILES template or PREAMP_SIM_CAPTURE file
+  unsigned int unNumFiles;  // PREAMP_SIM_FILES
+  unsigned int unChannel;   // PREAMP_SIM_CAPTURE
+  PreampSynthStruct stSynth;// PREAMP_SIM_SYNTHETIC
+};
+
+// Generated chromatogram. The baseline and peaks of one cycle are computed when
+// configured, so a sample costs a table lookup and the noise.
+class CPreampSynth {
+private:
+  std::vector<int> m_vnCycle;
+  unsigned int m_unNoise;
+  unsigned int m_unPos;
+  unsigned int m_unRandom;  // xorshift state
+
+  unsigned int NextRandom()
+  {
+    m_unRandom ^= m_unRandom << 13;
+    m_unRandom ^= m_unRandom >> 17;
+    m_unRandom ^= m_unRandom << 5;
+    return m_unRandom;
+  }
+
+public:
+  CPreampSynth();
+
+  int Configure(const PreampSynthStruct &stSynth);
+
+  // Back to the start of the cycle, with the same noise
+  void Reset();
+
+  // Next sample
+  int Next()
+  {
+    int nVal = m_vnCycle[m_unPos];
+    if (++m_unPos >= m_vnCycle.size())
+    {
+      m_unPos = 0;
+    }
+
+    if (m_unNoise)
+    {
+      // Sum of four uniform values - close to normal, standard deviation 4 / sqrt(12)
+      // of one 16 bit uniform value
+      unsigned int unR1 = NextRandom();
+      unsigned int unR2 = NextRandom();
+      long long llSum = (long long) (unR1 & 0xFFFF) + (unR1 >> 16) + (unR2 & 0xFFFF) + (unR2 >> 16) - 2 * 65535;
+      nVal += (int) (llSum * m_unNoise / 37837);   // 65536 * sqrt(4 / 12)
+    }
+    return nVal;
+  }
+};
+
+class CPreampSimSources {
+private:
+  static std::map<std::string, PreampSimSourceStruct> m_mapSources;
+  static BOOL m_bConfigFileRead;
+  static CHALMutex m_obLock;
+
+  static int ParseLine(const char *pszLine, std::string *psDevName, PreampSimSourceStruct *pstSource);
+
+public:
+  // Source of a device. Returns ERR_INVALID_ARGS for an invalid source.
+  static int SetSource(const char *DevName, const PreampSimSourceStruct &Source);
+
+  // Back to the default source of a device
+  static void ClearSource(const char *DevName);
+
+  // Source a device is opened with
+  static void GetSource(const char *DevName, PreampSimSourceStruct *Source);
+
+  // Set the sources listed in a configuration file. Returns the number of devices
+  // set, or a negative error code.
+  static int ReadConfigFile(const char *FileName);
+};
+
+#endif // #ifndef _PREAMP_SIM_SOURCE_H
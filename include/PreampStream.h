@@ -76,6 +76,47 @@
 #include <vector>
 #include "BaseDev.h"
 #include "PreampProtocol.h"
+#include "SpikeFilter.h"
+#include "PreampShm.h"
+#include "PeakDetector.h"
+#include "NoiseStats.h"
+#include "HALLock.h"      // For CHALMutex
+
+// Status flags of a sample returned by ReadStreamDataBatch()
+#define PREAMP_SAMPLE_SPIKE_FIXED   0x01  // Sample was a spike and was replaced by the spike filter
+#define PREAMP_SAMPLE_DUP_TIMESTAMP 0x02  // Device time stamp same as the previous sample's
+#define PREAMP_SAMPLE_GAP           0x04  // One or more samples before this one are missing
+#define PREAMP_SAMPLE_INTERPOLATED  0x08  // Sample was inserted in a gap (PREAMP_GAP_INTERPOLATE)
+#define PREAMP_SAMPLE_REORDERED     0x10  // Older than the previous sample - never returned, only counted
+
+// Number of raw samples read from the stream pipe before they are converted and filtered
+#define PREAMP_STREAM_BATCH_CHUNK   64
+
+// Largest gap (in missing samples) filled in by PREAMP_GAP_INTERPOLATE. Longer gaps
+// are only flagged.
+#define PREAMP_STREAM_MAX_GAP_FILL  8
+
+// A sample with a time stamp up to this many ms older than the previous sample's is
+// out of order and is dropped. A larger step back is the device time stamp rolling over.
+#define PREAMP_STREAM_REORDER_WINDOW_MS   2000
+
+// What to do about missing samples (CPreampStream::SetStreamCheck)
+typedef enum
+{
+  PREAMP_GAP_FLAG = 0,      // Set PREAMP_SAMPLE_GAP on the first sample after the gap
+  PREAMP_GAP_INTERPOLATE,   // Also insert samples interpolated between the samples around the gap
+} PREAMP_GAP_MODE_ENUM;
+
+// Stream continuity counters (CPreampStream::GetStreamStats)
+struct PreampStreamStatsStruct {
+  unsigned long ulSamples;        // Samples received from the device
+  unsigned long ulInOrder;        // Samples one sampling period after the previous one
+  unsigned long ulDuplicates;     // Samples with the previous sample's time stamp
+  unsigned long ulGaps;           // Samples after one or more missing samples
+  unsigned long ulMissing;        // Samples missing in all the gaps
+  unsigned long ulReordered;      // Samples older than the previous one (dropped)
+  unsigned long ulInterpolated;   // Samples inserted in gaps
+};
 
 // Bridge Preamplifier
 class CPreampStream : public CBaseDev {
@@ -87,26 +128,55 @@ private:
   unsigned int m_unBridgeData;
   BOOL m_bStreamingStarted;
   BOOL m_bRxFirstTimeStamp;
+  BOOL m_bRxPrevTimeStamp;        // A sample has been received to check the next one against
 
-  // Number of samples for filtering spikes
-  const std::size_t SPIKE_FILT_SAMPLE_SIZE;
-  // Slope threshold to use for determining a spike
-  const int SPIKE_SLOPE_THRESHOLD;
-  // Structure to store Detector data for Spike filtering
-  struct SampleDataStruct
-  {
-    int nBridgeVal; // Detector ADC counts
-    unsigned long long ullTimestamp; // Data acq timestamp
-  };
-  
-  // Holding area for storing detector data for performing spike trapping/elimination
-  std::vector <SampleDataStruct> m_vstSpikeFiltData;
+  // Spike filter run over the stream data
+  CSpikeFilter m_obSpikeFilter;
+
+  // Stream continuity check
+  unsigned int m_unPeriodUs;        // Expected sampling period, 0 -> missing samples not checked
+  PREAMP_GAP_MODE_ENUM m_eGapMode;
+  PreampStreamStatsStruct m_stStreamStats;
+
+  // Filtered samples not returned yet. Filling a gap makes several samples come out
+  // of one received sample.
+  SpikeFiltSampleStruct m_astOutQueue[PREAMP_STREAM_MAX_GAP_FILL + 1];
+  unsigned int m_unOutQueueHead;
+  unsigned int m_unOutQueueCount;
+
+  // Filtered samples for other processes (see PreampShm.h)
+  CPreampShmPublisher m_obShmPublisher;
+
+  // Peak detection on the filtered samples
+  CPeakDetector m_obPeakDetector;
+  BOOL m_bPeakDetect;
+
+  // Noise and drift figures of the filtered samples. Their own lock, not the stream
+  // lock, so that they can be read while a stream read waits for data.
+  CNoiseStats m_obNoiseStats;
+  CHALMutex m_obNoiseLock;
+  BOOL m_bNoiseStats;            // Guarded by m_obNoiseLock
+  void ResetNoiseStats ();
 
-  // Traps the spike and returns a clean data point. If there is no spike, this returns
-  // unmodified data point.
-  int GetFilteredData (unsigned int *BridgeData, unsigned long long *TimeStamp);
+  // Classify a received sample (in order, duplicate, gap or reordered), filling in the
+  // gap if asked to, and run the spike filter. Filtered samples go to the caller's
+  // arrays while *NumSamples < MaxSamples, and are queued after that.
+  void ProcessSample (const PREAMP_STREAM_STRUCT &stRaw, unsigned int *BridgeData, unsigned long long *TimeStamp,
+                      unsigned char *Flags, unsigned int *NumSamples, unsigned int MaxSamples);
 
-  void UpdateTime(unsigned short usCurrentTimeStamp);
+  // Return a filtered sample to the caller, or queue it if there is no room
+  void OutputSample (const SpikeFiltSampleStruct &stSample, unsigned int *BridgeData, unsigned long long *TimeStamp,
+                     unsigned char *Flags, unsigned int *NumSamples, unsigned int MaxSamples);
+
+  // Move queued samples to the caller's arrays
+  void DrainOutQueue (unsigned int *BridgeData, unsigned long long *TimeStamp,
+                      unsigned char *Flags, unsigned int *NumSamples, unsigned int MaxSamples);
+
+  // Unwraps the device time stamp, classifies the sample against the previous one and
+  // updates the stream counters. Returns the PREAMP_SAMPLE_ flags for the sample, with
+  // the number of samples missing before it in *punMissing. The time is not updated
+  // for a PREAMP_SAMPLE_REORDERED sample.
+  unsigned char UpdateTime(unsigned short usCurrentTimeStamp, unsigned int *punMissing);
 
 public:
   CPreampStream();  // Default Constructor
@@ -128,7 +198,51 @@ public:
   // Read stream data. Specify timeout in milli-seconds
   int ReadStreamData (unsigned int *BridgeData, unsigned long long *TimeStamp, unsigned int Timeout);
 
-  // Read stream data, block on read
+  // Read all samples that arrive within Timeout milli-seconds, up to MaxSamples, into
+  // the caller's arrays. Flags (PREAMP_SAMPLE_ flags) may be NULL. Time stamp unwrapping
+  // and spike filtering run over the whole batch. With Timeout = 0 only the samples
+  // already received are returned. Returns the number of samples read (0 if none
+  // arrived in time) or a negative error code.
+  int ReadStreamDataBatch (unsigned int *BridgeData, unsigned long long *TimeStamp, unsigned char *Flags,
+                           unsigned int MaxSamples, unsigned int Timeout);
+
+  // Select the spike filter applied by ReadStreamData() / ReadStreamDataBatch() (see
+  // SpikeFilter.h). The default is SPIKE_FILT_SLOPE, window 3, threshold 100000.
+  // Samples held by the filter are dropped.
+  int SetSpikeFilter (SPIKE_FILT_TYPE_ENUM Type, unsigned int WindowSize, int Threshold);
+
+  // Check the stream for missing samples against the sampling period of SamplingRate
+  // (MAX_PREAMP_SAMPLING_RATE -> only duplicate and out of order samples are detected).
+  // Set the rate the preamp is configured with (CPreampConfig::SetSamplingRate).
+  int SetStreamCheck (PREAMP_SAMPLING_RATE_ENUM SamplingRate, PREAMP_GAP_MODE_ENUM GapMode);
+
+  // Stream continuity counters since the device was opened or ResetStreamStats()
+  int GetStreamStats (PreampStreamStatsStruct *Stats);
+  void ResetStreamStats ();
+
+  // Publish the samples returned by ReadStreamData() / ReadStreamDataBatch() to a
+  // shared memory ring of Capacity samples (power of 2) that other processes read with
+  // CPreampShmReader (see PreampShm.h). Stops with Enable = FALSE or CloseHal().
+  int SetShmBroadcast (BOOL Enable, unsigned int Capacity = PREAMP_SHM_DFLT_CAPACITY);
+
+  // Run peak detection (see PeakDetector.h) on the samples returned by ReadStreamData()
+  // / ReadStreamDataBatch(), with Config or, if NULL, the configuration in use (the
+  // defaults at first). The detector starts over on each start of broadcast.
+  int SetPeakDetect (BOOL Enable, const PeakDetectConfigStruct *Config = NULL);
+
+  // Copy up to MaxEvents peak events found so far. Returns the number of events.
+  int ReadPeakEvents (PeakEventStruct *Events, unsigned int MaxEvents);
+
+  // Keep noise and drift figures (see NoiseStats.h) of the samples returned by
+  // ReadStreamData() / ReadStreamDataBatch(), over the windows of Config or, if NULL,
+  // the windows in use. The figures start over on each start of broadcast.
+  int SetNoiseStats (BOOL Enable, const NoiseStatsConfigStruct *Config = NULL);
+
+  // Figures of a window so far and of its last complete window (either may be NULL).
+  // Does not wait for a stream read in progress.
+  int GetNoiseStats (unsigned int Window, NoiseStatsStruct *Current, NoiseStatsStruct *Last);
+
+  // Read stream data, block on read (no spike filtering or gap filling)
   int ReadStreamDataBlocking (unsigned int *BridgeData, unsigned long long *TimeStamp);
 
   // Enable self calibration
@@ -140,6 +254,10 @@ public:
   // Flushes the contents of the Named Pipe that is used for streaming data for this device.
   int Flush();
 
+  // Returns the file descriptor that becomes readable when streaming data arrives
+  // for this device (for select() / CHALReactor)
+  int GetRxStreamingFd();
+
   // Set Cycle Clock associated with this detector.
   int SetCycleClock (unsigned int cycleClock);
 };
@@ -23,6 +23,13 @@
 #define _PREAMPSTREAMSIM_H
 #include <string>
 #include <Definitions.h>
+#include "HALLock.h"  // For CHALMutex
+#include "PreampSimFile.h"
+#include "SimClock.h"
+#include "PreampSimSource.h"
+#include "PreampShm.h"
+#include "PeakDetector.h"
+#include "NoiseStats.h"
 
 class CDetNameToRawFileMapping
 {
@@ -171,21 +178,46 @@ private:
   FILE* m_pRawDataFileFd; 
   std::string m_sDevName;
 
+  // Binary copy of the raw data file, read in place (see PreampSimFile.h). The text
+  // file is only read if the binary copy cannot be made.
+  CPreampSimFile m_obSimFile;
+  unsigned int m_unSimFileSample;   // Next sample of m_obSimFile
+  unsigned int m_unPeriodMs;        // Time stamp increment
+
   int m_nBridgeData; 
   unsigned long long m_ullTimeStamp;
 
   int m_nNumDetSimulationFiles; // Number of Raw Data Files to use
   int m_nDetFileInUse; // Which file are we currently using? 
 
-  static CDetNameToRawFileMapping m_oDetMapping; // One per process
+  // Where the samples come from (see PreampSimSource.h), set by IsSimulationEnabled
+  PreampSimSourceStruct m_stSource;
+  CPreampSynth m_obSynth;
+
+  // Returned samples for other processes (see PreampShm.h)
+  CPreampShmPublisher m_obShmPublisher;
+
+  // Peak detection on the returned samples
+  CPeakDetector m_obPeakDetector;
+  bool m_bPeakDetect;
+
+  // Noise and drift figures of the returned samples, with their own lock
+  CNoiseStats m_obNoiseStats;
+  CHALMutex m_obNoiseLock;
+  bool m_bNoiseStats;            // Guarded by m_obNoiseLock
+  void ResetNoiseStats ();
+
+  // Paces the samples - each sample is returned at its device time on this clock
+  // (see SimClock.h), so several detectors read by one thread do not slow each
+  // other down
+  CSimClock *m_pobClock;
+  unsigned long long m_ullStartDevUs; // Clock time of time stamp 0
 
-  // Workaround to get inter-sample delay of 20ms between samples. If we have two 
-  // detectors, then only one detector simulator needs to sleep. If both sleep then
-  // our CGM slows down.
-  static bool m_bDelayAssigned; 
-  bool m_bOkToSleep;
+  // Serializes the use of this object by several threads (see HALLock.h)
+  CHALMutex m_obLock;
 
   int OpenRawDataFile ();
+  int OpenSimFile (const std::string &sRawFilePath);
   int CloseRawDataFile ();
   int ReadRawDataFile (int *Data, unsigned long long *TimeStamp);
 
@@ -206,8 +238,24 @@ public:
   // Read stream data. Specify timeout in milli-seconds
   int ReadStreamData (unsigned int *BridgeData, unsigned long long *TimeStamp);
 
+  // Look up the simulation source of a device. Returns false if it is a real detector.
   bool IsSimulationEnabled (std::string sDetName);
 
+  // Clock pacing this simulator, CSimClock::GetDefault() unless set. Takes effect at
+  // the next start of broadcast. A read in progress may still wait on the old clock.
+  void SetClock (CSimClock *pobClock);
+
+  // Publish the returned samples to shared memory (see CPreampStream::SetShmBroadcast)
+  int SetShmBroadcast (bool Enable, unsigned int Capacity);
+
+  // Peak detection on the returned samples (see CPreampStream::SetPeakDetect)
+  int SetPeakDetect (bool Enable, const PeakDetectConfigStruct *Config);
+  int ReadPeakEvents (PeakEventStruct *Events, unsigned int MaxEvents);
+
+  // Noise and drift figures of the returned samples (see CPreampStream::SetNoiseStats)
+  int SetNoiseStats (bool Enable, const NoiseStatsConfigStruct *Config);
+  int GetNoiseStats (unsigned int Window, NoiseStatsStruct *Current, NoiseStatsStruct *Last);
+
   std::string GetNextFile ();
 };
 
@@ -56,6 +56,33 @@ public:
   // Read stream data. Specify timeout in milli-seconds
   int ReadStreamData (unsigned int *BridgeData, unsigned long long *TimeStamp, unsigned int Timeout);
 
+  // Read up to MaxSamples samples into the caller's arrays (see CPreampStream).
+  // The simulator returns one sample per call.
+  int ReadStreamDataBatch (unsigned int *BridgeData, unsigned long long *TimeStamp, unsigned char *Flags,
+                           unsigned int MaxSamples, unsigned int Timeout);
+
+  // Select the spike filter (see CPreampStream). The simulator does not filter.
+  int SetSpikeFilter (SPIKE_FILT_TYPE_ENUM Type, unsigned int WindowSize, int Threshold);
+
+  // Stream continuity check and counters (see CPreampStream). The simulator does not
+  // check its stream and reports no samples.
+  int SetStreamCheck (PREAMP_SAMPLING_RATE_ENUM SamplingRate, PREAMP_GAP_MODE_ENUM GapMode);
+  int GetStreamStats (PreampStreamStatsStruct *Stats);
+
+  // Publish the returned samples to shared memory (see CPreampStream)
+  int SetShmBroadcast (BOOL Enable, unsigned int Capacity = PREAMP_SHM_DFLT_CAPACITY);
+
+  // Peak detection on the returned samples (see CPreampStream)
+  int SetPeakDetect (BOOL Enable, const PeakDetectConfigStruct *Config = NULL);
+  int ReadPeakEvents (PeakEventStruct *Events, unsigned int MaxEvents);
+
+  // Noise and drift figures of the returned samples (see CPreampStream)
+  int SetNoiseStats (BOOL Enable, const NoiseStatsConfigStruct *Config = NULL);
+  int GetNoiseStats (unsigned int Window, NoiseStatsStruct *Current, NoiseStatsStruct *Last);
+
+  // Clock pacing the simulator (see SimClock.h). Ignored for a real detector.
+  void SetSimClock (CSimClock *pobClock);
+
   // Read stream data, block on read
   int ReadStreamDataBlocking (unsigned int *BridgeData, unsigned long long *TimeStamp);
 
@@ -82,19 +82,73 @@
 #ifndef _RELIABILITY_H
 #define _RELIABILITY_H
 
+#include <time.h>         // For struct timespec
 #include "Definitions.h"  // For common definitions and structures.
 #include "CANComm.h"
+#include "DevTransaction.h" // For CDevTxn
 
 
 // Maximum number of retries before the reliability layer should give up.
 #define MAX_NO_RETRIES  3
 
+// Floor for the adaptive retry timeout (in ms). Keeps scheduling jitter on the
+// host and the remote board from being mistaken for a lost response.
+#define HAL_MIN_RTO_MS  50
+
+// Number of distinct slot addresses in the CAN header (5 bits - see MASK_SLOT_ID)
+#define RELIABILITY_NUM_SLOT_ADDR  32
+
+// Communication statistics kept by the reliability layer for each device.
+// Round trip times are in micro-seconds, timeouts are in milli-seconds.
+struct ReliabilityStatsStruct {
+  unsigned long ulTransactions;     // Number of commands sent (GetRemoteResp calls and batched commands)
+  unsigned long ulRoundTrips;       // Number of times a response was waited on (a pipelined batch counts once)
+  unsigned long ulRetries;          // Number of retries (attempts beyond the first)
+  unsigned long ulFailures;         // Transactions that did not get a response
+  unsigned long ulDeadlineExpired;  // Transactions cut short by the caller's deadline
+  unsigned long ulSlotOffline;      // Transactions not sent because the slot is offline (see CSlotHealth)
+  unsigned long ulBatchAmbiguous;   // Batched responses fetched again - their command repeats in the batch and one went missing
+  unsigned long ulRttSamples;       // Number of round trip times measured
+  unsigned long long ullTotalRttUs; // Sum of all measured round trip times
+  unsigned int unLastRttUs;         // Last measured round trip time
+  unsigned int unMinRttUs;          // Smallest measured round trip time
+  unsigned int unMaxRttUs;          // Largest measured round trip time
+  unsigned int unSRttUs;            // Smoothed round trip time of the device's slot
+  unsigned int unRttVarUs;          // Round trip time variation of the device's slot
+  unsigned int unRtoMs;             // Current retry timeout of the device's slot
+};
+
 class CReliability {
 private: 
   int m_nRetryCount;
 
   CCANComm *m_pobCANComm;
 
+  // Use the slot's RTT estimate for the per-attempt timeout?
+  BOOL m_bAdaptiveTimeOut;
+
+  // Has the CAN channel been made available to the slot health probe?
+  BOOL m_bProbeChannelRegistered;
+
+  ReliabilityStatsStruct m_stStats;
+
+  // Running round trip time estimate for each slot (SRTT / RTTVAR as in RFC 6298).
+  // All function types on a board share the same CAN controller and firmware
+  // loop, so the estimate is kept per slot and shared by all objects in the process.
+  struct SlotRttStruct {
+    BOOL bValid;
+    unsigned int unSRttUs;
+    unsigned int unRttVarUs;
+  };
+  static SlotRttStruct m_astSlotRtt[RELIABILITY_NUM_SLOT_ADDR];
+  static pthread_mutex_t m_SlotRttMutex;  // Guards m_astSlotRtt
+
+  // Feed a round trip time measurement into the slot's estimator
+  void UpdateRtt(unsigned int unRttUs);
+
+  // Retry timeout for the given attempt (0 based), capped at unMaxTimeOut
+  unsigned int GetAttemptTimeOut(int nAttempt, unsigned int unMaxTimeOut);
+
 public:
 
   CReliability(CCANComm *pobCANComm = NULL); // Default Constructor
@@ -103,13 +157,36 @@ public:
   int SetMaxRetries(int nMaxRetries);
 
   // Send a command to the remote device and get a response back from it.
-  // For Response wait up to requested time-out
+  // For Response wait up to requested time-out. 
+  // When the time-out is not longer than HAL_DFLT_TIMEOUT, each attempt waits 
+  // only as long as the slot's measured round trip time warrants (doubling on 
+  // every retry), never longer than unTimeOut. Longer time-outs are used as is, 
+  // they are requested by commands that take a while to execute on the board.
+  // If pstDeadline is given (absolute CLOCK_MONOTONIC time), no attempt is made 
+  // or waited on beyond it, and ERR_TIMEOUT is returned once less than 1 ms of it
+  // is left (the time-out granularity).
+  // Returns ERR_SLOT_OFFLINE without sending anything if the board in the slot 
+  // has stopped responding (see CSlotHealth).
   int GetRemoteResp (unsigned char* pbyCmd,       // Data to form command packet
                      unsigned int unNumBytesCmd,  // Number of bytes in the command packet
                      unsigned char *pbyRespData,  // Pointer to write device response to
                      unsigned int unNumBytesResp, // Number of bytes expected from remote device
                      BOOL bStreamingTx = FALSE,                 // Indicates if we are transmitting streaming data
-                     unsigned int unTimeOut = HAL_DFLT_TIMEOUT);// Time to wait for response from remote device
+                     unsigned int unTimeOut = HAL_DFLT_TIMEOUT, // Time to wait for response from remote device
+                     const struct timespec *pstDeadline = NULL);// Deadline for the whole transaction
+
+  // Send a batch of commands to the remote device back to back and then collect
+  // their responses, so the whole batch costs about one round trip instead of one 
+  // per command. The board answers commands in the order received; a response that
+  // is lost or garbled is fetched again with GetRemoteResp() for that command alone.
+  // Responses are told apart by their command only, so when a command repeats in the
+  // batch and one of its responses is missing, all of its responses are fetched again.
+  // Each transaction's GetRespBytes() is set to the number of bytes received or a 
+  // negative error code. Returns ERR_SUCCESS once every command has been tried.
+  int GetRemoteRespBatch (CDevTxn **apobTxn,       // Commands to send, responses written back
+                          int nNumTxn,              // Number of commands (up to MAX_DEV_TXN_BATCH)
+                          unsigned int unTimeOut = HAL_DFLT_TIMEOUT, // Time to wait for each response
+                          BOOL bStreamingTx = FALSE);                // Indicates if we are transmitting streaming data
 
   int m_nRetryAttempts;
 
@@ -121,6 +198,20 @@ public:
              unsigned int unNumBytesCmd,  // Number of bytes in the command packet
              BOOL bStreamingTx = FALSE);  // Indicates if we are transmitting streaming data
 
+  // Enable / disable round trip time based retry timeouts (enabled by default)
+  void SetAdaptiveTimeOut(BOOL bEnable);
+
+  // Get the retry and latency statistics of this device
+  int GetStats(ReliabilityStatsStruct *pstStats);
+
+  // Clear the statistics of this device (the slot's RTT estimate is kept)
+  void ResetStats();
+
+  // Fill pstDeadline with the absolute time unMilliSec from now, for use with GetRemoteResp
+  static void MakeDeadline(unsigned int unMilliSec, struct timespec *pstDeadline);
+
+  // Monotonic time in micro-seconds
+  static unsigned long long GetMonotonicTimeUs();
+
 };
 #endif // #ifndef _RELIABILITY_H
-
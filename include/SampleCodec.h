@@ -0,0 +1,94 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                    10241 West Little York, Suite 200
+ * *                           Houston, TX 77040
+ * *
+ * *
+ * *  Filename: SampleCodec.h
+ * *
+ * *  Description: Lossless compression of detector sample sequences.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+// SampleCodec.h - header file for CSampleEncoder and CSampleDecoder
+//
+// Detector samples change slowly from one point to the next, so instead of each
+// sample the encoder stores the difference from a prediction of it -
+//   SAMPLE_CODEC_DELTA1: the previous sample
+//   SAMPLE_CODEC_DELTA2: the line through the previous two samples (2 * x[n-1] - x[n-2]),
+//                        better on the slopes of peaks
+// The difference is zigzag mapped (0, -1, 1, -2 ... -> 0, 1, 2, 3 ...) and written as
+// a varint (7 bits per byte, high bit set on all but the last byte), so a baseline
+// point usually takes one byte and the worst case is SAMPLE_CODEC_MAX_BYTES per sample.
+// Any 32 bit sample sequence is restored exactly.
+//
+// Both sides keep the previous samples between calls, so a sequence can be encoded
+// and decoded in pieces of any size. The decoder and the encoder must use the same
+// predictor and start from Reset() at the same sample.
+
+#ifndef _SAMPLE_CODEC_H
+#define _SAMPLE_CODEC_H
+
+#include "Definitions.h"  // For common definitions and structures.
+
+// Largest encoded size of one sample (32 bits, 7 per byte)
+#define SAMPLE_CODEC_MAX_BYTES    5
+
+// Buffer size needed to encode nSamples samples in the worst case
+#define SAMPLE_CODEC_MAX_ENCODED_SIZE(nSamples)   ((nSamples) * SAMPLE_CODEC_MAX_BYTES)
+
+typedef enum
+{
+  SAMPLE_CODEC_DELTA1 = 0,  // First order predictor
+  SAMPLE_CODEC_DELTA2,      // Second order predictor
+} SAMPLE_CODEC_PREDICTOR_ENUM;
+
+class CSampleEncoder {
+private:
+  SAMPLE_CODEC_PREDICTOR_ENUM m_ePredictor;
+  unsigned int m_unPrev1;     // Previous sample
+  unsigned int m_unPrev2;     // Sample before that
+  unsigned int m_unHistory;   // Number of previous samples known (up to 2)
+
+public:
+  explicit CSampleEncoder(SAMPLE_CODEC_PREDICTOR_ENUM ePredictor = SAMPLE_CODEC_DELTA1);
+
+  // Start a new sequence
+  void Reset();
+
+  // Encode NumSamples samples into Buf. Returns the number of bytes written, or
+  // ERR_INVALID_ARGS if BufSize is less than SAMPLE_CODEC_MAX_ENCODED_SIZE(NumSamples).
+  int Encode(const int *Samples, unsigned int NumSamples, unsigned char *Buf, unsigned int BufSize);
+};
+
+class CSampleDecoder {
+private:
+  SAMPLE_CODEC_PREDICTOR_ENUM m_ePredictor;
+  unsigned int m_unPrev1;
+  unsigned int m_unPrev2;
+  unsigned int m_unHistory;
+
+public:
+  explicit CSampleDecoder(SAMPLE_CODEC_PREDICTOR_ENUM ePredictor = SAMPLE_CODEC_DELTA1);
+
+  // Start a new sequence
+  void Reset();
+
+  // Decode up to MaxSamples samples from BufSize bytes of Buf. *BytesUsed is set to
+  // the bytes consumed - a sample cut off at the end of Buf is left for the next call
+  // (pass the remaining bytes again with more data). Returns the number of samples
+  // decoded, or ERR_PROTOCOL if the data is not a valid encoding.
+  int Decode(const unsigned char *Buf, unsigned int BufSize, int *Samples, unsigned int MaxSamples,
+             unsigned int *BytesUsed);
+};
+
+#endif // #ifndef _SAMPLE_CODEC_H
@@ -145,6 +145,10 @@ public:
   // Flushes the contents of the Named Pipe that is used for streaming data for this device.
   int Flush(); 
 
+  // Returns the file descriptor that becomes readable when streaming data arrives
+  // for this device (for select() / CHALReactor)
+  int GetRxStreamingFd();
+
   // Returns TRUE if G2 BaseIO Board else FALSE
   bool IsRS422ModeSupported( void );
   
@@ -0,0 +1,84 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                    10241 West Little York, Suite 200
+ * *                           Houston, TX 77040
+ * *
+ * *
+ * *  Filename: SimClock.h
+ * *
+ * *  Description: Virtual clock pacing the device simulators.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+// SimClock.h - header file for CSimClock
+//
+// A simulator gives each sample the device time it would have on real hardware, and
+// waits on a CSimClock until that time before returning it. The clock decides how
+// device time relates to wall time -
+//   SIM_CLOCK_REAL_TIME (1): one device second per second
+//   N > 1:                   N device seconds per second (10x, 100x ...)
+//   SIM_CLOCK_FREE_RUN (0):  no waiting - device time moves on as fast as the
+//                            samples are read
+// The time stamps are the same at any speed, so a recorded run replays identically,
+// only faster.
+//
+// All simulators use the process default clock (GetDefault()) unless given another
+// one. Its speed is set with SetSpeed() or, for a whole process, with the
+// PREAMP_SIM_SPEED environment variable (e.g. PREAMP_SIM_SPEED=0 for regression
+// tests). The speed may be changed while simulators run; device time continues from
+// where it is.
+
+#ifndef _SIM_CLOCK_H
+#define _SIM_CLOCK_H
+
+#include "Definitions.h"  // For common definitions and structures.
+#include "HALLock.h"      // For CHALMutex
+
+#define SIM_CLOCK_FREE_RUN    0
+#define SIM_CLOCK_REAL_TIME   1
+
+// Longest single sleep, so that a speed change is picked up by a waiting simulator
+#define SIM_CLOCK_MAX_SLEEP_US  100000
+
+class CSimClock {
+private:
+  unsigned int m_unSpeed;
+  unsigned long long m_ullBaseDevUs;  // Device time at m_ullBaseWallUs
+  unsigned long long m_ullBaseWallUs; // Monotonic wall time of the last speed change
+  CHALMutex m_obLock;
+
+  // Device time, with m_obLock held
+  unsigned long long DevTimeAt(unsigned long long ullWallUs) const;
+
+  // Not copyable
+  CSimClock(const CSimClock &);
+  CSimClock &operator=(const CSimClock &);
+
+public:
+  explicit CSimClock(unsigned int Speed = SIM_CLOCK_REAL_TIME);
+
+  // Process default clock
+  static CSimClock *GetDefault();
+
+  // SIM_CLOCK_FREE_RUN, SIM_CLOCK_REAL_TIME or a speed up factor
+  void SetSpeed(unsigned int Speed);
+  unsigned int GetSpeed();
+
+  // Device time in micro-seconds since the clock was made
+  unsigned long long GetTimeUs();
+
+  // Wait until device time DevTimeUs. Returns at once if that time has passed, or
+  // when free running (device time is then moved on to DevTimeUs).
+  void WaitUntilUs(unsigned long long DevTimeUs);
+};
+
+#endif // #ifndef _SIM_CLOCK_H
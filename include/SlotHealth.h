@@ -0,0 +1,124 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                    10241 West Little York, Suite 200
+ * *                           Houston, TX 77040
+ * *
+ * *
+ * *  Filename: SlotHealth.h
+ * *
+ * *  Description: Process wide health state (circuit breaker) for each
+ * *               board slot on the CAN bus.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+// SlotHealth.h - header file for CSlotHealth
+//
+// When a board is pulled or hung, every request to every function on that
+// board runs the full retry sequence in CReliability. CSlotHealth tracks
+// consecutive timed-out transactions per slot. Once SLOT_HEALTH_DFLT_FAIL_THRESHOLD
+// transactions in a row have timed out, the slot is marked OFFLINE and requests
+// to it fail immediately with ERR_SLOT_OFFLINE. A background thread then probes
+// the board every SLOT_HEALTH_DFLT_PROBE_INTERVAL ms (using the CAN channel of
+// one of the devices open on that slot) and marks the slot ONLINE again on the
+// first response. Any response to a regular request also marks it ONLINE.
+//
+// All members are static - there is one health state per slot per process.
+
+#ifndef _SLOT_HEALTH_H
+#define _SLOT_HEALTH_H
+
+#include <pthread.h>
+#include "Definitions.h"  // For common definitions and structures.
+#include "CANComm.h"
+
+// Number of consecutive timed-out transactions that take a slot offline
+#define SLOT_HEALTH_DFLT_FAIL_THRESHOLD   2
+
+// Interval (ms) between probes of an offline slot
+#define SLOT_HEALTH_DFLT_PROBE_INTERVAL   2000
+
+// Number of distinct slot addresses in the CAN header (5 bits - see MASK_SLOT_ID)
+#define SLOT_HEALTH_NUM_SLOT_ADDR  32
+
+// Maximum number of open devices per slot that can be used for probing
+#define SLOT_HEALTH_MAX_CHANNELS   16
+
+enum SLOT_HEALTH_STATE {
+  SLOT_ONLINE = 0,  // Requests are sent to the board (circuit closed)
+  SLOT_OFFLINE      // Requests fail immediately, board is being probed (circuit open)
+};
+
+// Called when a slot goes offline or comes back online. Called from the thread
+// that made the failing request (offline) or from the probe thread (online),
+// so keep it short and do not call back into HAL objects of that slot.
+typedef void (*SlotHealthEventCallback)(unsigned char bySlotID, SLOT_HEALTH_STATE eState, void *pvArg);
+
+class CSlotHealth {
+private:
+  struct SlotStateStruct {
+    SLOT_HEALTH_STATE eState;
+    int nConsecutiveFailures;
+    BOOL bProbeInProgress;            // Probe thread is using one of the channels
+    unsigned long ulOfflineCount;     // Number of times the slot went offline
+    unsigned long ulRejectedRequests; // Requests failed without touching the bus
+    unsigned long long ullNextProbeUs;
+    CCANComm *apobChannels[SLOT_HEALTH_MAX_CHANNELS];
+  };
+
+  static SlotStateStruct m_astSlots[SLOT_HEALTH_NUM_SLOT_ADDR];
+  static pthread_mutex_t m_Mutex;
+  static pthread_cond_t m_Cond;
+  static pthread_t m_ProbeThread;
+  static BOOL m_bProbeThreadRunning;
+  static BOOL m_bEnabled;
+  static int m_nFailThreshold;
+  static unsigned int m_unProbeIntervalMs;
+  static SlotHealthEventCallback m_pfnCallback;
+  static void *m_pvCallbackArg;
+
+  static void *ProbeThread(void *pvArg);
+  static void NotifyEvent(unsigned char bySlotID, SLOT_HEALTH_STATE eState);
+
+public:
+  // Enable / disable the circuit breaker for the whole process (enabled by default).
+  // Disabling it brings all slots back online.
+  static void Enable(BOOL bEnable);
+
+  // Number of consecutive timed-out transactions that take a slot offline
+  static int SetFailThreshold(int nFailures);
+
+  // Interval (ms) between probes of an offline slot
+  static int SetProbeInterval(unsigned int unProbeIntervalMs);
+
+  // Register a function to be told about slots going offline / online (NULL to remove)
+  static void SetEventCallback(SlotHealthEventCallback pfnCallback, void *pvArg);
+
+  // Current state of a slot
+  static SLOT_HEALTH_STATE GetState(unsigned char bySlotID);
+
+  // Number of times a slot went offline and number of requests rejected while offline
+  static int GetSlotStats(unsigned char bySlotID, unsigned long *pulOfflineCount, unsigned long *pulRejectedRequests);
+
+  // Used by the reliability layer -
+  // Register / unregister a CAN channel that the probe thread may use for a slot.
+  // UnregisterChannel waits for a probe in progress on the channel to complete.
+  static void RegisterChannel(CCANComm *pobCANComm);
+  static void UnregisterChannel(CCANComm *pobCANComm);
+
+  // Returns FALSE if requests to the slot should fail immediately
+  static BOOL IsRequestAllowed(unsigned char bySlotID);
+
+  // Outcome of a transaction - bResponded is TRUE if the board answered at all
+  static void ReportResult(unsigned char bySlotID, BOOL bResponded);
+};
+
+#endif // #ifndef _SLOT_HEALTH_H
@@ -0,0 +1,177 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                    10241 West Little York, Suite 200
+ * *                           Houston, TX 77040
+ * *
+ * *
+ * *  Filename: SolenoidSchedule.h
+ * *
+ * *  Description: Timed valve events of an analysis cycle, switched from a
+ * *               high priority thread.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+// SolenoidSchedule.h - header file for CSolenoidSchedule
+//
+// Switching valves from the application's timed event table puts the application's
+// own scheduling delays on top of the CAN round trip of every TurnONSolValve() /
+// TurnOFFSolValve(). Instead the valve events of a cycle are loaded once -
+//
+//   SolEventStruct astEvents[] = {
+//     {  1000, &obSol1, NULL, NULL, TRUE  },    // Inject at 1 s
+//     { 31000, &obSol1, NULL, NULL, FALSE },
+//     { 31000, &obSol4, NULL, NULL, TRUE  },    // Backflush
+//   };
+//   obSchedule.Load(astEvents, 3);
+//   obSchedule.StartCycle(&obCycleClock);       // Start the cycle clock and the events
+//   ...
+//   obSchedule.Wait();
+//   obSchedule.GetResults(astResults, 3);
+//
+// and switched by a thread of its own, at real time (SCHED_FIFO) priority when the
+// process is allowed to. The thread sleeps until shortly before an event and polls
+// the clock for the rest, so it is not late by a scheduler tick.
+//
+// Every event reports when it was scheduled, when its command was sent and when the
+// board acknowledged it, all relative to the start of the cycle. The valve switches
+// between the last two; the midpoint is taken as the actuation time and its
+// distance from the scheduled time as the actuation error. With compensation on,
+// the commands of a cycle are sent early by half the average round trip of the
+// cycles before, which centers the error on zero from the second cycle on.
+//
+// Events at the same time are sent one after the other, the later ones late by the
+// round trips before them. The valves must be open for as long as the schedule
+// runs. Load / Start / Stop / Wait are to be called from one thread. Times are in
+// micro-seconds of the monotonic clock (see CReliability::GetMonotonicTimeUs()).
+
+#ifndef _SOLENOID_SCHEDULE_H
+#define _SOLENOID_SCHEDULE_H
+
+#include <pthread.h>
+#include "Definitions.h"  // For common definitions and structures.
+
+class CSolenoidCtrl;
+class CCycleClockSync;
+
+#define SOL_SCHED_MAX_EVENTS      128
+
+// Defaults
+#define SOL_SCHED_DFLT_PRIORITY   80    // SCHED_FIFO priority of the thread (0 - normal priority)
+#define SOL_SCHED_DFLT_SPIN_US    500   // Last part of the wait spent polling the clock
+
+// Switches a valve of a SolEventStruct without a CSolenoidCtrl. Returns ERR_SUCCESS
+// or a negative error code, like TurnONSolValve().
+typedef int (*SolActuateFn)(void *pvArg, BOOL bOn);
+
+// One valve event
+struct SolEventStruct {
+  unsigned int unTimeMs;        // Time after the start of the cycle
+  CSolenoidCtrl *pobValve;      // Valve to switch (NULL - call pfnActuate)
+  SolActuateFn pfnActuate;
+  void *pvArg;                  // Argument of pfnActuate
+  BOOL bOn;                     // Switch on / off
+};
+
+// What happened to an event. Times are relative to the start of the cycle.
+struct SolEventResultStruct {
+  unsigned long long ullScheduledUs;
+  unsigned long long ullSentUs;     // Command sent
+  unsigned long long ullDoneUs;     // Command acknowledged
+  long lErrorUs;                    // Actuation (midpoint of sent and done) after the scheduled time
+  int nResult;                      // Result of the command, ERR_DATA_PENDING if not run
+};
+
+// Timing of the events of the last cycle
+struct SolScheduleStatsStruct {
+  unsigned long ulExecuted;         // Events run
+  unsigned long ulFailed;           // Events whose command failed
+  long lMinErrorUs;                 // Actuation errors
+  long lMaxErrorUs;
+  double dMeanAbsErrorUs;
+  unsigned int unMaxLateUs;         // Command sent after its (compensated) time
+  unsigned int unMaxRoundTripUs;    // Longest command
+  unsigned int unLeadUs;            // Time the commands were sent early by
+  BOOL bRealTime;                   // Thread ran at SCHED_FIFO priority
+};
+
+class CSolenoidSchedule {
+private:
+  SolEventStruct m_astEvents[SOL_SCHED_MAX_EVENTS];
+  SolEventResultStruct m_astResults[SOL_SCHED_MAX_EVENTS];
+  int m_anOrder[SOL_SCHED_MAX_EVENTS];  // Events in time order
+  int m_nNumEvents;
+
+  int m_nPriority;
+  unsigned int m_unSpinUs;
+  BOOL m_bCompensate;
+
+  // Round trips of the commands since Load(), for the compensation
+  unsigned long long m_ullTotalRoundTripUs;
+  unsigned long m_ulRoundTrips;
+
+  pthread_t m_Thread;
+  BOOL m_bThreadStarted;           // Not joined yet
+  BOOL m_bDone;                     // Thread has run the last event
+  BOOL m_bStop;
+  BOOL m_bRealTime;
+
+  // Guards the state above while the thread runs, and its waits
+  pthread_mutex_t m_Mutex;
+  pthread_cond_t m_Cond;            // Monotonic clock
+
+  unsigned long long m_ullCycleStartUs;
+  unsigned int m_unLeadUs;
+
+  // Sleep / poll the clock until ullDueUs. FALSE if stopped.
+  BOOL WaitUntil(unsigned long long ullDueUs);
+
+  // Switch the valve of an event
+  static int Actuate(const SolEventStruct &stEvent);
+
+  void Run();
+  static void *ScheduleThread(void *pvArg);
+
+  // Not copyable - owns a thread
+  CSolenoidSchedule(const CSolenoidSchedule &);
+  CSolenoidSchedule &operator=(const CSolenoidSchedule &);
+
+public:
+  CSolenoidSchedule();  // Default Constructor
+  ~CSolenoidSchedule(); // Destructor - stops the schedule
+
+  // Load the events of a cycle (in any order). Only while not running.
+  int Load(const SolEventStruct *Events, int NumEvents);
+
+  // Thread priority (SCHED_FIFO 1 .. 99, 0 - normal), clock polling time before
+  // each event, and whether to send the commands early by half the round trip.
+  int Configure(int Priority, unsigned int SpinUs, BOOL Compensate);
+
+  // Run the events of one cycle that started at CycleStartUs (monotonic clock,
+  // 0 - now). Events already due are run at once and reported late.
+  int Start(unsigned long long CycleStartUs = 0);
+
+  // Start the cycle clock and the events together
+  int StartCycle(CCycleClockSync *CycleClock);
+
+  // Skip the remaining events / wait for the last one
+  int Stop();
+  int Wait();
+
+  BOOL IsRunning();
+
+  // Results of the events in the order they were loaded. Returns the number copied.
+  int GetResults(SolEventResultStruct *Results, int MaxResults);
+
+  int GetStats(SolScheduleStatsStruct *Stats);
+};
+
+#endif // #ifndef _SOLENOID_SCHEDULE_H
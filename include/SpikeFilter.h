@@ -0,0 +1,120 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                    10241 West Little York, Suite 200
+ * *                           Houston, TX 77040
+ * *
+ * *
+ * *  Filename: SpikeFilter.h
+ * *
+ * *  Description: Spike filter for detector (preamp) stream data.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+// SpikeFilter.h - header file for CSpikeFilter
+//
+// Samples are held in a fixed size circular window. Once the window is full, every
+// new sample makes the filter check the sample at the centre of the window (fixing
+// it if it is a spike) and release the oldest sample, so samples come out delayed by
+// (window size - 1). Nothing is allocated after construction.
+//
+// Filter types -
+//   SPIKE_FILT_SLOPE:  The original preamp spike trap. The centre sample is a spike if
+//                      the slopes to both neighbours are at least Threshold counts and
+//                      of opposite sign; it is replaced by the average of the
+//                      neighbours. Window size must be 3.
+//   SPIKE_FILT_MEDIAN: Every sample is replaced by the median of the samples in the
+//                      window (as received). Odd window sizes only.
+//   SPIKE_FILT_HAMPEL: The centre sample is replaced by the window median if it is
+//                      more than Threshold / 1000 standard deviations from it, the
+//                      standard deviation being estimated as 1.4826 * the median
+//                      absolute deviation of the window. Odd window sizes only.
+//
+// Samples that are changed are returned with PREAMP_SAMPLE_SPIKE_FIXED set in byFlags.
+
+#ifndef _SPIKE_FILTER_H
+#define _SPIKE_FILTER_H
+
+#include "Definitions.h"  // For common definitions and structures.
+
+// Largest window supported
+#define SPIKE_FILT_MAX_WINDOW               15
+
+// Defaults (the filter CPreampStream has always used)
+#define SPIKE_FILT_DFLT_WINDOW              3
+#define SPIKE_FILT_DFLT_SLOPE_THRESHOLD     100000  // ADC counts
+#define SPIKE_FILT_DFLT_HAMPEL_THRESHOLD    3000    // 3 standard deviations
+
+enum SPIKE_FILT_TYPE_ENUM {
+  SPIKE_FILT_SLOPE = 0,
+  SPIKE_FILT_MEDIAN,
+  SPIKE_FILT_HAMPEL
+};
+
+// One detector sample
+struct SpikeFiltSampleStruct {
+  int nBridgeVal;                   // Detector ADC counts
+  unsigned long long ullTimestamp;  // Data acq timestamp
+  unsigned char byFlags;            // PREAMP_SAMPLE_ flags
+};
+
+class CSpikeFilter {
+private:
+  struct WindowEntryStruct {
+    SpikeFiltSampleStruct stSample; // Sample as it will be released
+    int nRawVal;                    // Detector ADC counts as received
+  };
+
+  WindowEntryStruct m_astWindow[SPIKE_FILT_MAX_WINDOW];
+  unsigned int m_unOldest;          // Index of the oldest sample in the window
+  unsigned int m_unCount;           // Number of samples in the window
+  unsigned int m_unWindowSize;
+  SPIKE_FILT_TYPE_ENUM m_eType;
+  int m_nThreshold;
+  const char *m_pszName;            // Device name for debug messages
+
+  // Window entry unAge samples newer than the oldest
+  WindowEntryStruct &Entry(unsigned int unAge)
+  {
+    unsigned int unIndex = m_unOldest + unAge;
+    if (unIndex >= m_unWindowSize)
+    {
+      unIndex -= m_unWindowSize;
+    }
+    return m_astWindow[unIndex];
+  }
+
+  // Check (and fix) the sample at the centre of a full window
+  void CheckSlope();
+  void CheckMedian(BOOL bHampel);
+
+public:
+  explicit CSpikeFilter(const char *pszName = ""); // Default Constructor
+
+  // Select the filter. Samples held in the window are dropped. Returns ERR_INVALID_ARGS
+  // if the window size is not valid for the filter type.
+  int Configure(SPIKE_FILT_TYPE_ENUM eType, unsigned int unWindowSize, int nThreshold);
+
+  // Drop the samples held in the window (e.g. when streaming restarts)
+  void Reset();
+
+  // Number of samples held in the window
+  unsigned int GetCount() const
+  {
+    return m_unCount;
+  }
+
+  // Add a sample to the window. Returns TRUE with the oldest sample (filtered) in
+  // *pstOut once the window is full, FALSE while it is still filling.
+  BOOL Push(const SpikeFiltSampleStruct &stIn, SpikeFiltSampleStruct *pstOut);
+};
+
+#endif // #ifndef _SPIKE_FILTER_H
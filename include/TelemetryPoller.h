@@ -0,0 +1,201 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                    10241 West Little York, Suite 200
+ * *                           Houston, TX 77040
+ * *
+ * *
+ * *  Filename: TelemetryPoller.h
+ * *
+ * *  Description: Background polling of heater, EPC, RTD and pressure
+ * *               readings.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+// TelemetryPoller.h - header file for CTelemetryPoller
+//
+// Instead of the control loop reading temperatures, PWMs and pressures one blocking
+// call at a time, the readings are listed once with the period each is wanted at -
+//
+//   nHtr1Temp = obPoller.AddHeater(&obHtr1, TELEMETRY_HTR_TEMP, 500);
+//   obPoller.AddHeater(&obHtr1, TELEMETRY_HTR_PWM, 1000);
+//   obPoller.AddEPC(&obEPC1, TELEMETRY_EPC_PRESSURE, 200);
+//   obPoller.AddRTD(&obRTD3, TELEMETRY_RTD_TEMP, 1000);
+//   obPoller.Start();
+//   ...
+//   obPoller.GetValue(nHtr1Temp, &stValue);   // Latest reading, never waits for the bus
+//
+// Worker threads make the reads. Reads of different devices run at the same time,
+// reads of one device one after the other (they would queue on its command lock
+// anyway). The first reads are spread over the periods, and no two reads start
+// closer than the configured gap, so the polls do not arrive on the bus as bursts
+// between streaming data. A reading that is still being read when it is next due
+// is skipped (counted), not queued up.
+//
+// Each reading keeps its latest value, time stamp and result, and the scheduling
+// jitter (start of the read after its due time) and read time. The poller keeps the
+// load it puts on the bus - reads per second and the average number of reads in
+// progress.
+//
+// The devices must be open before Start() and stay open until Stop(). Readings can
+// only be added while the poller is stopped. Times are in micro-seconds of the
+// monotonic clock (see CReliability::GetMonotonicTimeUs()).
+
+#ifndef _TELEMETRY_POLLER_H
+#define _TELEMETRY_POLLER_H
+
+#include <pthread.h>
+#include "Definitions.h"  // For common definitions and structures.
+
+class CHeaterCtrl;
+class CEPC;
+class CRTD;
+class CPressure;
+
+#define TELEMETRY_MAX_ITEMS         64
+#define TELEMETRY_MAX_WORKERS       8
+
+// Defaults
+#define TELEMETRY_DFLT_WORKERS      2
+#define TELEMETRY_DFLT_MIN_GAP_US   1000
+
+typedef enum
+{
+  TELEMETRY_HTR_TEMP = 0,   // CHeaterCtrl - temperature (milli DegC)
+  TELEMETRY_HTR_PWM,        // CHeaterCtrl - PWM (milli %)
+  TELEMETRY_HTR_CURRENT,    // CHeaterCtrl - total heater current (micro A)
+  TELEMETRY_EPC_PRESSURE,   // CEPC - pressure (milli V)
+  TELEMETRY_EPC_TEMP,       // CEPC - on board temperature (milli DegC)
+  TELEMETRY_RTD_TEMP,       // CRTD - temperature (milli DegC)
+  TELEMETRY_RTD_PWM,        // CRTD - PWM (milli %)
+  TELEMETRY_PRESSURE,       // CPressure - pressure (milli V)
+  TELEMETRY_CUSTOM,         // Application read function
+} TELEMETRY_VALUE_ENUM;
+
+// Read function of a TELEMETRY_CUSTOM reading. Returns ERR_SUCCESS or a negative
+// error code, like the HAL getters.
+typedef int (*TelemetryReadFn)(void *pvArg, long long *pllValue);
+
+// Latest reading of one item
+struct TelemetryValueStruct {
+  TELEMETRY_VALUE_ENUM eValue;
+  unsigned int unPeriodMs;
+  long long llValue;                // Last value read successfully
+  unsigned long long ullTimeUs;     // When it was read (0: not read yet)
+  int nLastResult;                  // Result of the last read
+  unsigned long ulReads;            // Reads made
+  unsigned long ulErrors;           // Reads that failed
+  unsigned long ulSkipped;          // Polls skipped - the previous read was not done
+  unsigned int unLastJitterUs;      // Read start after its due time
+  unsigned int unMaxJitterUs;
+  unsigned long long ullTotalJitterUs;
+  unsigned int unLastReadUs;        // Time the read took
+  unsigned int unMaxReadUs;
+};
+
+// Load of all the readings
+struct TelemetryStatsStruct {
+  unsigned long long ullRunUs;      // Time since Start()
+  unsigned long ulReads;
+  unsigned long ulErrors;
+  unsigned long ulSkipped;
+  unsigned long long ullBusyUs;     // Sum of the read times
+  double dReadsPerSec;
+  double dBusyRatio;                // ullBusyUs / ullRunUs - average reads in progress, up to the number of workers
+  unsigned int unMaxInFlight;       // Most reads in progress at once
+  unsigned int unMaxJitterUs;
+};
+
+class CTelemetryPoller {
+private:
+  struct ItemStruct {
+    TELEMETRY_VALUE_ENUM eValue;
+    void *pvDev;                    // Device object, or argument of pfnRead
+    TelemetryReadFn pfnRead;
+    unsigned int unPeriodMs;
+    unsigned long long ullDueUs;
+    BOOL bBusy;                     // Being read
+    TelemetryValueStruct stValue;
+  };
+
+  ItemStruct m_astItems[TELEMETRY_MAX_ITEMS];
+  int m_nNumItems;
+
+  unsigned int m_unNumWorkers;
+  unsigned int m_unMinGapUs;
+
+  pthread_t m_aWorkers[TELEMETRY_MAX_WORKERS];
+  unsigned int m_unWorkersRunning;
+  BOOL m_bStop;
+
+  // Guards everything above and below. Never held during a read.
+  pthread_mutex_t m_Mutex;
+  pthread_cond_t m_Cond;            // Monotonic clock
+
+  unsigned long long m_ullStartUs;
+  unsigned long long m_ullStopUs;     // 0 while running
+  unsigned long long m_ullNextStartUs; // Earliest start of the next read
+  unsigned int m_unInFlight;
+  TelemetryStatsStruct m_stStats;
+
+  int AddItem(TELEMETRY_VALUE_ENUM eValue, void *pvDev, TelemetryReadFn pfnRead, unsigned int unPeriodMs);
+
+  // Spread the first reads over their periods
+  void Schedule(unsigned long long ullNowUs);
+
+  // Item to read next - due, and its device not being read. NULL if none; then
+  // *pullWakeUs is when to look again (0: when a read completes).
+  ItemStruct *NextItem(unsigned long long ullNowUs, unsigned long long *pullWakeUs);
+
+  // Make one read. Called without the lock.
+  static int Read(const ItemStruct &stItem, long long *pllValue);
+
+  void Work();
+  static void *WorkerThread(void *pvArg);
+
+  // Not copyable - owns threads
+  CTelemetryPoller(const CTelemetryPoller &);
+  CTelemetryPoller &operator=(const CTelemetryPoller &);
+
+public:
+  CTelemetryPoller();   // Default Constructor
+  ~CTelemetryPoller();  // Destructor - stops the poller
+
+  // Add a reading. Returns the item id (>= 0) or a negative error code.
+  int AddHeater(CHeaterCtrl *Heater, TELEMETRY_VALUE_ENUM Value, unsigned int PeriodMs);
+  int AddEPC(CEPC *EPC, TELEMETRY_VALUE_ENUM Value, unsigned int PeriodMs);
+  int AddRTD(CRTD *RTD, TELEMETRY_VALUE_ENUM Value, unsigned int PeriodMs);
+  int AddPressure(CPressure *Pressure, unsigned int PeriodMs);
+  int AddCustom(TelemetryReadFn Read, void *Arg, unsigned int PeriodMs);
+
+  // Remove all the readings
+  int Clear();
+
+  // Number of worker threads (1 .. TELEMETRY_MAX_WORKERS) and the least time between
+  // the starts of two reads
+  int Configure(unsigned int NumWorkers, unsigned int MinGapUs);
+
+  // Start / stop polling. Stop() waits for the reads in progress.
+  int Start();
+  int Stop();
+
+  BOOL IsRunning();
+
+  // Latest reading of an item
+  int GetValue(int ItemId, TelemetryValueStruct *Value);
+
+  // Latest readings of all items (in item id order). Returns the number copied.
+  int GetTable(TelemetryValueStruct *Values, int MaxValues);
+
+  int GetStats(TelemetryStatsStruct *Stats);
+};
+
+#endif // #ifndef _TELEMETRY_POLLER_H
@@ -0,0 +1,145 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                    10241 West Little York, Suite 200
+ * *                           Houston, TX 77040
+ * *
+ * *
+ * *  Filename: WireFormat.h
+ * *
+ * *  Description: Compile time field descriptors for converting packed
+ * *               protocol structures between host and wire byte order.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+// WireFormat.h - byte order descriptors for protocol structures
+//
+// All multi-byte fields on the CAN bus are little endian. Instead of calling
+// FixEndian() on each field at every call site, the fields of a structure that
+// need swapping are listed once in a descriptor -
+//
+//   WIRE_LAYOUT_BEGIN(CAN_CMD_IMB_WRITE_DATA_STRUCT)
+//     WIRE_FIELD(uinFlashOffset)
+//     WIRE_FIELD(uinFlashLen)
+//   WIRE_LAYOUT_END()
+//
+// and HostToWire() / WireToHost() convert a whole structure in place. Single byte
+// fields and byte arrays need not be listed. Nested structures with a descriptor
+// of their own are listed with WIRE_STRUCT(), arrays of multi-byte values with
+// WIRE_ARRAY().
+//
+// On a little endian host the conversion is an empty inline function, so no code
+// is generated. On a big endian host only the listed fields are swapped.
+//
+// Using HostToWire() / WireToHost() on a structure without a descriptor is a
+// compile error (the primary template is declared, never defined), so a structure
+// can not silently go out unconverted.
+//
+// WIRE_ASSERT_SIZE() / WIRE_ASSERT_OFFSET() check the packed layout of a structure
+// at compile time against the size / offsets the remote firmware expects.
+
+#ifndef _WIRE_FORMAT_H
+#define _WIRE_FORMAT_H
+
+#include <stddef.h>   // For offsetof
+#include <endian.h>   // For __BYTE_ORDER
+
+// Defined before including this file to force the big endian conversion on a
+// little endian host (TestHAL/TestWireFormat.cpp checks the descriptors that way)
+#ifndef WIRE_HOST_BIG_ENDIAN
+#if __BYTE_ORDER == __BIG_ENDIAN
+#define WIRE_HOST_BIG_ENDIAN  1
+#else
+#define WIRE_HOST_BIG_ENDIAN  0
+#endif
+#endif
+
+// Compile time assertion - fails with a negative array size when bCond is false
+#define WIRE_CONCAT2(a, b)  a##b
+#define WIRE_CONCAT(a, b)   WIRE_CONCAT2(a, b)
+#define WIRE_STATIC_ASSERT(bCond) \
+  typedef char WIRE_CONCAT(WireStaticAssert_, __LINE__)[(bCond) ? 1 : -1] __attribute__ ((unused))
+
+// Packed size of a structure on the wire
+#define WIRE_ASSERT_SIZE(type, size)           WIRE_STATIC_ASSERT(sizeof (type) == (size))
+
+// Byte offset of a field in a structure on the wire
+#define WIRE_ASSERT_OFFSET(type, field, offset) WIRE_STATIC_ASSERT(offsetof(type, field) == (offset))
+
+// Swap a single field between host and wire byte order
+template <int nSize>
+struct CWireSwap {
+  static inline void Swap(unsigned char *pbyData)
+  {
+    for (int nLow = 0, nHigh = nSize - 1; nLow < nHigh; nLow++, nHigh--)
+    {
+      unsigned char byTmp = pbyData[nLow];
+      pbyData[nLow] = pbyData[nHigh];
+      pbyData[nHigh] = byTmp;
+    }
+  }
+};
+
+template <>
+struct CWireSwap<1> {
+  static inline void Swap(unsigned char *) {}
+};
+
+// Descriptor of a structure's multi-byte fields. Declared only - each structure
+// sent on the wire provides a specialization using the WIRE_LAYOUT_ macros.
+// Fields are addressed by offset, as references can not bind to packed fields.
+template <typename TStruct>
+struct CWireLayout;
+
+#define WIRE_LAYOUT_BEGIN(type) \
+  template <> struct CWireLayout<type> { \
+    typedef type TWire; \
+    static inline void Swap(unsigned char *pbyWire) { \
+      (void) pbyWire;
+
+#define WIRE_FIELD_SIZE(field)  sizeof (((TWire *) 0)->field)
+
+#define WIRE_FIELD(field) \
+  CWireSwap<WIRE_FIELD_SIZE(field)>::Swap(pbyWire + offsetof(TWire, field));
+
+#define WIRE_ARRAY(field) \
+  for (unsigned int unWireNdx = 0; unWireNdx < WIRE_FIELD_SIZE(field) / WIRE_FIELD_SIZE(field[0]); unWireNdx++) \
+  { \
+    CWireSwap<WIRE_FIELD_SIZE(field[0])>::Swap(pbyWire + offsetof(TWire, field) + unWireNdx * WIRE_FIELD_SIZE(field[0])); \
+  }
+
+#define WIRE_STRUCT(field) \
+  CWireLayout<__typeof__(((TWire *) 0)->field)>::Swap(pbyWire + offsetof(TWire, field));
+
+#define WIRE_LAYOUT_END()   } };
+
+// Convert a structure from host to wire byte order in place
+template <typename TStruct>
+inline void HostToWire(TStruct &stData)
+{
+#if WIRE_HOST_BIG_ENDIAN
+  CWireLayout<TStruct>::Swap((unsigned char *) &stData);
+#else
+  // Still instantiate the descriptor so a missing one is caught on every host
+  (void) sizeof (CWireLayout<TStruct>);
+  (void) stData;
+#endif
+}
+
+// Convert a structure from wire to host byte order in place
+template <typename TStruct>
+inline void WireToHost(TStruct &stData)
+{
+  // Byte swapping is its own inverse
+  HostToWire(stData);
+}
+
+#endif // #ifndef _WIRE_FORMAT_H
@@ -0,0 +1,175 @@
+/***********************************************************************
+ * *                          Rosemount Analytical
+ * *                    10241 West Little York, Suite 200
+ * *                           Houston, TX 77040
+ * *
+ * *
+ * *  Filename: WireLayouts.h
+ * *
+ * *  Description: Byte order descriptors and layout checks for the
+ * *               protocol structures exchanged with the remote boards.
+ * *
+ * *  Copyright:        Copyright (c) 2011-2012,
+ * *                    Rosemount Analytical
+ * *                    All Rights Reserved.
+ * *
+ * *  Operating System:  None.
+ * *  Language:          'C++'
+ * *  Target:            Gas Chromatograph Model GC700XP
+ * *
+ * *
+ * *************************************************************************/
+
+// WireLayouts.h - descriptors (see WireFormat.h) for the protocol structures.
+//
+// The protocol headers are shared with the board firmware and stay plain C, so
+// the descriptors live here. Add a descriptor next to the others when a structure
+// starts being sent with CDevRequest or converted with HostToWire() / WireToHost().
+//
+// The sizes below are those of the firmware's packed structures. Structures with
+// 'long' fields match the wire only where long is 32 bits (the PPC target and
+// 32 bit PC builds), so their checks are skipped on LP64 hosts.
+
+#ifndef _WIRE_LAYOUTS_H
+#define _WIRE_LAYOUTS_H
+
+#include "WireFormat.h"
+#include "DevProtocol.h"
+#include "HtrSolProtocol.h"
+#include "BaseIOProtocol.h"
+#include "IMBProtocol.h"
+#include "PreampProtocol.h"
+
+/************************************************************************************/
+// Common structures
+/************************************************************************************/
+WIRE_LAYOUT_BEGIN(CmdAckUnion)
+WIRE_LAYOUT_END()
+WIRE_ASSERT_SIZE(CmdAckUnion, 1);
+
+WIRE_LAYOUT_BEGIN(STATUS_STRUCT)
+WIRE_LAYOUT_END()
+WIRE_ASSERT_SIZE(STATUS_STRUCT, 1);
+
+WIRE_LAYOUT_BEGIN(DEVICE_SYSTEM_INFO_STRUCT)
+WIRE_LAYOUT_END()
+WIRE_ASSERT_SIZE(DEVICE_SYSTEM_INFO_STRUCT, 4);
+
+WIRE_LAYOUT_BEGIN(NACK_STRUCT)
+WIRE_LAYOUT_END()
+WIRE_ASSERT_SIZE(NACK_STRUCT, 2);
+
+WIRE_LAYOUT_BEGIN(PROCESS_VALUE_STREAM_STRUCT)
+  WIRE_FIELD(Value)
+WIRE_LAYOUT_END()
+WIRE_ASSERT_SIZE(PROCESS_VALUE_STREAM_STRUCT, 6);
+
+/************************************************************************************/
+// Heater / Solenoid / RTD
+/************************************************************************************/
+
+// Every member of the data union is a 32 bit value (the NACK error type is only
+// read before conversion), so the union is converted as one 32 bit field.
+WIRE_LAYOUT_BEGIN(HTR_SOL_RTD_DATA_STRUCT)
+  WIRE_FIELD(htrsolDataUnion.PWMmPct)
+WIRE_LAYOUT_END()
+
+WIRE_LAYOUT_BEGIN(CAN_CMD_HTR_STRUCT)
+  WIRE_STRUCT(stData)
+WIRE_LAYOUT_END()
+WIRE_ASSERT_OFFSET(CAN_CMD_HTR_STRUCT, stData, 1);
+
+WIRE_LAYOUT_BEGIN(CAN_CMD_HTR_STATUS_STRUCT)
+WIRE_LAYOUT_END()
+WIRE_ASSERT_SIZE(CAN_CMD_HTR_STATUS_STRUCT, 2);
+
+WIRE_LAYOUT_BEGIN(CAN_CMD_HTR_SOL_RTD_SYSINFO_STRUCT)
+WIRE_LAYOUT_END()
+WIRE_ASSERT_SIZE(CAN_CMD_HTR_SOL_RTD_SYSINFO_STRUCT, 5);
+
+WIRE_LAYOUT_BEGIN(CAN_CMD_SOL_STRUCT)
+  WIRE_STRUCT(stData)
+WIRE_LAYOUT_END()
+WIRE_ASSERT_OFFSET(CAN_CMD_SOL_STRUCT, stData, 1);
+
+WIRE_LAYOUT_BEGIN(CMD_SOL_GET_STATUS_STRUCT)
+WIRE_LAYOUT_END()
+WIRE_ASSERT_SIZE(CMD_SOL_GET_STATUS_STRUCT, 2);
+
+#ifndef __LP64__
+WIRE_ASSERT_SIZE(HTR_SOL_RTD_DATA_STRUCT, 4);
+WIRE_ASSERT_SIZE(CAN_CMD_HTR_STRUCT, 5);
+WIRE_ASSERT_SIZE(CAN_CMD_SOL_STRUCT, 5);
+#endif
+
+/************************************************************************************/
+// EPC (Base IO)
+/************************************************************************************/
+
+// The EPC only uses the 32 bit members of the Base IO data union
+WIRE_LAYOUT_BEGIN(CAN_EPC_DATA_STRUCT)
+  WIRE_FIELD(stData.BaseIOData.PressureMilliVolt)
+WIRE_LAYOUT_END()
+WIRE_ASSERT_OFFSET(CAN_EPC_DATA_STRUCT, stData, 1);
+
+WIRE_LAYOUT_BEGIN(CAN_BASEIO_STATUS_STRUCT)
+WIRE_LAYOUT_END()
+WIRE_ASSERT_SIZE(CAN_BASEIO_STATUS_STRUCT, 2);
+
+WIRE_LAYOUT_BEGIN(CAN_BASEIO_SYSINFO_STRUCT)
+WIRE_LAYOUT_END()
+WIRE_ASSERT_SIZE(CAN_BASEIO_SYSINFO_STRUCT, 5);
+
+/************************************************************************************/
+// Preamp configuration
+/************************************************************************************/
+
+// Every member of the data union is a 32 bit value (enums, long, float)
+WIRE_LAYOUT_BEGIN(PREAMP_DATA_STRUCT)
+  WIRE_FIELD(preampData.Gain)
+WIRE_LAYOUT_END()
+
+WIRE_LAYOUT_BEGIN(CAN_CMD_PREAMP_DATA_STRUCT)
+  WIRE_STRUCT(stData)
+WIRE_LAYOUT_END()
+WIRE_ASSERT_OFFSET(CAN_CMD_PREAMP_DATA_STRUCT, stData, 1);
+
+WIRE_LAYOUT_BEGIN(CAN_CMD_PREAMP_STATUS_STRUCT)
+WIRE_LAYOUT_END()
+WIRE_ASSERT_SIZE(CAN_CMD_PREAMP_STATUS_STRUCT, 2);
+
+#ifndef __LP64__
+WIRE_ASSERT_SIZE(PREAMP_DATA_STRUCT, 4);
+WIRE_ASSERT_SIZE(CAN_CMD_PREAMP_DATA_STRUCT, 5);
+#endif
+
+/************************************************************************************/
+// IMB
+/************************************************************************************/
+WIRE_LAYOUT_BEGIN(CAN_IMB_STATUS_STRUCT)
+WIRE_LAYOUT_END()
+WIRE_ASSERT_SIZE(CAN_IMB_STATUS_STRUCT, 2);
+
+WIRE_LAYOUT_BEGIN(CAN_CMD_IMB_READ_DATA_REQUEST_STRUCT)
+  WIRE_FIELD(nFlashOffset)
+  WIRE_FIELD(nFlashLen)
+WIRE_LAYOUT_END()
+WIRE_ASSERT_SIZE(CAN_CMD_IMB_READ_DATA_REQUEST_STRUCT, 10);
+WIRE_ASSERT_OFFSET(CAN_CMD_IMB_READ_DATA_REQUEST_STRUCT, nFlashOffset, 2);
+
+WIRE_LAYOUT_BEGIN(CAN_CMD_IMB_READ_DATA_STRUCT)
+  WIRE_FIELD(nRequestOffset)
+  WIRE_FIELD(nRequestLen)
+  WIRE_FIELD(flashDataLen)
+WIRE_LAYOUT_END()
+WIRE_ASSERT_SIZE(CAN_CMD_IMB_READ_DATA_STRUCT, 2 + FLASH_IMAGE_DATA_LENGTH + 12);
+WIRE_ASSERT_OFFSET(CAN_CMD_IMB_READ_DATA_STRUCT, nRequestOffset, 2 + FLASH_IMAGE_DATA_LENGTH);
+
+WIRE_LAYOUT_BEGIN(CAN_CMD_IMB_WRITE_DATA_STRUCT)
+  WIRE_FIELD(uinFlashOffset)
+  WIRE_FIELD(uinFlashLen)
+WIRE_LAYOUT_END()
+WIRE_ASSERT_SIZE(CAN_CMD_IMB_WRITE_DATA_STRUCT, 2 + FLASH_IMAGE_DATA_LENGTH + 8);
+WIRE_ASSERT_OFFSET(CAN_CMD_IMB_WRITE_DATA_STRUCT, uinFlashOffset, 2 + FLASH_IMAGE_DATA_LENGTH);
+
+#endif // #ifndef _WIRE_LAYOUTS_H
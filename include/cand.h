@@ -91,6 +91,17 @@ struct CANDRegInfo
   CIPC *m_streamRespIPC;
 };
 
+//IPC channel to the upper layer. Devices registered with the same IPC id
+//  (e.g. all devices of a process using a multiplexed CAN connection)
+//  share one channel.
+struct CANDSharedIPC
+{
+  unsigned int unIPCid;
+  int nMailboxID;
+  int nRefCount;
+  CIPC *pobIPC;
+};
+
 enum CAND_ERRS
 {
   CAND_ERR_DRV_OPEN = 0,
@@ -143,6 +154,12 @@ private:
   //Get details of a matching entry in the list
   CANDRegInfo* GetMatchingEntry(unsigned char SlotID, unsigned char FnType, unsigned char FnCount);
 
+  //Open (or get a reference to an already open) IPC channel to the upper layer
+  CIPC* OpenRespIPC(unsigned int unIPCid, int nMailboxID);
+
+  //Release a reference to an IPC channel, close it with the last reference
+  void CloseRespIPC(CIPC *pobIPC);
+
   void LogError(CAND_ERRS eCANDError, long lLineNr);
 
 //Variables...
@@ -156,6 +173,9 @@ private:
 
   //List of registered device enumerations
   CANDRegInfo ltRegList[32][32][16]; // Max 32 Slots, Max 32 Fn Types Per Slot, Max 16 Enumerations Per Type
+
+  //Open IPC channels to the upper layer
+  list<CANDSharedIPC> m_ltSharedIPC;
   
 
 